@@ -22,6 +22,8 @@
    available. 
 */
 
+// This copy has local changes, listed in PATCHES_tree_hh.txt next to it.
+
 
 #ifndef tree_hh_
 #define tree_hh_
@@ -632,16 +634,25 @@ void tree<T, tree_node_allocator>::erase_children(const iterator_base& it)
 //	std::cout << "erase_children " << it.node << std::endl;
 	if(it.node==0) return;
 
+	// Destroy the descendants in postfix order without recursion, so that
+	// deep trees do not overflow the call stack. A node is destroyed once
+	// its last child is, at which point its children list is cleared
 	tree_node *cur=it.node->first_child;
-	tree_node *prev=0;
 
-	while(cur!=0) {
-		prev=cur;
-		cur=cur->next_sibling;
-		erase_children(pre_order_iterator(prev));
-//		kp::destructor(&prev->data);
-		alloc_.destroy(prev);
-		alloc_.deallocate(prev,1);
+	while(cur!=0 && cur!=it.node) {
+		if(cur->first_child!=0) {
+			cur=cur->first_child;
+			continue;
+			}
+		tree_node *next=cur->next_sibling;
+		if(next==0) {
+			next=cur->parent;
+			next->first_child=0;
+			next->last_child=0;
+			}
+		alloc_.destroy(cur);
+		alloc_.deallocate(cur,1);
+		cur=next;
 		}
 	it.node->first_child=0;
 	it.node->last_child=0;
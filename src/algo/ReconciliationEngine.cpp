@@ -0,0 +1,96 @@
+#include "ReconciliationEngine.hpp"
+
+ReconciliationEngine::ReconciliationEngine(
+    const SuperReconciliationParams& params)
+: params(params)
+{}
+
+void ReconciliationEngine::reconcile(
+    tree<Event>& tree,
+    Mode mode,
+    ReconciliationStats* stats)
+{
+    if (mode == Mode::Unordered)
+    {
+        unordered_super_reconciliation(
+            tree, this->unordered, stats, this->params.jobs);
+    }
+    else if (mode == Mode::Beam)
+    {
+        auto params = this->params;
+        params.stats = stats;
+        beam_super_reconciliation(tree, params);
+    }
+    else if (mode == Mode::Search)
+    {
+        auto params = this->params;
+        params.stats = stats;
+        search_super_reconciliation(tree, params);
+    }
+    else if (stats != nullptr)
+    {
+        auto params = this->params;
+        params.stats = stats;
+        super_reconciliation(tree, this->ordered, params);
+    }
+    else
+    {
+        super_reconciliation(tree, this->ordered, this->params);
+    }
+}
+
+tree<Event> ReconciliationEngine::start(
+    tree<Event>& tree,
+    Mode mode,
+    ReconciliationStats* stats)
+{
+    this->started = mode;
+
+    if (mode == Mode::Unordered)
+    {
+        return start_unordered_super_reconciliation(
+            tree, this->unordered, stats, this->params.jobs);
+    }
+
+    if (mode == Mode::Beam || mode == Mode::Search)
+    {
+        auto result = tree;
+        this->reconcile(result, mode, stats);
+        return result;
+    }
+
+    auto params = this->params;
+    params.stats = stats;
+
+    return start_super_reconciliation(tree, this->ordered, params);
+}
+
+tree<Event> ReconciliationEngine::update(
+    tree<Event>& tree,
+    const std::vector<::tree<Event>::iterator>& edited,
+    ReconciliationStats* stats)
+{
+    if (this->started == Mode::Unordered)
+    {
+        return update_unordered_super_reconciliation(
+            tree, this->unordered, edited, stats, this->params.jobs);
+    }
+
+    if (this->started == Mode::Beam || this->started == Mode::Search)
+    {
+        auto result = tree;
+        this->reconcile(result, this->started, stats);
+        return result;
+    }
+
+    auto params = this->params;
+    params.stats = stats;
+
+    return update_super_reconciliation(tree, this->ordered, edited, params);
+}
+
+const SuperReconciliationParams&
+ReconciliationEngine::getParams() const noexcept
+{
+    return this->params;
+}
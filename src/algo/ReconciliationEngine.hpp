@@ -0,0 +1,123 @@
+#ifndef ALGO_RECONCILIATION_ENGINE_HPP
+#define ALGO_RECONCILIATION_ENGINE_HPP
+
+#include "../model/Event.hpp"
+#include "beam_super_reconciliation.hpp"
+#include "search_super_reconciliation.hpp"
+#include "super_reconciliation.hpp"
+#include "unordered_super_reconciliation.hpp"
+#include <tree.hh>
+#include <vector>
+
+/**
+ * Reusable entry point for computing super-reconciliations of many trees.
+ *
+ * An engine owns the workspaces of both algorithms, so that reconciling a
+ * sequence of trees reuses the same buffers instead of allocating them
+ * anew for each tree. Once the buffers have grown to the size of the
+ * largest tree, each call only allocates for the nodes and syntenies that
+ * it adds to the reconciled tree. An engine is not thread-safe: concurrent
+ * computations need an engine each.
+ */
+class ReconciliationEngine
+{
+public:
+    /**
+     * Algorithms that an engine can use.
+     */
+    enum class Mode
+    {
+        // Ordered Super-Reconciliation (see super_reconciliation)
+        Ordered,
+
+        // Unordered Super-Reconciliation (see unordered_super_reconciliation)
+        Unordered,
+
+        // Approximate ordered Super-Reconciliation with a bounded number of
+        // candidates per node (see beam_super_reconciliation)
+        Beam,
+
+        // Ordered Super-Reconciliation under the best ancestral order (see
+        // search_super_reconciliation)
+        Search,
+    };
+
+    /**
+     * Create an engine.
+     *
+     * @param [params] Parameters of the ordered and approximate
+     * computations. The unordered computation only uses the number of
+     * threads.
+     */
+    explicit ReconciliationEngine(
+        const SuperReconciliationParams& = SuperReconciliationParams{});
+
+    /**
+     * Compute the super-reconciliation of a tree in place.
+     *
+     * @param tree Synteny tree to reconcile (see super_reconciliation).
+     * @param [mode] Algorithm to use.
+     * @param [stats] If not null, filled with statistics about the
+     * computation.
+     *
+     * @throws If the tree is improperly labeled or, in ordered mode, if the
+     * order is not consistent.
+     */
+    void reconcile(
+        tree<Event>&,
+        Mode = Mode::Ordered,
+        ReconciliationStats* = nullptr);
+
+    /**
+     * Compute the super-reconciliation of a tree so that it can be updated
+     * after local edits (see start_super_reconciliation and
+     * start_unordered_super_reconciliation). Computing another tree with the
+     * same engine and mode discards the kept state. The approximate
+     * algorithm and the order search keep no state, so their updates
+     * compute the whole tree again.
+     *
+     * @param tree Synteny tree to reconcile, which is not modified.
+     * @param [mode] Algorithm to use.
+     * @param [stats] If not null, filled with statistics about the
+     * computation.
+     * @return Reconciled copy of the tree.
+     *
+     * @throws If the tree is improperly labeled or, in ordered mode, if the
+     * order is not consistent.
+     */
+    tree<Event> start(
+        tree<Event>&,
+        Mode = Mode::Ordered,
+        ReconciliationStats* = nullptr);
+
+    /**
+     * Update the last super-reconciliation started with `start` after some
+     * nodes of its tree were edited in place, using the same algorithm.
+     *
+     * @param tree Tree that was passed to `start`.
+     * @param edited Nodes of the tree that were edited.
+     * @param [stats] If not null, filled with statistics about the
+     * computation.
+     * @return Reconciled copy of the edited tree.
+     *
+     * @throws If the tree is improperly labeled or, in ordered mode, if the
+     * order is not consistent.
+     */
+    tree<Event> update(
+        tree<Event>&,
+        const std::vector<tree<Event>::iterator>& edited,
+        ReconciliationStats* = nullptr);
+
+    /**
+     * Get the parameters of the ordered and approximate computations.
+     */
+    const SuperReconciliationParams& getParams() const noexcept;
+
+private:
+    SuperReconciliationParams params;
+    Mode started = Mode::Ordered;
+    SuperReconciliationWorkspace ordered;
+    UnorderedSuperReconciliationWorkspace unordered;
+};
+
+#endif // ALGO_RECONCILIATION_ENGINE_HPP
@@ -0,0 +1,292 @@
+#include "ReconciliationEngine.hpp"
+#include "erase.hpp"
+#include "simulate.hpp"
+#include "super_reconciliation.hpp"
+#include "unordered_super_reconciliation.hpp"
+#include "../io/nhx.hpp"
+#include "../model/Event.hpp"
+#include <catch.hpp>
+#include <random>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+TEST_CASE("Reconciliation engine")
+{
+    using Mode = ReconciliationEngine::Mode;
+
+    SECTION("Reusing an engine yields the same results as fresh calls")
+    {
+        std::mt19937 prng{42};
+        ReconciliationEngine engine;
+
+        // Alternate between trees of different sizes and between modes, so
+        // that buffers are both grown and reused with leftover contents
+        for (int sample = 0; sample < 30; ++sample)
+        {
+            SimulationParams params;
+            params.base = Synteny::generateDummy(3 + sample % 5);
+            params.depth = 2 + (sample * 7) % 5;
+
+            auto input_tree = simulate_evolution(prng, params);
+            erase_tree(input_tree, std::begin(input_tree));
+
+            auto expected_tree = input_tree;
+            auto engine_tree = input_tree;
+
+            if (sample % 3 == 0)
+            {
+                unordered_super_reconciliation(expected_tree);
+                engine.reconcile(engine_tree, Mode::Unordered);
+            }
+            else
+            {
+                super_reconciliation(expected_tree);
+                engine.reconcile(engine_tree, Mode::Ordered);
+            }
+
+            REQUIRE(stringify_nhx_tree(engine_tree)
+                == stringify_nhx_tree(expected_tree));
+        }
+    }
+
+    SECTION("An engine can still be used after a failed computation")
+    {
+        ReconciliationEngine engine;
+
+        auto invalid_tree = parse_nhx_tree<Event>(
+            "(\"b a\",a)\"a b\"[&&NHX:event=speciation];");
+        REQUIRE_THROWS_AS(
+            engine.reconcile(invalid_tree),
+            std::invalid_argument);
+
+        auto input = "((\"a b\",a)[&&NHX:event=duplication],\"b a\")"
+            "\"a b a b\"[&&NHX:event=speciation];";
+        auto expected_tree = parse_nhx_tree<Event>(input);
+        auto engine_tree = expected_tree;
+
+        super_reconciliation(expected_tree);
+        engine.reconcile(engine_tree);
+
+        REQUIRE(stringify_nhx_tree(engine_tree)
+            == stringify_nhx_tree(expected_tree));
+    }
+
+    SECTION("Tables cached between trees yield the same results")
+    {
+        SuperReconciliationParams reference_params;
+        reference_params.share_subtrees = false;
+
+        // A small cache fills up quickly and is mostly cleared, while a
+        // large cache is only cleared when the ancestral synteny changes or,
+        // with few classes allowed, when the classes of subtrees overflow
+        std::vector<std::pair<std::size_t, std::size_t>> limits{
+            {64, 1 << 20}, {1 << 20, 1 << 20}, {1 << 20, 16}};
+
+        for (const auto& limit : limits)
+        {
+            SuperReconciliationParams params;
+            params.cache_size = limit.first;
+            params.cache_classes = limit.second;
+            ReconciliationEngine engine{params};
+            std::mt19937 prng{11};
+
+            for (int sample = 0; sample < 40; ++sample)
+            {
+                SimulationParams sim_params;
+                sim_params.base = Synteny::generateDummy(
+                    sample < 30 ? 5 : 6);
+                sim_params.depth = 3 + sample % 4;
+
+                auto input_tree = simulate_evolution(prng, sim_params);
+                erase_tree(input_tree, std::begin(input_tree));
+
+                auto expected_tree = input_tree;
+                auto engine_tree = input_tree;
+
+                super_reconciliation(expected_tree, reference_params);
+                engine.reconcile(engine_tree);
+
+                REQUIRE(stringify_nhx_tree(engine_tree)
+                    == stringify_nhx_tree(expected_tree));
+            }
+        }
+    }
+
+    SECTION("Updates after local edits yield the same results as fresh calls")
+    {
+        std::mt19937 prng{23};
+        ReconciliationEngine engine;
+
+        for (auto mode : {Mode::Ordered, Mode::Unordered})
+        {
+            for (int sample = 0; sample < 10; ++sample)
+            {
+                SimulationParams sim_params;
+                sim_params.base = Synteny::generateDummy(5);
+                sim_params.depth = 3 + sample % 4;
+
+                if (mode == Mode::Unordered)
+                {
+                    sim_params.p_rearr = 0.5;
+                }
+
+                auto input_tree = simulate_evolution(prng, sim_params);
+                erase_tree(input_tree, std::begin(input_tree));
+                auto result_tree = engine.start(input_tree, mode);
+
+                for (int edit = 0; edit < 5; ++edit)
+                {
+                    auto expected_tree = input_tree;
+
+                    if (mode == Mode::Unordered)
+                    {
+                        unordered_super_reconciliation(expected_tree);
+                    }
+                    else
+                    {
+                        super_reconciliation(expected_tree);
+                    }
+
+                    REQUIRE(stringify_nhx_tree(result_tree)
+                        == stringify_nhx_tree(expected_tree));
+
+                    // Replace the synteny of a leaf with a subsequence of the
+                    // ancestral synteny, or swap the event of an internal node
+                    std::vector<::tree<Event>::iterator> nodes;
+
+                    for (auto it = std::begin(input_tree);
+                            it != std::end(input_tree); ++it)
+                    {
+                        nodes.push_back(it);
+                    }
+
+                    std::uniform_int_distribution<std::size_t> pick{
+                        1, nodes.size() - 1};
+                    auto node = nodes[pick(prng)];
+
+                    if (input_tree.number_of_children(node) == 0)
+                    {
+                        std::bernoulli_distribution keep{0.6};
+                        Synteny synteny;
+
+                        for (const auto& gene : sim_params.base)
+                        {
+                            if (keep(prng))
+                            {
+                                synteny.push_back(gene);
+                            }
+                        }
+
+                        if (synteny.empty())
+                        {
+                            synteny.push_back(*std::begin(sim_params.base));
+                        }
+
+                        node->synteny = synteny;
+                    }
+                    else
+                    {
+                        node->type = node->type == Event::Type::Speciation
+                            ? Event::Type::Duplication
+                            : Event::Type::Speciation;
+                    }
+
+                    result_tree = engine.update(input_tree, {node});
+                }
+            }
+        }
+    }
+
+    SECTION("Updates after a change of shape yield the same results as fresh calls")
+    {
+        std::mt19937 prng{31};
+        ReconciliationEngine engine;
+
+        for (auto mode : {Mode::Ordered, Mode::Unordered})
+        {
+            for (int sample = 0; sample < 10; ++sample)
+            {
+                SimulationParams sim_params;
+                sim_params.base = Synteny::generateDummy(5);
+                sim_params.depth = 4 + sample % 3;
+
+                if (mode == Mode::Unordered)
+                {
+                    sim_params.p_rearr = 0.5;
+                }
+
+                auto input_tree = simulate_evolution(prng, sim_params);
+                erase_tree(input_tree, std::begin(input_tree));
+                engine.start(input_tree, mode);
+
+                // Swap two leaves under different parents, which keeps
+                // the number of nodes but moves them in the tree
+                std::vector<::tree<Event>::iterator> leaves;
+
+                for (auto it = std::begin(input_tree);
+                        it != std::end(input_tree); ++it)
+                {
+                    if (input_tree.number_of_children(it) == 0)
+                    {
+                        leaves.push_back(it);
+                    }
+                }
+
+                auto one = leaves.front();
+                auto two = leaves.back();
+
+                if (one.node->parent == two.node->parent)
+                {
+                    continue;
+                }
+
+                input_tree.swap(one, two);
+                auto result_tree = engine.update(input_tree, {one, two});
+                auto expected_tree = input_tree;
+
+                if (mode == Mode::Unordered)
+                {
+                    unordered_super_reconciliation(expected_tree);
+                }
+                else
+                {
+                    super_reconciliation(expected_tree);
+                }
+
+                REQUIRE(stringify_nhx_tree(result_tree)
+                    == stringify_nhx_tree(expected_tree));
+            }
+        }
+    }
+
+    SECTION("Parameters are forwarded to the ordered algorithm")
+    {
+        SuperReconciliationParams params;
+        params.jobs = 4;
+        params.task_size = 1;
+
+        ReconciliationEngine engine{params};
+        REQUIRE(engine.getParams().jobs == 4);
+
+        std::mt19937 prng{7};
+        SimulationParams sim_params;
+        sim_params.base = Synteny::generateDummy(6);
+        sim_params.depth = 6;
+
+        for (int sample = 0; sample < 5; ++sample)
+        {
+            auto input_tree = simulate_evolution(prng, sim_params);
+            erase_tree(input_tree, std::begin(input_tree));
+
+            auto expected_tree = input_tree;
+            auto engine_tree = input_tree;
+
+            super_reconciliation(expected_tree);
+            engine.reconcile(engine_tree);
+
+            REQUIRE(stringify_nhx_tree(engine_tree)
+                == stringify_nhx_tree(expected_tree));
+        }
+    }
+}
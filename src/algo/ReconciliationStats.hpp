@@ -0,0 +1,72 @@
+#ifndef ALGO_RECONCILIATION_STATS_HPP
+#define ALGO_RECONCILIATION_STATS_HPP
+
+#include <cstddef>
+#include <vector>
+
+/**
+ * Statistics about the work done by a super-reconciliation, for estimating
+ * the cost of similar computations.
+ */
+struct ReconciliationStats
+{
+    /**
+     * Number of candidate syntenies evaluated for each node of the input
+     * tree, in postfix order. Only filled by the ordered algorithm.
+     */
+    std::vector<std::size_t> candidates;
+
+    /**
+     * Number of candidate syntenies with a finite cost for each node of
+     * the input tree, in postfix order. Only filled by the ordered
+     * algorithm.
+     */
+    std::vector<std::size_t> finite_candidates;
+
+    /**
+     * Number of nodes whose candidates were not evaluated because they
+     * were taken from an identical subtree, either from the same tree or
+     * from a previous computation. Their entries in the previous vectors
+     * are zero. Only filled by the ordered algorithm.
+     */
+    std::size_t shared_nodes = 0;
+
+    /**
+     * Number of bytes of child assignations moved to a spill file (see
+     * `SuperReconciliationParams::spill_directory`). Only filled by the
+     * ordered algorithm.
+     */
+    std::size_t spilled_bytes = 0;
+
+    /**
+     * Number of loss nodes inserted in the tree.
+     */
+    std::size_t inserted_losses = 0;
+
+    /**
+     * Duplication-loss score of the resulting tree (see `get_dl_score`),
+     * counted while the tree is labeled instead of in a separate pass.
+     */
+    unsigned dl_score = 0;
+
+    /**
+     * Lower bound on the duplication-loss score of any valid labeling of
+     * the tree. Only filled by the approximate ordered algorithm.
+     */
+    unsigned lower_bound = 0;
+
+    /**
+     * Number of complete ancestral orders solved with the exact algorithm.
+     * Only filled by the search over ancestral orders.
+     */
+    std::size_t solved_orders = 0;
+
+    /**
+     * Number of prefixes of ancestral orders abandoned because none of
+     * their completions could improve the result. Only filled by the search
+     * over ancestral orders.
+     */
+    std::size_t pruned_orders = 0;
+};
+
+#endif // ALGO_RECONCILIATION_STATS_HPP
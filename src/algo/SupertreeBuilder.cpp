@@ -0,0 +1,615 @@
+#include "SupertreeBuilder.hpp"
+#include "../io/nhx.hpp"
+#include <algorithm>
+#include <numeric>
+#include <stdexcept>
+#include <utility>
+
+constexpr std::size_t SupertreeBuilder::none;
+
+namespace
+{
+const char* FAMILY_KEY = "family";
+const char* EVENT_KEY = "event";
+
+/**
+ * Disjoint sets of consecutive integers, with path halving and union by
+ * size. Sets are only initialized when they are reset, so that a structure
+ * can be reused for any subset of its elements.
+ */
+class DisjointSets
+{
+public:
+    /**
+     * Create a structure for the integers lower than a given bound.
+     */
+    explicit DisjointSets(std::size_t count)
+    : parents(count), sizes(count)
+    {}
+
+    /**
+     * Put an element in a set of its own.
+     */
+    void reset(std::size_t element)
+    {
+        this->parents[element] = element;
+        this->sizes[element] = 1;
+    }
+
+    /**
+     * Find the representative of the set of an element.
+     */
+    std::size_t find(std::size_t element)
+    {
+        while (this->parents[element] != element)
+        {
+            this->parents[element] = this->parents[this->parents[element]];
+            element = this->parents[element];
+        }
+
+        return element;
+    }
+
+    /**
+     * Merge the sets of two elements.
+     */
+    void unite(std::size_t first, std::size_t second)
+    {
+        first = this->find(first);
+        second = this->find(second);
+
+        if (first == second)
+        {
+            return;
+        }
+
+        if (this->sizes[first] < this->sizes[second])
+        {
+            std::swap(first, second);
+        }
+
+        this->parents[second] = first;
+        this->sizes[first] += this->sizes[second];
+    }
+
+private:
+    std::vector<std::size_t> parents;
+    std::vector<std::size_t> sizes;
+};
+
+/**
+ * Gene tree whose root was split between two components of a node of the
+ * supertree, so that the lowest common ancestor of these components must
+ * be labeled with the event of that root.
+ */
+struct Edge
+{
+    std::size_t first;
+    std::size_t second;
+    Event::Type type;
+};
+
+/**
+ * Throw the error reported for inconsistent gene trees.
+ */
+[[noreturn]] void fail_inconsistent()
+{
+    throw std::invalid_argument{"The gene trees are not consistent."};
+}
+}
+
+std::size_t SupertreeBuilder::addNode(std::size_t parent)
+{
+    auto index = this->nodes.size();
+
+    if (parent != none)
+    {
+        auto& parent_node = this->nodes[parent];
+
+        if (parent_node.right != none)
+        {
+            throw std::invalid_argument{"Gene tree is not binary."};
+        }
+
+        (parent_node.left == none ? parent_node.left : parent_node.right)
+            = index;
+    }
+
+    this->nodes.emplace_back();
+    this->nodes.back().begin = this->leaves.size();
+    return index;
+}
+
+void SupertreeBuilder::addLeaf(boost::string_ref name)
+{
+    if (name.empty())
+    {
+        throw std::invalid_argument{"Unnamed leaf in gene tree."};
+    }
+
+    this->name_buffer.assign(name.data(), name.size());
+    auto it = this->synteny_indices.find(this->name_buffer);
+    std::size_t synteny;
+
+    if (it == std::end(this->synteny_indices))
+    {
+        synteny = this->syntenies.size();
+        this->synteny_indices.emplace(this->name_buffer, synteny);
+        this->syntenies.emplace_back();
+        this->last_trees.push_back(none);
+    }
+    else
+    {
+        synteny = it->second;
+    }
+
+    auto tree_index = this->families.size();
+
+    if (this->last_trees[synteny] == tree_index)
+    {
+        throw std::invalid_argument{
+            "Synteny '" + this->name_buffer
+            + "' holds two genes of the same family."};
+    }
+
+    this->last_trees[synteny] = tree_index;
+    this->leaves.push_back(synteny);
+    this->nodes.back().end = this->nodes.back().begin + 1;
+}
+
+void SupertreeBuilder::rollBack(
+    std::size_t first_node,
+    std::size_t first_leaf,
+    std::size_t first_synteny)
+{
+    for (auto leaf = first_leaf; leaf < this->leaves.size(); ++leaf)
+    {
+        this->last_trees[this->leaves[leaf]] = none;
+    }
+
+    for (auto it = std::begin(this->synteny_indices);
+            it != std::end(this->synteny_indices);)
+    {
+        if (it->second >= first_synteny)
+        {
+            it = this->synteny_indices.erase(it);
+        }
+        else
+        {
+            ++it;
+        }
+    }
+
+    this->nodes.resize(first_node);
+    this->leaves.resize(first_leaf);
+    this->syntenies.resize(first_synteny);
+    this->last_trees.resize(first_synteny);
+}
+
+void SupertreeBuilder::addGeneTree(boost::string_ref input)
+{
+    auto first_node = this->nodes.size();
+    auto first_leaf = this->leaves.size();
+    auto first_synteny = this->syntenies.size();
+
+    NHXReader reader{input};
+    NHXNodeView view;
+    Gene family;
+
+    // Nodes are added in prefix order, as soon as their subtree starts, so
+    // that the leaves of each subtree are contiguous. Labels are read after
+    // the children of their node
+    std::vector<std::size_t> ancestors;
+    bool is_descending = true;
+
+    try
+    {
+        while (true)
+        {
+            if (is_descending)
+            {
+                auto index = this->addNode(
+                    ancestors.empty() ? none : ancestors.back());
+
+                if (reader.openChildren())
+                {
+                    ancestors.push_back(index);
+                    continue;
+                }
+
+                reader.readNode(view);
+                this->addLeaf(view.name);
+                is_descending = false;
+            }
+            else if (reader.nextChild())
+            {
+                is_descending = true;
+                continue;
+            }
+            else
+            {
+                reader.closeChildren();
+                auto index = ancestors.back();
+                ancestors.pop_back();
+                reader.readNode(view);
+
+                auto& node = this->nodes[index];
+                boost::string_ref event;
+                node.type = Event::Type::Speciation;
+                node.end = this->leaves.size();
+
+                if (node.right == none)
+                {
+                    throw std::invalid_argument{"Unexpected unary node."};
+                }
+
+                if (view.findTag(EVENT_KEY, event) && event != "speciation")
+                {
+                    if (event != "duplication")
+                    {
+                        throw std::invalid_argument{
+                            "Unexpected event '" + event.to_string()
+                            + "' in gene tree."};
+                    }
+
+                    node.type = Event::Type::Duplication;
+                }
+            }
+
+            if (ancestors.empty())
+            {
+                break;
+            }
+        }
+
+        reader.finish();
+
+        // The family is given by the label of the root
+        boost::string_ref family_name;
+
+        if (view.findTag(FAMILY_KEY, family_name))
+        {
+            family = Gene{family_name.to_string()};
+        }
+        else if (this->nodes[first_node].right != none)
+        {
+            family = Gene{view.name.to_string()};
+        }
+
+        if (family.empty())
+        {
+            throw std::invalid_argument{"Missing family name of gene tree."};
+        }
+
+        if (this->family_set.count(family) != 0)
+        {
+            throw std::invalid_argument{
+                "Duplicate gene tree for family '"
+                + family.getName() + "'."};
+        }
+    }
+    catch (...)
+    {
+        this->rollBack(first_node, first_leaf, first_synteny);
+        throw;
+    }
+
+    for (auto leaf = first_leaf; leaf < this->leaves.size(); ++leaf)
+    {
+        this->syntenies[this->leaves[leaf]].push_back(family);
+    }
+
+    this->roots.push_back(first_node);
+    this->families.push_back(family);
+    this->family_set.insert(family);
+}
+
+std::size_t SupertreeBuilder::size() const noexcept
+{
+    return this->families.size();
+}
+
+::tree<Event> SupertreeBuilder::build() const
+{
+    ::tree<Event> result;
+
+    if (this->families.empty())
+    {
+        return result;
+    }
+
+    auto count = this->syntenies.size();
+    auto cluster_size = [this](std::size_t node)
+    {
+        return this->nodes[node].end - this->nodes[node].begin;
+    };
+
+    // Syntenies below each node of the supertree being built, which are
+    // partitioned in place between the children of the node
+    std::vector<std::size_t> order(count);
+    std::iota(std::begin(order), std::end(order), std::size_t{0});
+    std::vector<std::size_t> scratch(count);
+
+    // Connected components of the syntenies below the current node, and
+    // groups of components joined below the same child
+    DisjointSets synteny_sets{count};
+    std::vector<std::size_t> representatives(count);
+    std::vector<std::size_t> components(count);
+    DisjointSets component_sets{count};
+
+    // Node of the supertree to build, range of its syntenies in `order`,
+    // and gene trees restricted to these syntenies, given by their roots.
+    // Gene trees of a single synteny are left out since they constrain
+    // nothing
+    struct Item
+    {
+        ::tree<Event>::iterator node;
+        std::size_t begin;
+        std::size_t end;
+        std::vector<std::size_t> roots;
+    };
+
+    std::vector<Item> items;
+    items.push_back({result.set_head(Event{}), 0, count, {}});
+
+    for (auto root : this->roots)
+    {
+        if (cluster_size(root) > 1)
+        {
+            items.back().roots.push_back(root);
+        }
+    }
+
+    // Node of the supertree that joins a group of components, and edges
+    // between the components of the group
+    struct Group
+    {
+        ::tree<Event>::iterator node;
+        std::vector<std::size_t> components;
+        std::vector<Edge> edges;
+    };
+
+    std::vector<Group> groups;
+
+    while (!items.empty())
+    {
+        auto item = std::move(items.back());
+        items.pop_back();
+
+        if (item.end - item.begin == 1)
+        {
+            item.node->synteny = this->syntenies[order[item.begin]];
+            continue;
+        }
+
+        // Join the syntenies of each cluster below the root of each
+        // restricted gene tree
+        for (auto index = item.begin; index < item.end; ++index)
+        {
+            synteny_sets.reset(order[index]);
+        }
+
+        for (auto root : item.roots)
+        {
+            for (auto child : {this->nodes[root].left, this->nodes[root].right})
+            {
+                for (auto leaf = this->nodes[child].begin + 1;
+                        leaf < this->nodes[child].end;
+                        ++leaf)
+                {
+                    synteny_sets.unite(
+                        this->leaves[leaf - 1], this->leaves[leaf]);
+                }
+            }
+        }
+
+        // Number the components by their first synteny
+        for (auto index = item.begin; index < item.end; ++index)
+        {
+            representatives[order[index]] = none;
+        }
+
+        std::size_t component_count = 0;
+
+        for (auto index = item.begin; index < item.end; ++index)
+        {
+            auto& representative
+                = representatives[synteny_sets.find(order[index])];
+
+            if (representative == none)
+            {
+                representative = component_count++;
+            }
+
+            components[order[index]] = representative;
+        }
+
+        if (component_count == 1)
+        {
+            fail_inconsistent();
+        }
+
+        // Partition the syntenies by component, keeping their order
+        std::vector<std::size_t> offsets(component_count + 1, 0);
+
+        for (auto index = item.begin; index < item.end; ++index)
+        {
+            ++offsets[components[order[index]] + 1];
+        }
+
+        std::partial_sum(
+            std::begin(offsets), std::end(offsets), std::begin(offsets));
+
+        for (auto index = item.begin; index < item.end; ++index)
+        {
+            auto synteny = order[index];
+            scratch[offsets[components[synteny]]++] = synteny;
+        }
+
+        std::copy(
+            std::begin(scratch), std::next(std::begin(scratch),
+                item.end - item.begin),
+            std::next(std::begin(order), item.begin));
+
+        // Restrict the gene trees to each component. A gene tree whose
+        // children fall in two components is split, and the lowest common
+        // ancestor of these components gets the event of its root
+        std::vector<std::vector<std::size_t>> component_roots(
+            component_count);
+        std::vector<Edge> edges;
+
+        for (auto root : item.roots)
+        {
+            const auto& node = this->nodes[root];
+            auto left = components[this->leaves[this->nodes[node.left].begin]];
+            auto right = components[
+                this->leaves[this->nodes[node.right].begin]];
+
+            if (left == right)
+            {
+                component_roots[left].push_back(root);
+            }
+            else
+            {
+                edges.push_back({left, right, node.type});
+
+                if (cluster_size(node.left) > 1)
+                {
+                    component_roots[left].push_back(node.left);
+                }
+
+                if (cluster_size(node.right) > 1)
+                {
+                    component_roots[right].push_back(node.right);
+                }
+            }
+        }
+
+        // Join the components with binary nodes. Under a node labeled with
+        // a given event, components linked by a gene tree root with another
+        // event must stay in the same group, and groups are joined by a
+        // chain of nodes with that event
+        groups.clear();
+        groups.push_back({item.node, {}, std::move(edges)});
+        groups.back().components.resize(component_count);
+        std::iota(
+            std::begin(groups.back().components),
+            std::end(groups.back().components),
+            std::size_t{0});
+
+        while (!groups.empty())
+        {
+            auto group = std::move(groups.back());
+            groups.pop_back();
+
+            if (group.components.size() == 1)
+            {
+                auto component = group.components.front();
+                auto begin = item.begin
+                    + (component == 0 ? 0 : offsets[component - 1]);
+                auto end = item.begin + offsets[component];
+                items.push_back({
+                    group.node, begin, end,
+                    std::move(component_roots[component])});
+                continue;
+            }
+
+            Event::Type type = Event::Type::None;
+            std::size_t subgroup_count = 0;
+
+            for (auto candidate : {
+                    Event::Type::Speciation,
+                    Event::Type::Duplication})
+            {
+                for (auto component : group.components)
+                {
+                    component_sets.reset(component);
+                }
+
+                for (const auto& edge : group.edges)
+                {
+                    if (edge.type != candidate)
+                    {
+                        component_sets.unite(edge.first, edge.second);
+                    }
+                }
+
+                for (auto component : group.components)
+                {
+                    representatives[component] = none;
+                }
+
+                subgroup_count = 0;
+
+                for (auto component : group.components)
+                {
+                    auto& representative = representatives[
+                        component_sets.find(component)];
+
+                    if (representative == none)
+                    {
+                        representative = subgroup_count++;
+                    }
+                }
+
+                if (subgroup_count > 1)
+                {
+                    type = candidate;
+                    break;
+                }
+            }
+
+            if (type == Event::Type::None)
+            {
+                fail_inconsistent();
+            }
+
+            // Create the chain of nodes first, so that the children of each
+            // node keep the order of their components
+            std::vector<Group> subgroups(subgroup_count);
+            auto current = group.node;
+
+            for (std::size_t index = 0; index + 1 < subgroup_count; ++index)
+            {
+                current->type = type;
+                subgroups[index].node = result.append_child(
+                    current, Event{});
+                current = result.append_child(current, Event{});
+            }
+
+            subgroups.back().node = current;
+
+            for (auto component : group.components)
+            {
+                subgroups[representatives[component_sets.find(component)]]
+                    .components.push_back(component);
+            }
+
+            for (const auto& edge : group.edges)
+            {
+                auto first = representatives[component_sets.find(edge.first)];
+                auto second = representatives[
+                    component_sets.find(edge.second)];
+
+                if (first == second)
+                {
+                    subgroups[first].edges.push_back(edge);
+                }
+            }
+
+            for (auto& subgroup : subgroups)
+            {
+                groups.push_back(std::move(subgroup));
+            }
+        }
+    }
+
+    // The root holds all the families, in the order of their gene trees
+    if (result.begin().number_of_children() > 0)
+    {
+        result.begin()->synteny = Synteny{
+            std::cbegin(this->families), std::cend(this->families)};
+    }
+
+    return result;
+}
@@ -0,0 +1,123 @@
+#ifndef ALGO_SUPERTREE_BUILDER_HPP
+#define ALGO_SUPERTREE_BUILDER_HPP
+
+#include "../model/Event.hpp"
+#include "../model/Gene.hpp"
+#include "../model/Synteny.hpp"
+#include <boost/utility/string_ref.hpp>
+#include <cstddef>
+#include <string>
+#include <tree.hh>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+/**
+ * Build the synteny supertree of a set of consistent gene trees, which can
+ * then be super-reconciled.
+ *
+ * Each gene tree holds the genes of one family. Its leaves are named after
+ * the extant syntenies that hold these genes, and its internal nodes are
+ * tagged with the event that happened there (`event=duplication` or
+ * `event=speciation`, which is the default). The family is given by the
+ * `family` tag of the root or, for a root that is not a leaf, by its name.
+ * For example, `(X,(Y,Z)[&&NHX:event=duplication])a;` is the tree of
+ * family `a`, whose genes belong to syntenies `X`, `Y` and `Z`.
+ *
+ * The supertree is the binary synteny tree whose restriction to the leaves
+ * holding each family, after removing unary nodes, is the gene tree of that
+ * family with the same events. Its leaves are labeled with the families
+ * they hold and its root with all the families, in the order in which the
+ * gene trees were added, as expected by `super_reconciliation`.
+ *
+ * Gene trees are stored in a compact form as soon as they are added.
+ */
+class SupertreeBuilder
+{
+public:
+    /**
+     * Add the gene tree of a family.
+     *
+     * The tree is read directly from its NHX representation, without
+     * building an intermediate tree, so that large sets of trees can be
+     * read one at a time.
+     *
+     * @param tree Gene tree to add, in NHX format (see `parse_nhx_tree`).
+     * @throws std::invalid_argument If the tree is not valid NHX, is not
+     * binary, has no family name, has a family that was already added, has
+     * an unnamed leaf, holds two genes in the same synteny, or has an
+     * unexpected event. The builder is left unchanged.
+     */
+    void addGeneTree(boost::string_ref tree);
+
+    /**
+     * Get the number of gene trees added so far.
+     */
+    std::size_t size() const noexcept;
+
+    /**
+     * Build the supertree of all the gene trees added so far.
+     *
+     * The supertree is built with the BUILD algorithm (Aho et al., 1981):
+     * the syntenies below each node are split into the connected components
+     * of the clusters of the gene trees restricted to them, and components
+     * are joined by binary nodes whose events agree with the gene trees.
+     * Clusters are ranges of syntenies of the compact gene trees, so that
+     * each node takes a time linear in the size of the gene trees that it
+     * splits, and the whole construction a time proportional to the size of
+     * the gene trees times the depth of the supertree.
+     *
+     * @return Supertree of the gene trees, or an empty tree if no tree was
+     * added.
+     * @throws std::invalid_argument If the gene trees are not consistent.
+     */
+    ::tree<Event> build() const;
+
+private:
+    // Marker for a missing node
+    static constexpr std::size_t none = static_cast<std::size_t>(-1);
+
+    // Node of a compact gene tree. The syntenies of the leaves of its
+    // subtree span a range of `leaves`
+    struct Node
+    {
+        std::size_t left = none;
+        std::size_t right = none;
+        std::size_t begin = 0;
+        std::size_t end = 0;
+        Event::Type type = Event::Type::None;
+    };
+
+    // Nodes of all the gene trees, each tree after the other in prefix
+    // order, and root of each tree
+    std::vector<Node> nodes;
+    std::vector<std::size_t> roots;
+
+    // Index of the synteny of each leaf of the gene trees
+    std::vector<std::size_t> leaves;
+
+    // Index of each synteny by name, families held by each synteny, and
+    // last gene tree in which each synteny was seen
+    std::unordered_map<std::string, std::size_t> synteny_indices;
+    std::vector<Synteny> syntenies;
+    std::vector<std::size_t> last_trees;
+
+    // Family of each gene tree
+    std::vector<Gene> families;
+    std::unordered_set<Gene> family_set;
+
+    // Buffer for looking up synteny names
+    std::string name_buffer;
+
+    // Add a node below a given parent, or a root if the parent is `none`
+    std::size_t addNode(std::size_t parent);
+
+    // Add the synteny of a leaf of the gene tree being added
+    void addLeaf(boost::string_ref name);
+
+    // Remove the nodes and syntenies of a gene tree that was not added
+    void rollBack(std::size_t first_node, std::size_t first_leaf,
+        std::size_t first_synteny);
+};
+
+#endif // ALGO_SUPERTREE_BUILDER_HPP
@@ -0,0 +1,327 @@
+#include "SupertreeBuilder.hpp"
+#include "erase.hpp"
+#include "simulate.hpp"
+#include "../io/nhx.hpp"
+#include "../model/Event.hpp"
+#include <algorithm>
+#include <catch.hpp>
+#include <map>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace
+{
+::tree<Event> build_from(const std::vector<std::string>& gene_trees)
+{
+    SupertreeBuilder builder;
+
+    for (const auto& gene_tree : gene_trees)
+    {
+        builder.addGeneTree(gene_tree);
+    }
+
+    return builder.build();
+}
+
+std::string normalize(const std::string& event_tree)
+{
+    return stringify_nhx_tree(parse_nhx_tree<Event>(event_tree));
+}
+
+// Sorted names of the families of a synteny
+std::string get_label(const Synteny& synteny)
+{
+    std::vector<std::string> names;
+
+    for (const auto& gene : synteny)
+    {
+        names.push_back(gene.getName());
+    }
+
+    std::sort(std::begin(names), std::end(names));
+    std::string result;
+
+    for (const auto& name : names)
+    {
+        result += name + " ";
+    }
+
+    return result;
+}
+
+std::string join_sorted(std::vector<std::string> children, char event)
+{
+    std::sort(std::begin(children), std::end(children));
+    return "(" + children[0] + "," + children[1] + ")" + event;
+}
+
+bool contains(const ::tree<Event>::iterator& node, const Gene& family)
+{
+    if (node.number_of_children() == 0)
+    {
+        return std::find(
+            std::cbegin(node->synteny), std::cend(node->synteny), family)
+            != std::cend(node->synteny);
+    }
+
+    for (auto child = node.begin(); child != node.end(); ++child)
+    {
+        if (contains(child, family))
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+// Restriction of a synteny tree to the leaves that hold a family, without
+// unary nodes, in a canonical form
+std::string restrict(const ::tree<Event>::iterator& node, const Gene& family)
+{
+    if (node.number_of_children() == 0)
+    {
+        return contains(node, family) ? get_label(node->synteny) : "";
+    }
+
+    std::vector<std::string> children;
+
+    for (auto child = node.begin(); child != node.end(); ++child)
+    {
+        auto restricted = restrict(child, family);
+
+        if (!restricted.empty())
+        {
+            children.push_back(restricted);
+        }
+    }
+
+    if (children.size() < 2)
+    {
+        return children.empty() ? "" : children[0];
+    }
+
+    return join_sorted(
+        children, node->type == Event::Type::Duplication ? 'D' : 'S');
+}
+
+// Canonical form of a gene tree, each leaf being labeled by the families
+// of its synteny
+std::string canonicalize(
+    const ::tree<TaggedNode>::iterator& node,
+    const std::map<std::string, std::string>& labels)
+{
+    if (node.number_of_children() == 0)
+    {
+        return labels.at(node->name);
+    }
+
+    std::vector<std::string> children;
+
+    for (auto child = node.begin(); child != node.end(); ++child)
+    {
+        children.push_back(canonicalize(child, labels));
+    }
+
+    return join_sorted(
+        children, node->tags.count("event")
+            && node->tags.at("event") == "duplication" ? 'D' : 'S');
+}
+
+// Gene tree of a family in a synteny tree, whose leaves are named after
+// their index in the synteny tree
+void add_gene_tree(
+    const ::tree<Event>::iterator& node,
+    const Gene& family,
+    const std::map<const void*, std::string>& names,
+    ::tree<TaggedNode>& result,
+    ::tree<TaggedNode>::iterator parent)
+{
+    auto add = [&result, &parent](const TaggedNode& tagged)
+    {
+        return result.empty()
+            ? result.set_head(tagged)
+            : result.append_child(parent, tagged);
+    };
+
+    if (node.number_of_children() == 0)
+    {
+        TaggedNode leaf;
+        leaf.name = names.at(node.node);
+        add(leaf);
+        return;
+    }
+
+    std::vector<::tree<Event>::iterator> children;
+
+    for (auto child = node.begin(); child != node.end(); ++child)
+    {
+        if (contains(child, family))
+        {
+            children.push_back(child);
+        }
+    }
+
+    if (children.size() == 1)
+    {
+        add_gene_tree(children[0], family, names, result, parent);
+    }
+    else if (children.size() == 2)
+    {
+        TaggedNode internal;
+        internal.tags["event"] = node->type == Event::Type::Duplication
+            ? "duplication"
+            : "speciation";
+        auto added = add(internal);
+
+        for (const auto& child : children)
+        {
+            add_gene_tree(child, family, names, result, added);
+        }
+    }
+}
+}
+
+TEST_CASE("Supertree of gene trees")
+{
+    // Gene trees that resolve every node
+    REQUIRE(stringify_nhx_tree(build_from({
+        "((X,Y),Z)a;",
+        "(Y,Z)b;"
+    })) == normalize(
+        "((\"a\",\"a b\")[&&NHX:event=speciation],\"a b\")\"a b\""
+        "[&&NHX:event=speciation];"));
+
+    // Components joined by a root with another event are kept together
+    REQUIRE(stringify_nhx_tree(build_from({
+        "(X,Y)a;",
+        "(Y,Z)[&&NHX:event=duplication:family=b];"
+    })) == normalize(
+        "(\"a\",(\"a b\",\"b\")[&&NHX:event=duplication])"
+        "\"a b\"[&&NHX:event=speciation];"));
+
+    // A single synteny
+    REQUIRE(stringify_nhx_tree(build_from({
+        "X[&&NHX:family=a];",
+        "X[&&NHX:family=b];"
+    })) == normalize("\"a b\";"));
+
+    REQUIRE(build_from({}).empty());
+}
+
+TEST_CASE("Supertree of simulated gene trees")
+{
+    std::mt19937 prng{29};
+    SimulationParams params;
+    params.base = Synteny::generateDummy(8);
+    params.depth = 6;
+    params.p_loss = 0.4;
+
+    for (int sample = 0; sample < 30; ++sample)
+    {
+        auto synteny_tree = get_erased_tree(simulate_evolution(prng, params));
+
+        // Name each non-empty leaf
+        std::map<const void*, std::string> names;
+        std::map<std::string, std::string> labels;
+
+        for (auto node = synteny_tree.begin();
+                node != synteny_tree.end();
+                ++node)
+        {
+            if (node.number_of_children() == 0 && !node->synteny.empty())
+            {
+                auto name = "s" + std::to_string(names.size());
+                names[node.node] = name;
+                labels[name] = get_label(node->synteny);
+            }
+        }
+
+        SupertreeBuilder builder;
+        std::vector<std::string> expected;
+
+        for (const auto& family : params.base)
+        {
+            if (!contains(synteny_tree.begin(), family))
+            {
+                continue;
+            }
+
+            ::tree<TaggedNode> gene_tree;
+            add_gene_tree(
+                synteny_tree.begin(), family, names,
+                gene_tree, gene_tree.end());
+            gene_tree.begin()->tags["family"] = family.getName();
+            builder.addGeneTree(stringify_nhx_tree(gene_tree));
+            expected.push_back(canonicalize(gene_tree.begin(), labels));
+        }
+
+        auto supertree = builder.build();
+        std::size_t leaf_count = 0;
+
+        for (auto node = supertree.begin(); node != supertree.end(); ++node)
+        {
+            REQUIRE((node.number_of_children() == 0
+                || node.number_of_children() == 2));
+            leaf_count += node.number_of_children() == 0;
+        }
+
+        REQUIRE(leaf_count == names.size());
+
+        std::size_t index = 0;
+
+        for (const auto& family : params.base)
+        {
+            if (contains(synteny_tree.begin(), family))
+            {
+                REQUIRE(restrict(supertree.begin(), family)
+                    == expected[index]);
+                ++index;
+            }
+        }
+    }
+}
+
+TEST_CASE("Supertree of inconsistent gene trees")
+{
+    // Incompatible clusters
+    REQUIRE_THROWS_AS(
+        build_from({"((X,Y),Z)a;", "((X,Z),Y)b;"}),
+        std::invalid_argument);
+
+    // Conflicting events
+    REQUIRE_THROWS_AS(
+        build_from({"(X,Y)a;", "(X,Y)b[&&NHX:event=duplication];"}),
+        std::invalid_argument);
+
+    SupertreeBuilder builder;
+    builder.addGeneTree("(X,Y)a;");
+
+    REQUIRE_THROWS_AS(
+        builder.addGeneTree("(X,Y,Z)b;"),
+        std::invalid_argument);
+    REQUIRE_THROWS_AS(
+        builder.addGeneTree("(W,(V,W))b;"),
+        std::invalid_argument);
+    REQUIRE_THROWS_AS(
+        builder.addGeneTree("((X),Y)b;"),
+        std::invalid_argument);
+    REQUIRE_THROWS_AS(
+        builder.addGeneTree("(X,(Y,Z)b;"),
+        std::invalid_argument);
+    REQUIRE_THROWS_AS(
+        builder.addGeneTree("(X,Y);"),
+        std::invalid_argument);
+    REQUIRE_THROWS_AS(
+        builder.addGeneTree("(X,Y)a;"),
+        std::invalid_argument);
+    REQUIRE_THROWS_AS(
+        builder.addGeneTree("(X,Y)b[&&NHX:event=loss];"),
+        std::invalid_argument);
+
+    // Rejected trees are forgotten
+    REQUIRE(builder.size() == 1);
+    REQUIRE(stringify_nhx_tree(builder.build()) == normalize(
+        "(a,a)a[&&NHX:event=speciation];"));
+}
@@ -0,0 +1,841 @@
+#include "beam_super_reconciliation.hpp"
+#include "losses.hpp"
+#include "../model/Event.hpp"
+#include "../util/SaturatingNumber.hpp"
+#include "../util/bits.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <numeric>
+#include <sstream>
+#include <stdexcept>
+#include <tree.hh>
+#include <vector>
+
+namespace
+{
+// Word of a set of positions, in which each bit stands for a position of
+// the ancestral synteny
+using Word = std::uint64_t;
+constexpr std::size_t word_width = 64;
+
+// Set of positions of the ancestral synteny, which encodes one of its
+// subsequences like a mask does, but for syntenies of any length. Position
+// i is stored in bit i % word_width of word i / word_width
+using Positions = std::vector<Word>;
+
+// Cost of a candidate, which is infinite if the candidate is not valid
+// (see `Cost` in super_reconciliation.cpp)
+using Cost = SaturatingNumber<std::uint32_t>;
+
+/**
+ * Check whether a set of positions is included in another one.
+ */
+bool is_subset(const Positions& subset, const Positions& set)
+{
+    for (std::size_t word = 0; word < set.size(); ++word)
+    {
+        if ((subset[word] & ~set[word]) != 0)
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/**
+ * Count the positions of a set.
+ */
+std::size_t count_positions(const Positions& set)
+{
+    std::size_t result = 0;
+
+    for (auto word : set)
+    {
+        result += popcount(word);
+    }
+
+    return result;
+}
+
+/**
+ * Compute the minimum number of segmental losses required to turn a
+ * subsequence of the ancestral synteny into one of its own subsequences
+ * (see `distance` in Mask.hpp, which this extends to sets of positions).
+ *
+ * @param parent Positions of the source subsequence.
+ * @param child Positions of the target subsequence.
+ * @param substring When set to true, does not count any initial or
+ * terminal segmental loss.
+ * @return Minimum number of segmental losses.
+ */
+int positions_distance(
+    const Positions& parent,
+    const Positions& child,
+    bool substring)
+{
+    int result = 0;
+    bool is_empty = true;
+    bool is_first_lost = false;
+    bool is_last_lost = false;
+    bool is_all_lost = true;
+
+    for (std::size_t word = 0; word < parent.size(); ++word)
+    {
+        for (auto rest = parent[word]; rest != 0; rest &= rest - 1)
+        {
+            bool is_lost = (child[word] & lowest_bit(rest)) == 0;
+
+            // A lost segment starts at each lost position that does not
+            // follow another lost position
+            if (is_lost && (is_empty || !is_last_lost))
+            {
+                ++result;
+            }
+
+            if (is_empty)
+            {
+                is_first_lost = is_lost;
+                is_empty = false;
+            }
+
+            is_all_lost = is_all_lost && is_lost;
+            is_last_lost = is_lost;
+        }
+    }
+
+    if (substring && !is_empty)
+    {
+        // Discount the initial and terminal lost segments, making sure not
+        // to discount the same segment twice if everything is lost
+        result -= is_first_lost;
+        result -= is_last_lost;
+        result += is_all_lost;
+    }
+
+    return result;
+}
+
+/**
+ * Spell out the subsequence of a synteny that is encoded by a set of
+ * positions.
+ */
+Synteny get_subsequence(
+    const std::vector<Gene>& genes,
+    const Positions& positions)
+{
+    Synteny result;
+
+    for (std::size_t word = 0; word < positions.size(); ++word)
+    {
+        for (auto rest = positions[word]; rest != 0; rest &= rest - 1)
+        {
+            auto bit = popcount(lowest_bit(rest) - 1);
+            result.push_back(genes[word * word_width + bit]);
+        }
+    }
+
+    return result;
+}
+
+/**
+ * Find the leftmost or the rightmost extraction of a target subsequence
+ * from a base synteny.
+ *
+ * @param base Base synteny.
+ * @param genes Target subsequence.
+ * @param from_end Whether to find the rightmost extraction.
+ * @param [result] Set to the positions of the extraction.
+ * @return True if and only if the target is a subsequence of the base.
+ */
+bool find_extraction(
+    const std::vector<Gene>& base,
+    const std::vector<Gene>& genes,
+    bool from_end,
+    Positions& result)
+{
+    auto n = base.size();
+    auto m = genes.size();
+    std::fill(std::begin(result), std::end(result), 0);
+    std::size_t matched = 0;
+
+    for (std::size_t step = 0; step < n && matched < m; ++step)
+    {
+        auto i = from_end ? n - 1 - step : step;
+        auto j = from_end ? m - 1 - matched : matched;
+
+        if (base[i] == genes[j])
+        {
+            result[i / word_width] |= Word{1} << (i % word_width);
+            ++matched;
+        }
+    }
+
+    return matched == m;
+}
+
+// Candidate synteny of a node along with its cost and, for internal
+// nodes, its optimal child assignations among the candidates of the
+// children (see `Choice` in super_reconciliation.cpp)
+struct Candidate
+{
+    Positions positions;
+    std::size_t size = 0;
+    Cost cost;
+
+    std::size_t index_left = 0;
+    std::size_t index_right = 0;
+    bool partial_left = false;
+    bool partial_right = false;
+};
+
+/**
+ * Find the best assignation of a child among its candidates, given the
+ * candidate synteny of its parent.
+ *
+ * @param parent Candidate synteny of the parent.
+ * @param child Child node.
+ * @param beam Candidates of the child.
+ * @param substring Whether the child is partially duplicated or not.
+ * @param [best_index] Set to the index of the best candidate of the child.
+ * @return Cost of the best candidate, including the losses from the parent,
+ * or an infinite cost if no candidate of the child fits in the parent.
+ */
+Cost find_best_child(
+    const Positions& parent,
+    const Event& child,
+    const std::vector<Candidate>& beam,
+    bool substring,
+    std::size_t& best_index)
+{
+    auto best_cost = Cost::positiveInfinity();
+
+    for (std::size_t index = 0; index < beam.size(); ++index)
+    {
+        if (!is_subset(beam[index].positions, parent))
+        {
+            continue;
+        }
+
+        // The distance to a child loss node is always zero, because it
+        // encodes a loss **from** this node’s synteny
+        auto cost = beam[index].cost + Cost{static_cast<std::uint32_t>(
+            child.type == Event::Type::Loss
+                ? 0
+                : positions_distance(
+                    parent, beam[index].positions, substring))};
+
+        if (cost < best_cost)
+        {
+            best_cost = cost;
+            best_index = index;
+        }
+    }
+
+    return best_cost;
+}
+
+/**
+ * Compute the cost and the child assignations of a candidate of an internal
+ * node, using the same rules as the exact algorithm.
+ *
+ * @param node Internal node.
+ * @param left Left child of the node.
+ * @param left_beam Candidates of the left child.
+ * @param right Right child of the node.
+ * @param right_beam Candidates of the right child.
+ * @param candidate Candidate to evaluate.
+ */
+void evaluate_candidate(
+    const Event& node,
+    const Event& left, const std::vector<Candidate>& left_beam,
+    const Event& right, const std::vector<Candidate>& right_beam,
+    Candidate& candidate)
+{
+    std::size_t total_left = 0, partial_left = 0;
+    std::size_t total_right = 0, partial_right = 0;
+
+    auto total_left_cost = find_best_child(
+        candidate.positions, left, left_beam, false, total_left);
+    auto total_right_cost = find_best_child(
+        candidate.positions, right, right_beam, false, total_right);
+
+    auto total_total = total_left_cost + total_right_cost;
+
+    if (node.type == Event::Type::Speciation)
+    {
+        candidate.cost = total_total;
+        candidate.index_left = total_left;
+        candidate.index_right = total_right;
+        return;
+    }
+
+    auto partial_left_cost = find_best_child(
+        candidate.positions, left, left_beam, true, partial_left);
+    auto partial_right_cost = find_best_child(
+        candidate.positions, right, right_beam, true, partial_right);
+
+    auto total_partial = total_left_cost + partial_right_cost;
+    auto partial_total = partial_left_cost + total_right_cost;
+
+    // At duplication nodes, consider the most advantageous scenario between
+    // a full duplication, a segmental duplication on the left or a segmental
+    // duplication on the right
+    if (total_total <= total_partial && total_total <= partial_total)
+    {
+        candidate.cost = Cost{1} + total_total;
+        candidate.index_left = total_left;
+        candidate.index_right = total_right;
+    }
+    else if (total_partial <= total_total && total_partial <= partial_total)
+    {
+        candidate.cost = Cost{1} + total_partial;
+        candidate.index_left = total_left;
+        candidate.index_right = partial_right;
+        candidate.partial_right = true;
+    }
+    else
+    {
+        candidate.cost = Cost{1} + partial_total;
+        candidate.index_left = partial_left;
+        candidate.partial_left = true;
+        candidate.index_right = total_right;
+    }
+}
+
+/**
+ * Nodes of an event tree indexed in postfix order, with the indices of
+ * the children and of the parent of each node.
+ */
+struct IndexedTree
+{
+    std::vector<::tree<Event>::iterator> nodes;
+    std::vector<std::size_t> lefts;
+    std::vector<std::size_t> rights;
+    std::vector<std::size_t> parents;
+
+    static constexpr std::size_t none = static_cast<std::size_t>(-1);
+
+    bool isLeaf(std::size_t index) const
+    {
+        return this->lefts[index] == none;
+    }
+};
+
+constexpr std::size_t IndexedTree::none;
+
+/**
+ * Index the nodes of a tree in postfix order.
+ *
+ * @throws std::invalid_argument If the tree contains a node that has
+ * neither zero nor two children, or an internal node that is neither a
+ * speciation nor a duplication.
+ */
+IndexedTree index_tree(::tree<Event>& tree)
+{
+    IndexedTree result;
+    std::vector<std::size_t> pending;
+
+    for (auto it = tree.begin_post(); it != tree.end_post(); ++it)
+    {
+        auto index = result.nodes.size();
+        auto children_count = tree.number_of_children(it);
+
+        if (children_count != 0 && children_count != 2)
+        {
+            std::ostringstream message;
+            message << "There is no valid candidate for the node "
+                << *it << " because it has " << children_count
+                << " children.";
+            throw std::invalid_argument{message.str()};
+        }
+
+        if (children_count == 2 && it->type != Event::Type::Speciation
+                && it->type != Event::Type::Duplication)
+        {
+            std::ostringstream message;
+            message << "Invalid event type on an internal node: "
+                << it->type;
+            throw std::invalid_argument{message.str()};
+        }
+
+        result.nodes.push_back(it);
+        result.parents.push_back(IndexedTree::none);
+
+        if (children_count == 0)
+        {
+            result.lefts.push_back(IndexedTree::none);
+            result.rights.push_back(IndexedTree::none);
+        }
+        else
+        {
+            auto right = pending.back();
+            pending.pop_back();
+            auto left = pending.back();
+            pending.pop_back();
+
+            result.lefts.push_back(left);
+            result.rights.push_back(right);
+            result.parents[left] = result.parents[right] = index;
+        }
+
+        pending.push_back(index);
+    }
+
+    return result;
+}
+
+/**
+ * Compute a lower bound on the duplication-loss score of any valid labeling
+ * of a tree.
+ *
+ * Nodes that have a leaf with a non-empty synteny below them (called
+ * “anchored” here) always get a non-empty synteny, so that they are never
+ * removed by the traceback: each of their duplications is counted, along
+ * with each lost leaf directly below them. In addition, the positions of
+ * the ancestral synteny that are missing between two consecutive genes of
+ * a leaf can only be removed by losses on the path from the root to that
+ * leaf, one gap per loss, and so can the missing positions at either end
+ * of the leaf if no duplication on that path is segmental. The bound
+ * counts the gaps of the leaf that has the most of them.
+ *
+ * @param indexed Indexed nodes of the tree.
+ * @param ancestral_genes Genes of the ancestral synteny.
+ * @return Lower bound on the duplication-loss score.
+ */
+unsigned get_lower_bound(
+    const IndexedTree& indexed,
+    const std::vector<Gene>& ancestral_genes)
+{
+    auto node_count = indexed.nodes.size();
+    std::vector<char> is_anchored(node_count, false);
+    unsigned result = 0;
+
+    for (std::size_t index = 0; index < node_count; ++index)
+    {
+        const auto& node = *indexed.nodes[index];
+
+        if (indexed.isLeaf(index))
+        {
+            is_anchored[index] = node.type != Event::Type::Loss
+                && !node.synteny.empty();
+            continue;
+        }
+
+        auto left = indexed.lefts[index];
+        auto right = indexed.rights[index];
+        is_anchored[index] = is_anchored[left] || is_anchored[right];
+
+        if (!is_anchored[index])
+        {
+            continue;
+        }
+
+        result += node.type == Event::Type::Duplication;
+
+        for (auto child : {left, right})
+        {
+            result += indexed.isLeaf(child)
+                && indexed.nodes[child]->type == Event::Type::Loss;
+        }
+    }
+
+    // Whether any ancestor of each node is a duplication, visiting parents
+    // before their children
+    std::vector<char> has_duplication(node_count, false);
+    auto words = (ancestral_genes.size() + word_width - 1) / word_width;
+    Positions leftmost(words), rightmost(words);
+    std::vector<Gene> leaf_genes;
+    unsigned most_gaps = 0;
+
+    for (auto index = node_count; index-- > 0;)
+    {
+        auto parent = indexed.parents[index];
+
+        if (parent != IndexedTree::none)
+        {
+            has_duplication[index] = has_duplication[parent]
+                || indexed.nodes[parent]->type == Event::Type::Duplication;
+        }
+
+        if (!indexed.isLeaf(index) || !is_anchored[index])
+        {
+            continue;
+        }
+
+        // Gaps are only known if the leaf can be extracted in a single way
+        const auto& synteny = indexed.nodes[index]->synteny;
+        leaf_genes.assign(std::cbegin(synteny), std::cend(synteny));
+
+        if (!find_extraction(ancestral_genes, leaf_genes, false, leftmost)
+                || !find_extraction(
+                    ancestral_genes, leaf_genes, true, rightmost)
+                || leftmost != rightmost)
+        {
+            continue;
+        }
+
+        unsigned gaps = 0;
+        std::size_t first = ancestral_genes.size();
+        std::size_t last = 0;
+
+        for (std::size_t position = 0; position < ancestral_genes.size();
+                ++position)
+        {
+            if (leftmost[position / word_width]
+                    & (Word{1} << (position % word_width)))
+            {
+                if (first == ancestral_genes.size())
+                {
+                    first = position;
+                }
+                else if (position != last + 1)
+                {
+                    ++gaps;
+                }
+
+                last = position;
+            }
+        }
+
+        if (!has_duplication[index])
+        {
+            gaps += first != 0;
+            gaps += last + 1 != ancestral_genes.size();
+        }
+
+        most_gaps = std::max(most_gaps, gaps);
+    }
+
+    return result + most_gaps;
+}
+}
+
+void beam_super_reconciliation(
+    tree<Event>& tree,
+    const SuperReconciliationParams& params)
+{
+    if (params.beam == 0)
+    {
+        throw std::invalid_argument{"The beam must hold at least one "
+            "candidate."};
+    }
+
+    if (tree.empty())
+    {
+        return;
+    }
+
+    const auto& ancestral_synteny = std::begin(tree)->synteny;
+    std::vector<Gene> ancestral_genes(
+        std::cbegin(ancestral_synteny),
+        std::cend(ancestral_synteny));
+
+    auto indexed = index_tree(tree);
+    auto node_count = indexed.nodes.size();
+    auto words = (ancestral_genes.size() + word_width - 1) / word_width;
+
+    Positions full(words, 0);
+
+    for (std::size_t position = 0; position < ancestral_genes.size();
+            ++position)
+    {
+        full[position / word_width] |= Word{1} << (position % word_width);
+    }
+
+    if (params.stats != nullptr)
+    {
+        params.stats->candidates.assign(node_count, 0);
+        params.stats->finite_candidates.assign(node_count, 0);
+        params.stats->shared_nodes = 0;
+        params.stats->lower_bound = get_lower_bound(indexed, ancestral_genes);
+    }
+
+    // Candidates kept for each node (by postfix index), ranked by cost
+    std::vector<std::vector<Candidate>> beams(node_count);
+    std::vector<Candidate> candidates;
+    std::vector<Gene> leaf_genes;
+    std::vector<std::size_t> order;
+
+    for (std::size_t index = 0; index < node_count; ++index)
+    {
+        const auto& node = *indexed.nodes[index];
+        candidates.clear();
+
+        if (indexed.isLeaf(index))
+        {
+            // Leaves keep their synteny, which may be extracted from the
+            // ancestral synteny in several ways: only the leftmost and the
+            // rightmost extractions are considered
+            leaf_genes.assign(
+                std::cbegin(node.synteny),
+                std::cend(node.synteny));
+
+            for (bool from_end : {false, true})
+            {
+                Candidate candidate;
+                candidate.positions.resize(words);
+
+                if (find_extraction(
+                        ancestral_genes, leaf_genes, from_end,
+                        candidate.positions)
+                    && (candidates.empty()
+                        || candidates.front().positions
+                            != candidate.positions))
+                {
+                    candidates.push_back(std::move(candidate));
+                }
+            }
+        }
+        else
+        {
+            auto left = indexed.lefts[index];
+            auto right = indexed.rights[index];
+            const auto& left_beam = beams[left];
+            const auto& right_beam = beams[right];
+
+            // The root can only be assigned the ancestral synteny. Other
+            // nodes are assigned either the smallest synteny that contains a
+            // pair of child candidates, the span of that synteny in the
+            // ancestral synteny, which avoids losses to the parent, or the
+            // whole ancestral synteny
+            std::vector<Positions> proposals{full};
+
+            if (index + 1 != node_count)
+            {
+                for (const auto& left_candidate : left_beam)
+                {
+                    for (const auto& right_candidate : right_beam)
+                    {
+                        Positions merged(words);
+
+                        for (std::size_t word = 0; word < words; ++word)
+                        {
+                            merged[word] = left_candidate.positions[word]
+                                | right_candidate.positions[word];
+                        }
+
+                        proposals.push_back(merged);
+
+                        // Fill the positions between the first and the last
+                        // ones of the merged synteny
+                        auto first = std::find_if(
+                            std::begin(merged), std::end(merged),
+                            [](Word word) { return word != 0; });
+
+                        if (first == std::end(merged))
+                        {
+                            continue;
+                        }
+
+                        auto last = std::find_if(
+                            merged.rbegin(), merged.rend(),
+                            [](Word word) { return word != 0; }).base() - 1;
+
+                        auto from_low = ~(lowest_bit(*first) - 1);
+                        auto high = highest_bit(*last);
+                        auto to_high = high | (high - 1);
+
+                        if (first == last)
+                        {
+                            *first = from_low & to_high;
+                        }
+                        else
+                        {
+                            *first = from_low;
+                            std::fill(std::next(first), last, ~Word{0});
+                            *last = to_high;
+                        }
+
+                        proposals.push_back(std::move(merged));
+                    }
+                }
+
+                std::sort(std::begin(proposals), std::end(proposals));
+                proposals.erase(
+                    std::unique(std::begin(proposals), std::end(proposals)),
+                    std::end(proposals));
+            }
+
+            for (auto& positions : proposals)
+            {
+                Candidate candidate;
+                candidate.positions = std::move(positions);
+                evaluate_candidate(
+                    node,
+                    *indexed.nodes[left], left_beam,
+                    *indexed.nodes[right], right_beam,
+                    candidate);
+
+                if (!candidate.cost.isInfinity())
+                {
+                    candidates.push_back(std::move(candidate));
+                }
+            }
+        }
+
+        if (candidates.empty())
+        {
+            std::ostringstream message;
+            message << "There is no valid candidate for the node "
+                << node << " under the order of the root synteny ("
+                << ancestral_synteny << ").";
+            throw std::invalid_argument{message.str()};
+        }
+
+        if (params.stats != nullptr)
+        {
+            params.stats->candidates[index] = candidates.size();
+        }
+
+        // Keep the cheapest candidates, preferring longer syntenies among
+        // candidates of the same cost since they need fewer losses from
+        // their parent, and breaking remaining ties by position
+        for (auto& candidate : candidates)
+        {
+            candidate.size = count_positions(candidate.positions);
+        }
+
+        order.resize(candidates.size());
+        std::iota(std::begin(order), std::end(order), 0);
+        auto kept = std::min(params.beam, candidates.size());
+
+        std::partial_sort(
+            std::begin(order), std::next(std::begin(order), kept),
+            std::end(order),
+            [&candidates](std::size_t first, std::size_t second)
+            {
+                const auto& a = candidates[first];
+                const auto& b = candidates[second];
+
+                if (a.cost != b.cost)
+                {
+                    return a.cost < b.cost;
+                }
+
+                if (a.size != b.size)
+                {
+                    return a.size > b.size;
+                }
+
+                return a.positions < b.positions;
+            });
+
+        auto& beam = beams[index];
+        beam.reserve(kept);
+
+        for (std::size_t rank = 0; rank < kept; ++rank)
+        {
+            beam.push_back(std::move(candidates[order[rank]]));
+        }
+
+        if (params.stats != nullptr)
+        {
+            params.stats->finite_candidates[index] = kept;
+        }
+    }
+
+    // Propagate the chosen candidates from the root, in prefix order, and
+    // insert the losses that they imply (see super_reconciliation)
+    std::vector<std::size_t> chosen(node_count, 0);
+    std::vector<const Positions*> assigned(node_count, nullptr);
+    std::vector<std::size_t> stack{node_count - 1};
+    assigned.back() = &beams.back().front().positions;
+    std::size_t inserted_losses = 0;
+    unsigned dl_score = 0;
+
+    while (!stack.empty())
+    {
+        auto index = stack.back();
+        stack.pop_back();
+
+        if (indexed.isLeaf(index))
+        {
+            dl_score += get_dl_cost(*indexed.nodes[index]);
+            continue;
+        }
+
+        auto parent = indexed.nodes[index];
+        auto left = indexed.lefts[index];
+        auto right = indexed.rights[index];
+        const auto& info = beams[index][chosen[index]];
+
+        chosen[left] = info.index_left;
+        chosen[right] = info.index_right;
+        auto partial_left = info.partial_left;
+        auto partial_right = info.partial_right;
+
+        // Subtrees in which every leaf is lost only have the empty
+        // candidate, which fits in any parent at the same cost as the
+        // parent synteny. Assign them the parent synteny instead, so that
+        // they are not collapsed into a single loss by the traceback
+        for (auto child : {left, right})
+        {
+            const auto& positions = beams[child][chosen[child]].positions;
+
+            if (!indexed.isLeaf(child) && count_positions(positions) == 0)
+            {
+                assigned[child] = assigned[index];
+                (child == left ? partial_left : partial_right) = false;
+            }
+            else
+            {
+                assigned[child] = &positions;
+            }
+        }
+
+        auto synteny_parent = get_subsequence(
+            ancestral_genes, *assigned[index]);
+        auto synteny_left = get_subsequence(
+            ancestral_genes, *assigned[left]);
+        auto synteny_right = get_subsequence(
+            ancestral_genes, *assigned[right]);
+
+        auto child_left = indexed.nodes[left];
+        auto child_right = indexed.nodes[right];
+
+        if (partial_left)
+        {
+            parent->segment = find_duplicated_segment(
+                synteny_parent, synteny_left);
+        }
+
+        if (partial_right)
+        {
+            parent->segment = find_duplicated_segment(
+                synteny_parent, synteny_right);
+        }
+
+        child_left->synteny = std::move(synteny_left);
+        auto is_left_removed = resolve_losses(
+            tree, parent, child_left, partial_left, inserted_losses);
+
+        // Both children are removed if the parent synteny is empty
+        if (tree.number_of_children(parent) == 0)
+        {
+            dl_score += get_dl_cost(*parent);
+            continue;
+        }
+
+        child_right->synteny = std::move(synteny_right);
+        auto is_right_removed = resolve_losses(
+            tree, parent, child_right, partial_right, inserted_losses);
+        dl_score += get_dl_cost(*parent);
+
+        if (!is_right_removed)
+        {
+            stack.push_back(right);
+        }
+
+        if (!is_left_removed)
+        {
+            stack.push_back(left);
+        }
+    }
+
+    if (params.stats != nullptr)
+    {
+        params.stats->inserted_losses = inserted_losses;
+        params.stats->dl_score = dl_score + inserted_losses;
+    }
+}
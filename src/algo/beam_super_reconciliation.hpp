@@ -0,0 +1,37 @@
+#ifndef ALGO_BEAM_SUPER_RECONCILIATION_HPP
+#define ALGO_BEAM_SUPER_RECONCILIATION_HPP
+
+#include "../model/Event.hpp"
+#include "super_reconciliation.hpp"
+#include <tree.hh>
+
+/**
+ * Compute an approximate ordered Super-Reconciliation of a synteny tree,
+ * for ancestral syntenies too long for the exact algorithm.
+ *
+ * Instead of evaluating every subsequence of the ancestral synteny at each
+ * node, only a bounded beam of the `params.beam` best candidates of each
+ * node is kept, ranked by cost. The candidates of an internal node are
+ * built from pairs of candidates of its children: their union, the span of
+ * the ancestral synteny between the first and last positions of their
+ * union, and the whole ancestral synteny. The resulting labeling is valid,
+ * but it may not be optimal. This takes O(n K³ m) time and O(n K m) memory
+ * for a tree of n nodes, a beam of K candidates and an ancestral synteny of
+ * m genes.
+ *
+ * A lower bound on the duplication-loss score of any labeling is stored in
+ * `params.stats->lower_bound`, if requested, to estimate how far the result
+ * is from the optimum.
+ *
+ * @param tree Synteny tree to reconcile (see super_reconciliation), which
+ * is modified so that a synteny assignation is set in each internal node.
+ * @param [params] Parameters of the computation. Only `beam` and `stats`
+ * are used: the computation is sequential.
+ *
+ * @throws If the order is not consistent or if the tree is improperly labeled.
+ */
+void beam_super_reconciliation(
+    tree<Event>& tree,
+    const SuperReconciliationParams& = SuperReconciliationParams{});
+
+#endif // ALGO_BEAM_SUPER_RECONCILIATION_HPP
@@ -0,0 +1,122 @@
+#include "beam_super_reconciliation.hpp"
+#include "erase.hpp"
+#include "simulate.hpp"
+#include "super_reconciliation.hpp"
+#include "../io/nhx.hpp"
+#include "../model/Event.hpp"
+#include <catch.hpp>
+#include <random>
+
+TEST_CASE("Approximate Super-Reconciliation")
+{
+    SECTION("Simple example from the paper")
+    {
+        auto input_tree = parse_nhx_tree<Event>(R"NHX(
+            (
+                (
+                    "x x' x''",
+                    [&&NHX:event=loss]
+                )[&&NHX:event=speciation],
+                (
+                    "x",
+                    (
+                        "x x''",
+                        "x x'"
+                    )[&&NHX:event=duplication]
+                )[&&NHX:event=speciation]
+            )"x x' x''"[&&NHX:event=duplication];
+        )NHX");
+
+        auto exact_tree = input_tree;
+        super_reconciliation(exact_tree);
+
+        ReconciliationStats stats;
+        SuperReconciliationParams params;
+        params.stats = &stats;
+
+        auto beam_tree = input_tree;
+        beam_super_reconciliation(beam_tree, params);
+
+        REQUIRE(get_dl_score(beam_tree) == get_dl_score(exact_tree));
+        REQUIRE(stats.lower_bound <= get_dl_score(exact_tree));
+    }
+
+    SECTION("Reject leaves that do not follow the ancestral order")
+    {
+        auto event_tree = parse_nhx_tree<Event>(R"NHX(
+            ("b a", "a")"a b"[&&NHX:event=speciation];
+        )NHX");
+
+        REQUIRE_THROWS_AS(
+            beam_super_reconciliation(event_tree),
+            std::invalid_argument);
+    }
+
+    SECTION("Reject an empty beam")
+    {
+        auto event_tree = parse_nhx_tree<Event>(R"NHX(
+            ("a", "b")"a b"[&&NHX:event=speciation];
+        )NHX");
+
+        SuperReconciliationParams params;
+        params.beam = 0;
+
+        REQUIRE_THROWS_AS(
+            beam_super_reconciliation(event_tree, params),
+            std::invalid_argument);
+    }
+
+    SECTION("Scores lie between the lower bound and the reference")
+    {
+        std::mt19937 prng{42};
+        SimulationParams params;
+        params.base = Synteny::generateDummy(6);
+        params.depth = 5;
+
+        for (int sample = 0; sample < 20; ++sample)
+        {
+            auto reference_tree = simulate_evolution(prng, params);
+            auto input_tree = get_erased_tree(reference_tree);
+
+            auto exact_tree = input_tree;
+            super_reconciliation(exact_tree);
+            auto exact_score = get_dl_score(exact_tree);
+
+            ReconciliationStats stats;
+            SuperReconciliationParams beam_params;
+            beam_params.beam = 8;
+            beam_params.stats = &stats;
+
+            auto beam_tree = input_tree;
+            beam_super_reconciliation(beam_tree, beam_params);
+
+            REQUIRE(stats.lower_bound <= exact_score);
+            REQUIRE(exact_score <= get_dl_score(beam_tree));
+            REQUIRE(stats.dl_score == get_dl_score(beam_tree));
+        }
+    }
+
+    SECTION("Long ancestral syntenies")
+    {
+        std::mt19937 prng{42};
+        SimulationParams params;
+        params.base = Synteny::generateDummy(100);
+        params.depth = 4;
+
+        for (int sample = 0; sample < 5; ++sample)
+        {
+            auto reference_tree = simulate_evolution(prng, params);
+            auto input_tree = get_erased_tree(reference_tree);
+
+            ReconciliationStats stats;
+            SuperReconciliationParams beam_params;
+            beam_params.beam = 4;
+            beam_params.stats = &stats;
+
+            beam_super_reconciliation(input_tree, beam_params);
+
+            REQUIRE(stats.lower_bound <= get_dl_score(reference_tree));
+            REQUIRE(stats.lower_bound <= get_dl_score(input_tree));
+        }
+    }
+}
@@ -1,43 +1,139 @@
 #include "erase.hpp"
+#include <utility>
+#include <vector>
+
+namespace
+{
+
+/**
+ * Check whether the synteny of an event is kept when erasing a tree.
+ *
+ * @param event Event to check.
+ * @param keep_synteny Whether to keep the synteny of an internal node.
+ * @return True if the event is a leaf, or if `keep_synteny` is true and it
+ * is not a loss.
+ */
+bool keeps_synteny(const Event& event, bool keep_synteny)
+{
+    return event.type == Event::Type::None
+        || (keep_synteny && event.type != Event::Type::Loss);
+}
+
+/**
+ * Make the erased copy of a single event, without its children.
+ *
+ * @param event Event to copy.
+ * @param keep_synteny Whether to keep the synteny of an internal node.
+ * @return Copy of the event with its segment and, unless it is a leaf or
+ * `keep_synteny` is true, its synteny erased.
+ */
+Event get_erased_event(const Event& event, bool keep_synteny)
+{
+    Event result;
+    result.type = event.type;
+
+    if (keeps_synteny(event, keep_synteny))
+    {
+        result.synteny = event.synteny;
+    }
+
+    return result;
+}
+
+} // namespace
 
 void erase_tree(
-    ::tree<Event> input,
+    ::tree<Event>& tree,
     ::tree<Event>::sibling_iterator root,
     bool is_root)
 {
-    root->segment = Synteny::NoSegment;
+    // Visit nodes iteratively in prefix order, as `get_erased_tree` does,
+    // along with whether their synteny is kept. Children are collected
+    // before their parent is edited, since removing a loss node moves its
+    // children up
+    std::vector<std::pair<::tree<Event>::sibling_iterator, bool>> pending;
+    pending.emplace_back(root, is_root);
 
-    switch (root->type)
+    while (!pending.empty())
     {
-    case Event::Type::None:
-        return;
+        auto node = pending.back().first;
+        auto keep_synteny = pending.back().second;
+        pending.pop_back();
 
-    case Event::Type::Loss:
-    {
-        root->synteny = Synteny{};
+        for (auto child = node.node->last_child;
+                child != nullptr;
+                child = child->prev_sibling)
+        {
+            pending.emplace_back(child, false);
+        }
 
-        if (input.number_of_children(root) != 0)
+        if (node->type == Event::Type::Loss && node.number_of_children() > 0)
+        {
+            // Remove loss nodes that have a child, moving their children up
+            tree.flatten(node);
+            tree.erase(node);
+        }
+        else
         {
-            // Remove loss nodes, moving their only child up
-            auto child = input.child(root, 0);
-            input.flatten(root);
-            input.erase(root);
-            erase_tree(input, child, false);
+            node->segment = Synteny::NoSegment;
+
+            if (!keeps_synteny(*node, keep_synteny))
+            {
+                node->synteny = Synteny{};
+            }
         }
+    }
+}
 
-        return;
+::tree<Event> get_erased_tree(const ::tree<Event>& tree)
+{
+    ::tree<Event> result;
+
+    if (tree.empty())
+    {
+        return result;
     }
 
-    case Event::Type::Duplication:
-    case Event::Type::Speciation:
-        if (!is_root)
+    ::tree<Event>::sibling_iterator root = tree.begin();
+    bool keep_synteny = true;
+
+    // Remove loss nodes at the top, whose child becomes the new root
+    while (root->type == Event::Type::Loss && root.number_of_children() > 0)
+    {
+        root = tree.begin(root);
+        keep_synteny = false;
+    }
+
+    // Visit nodes iteratively in prefix order, so that the call stack does
+    // not grow with the depth of the tree, along with the node of the result
+    // under which their copy is appended. Children are pushed last to first
+    // so that they are appended in order
+    std::vector<std::pair<::tree<Event>::sibling_iterator,
+        ::tree<Event>::iterator>> pending;
+    pending.emplace_back(
+        root, result.set_head(get_erased_event(*root, keep_synteny)));
+
+    while (!pending.empty())
+    {
+        auto node = pending.back().first;
+        auto target = pending.back().second;
+        pending.pop_back();
+
+        if (node != root && (node->type != Event::Type::Loss
+                || node.number_of_children() == 0))
         {
-            // Erase all syntenies in internal nodes except for the root node
-            root->synteny = Synteny{};
+            // Remove loss nodes that have a child, moving their children up
+            target = result.append_child(
+                target, get_erased_event(*node, false));
         }
 
-        erase_tree(input, input.child(root, 0), false);
-        erase_tree(input, input.child(root, 1), false);
-        return;
+        for (auto child = node.node->last_child;
+                child != nullptr;
+                child = child->prev_sibling)
+        {
+            pending.emplace_back(child, target);
+        }
     }
+
+    return result;
 }
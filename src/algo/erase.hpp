@@ -5,18 +5,28 @@
 #include "../model/Event.hpp"
 
 /**
- * Erase loss and internal synteny labelling from a synteny tree.
+ * Erase loss and internal synteny labelling from a subtree of a synteny
+ * tree, in place and in a single traversal.
  *
- * @param tree Input synteny tree.
+ * @param tree Input synteny tree, modified in place.
  * @param root Node from which to start removing.
  * @param [is_root=true] Whether `root` is the root of the whole tree or of
  * one of the subtrees.
- *
- * @return Resulting tree.
  */
 void erase_tree(
-    ::tree<Event> input,
+    ::tree<Event>& tree,
     ::tree<Event>::sibling_iterator root,
     bool is_root = true);
 
+/**
+ * Make an erased copy of a synteny tree, without modifying it. This builds
+ * the same tree as copying the input and erasing the copy, but only copies
+ * the nodes and syntenies that are kept, in a single traversal.
+ *
+ * @param tree Input synteny tree.
+ * @return Copy of `tree` in which losses and internal syntenies (except
+ * for the synteny of the root) are erased.
+ */
+::tree<Event> get_erased_tree(const ::tree<Event>& tree);
+
 #endif // ALGO_ERASE_HPP
@@ -0,0 +1,95 @@
+#include "erase.hpp"
+#include "simulate.hpp"
+#include "super_reconciliation.hpp"
+#include "../io/nhx.hpp"
+#include "../model/Event.hpp"
+#include "../util/tree.hpp"
+#include <catch.hpp>
+#include <random>
+
+TEST_CASE("Erased copies of trees")
+{
+    SECTION("Losses and internal syntenies are erased")
+    {
+        auto input = parse_nhx_tree<Event>(R"NHX(
+            (
+                (
+                    "a b"[&&NHX:event=loss:segment="1 - 2"],
+                    (("a b c")"a b c"[&&NHX:event=loss:segment="2 - 3"])
+                        "a b c d"[&&NHX:event=loss:segment="3 - 4"]
+                )"a b c d"[&&NHX:event=speciation],
+                "a b c d"
+            )"a b c d"[&&NHX:event=duplication:segment="0 - 4"];
+        )NHX");
+
+        auto expected = parse_nhx_tree<Event>(R"NHX(
+            (
+                (
+                    ""[&&NHX:event=loss],
+                    "a b c"
+                )""[&&NHX:event=speciation],
+                "a b c d"
+            )"a b c d"[&&NHX:event=duplication];
+        )NHX");
+
+        auto input_copy = input;
+        auto erased = get_erased_tree(input);
+
+        CHECK(stringify_nhx_tree(erased) == stringify_nhx_tree(expected));
+        CHECK(stringify_nhx_tree(input) == stringify_nhx_tree(input_copy));
+    }
+
+    SECTION("Erased copies are the same as trees erased in place")
+    {
+        std::mt19937 prng{7};
+
+        for (int sample = 0; sample < 50; ++sample)
+        {
+            SimulationParams params;
+            params.base = Synteny::generateDummy(2 + sample % 6);
+            params.depth = 1 + sample % 7;
+            params.p_loss = 0.5;
+
+            auto input = simulate_evolution(prng, params);
+            auto erased = input;
+            erase_tree(erased, std::begin(erased));
+
+            CHECK(stringify_nhx_tree(get_erased_tree(input))
+                == stringify_nhx_tree(erased));
+        }
+    }
+
+    SECTION("Deep trees are traversed without recursion")
+    {
+        // Caterpillar of duplications, deeper than what recursive
+        // traversals can visit on the default call stack
+        constexpr unsigned depth = 500000;
+        Event leaf;
+        leaf.synteny = Synteny{"a"};
+
+        ::tree<Event> input{Event{}};
+        auto node = input.begin();
+
+        for (unsigned level = 0; level < depth; ++level)
+        {
+            node->type = Event::Type::Duplication;
+            node->synteny = leaf.synteny;
+            input.append_child(node, leaf);
+            node = input.append_child(node, Event{});
+        }
+
+        *node = leaf;
+        REQUIRE(get_dl_score(input) == depth);
+
+        auto erased = get_erased_tree(input);
+        REQUIRE(erased.size() == input.size());
+        REQUIRE(get_dl_score(erased) == depth);
+
+        auto tagged = tree_cast<Event, TaggedNode>(input);
+        auto events = tree_cast<TaggedNode, Event>(tagged);
+        REQUIRE(stringify_nhx_tree(events) == stringify_nhx_tree(input));
+
+        erase_tree(input, std::begin(input));
+        REQUIRE(stringify_nhx_tree(input) == stringify_nhx_tree(erased));
+    }
+}
@@ -0,0 +1,81 @@
+#include "losses.hpp"
+#include "../util/ExtendedNumber.hpp"
+#include <iterator>
+
+bool resolve_losses(
+    ::tree<Event>& tree,
+    ::tree<Event>::iterator_base parent, ::tree<Event>::iterator_base child,
+    bool substring,
+    std::size_t& inserted)
+{
+    // Inserted loss nodes share the synteny of their parent
+    auto synteny_parent = parent->synteny;
+    const Synteny& synteny_child = child->synteny;
+
+    // If the parent is a loss node, consider its synteny to be as if the loss
+    // had already occurred
+    if (parent->type == Event::Type::Loss)
+    {
+        auto& remaining = synteny_parent.mutate();
+        remaining.erase(
+            std::next(std::cbegin(remaining), parent->segment.first),
+            std::next(std::cbegin(remaining), parent->segment.second));
+    }
+
+    // Edge case: if we happen to generate a internal node which has an empty
+    // synteny, we must make sure that it does not have any child, because
+    // there can be no evolution from an empty set of genes
+    if (synteny_parent.empty())
+    {
+        tree.erase_children(parent);
+        parent->type = Event::Type::Loss;
+        return true;
+    }
+
+    // If the distance between the parent and the child syntenies is at
+    // least one, loss nodes need to be introduced between them
+    auto losses = synteny_parent.get().reconcile(synteny_child, substring);
+
+    if (losses.size() >= 1)
+    {
+        Event new_node;
+        new_node.type = Event::Type::Loss;
+        new_node.synteny = synteny_parent;
+        new_node.segment = losses.front();
+
+        auto new_child = tree.wrap(child, new_node);
+        ++inserted;
+        return resolve_losses(tree, new_child, child, substring, inserted);
+    }
+
+    return false;
+}
+
+Synteny::Segment find_duplicated_segment(
+    const Synteny& synteny_parent,
+    const Synteny& synteny_child)
+{
+    auto losses = synteny_parent.reconcile(
+        synteny_child, false,
+        ExtendedNumber<int>::positiveInfinity());
+
+    auto max = synteny_parent.size();
+    auto result = Synteny::Segment(0, max);
+
+    // We are interested in segments at the very start or end of the
+    // parent synteny. Those induce a reduction in the duplicated segment
+    for (const auto& loss : losses)
+    {
+        if (loss.first == 0)
+        {
+            result.first = loss.second;
+        }
+
+        if (loss.second == max)
+        {
+            result.second = loss.first;
+        }
+    }
+
+    return result;
+}
@@ -0,0 +1,41 @@
+#ifndef ALGO_LOSSES_HPP
+#define ALGO_LOSSES_HPP
+
+#include "../model/Event.hpp"
+#include "../model/Synteny.hpp"
+#include <cstddef>
+#include <tree.hh>
+
+/**
+ * Make sure that, in an event tree, the distance in terms of losses between
+ * a parent and one of its children is at most 1 for loss nodes and at most
+ * 0 (ie. they have the same synteny) for other nodes by inserting loss nodes
+ * where needed.
+ *
+ * @param tree Tree on which to check the condition.
+ * @param parent Parent node.
+ * @param child Child node.
+ * @param substring Whether to check distances in substring mode or not.
+ * @param [inserted] Incremented by the number of inserted loss nodes.
+ * @return True if and only if the child was removed from the tree.
+ */
+bool resolve_losses(
+    ::tree<Event>& tree,
+    ::tree<Event>::iterator_base parent, ::tree<Event>::iterator_base child,
+    bool substring,
+    std::size_t& inserted);
+
+/**
+ * Find the segment of a parent synteny that is duplicated to produce a
+ * child synteny in a segmental duplication, that is, the parent synteny
+ * without the genes that the child is missing at either of its ends.
+ *
+ * @param synteny_parent Synteny of the duplication node.
+ * @param synteny_child Synteny of the partially duplicated child.
+ * @return Duplicated segment.
+ */
+Synteny::Segment find_duplicated_segment(
+    const Synteny& synteny_parent,
+    const Synteny& synteny_child);
+
+#endif // ALGO_LOSSES_HPP
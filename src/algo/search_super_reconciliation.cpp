@@ -0,0 +1,479 @@
+#include "search_super_reconciliation.hpp"
+#include "../model/Event.hpp"
+#include "../model/Mask.hpp"
+#include "../util/bits.hpp"
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <iterator>
+#include <limits>
+#include <mutex>
+#include <omp.h>
+#include <sstream>
+#include <stdexcept>
+#include <tree.hh>
+#include <vector>
+
+namespace
+{
+// Number of genes placed in a prefix below which each extension of the
+// prefix is explored in a task of its own. Deeper prefixes are explored
+// sequentially, to amortize the scheduling overhead
+constexpr std::size_t task_depth = 2;
+
+// Leaf with a non-empty synteny, whose genes constrain the ancestral order
+struct Anchor
+{
+    // Set of the indices of the genes of the leaf among the ancestral genes
+    Mask genes = 0;
+
+    // Whether any ancestor of the leaf is a duplication, in which case its
+    // missing genes at either end may come from a segmental duplication
+    bool has_duplication = false;
+};
+
+/**
+ * State of a search shared by all its tasks.
+ */
+struct Search
+{
+    // Tree to reconcile, whose root synteny is replaced by each order
+    const ::tree<Event>* input = nullptr;
+
+    // Parameters of the computation of each order
+    SuperReconciliationParams params;
+
+    // Genes of the ancestral synteny, in their initial order
+    std::vector<Gene> genes;
+
+    // Set of the genes that must come after each gene in any order from
+    // which all the leaves can be extracted
+    std::vector<Mask> successors;
+
+    // Leaves that constrain the order
+    std::vector<Anchor> anchors;
+
+    // Part of the lower bound that does not depend on the order
+    unsigned base_bound = 0;
+
+    // Workspace of each thread
+    std::vector<SuperReconciliationWorkspace> workspaces;
+
+    // Score of the best complete order found so far, which can be read
+    // without locking, and the order itself
+    std::atomic<unsigned> best_score{std::numeric_limits<unsigned>::max()};
+    std::vector<std::size_t> best_order;
+    std::mutex best_mutex;
+
+    // First error raised while solving an order, after which the search
+    // is abandoned
+    std::exception_ptr error;
+    std::atomic<bool> has_failed{false};
+
+    std::atomic<std::size_t> solved{0};
+    std::atomic<std::size_t> pruned{0};
+};
+
+/**
+ * Compute a lower bound on the duplication-loss score of any order that
+ * starts with a given prefix (see `get_lower_bound` in
+ * beam_super_reconciliation.cpp). Missing genes between two genes of a leaf
+ * are only counted once they are known to be missing: when a gene of the
+ * leaf follows them or when they follow the last gene of the leaf while
+ * other genes of the leaf remain to be placed.
+ *
+ * @param search Search state.
+ * @param prefix Indices of the genes placed so far.
+ * @return Lower bound on the score of the completions of the prefix.
+ */
+unsigned get_prefix_bound(
+    const Search& search,
+    const std::vector<std::size_t>& prefix)
+{
+    unsigned most_gaps = 0;
+
+    for (const auto& anchor : search.anchors)
+    {
+        unsigned gaps = 0;
+        int placed = 0;
+        bool is_pending = false;
+
+        for (std::size_t rank = 0; rank < prefix.size(); ++rank)
+        {
+            bool is_in_leaf = (anchor.genes >> prefix[rank]) & 1;
+
+            if (is_in_leaf)
+            {
+                gaps += is_pending;
+                is_pending = false;
+                ++placed;
+            }
+            else if (placed > 0)
+            {
+                is_pending = true;
+            }
+            else if (rank == 0 && !anchor.has_duplication)
+            {
+                // Genes before the first gene of the leaf are lost
+                ++gaps;
+            }
+        }
+
+        if (is_pending)
+        {
+            // Either other genes of the leaf come later, or the genes after
+            // the last one of the leaf are lost
+            if (placed < popcount(anchor.genes))
+            {
+                ++gaps;
+            }
+            else if (!anchor.has_duplication)
+            {
+                ++gaps;
+            }
+        }
+
+        most_gaps = std::max(most_gaps, gaps);
+    }
+
+    return search.base_bound + most_gaps;
+}
+
+/**
+ * Check whether no completion of a prefix can be chosen over the best
+ * complete order found so far.
+ *
+ * @param search Search state.
+ * @param prefix Indices of the genes placed so far.
+ * @param bound Lower bound on the score of the completions of the prefix.
+ * @return True if and only if the prefix can be abandoned.
+ */
+bool is_dominated(
+    Search& search,
+    const std::vector<std::size_t>& prefix,
+    unsigned bound)
+{
+    auto best_score = search.best_score.load();
+
+    if (bound != best_score)
+    {
+        return bound > best_score;
+    }
+
+    // Ties are resolved in favor of the order that comes first, so that the
+    // result does not depend on the order in which tasks complete
+    std::lock_guard<std::mutex> lock{search.best_mutex};
+    return std::lexicographical_compare(
+        std::begin(search.best_order),
+        std::next(std::begin(search.best_order), prefix.size()),
+        std::begin(prefix), std::end(prefix));
+}
+
+/**
+ * Solve a complete order with the exact algorithm and keep it if it is
+ * better than the best order found so far.
+ *
+ * @param search Search state.
+ * @param order Indices of the genes in the order.
+ */
+void solve_order(Search& search, const std::vector<std::size_t>& order)
+{
+    auto candidate = *search.input;
+    auto& root_synteny = std::begin(candidate)->synteny;
+    root_synteny.clear();
+
+    for (auto index : order)
+    {
+        root_synteny.push_back(search.genes[index]);
+    }
+
+    ReconciliationStats stats;
+    auto params = search.params;
+    params.stats = &stats;
+
+    super_reconciliation(
+        candidate,
+        search.workspaces[omp_get_thread_num()],
+        params);
+
+    auto score = stats.dl_score;
+    ++search.solved;
+
+    std::lock_guard<std::mutex> lock{search.best_mutex};
+
+    if (score < search.best_score
+            || (score == search.best_score && order < search.best_order))
+    {
+        search.best_score = score;
+        search.best_order = order;
+    }
+}
+
+/**
+ * Explore the orders that start with a prefix.
+ *
+ * @param search Search state.
+ * @param prefix Indices of the genes placed so far.
+ * @param placed Set of the genes placed so far.
+ */
+void explore(
+    Search& search,
+    const std::vector<std::size_t>& prefix,
+    Mask placed)
+{
+    if (prefix.size() == search.genes.size())
+    {
+        try
+        {
+            solve_order(search, prefix);
+        }
+        catch (...)
+        {
+            std::lock_guard<std::mutex> lock{search.best_mutex};
+
+            if (!search.error)
+            {
+                search.error = std::current_exception();
+                search.has_failed = true;
+            }
+        }
+
+        return;
+    }
+
+    if (search.has_failed)
+    {
+        return;
+    }
+
+    for (std::size_t index = 0; index < search.genes.size(); ++index)
+    {
+        // Genes that must follow this one cannot be placed already
+        if (((placed >> index) & 1) || (search.successors[index] & placed))
+        {
+            continue;
+        }
+
+        auto next = prefix;
+        next.push_back(index);
+
+        if (is_dominated(search, next, get_prefix_bound(search, next)))
+        {
+            ++search.pruned;
+            continue;
+        }
+
+        auto next_placed = placed | (Mask{1} << index);
+
+        if (prefix.size() < task_depth)
+        {
+            #pragma omp task firstprivate(next, next_placed) shared(search)
+            explore(search, next, next_placed);
+        }
+        else
+        {
+            explore(search, next, next_placed);
+        }
+    }
+}
+
+/**
+ * Find the genes of the ancestral synteny and the constraints that the
+ * leaves put on their order.
+ *
+ * @param tree Tree to reconcile.
+ * @param [search] Search state to fill.
+ * @throws std::invalid_argument If the ancestral genes are not distinct or
+ * do not contain the genes of a leaf.
+ */
+void prepare_search(const ::tree<Event>& tree, Search& search)
+{
+    const auto& root_synteny = std::begin(tree)->synteny;
+    auto& genes = search.genes;
+    genes.assign(std::cbegin(root_synteny), std::cend(root_synteny));
+
+    if (genes.empty())
+    {
+        for (auto it = tree.begin_leaf(); it != tree.end_leaf(); ++it)
+        {
+            for (const auto& gene : it->synteny)
+            {
+                if (std::find(std::begin(genes), std::end(genes), gene)
+                        == std::end(genes))
+                {
+                    genes.push_back(gene);
+                }
+            }
+        }
+    }
+
+    for (auto it = std::begin(genes); it != std::end(genes); ++it)
+    {
+        if (std::find(std::next(it), std::end(genes), *it) != std::end(genes))
+        {
+            std::ostringstream message;
+            message << "The ancestral genes must be distinct to search "
+                "their order, but " << *it << " appears several times.";
+            throw std::invalid_argument{message.str()};
+        }
+    }
+
+    if (genes.size() > max_mask_width)
+    {
+        std::ostringstream message;
+        message << "The ancestral synteny must contain at most "
+            << max_mask_width << " genes.";
+        throw std::invalid_argument{message.str()};
+    }
+
+    search.successors.assign(genes.size(), 0);
+    std::vector<std::size_t> indices;
+
+    for (auto it = tree.begin_leaf(); it != tree.end_leaf(); ++it)
+    {
+        if (it->type == Event::Type::Loss || it->synteny.empty())
+        {
+            continue;
+        }
+
+        indices.clear();
+        Anchor anchor;
+
+        for (const auto& gene : it->synteny)
+        {
+            auto found = std::find(std::begin(genes), std::end(genes), gene);
+
+            if (found == std::end(genes))
+            {
+                std::ostringstream message;
+                message << "The gene " << gene << " of the leaf " << *it
+                    << " is not part of the ancestral genes.";
+                throw std::invalid_argument{message.str()};
+            }
+
+            auto index = static_cast<std::size_t>(
+                std::distance(std::begin(genes), found));
+            anchor.genes |= Mask{1} << index;
+            indices.push_back(index);
+        }
+
+        // Each gene of the leaf must come before the ones that follow it.
+        // A leaf with a repeated gene makes some gene follow itself, which
+        // leaves no valid order
+        for (std::size_t i = 0; i < indices.size(); ++i)
+        {
+            for (std::size_t j = i + 1; j < indices.size(); ++j)
+            {
+                search.successors[indices[i]] |= Mask{1} << indices[j];
+            }
+        }
+
+        for (auto parent = ::tree<Event>::parent(it);
+                tree.is_valid(parent);
+                parent = ::tree<Event>::parent(parent))
+        {
+            if (parent->type == Event::Type::Duplication)
+            {
+                anchor.has_duplication = true;
+                break;
+            }
+        }
+
+        search.anchors.push_back(anchor);
+    }
+
+    // Nodes that have a leaf with a non-empty synteny below them always get
+    // a non-empty synteny: count each of their duplications and each lost
+    // leaf directly below them, whatever the order
+    std::vector<char> is_anchored;
+
+    for (auto it = tree.begin_post(); it != tree.end_post(); ++it)
+    {
+        auto children_count = tree.number_of_children(it);
+
+        if (children_count == 0)
+        {
+            is_anchored.push_back(
+                it->type != Event::Type::Loss && !it->synteny.empty());
+            continue;
+        }
+
+        // Flags of the children are the last ones that were pushed
+        auto children = std::prev(std::end(is_anchored), children_count);
+        bool node_anchored = std::find(
+            children, std::end(is_anchored), true) != std::end(is_anchored);
+        is_anchored.erase(children, std::end(is_anchored));
+
+        if (node_anchored)
+        {
+            search.base_bound += it->type == Event::Type::Duplication;
+
+            for (auto child = tree.begin(it); child != tree.end(it); ++child)
+            {
+                search.base_bound += tree.number_of_children(child) == 0
+                    && child->type == Event::Type::Loss;
+            }
+        }
+
+        is_anchored.push_back(node_anchored);
+    }
+}
+}
+
+void search_super_reconciliation(
+    tree<Event>& tree,
+    const SuperReconciliationParams& params)
+{
+    if (tree.empty())
+    {
+        return;
+    }
+
+    Search search;
+    search.input = &tree;
+    prepare_search(tree, search);
+
+    // Orders are solved concurrently, each one sequentially
+    search.params = params;
+    search.params.jobs = 1;
+    search.params.stats = nullptr;
+
+    auto thread_count = params.jobs == 0
+        ? static_cast<std::size_t>(omp_get_max_threads())
+        : std::size_t{params.jobs};
+
+    search.workspaces.resize(thread_count);
+
+    #pragma omp parallel num_threads(thread_count)
+    #pragma omp single
+    explore(search, {}, 0);
+
+    if (search.error)
+    {
+        std::rethrow_exception(search.error);
+    }
+
+    if (search.best_order.empty() && !search.genes.empty())
+    {
+        throw std::invalid_argument{"There is no order of the ancestral "
+            "genes from which all the leaves can be extracted."};
+    }
+
+    // Compute the result again for the best order, with the requested
+    // parameters and statistics
+    auto& root_synteny = std::begin(tree)->synteny;
+    root_synteny.clear();
+
+    for (auto index : search.best_order)
+    {
+        root_synteny.push_back(search.genes[index]);
+    }
+
+    super_reconciliation(tree, params);
+
+    if (params.stats != nullptr)
+    {
+        params.stats->solved_orders = search.solved;
+        params.stats->pruned_orders = search.pruned;
+    }
+}
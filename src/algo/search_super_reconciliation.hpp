@@ -0,0 +1,40 @@
+#ifndef ALGO_SEARCH_SUPER_RECONCILIATION_HPP
+#define ALGO_SEARCH_SUPER_RECONCILIATION_HPP
+
+#include "../model/Event.hpp"
+#include "super_reconciliation.hpp"
+#include <tree.hh>
+
+/**
+ * Compute an ordered Super-Reconciliation of a synteny tree whose ancestral
+ * order is unknown, by finding the order of the ancestral genes that leads
+ * to the most parsimonious result.
+ *
+ * Orders are built gene by gene in a branch-and-bound search. A prefix of
+ * an order is abandoned as soon as a leaf cannot be extracted from it, or
+ * as soon as a lower bound on the duplication-loss score of its completions
+ * (see beam_super_reconciliation) exceeds the score of the best complete
+ * order found so far. Each remaining order is solved with the exact
+ * algorithm. Branches of the search are explored concurrently by OpenMP
+ * tasks, and each thread reuses its own workspace for all the orders that
+ * it solves. Among orders of the same score, the one that comes first in
+ * the initial order of the genes is chosen, so that the result does not
+ * depend on the number of threads.
+ *
+ * @param tree Synteny tree to reconcile (see super_reconciliation). The
+ * genes of the root synteny are used in any order, or, if the root synteny
+ * is empty, the genes of the leaves in order of appearance. The tree is
+ * modified so that the root is assigned the best order and each internal
+ * node an optimal synteny under that order.
+ * @param [params] Parameters of the computation. `jobs` is the number of
+ * threads of the search, each order being solved sequentially.
+ *
+ * @throws std::invalid_argument If the ancestral genes are not distinct, if
+ * no order is consistent with the leaves or if the tree is improperly
+ * labeled.
+ */
+void search_super_reconciliation(
+    tree<Event>& tree,
+    const SuperReconciliationParams& = SuperReconciliationParams{});
+
+#endif // ALGO_SEARCH_SUPER_RECONCILIATION_HPP
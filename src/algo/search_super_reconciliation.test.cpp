@@ -0,0 +1,139 @@
+#include "search_super_reconciliation.hpp"
+#include "erase.hpp"
+#include "simulate.hpp"
+#include "super_reconciliation.hpp"
+#include "../io/nhx.hpp"
+#include "../model/Event.hpp"
+#include <algorithm>
+#include <catch.hpp>
+#include <limits>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+namespace
+{
+/**
+ * Find the best DL-score of a tree among all the orders of its root
+ * synteny, by solving each of them.
+ */
+unsigned get_best_score(const ::tree<Event>& input)
+{
+    const auto& root_synteny = std::begin(input)->synteny;
+    std::vector<Gene> genes(
+        std::cbegin(root_synteny), std::cend(root_synteny));
+    std::sort(std::begin(genes), std::end(genes));
+    auto best = std::numeric_limits<unsigned>::max();
+
+    do
+    {
+        auto candidate = input;
+        auto& synteny = std::begin(candidate)->synteny;
+        synteny.clear();
+
+        for (const auto& gene : genes)
+        {
+            synteny.push_back(gene);
+        }
+
+        try
+        {
+            super_reconciliation(candidate);
+            best = std::min(best, get_dl_score(candidate));
+        }
+        catch (const std::invalid_argument&)
+        {
+            // Leaves cannot be extracted from this order
+        }
+    }
+    while (std::next_permutation(std::begin(genes), std::end(genes)));
+
+    return best;
+}
+}
+
+TEST_CASE("Search over ancestral orders")
+{
+    SECTION("Find the order of the leaves")
+    {
+        auto input_tree = parse_nhx_tree<Event>(R"NHX(
+            (
+                "c a",
+                ("a b", "c b")[&&NHX:event=duplication]
+            )"a b c"[&&NHX:event=speciation];
+        )NHX");
+
+        ReconciliationStats stats;
+        SuperReconciliationParams params;
+        params.stats = &stats;
+
+        search_super_reconciliation(input_tree, params);
+
+        std::ostringstream root_synteny;
+        root_synteny << std::begin(input_tree)->synteny;
+        REQUIRE(root_synteny.str() == "c a b");
+        REQUIRE(stats.solved_orders >= 1);
+    }
+
+    SECTION("Use the genes of the leaves if the root synteny is empty")
+    {
+        auto input_tree = parse_nhx_tree<Event>(R"NHX(
+            ("a b", "b c")[&&NHX:event=speciation];
+        )NHX");
+
+        search_super_reconciliation(input_tree);
+
+        std::ostringstream root_synteny;
+        root_synteny << std::begin(input_tree)->synteny;
+        REQUIRE(root_synteny.str() == "a b c");
+    }
+
+    SECTION("Reject leaves that no order can explain")
+    {
+        auto input_tree = parse_nhx_tree<Event>(R"NHX(
+            ("a b", "b a")"a b"[&&NHX:event=speciation];
+        )NHX");
+
+        REQUIRE_THROWS_AS(
+            search_super_reconciliation(input_tree),
+            std::invalid_argument);
+    }
+
+    SECTION("Reject repeated ancestral genes")
+    {
+        auto input_tree = parse_nhx_tree<Event>(R"NHX(
+            ("a b", "a")"a b a"[&&NHX:event=speciation];
+        )NHX");
+
+        REQUIRE_THROWS_AS(
+            search_super_reconciliation(input_tree),
+            std::invalid_argument);
+    }
+
+    SECTION("Find the best score among all orders")
+    {
+        std::mt19937 prng{42};
+        SimulationParams params;
+        params.base = Synteny::generateDummy(5);
+        params.depth = 4;
+
+        for (int sample = 0; sample < 10; ++sample)
+        {
+            auto reference_tree = simulate_evolution(prng, params);
+            auto input_tree = get_erased_tree(reference_tree);
+            auto expected_score = get_best_score(input_tree);
+
+            auto sequential_tree = input_tree;
+            search_super_reconciliation(sequential_tree);
+            REQUIRE(get_dl_score(sequential_tree) == expected_score);
+
+            SuperReconciliationParams parallel_params;
+            parallel_params.jobs = 4;
+
+            auto parallel_tree = input_tree;
+            search_super_reconciliation(parallel_tree, parallel_params);
+            REQUIRE(std::begin(parallel_tree)->synteny
+                == std::begin(sequential_tree)->synteny);
+        }
+    }
+}
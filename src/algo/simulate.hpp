@@ -71,11 +71,16 @@ namespace std
  * @param prng Pseudo-random number generator to use, from C++’s <random>
  * library generators (eg. std::mt19937).
  * @param params Parameters for the simulation.
+ * @param [dl_score] If not null, receives the duplication-loss score of the
+ * simulated tree (see `get_dl_score`), counted while events are simulated.
  *
  * @return Simulated event tree.
  */
 template<typename PRNG>
-::tree<Event> simulate_evolution(PRNG&, SimulationParams);
+::tree<Event> simulate_evolution(
+    PRNG&,
+    const SimulationParams&,
+    unsigned* dl_score = nullptr);
 
 #include "simulate.tpp"
 
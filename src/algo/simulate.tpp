@@ -5,7 +5,7 @@
 #include <random>
 #include <tree.hh>
 
-bool operator==(const SimulationParams& a, const SimulationParams& b)
+inline bool operator==(const SimulationParams& a, const SimulationParams& b)
 {
     return
         a.base == b.base
@@ -17,7 +17,7 @@ bool operator==(const SimulationParams& a, const SimulationParams& b)
         && a.p_rearr == b.p_rearr;
 }
 
-std::hash<SimulationParams>::result_type
+inline std::hash<SimulationParams>::result_type
 std::hash<SimulationParams>::operator()(const argument_type& a) const
 {
     result_type seed = boost::hash_range(
@@ -41,15 +41,15 @@ namespace
      *
      * @param prng Pseudo-random number generator to use.
      * @param size Total size of the synteny.
-     * @param p_length Parameter defining the geometric distriubtion of
-     * a segment’s length.
+     * @param get_length Geometric distribution of a segment’s length,
+     * minus one.
      * @return Interval of the randomly-drew segment.
      */
     template<typename PRNG>
     Synteny::Segment get_random_segment(
         PRNG& prng,
         std::size_t size,
-        double p_length)
+        std::geometric_distribution<std::size_t>& get_length)
     {
         if (size == 0)
         {
@@ -58,7 +58,6 @@ namespace
         }
 
         // Randomly choose a length for the segment
-        std::geometric_distribution<std::size_t> get_length{p_length};
         auto length = clamp(
             get_length(prng) + 1,
             static_cast<std::size_t>(1),
@@ -76,37 +75,35 @@ namespace
      * Randomly rearrange some pairs of gene families inside a synteny.
      *
      * @param prng Pseudo-random generator to use.
-     * @param base Original synteny.
-     * @param p_rearr Parameter defining the geometric distribution of the
-     * number of rearranged pairs.
-     * @return Randomly rearranged synteny.
+     * @param synteny Synteny to rearrange in place.
+     * @param choose_pair_count Geometric distribution of the number of
+     * rearranged pairs.
      */
     template<typename PRNG>
-    Synteny get_random_rearrangement(
+    void random_rearrange(
         PRNG& prng,
-        Synteny base,
-        double p_rearr)
+        Synteny& synteny,
+        std::geometric_distribution<int>& choose_pair_count)
     {
-        std::geometric_distribution<int> choose_pair_count{p_rearr};
-        std::uniform_int_distribution<std::size_t> get_index{0, base.size() - 1};
-
-        if (base.size() <= 1)
+        if (synteny.size() <= 1)
         {
             // We need at least one pair to be able to rearrange
-            return base;
+            return;
         }
 
+        std::uniform_int_distribution<std::size_t> get_index{
+            0, synteny.size() - 1};
         auto pair_count = choose_pair_count(prng);
 
         for (int i = 0; i < pair_count; ++i)
         {
             using std::swap;
-            auto first = std::next(begin(base), get_index(prng));
-            auto second = std::next(begin(base), get_index(prng));
+            auto first = get_index(prng);
+            auto second = get_index(prng);
 
             if (first != second)
             {
-                swap(*first, *second);
+                swap(synteny[first], synteny[second]);
             }
             else
             {
@@ -115,152 +112,203 @@ namespace
                 --i;
             }
         }
-
-        return base;
     }
 
     /**
-     * Simulate a sequence of losses and create a tree of loss events
-     * recording the loss sequence. This function recurses into
-     * `simulate_evolution` whenever it is chosen not to incur losses
-     * anymore.
+     * Builder of a simulated event tree.
      *
-     * @param prng Pseudo-random number generator to use.
-     * @param params Parameters for the simulation.
-     * @return Simulated event tree.
+     * Nodes are appended directly to a single output tree, from the root
+     * down to the leaves, and distributions are only created once per
+     * simulation. Random choices are made in the same order as a bottom-up
+     * construction would make them (each node before its left subtree,
+     * and its left subtree before its right subtree), so that a given seed
+     * always yields the same tree.
      */
     template<typename PRNG>
-    ::tree<Event> simulate_losses(PRNG& prng, SimulationParams params)
+    class EvolutionSimulator
     {
-        std::discrete_distribution<int> choose_loss{
-            1 - params.p_loss, params.p_loss};
-
-        if (choose_loss(prng) && !params.base.empty())
+    public:
+        using iterator = typename ::tree<Event>::iterator;
+
+        EvolutionSimulator(
+            PRNG& prng,
+            const SimulationParams& params,
+            ::tree<Event>& result)
+        : prng(prng)
+        , result(result)
+        , choose_segment_left_child{0.5, 0.5}
+        , choose_event_type{
+            0,                // probability for None
+            params.p_dup,     // probability for Duplication
+            1 - params.p_dup, // probability for Speciation
+            0}                // probability for Loss
+        , choose_loss{1 - params.p_loss, params.p_loss}
+        , get_dup_length{params.p_dup_length}
+        , get_loss_length{params.p_loss_length}
+        , choose_pair_count{params.p_rearr}
+        {}
+
+        /**
+         * Simulate the evolution of a synteny.
+         *
+         * @param node Node of the output tree in which to store the first
+         * event. Children of this node are appended to the output tree.
+         * @param synteny Synteny of the node.
+         * @param depth Maximum depth of events below the node, not counting
+         * losses.
+         */
+        void evolve(iterator node, Synteny synteny, int depth)
         {
-            // Randomly select a segment to be removed from the synteny
-            auto segment = get_random_segment(
-                prng, params.base.size(),
-                params.p_loss_length);
+            auto& event = *node;
 
-            Event root;
-            root.type = Event::Type::Loss;
-            root.synteny = params.base;
-            root.segment = segment;
+            if (synteny.empty())
+            {
+                // The synteny has been completely lost: create a full
+                // loss node
+                event.type = Event::Type::Loss;
+                ++this->dl_score;
+                return;
+            }
 
-            ::tree<Event> result{std::move(root)};
+            if (depth <= 0)
+            {
+                // We have reached maximum depth: end the branch here
+                event.synteny = std::move(synteny);
+                return;
+            }
+
+            auto type = static_cast<Event::Type>(
+                this->choose_event_type(this->prng));
+            event.type = type;
 
-            // Actually apply the removal before recursing to generate
-            // children based on the appropriate synteny
-            params.base.erase(
-                std::next(std::cbegin(params.base), segment.first),
-                std::next(std::cbegin(params.base), segment.second));
+            Synteny synteny_left = synteny;
+            Synteny synteny_right = synteny;
 
-            if (!params.base.empty())
+            // For segmental duplications, either one of the children has a
+            // synteny that is a segment of the parent one (this segment
+            // may be the whole synteny)
+            if (type == Event::Type::Duplication)
             {
-                auto child = simulate_losses(prng, std::move(params));
-                result.append_child(result.begin(), child.begin());
+                auto& segmented = this->choose_segment_left_child(this->prng)
+                    ? synteny_left
+                    : synteny_right;
+
+                auto segment = get_random_segment(
+                    this->prng,
+                    segmented.size(),
+                    this->get_dup_length);
+
+                segmented.erase(
+                    std::next(std::cbegin(segmented), segment.second),
+                    std::cend(segmented));
+                segmented.erase(
+                    std::cbegin(segmented),
+                    std::next(std::cbegin(segmented), segment.first));
+
+                event.segment = segment;
+                ++this->dl_score;
             }
 
-            return result;
-        }
-        else
-        {
-            return simulate_evolution(prng, std::move(params));
-        }
-    }
-}
+            // Randomly introduce rearrangements into the child syntenies
+            random_rearrange(
+                this->prng, synteny_left,
+                this->choose_pair_count);
 
-template<typename PRNG>
-::tree<Event> simulate_evolution(PRNG& prng, SimulationParams params)
-{
-    std::discrete_distribution<int> choose_segment_left_child{0.5, 0.5};
-    std::discrete_distribution<int> choose_event_type{
-        0,                // probability for None
-        params.p_dup,     // probability for Duplication
-        1 - params.p_dup, // probability for Speciation
-        0};               // probability for Loss
+            random_rearrange(
+                this->prng, synteny_right,
+                this->choose_pair_count);
 
-    Event root;
-    root.synteny = params.base;
+            event.synteny = std::move(synteny);
 
-    if (params.base.empty())
-    {
-        // The synteny has been completely lost: create a full loss node
-        root.type = Event::Type::Loss;
-        return ::tree<Event>{root};
-    }
-    else if (params.depth <= 0)
-    {
-        // We have reached maximum depth: end the branch here
-        return ::tree<Event>{root};
-    }
-    else
-    {
-        auto type = static_cast<Event::Type>(choose_event_type(prng));
-        root.type = type;
+            // Randomly introduce losses, which can be cascaded
+            this->lose(
+                this->result.append_child(node, Event{}),
+                std::move(synteny_left), depth - 1);
 
-        Synteny synteny_left = params.base;
-        Synteny synteny_right = params.base;
+            this->lose(
+                this->result.append_child(node, Event{}),
+                std::move(synteny_right), depth - 1);
+        }
 
-        // For segmental duplications, either one of the children has a
-        // synteny that is a segment of the parent one (this segment
-        // may be the whole synteny)
-        if (type == Event::Type::Duplication)
+        /**
+         * Simulate a sequence of losses recorded as a chain of loss events,
+         * followed by the evolution of the remaining synteny whenever it is
+         * chosen not to incur losses anymore.
+         *
+         * @param node Node of the output tree in which to store the first
+         * event.
+         * @param synteny Synteny of the node.
+         * @param depth Maximum depth of events below the node, not counting
+         * losses.
+         */
+        void lose(iterator node, Synteny synteny, int depth)
         {
-            if (choose_segment_left_child(prng))
+            while (this->choose_loss(this->prng) && !synteny.empty())
             {
+                // Randomly select a segment to be removed from the synteny
                 auto segment = get_random_segment(
-                    prng,
-                    synteny_left.size(),
-                    params.p_dup_length);
-
-                synteny_left = Synteny(
-                    std::next(std::cbegin(synteny_left), segment.first),
-                    std::next(std::cbegin(synteny_left), segment.second));
-
-                root.segment = segment;
+                    this->prng, synteny.size(),
+                    this->get_loss_length);
+
+                auto& event = *node;
+                event.type = Event::Type::Loss;
+                event.synteny = synteny;
+                event.segment = segment;
+                ++this->dl_score;
+
+                // Actually apply the removal before continuing to generate
+                // children based on the appropriate synteny
+                synteny.erase(
+                    std::next(std::cbegin(synteny), segment.first),
+                    std::next(std::cbegin(synteny), segment.second));
+
+                if (synteny.empty())
+                {
+                    return;
+                }
+
+                node = this->result.append_child(node, Event{});
             }
-            else
-            {
-                auto segment = get_random_segment(
-                    prng,
-                    synteny_right.size(),
-                    params.p_dup_length);
 
-                synteny_right = Synteny(
-                    std::next(std::cbegin(synteny_right), segment.first),
-                    std::next(std::cbegin(synteny_right), segment.second));
-
-                root.segment = segment;
-            }
+            this->evolve(node, std::move(synteny), depth);
         }
 
-        // Randomly introduce rearrangements into the child syntenies
-        synteny_left = get_random_rearrangement(
-            prng, synteny_left,
-            params.p_rearr);
-
-        synteny_right = get_random_rearrangement(
-            prng, synteny_right,
-            params.p_rearr);
-
-        // Randomly introduce losses, which can be cascaded
-        SimulationParams params_left = params;
-        --params_left.depth;
-        params_left.base = synteny_left;
-
-        auto child_left = simulate_losses(prng, params_left);
+        /**
+         * Get the number of duplications and losses simulated so far.
+         */
+        unsigned getDLScore() const
+        {
+            return this->dl_score;
+        }
 
-        SimulationParams params_right = params;
-        --params_right.depth;
-        params_right.base = synteny_right;
+    private:
+        PRNG& prng;
+        ::tree<Event>& result;
+
+        std::discrete_distribution<int> choose_segment_left_child;
+        std::discrete_distribution<int> choose_event_type;
+        std::discrete_distribution<int> choose_loss;
+        std::geometric_distribution<std::size_t> get_dup_length;
+        std::geometric_distribution<std::size_t> get_loss_length;
+        std::geometric_distribution<int> choose_pair_count;
+        unsigned dl_score = 0;
+    };
+}
 
-        auto child_right = simulate_losses(prng, params_right);
+template<typename PRNG>
+::tree<Event> simulate_evolution(
+    PRNG& prng,
+    const SimulationParams& params,
+    unsigned* dl_score)
+{
+    ::tree<Event> result{Event{}};
+    EvolutionSimulator<PRNG> simulator{prng, params, result};
+    simulator.evolve(result.begin(), params.base, params.depth);
 
-        // Assemble children and root into the final tree
-        ::tree<Event> result{std::move(root)};
-        result.append_child(result.begin(), child_left.begin());
-        result.append_child(result.begin(), child_right.begin());
-        return result;
+    if (dl_score != nullptr)
+    {
+        *dl_score = simulator.getDLScore();
     }
+
+    return result;
 }
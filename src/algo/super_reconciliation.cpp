@@ -1,384 +1,2023 @@
+#include "super_reconciliation.hpp"
 #include "../model/Event.hpp"
-#include "../util/ExtendedNumber.hpp"
-#include <map>
+#include "../model/Mask.hpp"
+#include "../util/SaturatingNumber.hpp"
+#include "../util/SpillFile.hpp"
+#include "../util/bits.hpp"
+#include <algorithm>
+#include <atomic>
+#include <boost/container_hash/hash.hpp>
+#include <cstdint>
+#include <cstring>
+#include <exception>
+#include <memory>
+#include <omp.h>
+#include <sstream>
+#include <stdexcept>
 #include <tree.hh>
+#include <tuple>
+#include <unordered_map>
+#include <vector>
+
+namespace
+{
+// Costs (number of segmental duplications and losses) are modeled by a
+// saturating integer whose largest value represents infinity, so that the
+// loops that add and compare costs do not branch. The cost of a subtree
+// grows with its number of nodes rather than with the width of the
+// ancestral synteny, so costs keep the same width for all mask types:
+// a narrower type would saturate to infinity on large trees
+using Cost = SaturatingNumber<std::uint32_t>;
+
+// For each node, we call a “candidate synteny” a possible synteny
+// affectation for this node. Each candidate is a subsequence of the
+// ancestral synteny and is therefore represented by a mask over the
+// positions of the ancestral synteny. The following structure stores
+// the optimal child assignations of a candidate synteny, which is all
+// that is needed to trace back the solution once costs are known
+struct Choice
+{
+public:
+    // If this candidate is optimal, then its two optimal child
+    // assignations are the candidates stored at the following indices in
+    // the tables of the children. If the node is a leaf, then these values
+    // are not significant
+    std::uint32_t index_left = 0;
+    std::uint32_t index_right = 0;
+
+    // If this is a duplication, the following flags mark whether one
+    // of the children were partially duplicated
+    bool partial_left = false;
+    bool partial_right = false;
+};
+
+// Data structure storing all candidates for a given node. Only candidates
+// that may have a finite cost are stored: those are the masks that contain
+// all the `required` positions and whose other positions are `optional`
+struct CandidateTable
+{
+    // Positions that are part of every candidate with a finite cost
+    Mask required = 0;
+
+    // Positions that may be part of a candidate with a finite cost, in
+    // addition to the required positions
+    Mask optional = 0;
+
+    // Each candidate has a (potentially infinite) cost. It is the value
+    // of d(v, X) as defined in the article, such that v is the node for
+    // which X is a candidate synteny. Costs are only needed until the
+    // parent node is solved and are released afterwards. The candidate
+    // whose mask is `required | deposit_bits(i, optional)` is stored at
+    // index i of this vector and of the next one
+    std::vector<Cost> costs;
+
+    // Optimal child assignations of each candidate, kept until traceback
+    std::vector<Choice> choices;
+
+    // If the choices were moved to the spill file of the computation, their
+    // offset in that file, or `in_memory` otherwise
+    std::size_t spill_offset = in_memory;
+
+    static constexpr std::size_t in_memory = static_cast<std::size_t>(-1);
+
+    /**
+     * Allocate entries for all the candidates of this table.
+     *
+     * @param has_choices Whether to store child assignations or not.
+     * @throws std::invalid_argument If there are too many candidates to
+     * be addressed by a choice.
+     */
+    void allocate(bool has_choices)
+    {
+        auto width = popcount(this->optional);
+
+        if (width >= 32)
+        {
+            std::ostringstream message;
+            message << "Too many candidates (2^" << width << ") to "
+                "store for a single node.";
+            throw std::invalid_argument{message.str()};
+        }
+
+        auto size = std::size_t{1} << width;
+        this->costs.assign(size, Cost::positiveInfinity());
+        this->spill_offset = in_memory;
+
+        if (has_choices)
+        {
+            this->choices.assign(size, Choice{});
+        }
+    }
+
+    /**
+     * Get the number of candidates in this table.
+     */
+    std::size_t size() const
+    {
+        return std::size_t{1} << popcount(this->optional);
+    }
+
+    /**
+     * Get the mask of the candidate stored at a given index.
+     */
+    Mask mask(std::size_t index) const
+    {
+        return this->required | deposit_bits<Mask>(index, this->optional);
+    }
+
+    /**
+     * Get the index at which a candidate is stored.
+     */
+    std::size_t index(Mask mask) const
+    {
+        return extract_bits(mask, this->optional);
+    }
+
+    /**
+     * Get the child assignations of the candidate stored at a given index.
+     *
+     * @param index Index of the candidate.
+     * @param spilled Start of the mapped spill file of the computation, if
+     * the choices were moved there.
+     */
+    Choice choice(std::size_t index, const char* spilled) const
+    {
+        if (this->spill_offset == in_memory)
+        {
+            return this->choices[index];
+        }
+
+        Choice result;
+        std::memcpy(
+            &result,
+            spilled + this->spill_offset + index * sizeof(Choice),
+            sizeof(Choice));
+        return result;
+    }
+};
+
+constexpr std::size_t CandidateTable::in_memory;
+
+/**
+ * Storage for the cost vectors of candidate tables that are not in use
+ * anymore, which is handed back to new tables instead of being freed. Cost
+ * vectors are large and short-lived, so that recycling them saves most of
+ * the allocations of the computation, while keeping the number of live
+ * vectors bounded by the width of the tree.
+ */
+class CostPool
+{
+public:
+    /**
+     * Take a vector from the pool, or an empty one if the pool is empty.
+     */
+    std::vector<Cost> take()
+    {
+        std::vector<Cost> result;
+
+        #pragma omp critical(super_reconciliation_cost_pool)
+        if (!this->vectors.empty())
+        {
+            result = std::move(this->vectors.back());
+            this->vectors.pop_back();
+        }
+
+        return result;
+    }
+
+    /**
+     * Give a vector back to the pool, leaving it empty.
+     */
+    void give(std::vector<Cost>& costs)
+    {
+        if (costs.capacity() == 0)
+        {
+            return;
+        }
+
+        #pragma omp critical(super_reconciliation_cost_pool)
+        this->vectors.push_back(std::move(costs));
+
+        costs.clear();
+    }
+
+private:
+    std::vector<std::vector<Cost>> vectors;
+};
+
+/**
+ * Spell out the subsequence of a synteny that is encoded by a mask.
+ *
+ * @param genes Genes of the synteny, indexed by position.
+ * @param mask Mask of the subsequence.
+ * @return Subsequence synteny.
+ */
+Synteny get_subsequence(const std::vector<Gene>& genes, Mask mask)
+{
+    Synteny result;
+
+    for (; mask != 0; mask &= mask - 1)
+    {
+        result.push_back(genes[popcount(lowest_bit(mask) - 1)]);
+    }
+
+    return result;
+}
+
+/**
+ * Find the segment of a parent synteny that is duplicated to produce a
+ * partially duplicated child, from the masks of both syntenies (see
+ * `find_duplicated_segment`).
+ *
+ * @param mask_parent Mask of the synteny of the duplication node.
+ * @param mask_child Mask of the synteny of the child, a subset of the
+ * parent mask.
+ * @return Positions in the parent synteny of the first gene of the child
+ * and past its last gene.
+ */
+Synteny::Segment get_duplicated_segment(Mask mask_parent, Mask mask_child)
+{
+    auto kept = extract_bits(mask_child, mask_parent);
+
+    if (kept == 0)
+    {
+        // All the genes are lost at both ends
+        return Synteny::Segment{
+            static_cast<std::size_t>(popcount(mask_parent)), 0};
+    }
+
+    return Synteny::Segment{
+        static_cast<std::size_t>(popcount(lowest_bit(kept) - 1)),
+        static_cast<std::size_t>(popcount((highest_bit(kept) << 1) - 1))};
+}
+
+/**
+ * Insert the loss nodes between a node and one of its children, given the
+ * masks of their syntenies (see `resolve_losses`). Lost segments are the
+ * runs of consecutive genes of the parent that the child does not keep,
+ * which are all found at once by comparing the masks. They are inserted
+ * from left to right, each loss node having the synteny of the previous
+ * one without its lost segment, and the first one sharing the synteny of
+ * the parent.
+ *
+ * @param tree Tree to modify.
+ * @param parent Parent node, whose synteny must be set.
+ * @param child Child node.
+ * @param mask_parent Mask of the parent synteny.
+ * @param mask_child Mask of the child synteny, a subset of the parent mask.
+ * @param substring Whether losses at either end of the parent are free,
+ * because the child comes from a segmental duplication.
+ * @param ancestral_genes Genes of the ancestral synteny.
+ * @param [inserted] Incremented by the number of inserted loss nodes.
+ * @return True if and only if the child was removed from the tree, because
+ * all the genes of the parent are lost.
+ */
+bool insert_losses(
+    ::tree<Event>& tree,
+    ::tree<Event>::iterator parent,
+    ::tree<Event>::iterator child,
+    Mask mask_parent,
+    Mask mask_child,
+    bool substring,
+    const std::vector<Gene>& ancestral_genes,
+    std::size_t& inserted)
+{
+    // There can be no evolution from an empty set of genes
+    if (mask_parent == 0)
+    {
+        tree.erase_children(parent);
+        parent->type = Event::Type::Loss;
+        return true;
+    }
+
+    // Work on the positions of the genes in the parent synteny
+    auto remaining = (Mask{1} << popcount(mask_parent)) - 1;
+    auto kept = extract_bits(mask_child, mask_parent);
+    auto lost = remaining & ~kept;
+
+    if (substring)
+    {
+        // Losses at either end of a partially duplicated child are free
+        lost = kept == 0 ? 0 : lost
+            & ~(lowest_bit(kept) - 1)
+            & ((highest_bit(kept) << 1) - 1);
+    }
+
+    auto synteny = parent->synteny;
+    std::size_t removed = 0;
+
+    while (lost != 0)
+    {
+        // Lowest run of lost positions
+        auto first = lowest_bit(lost);
+        auto run = lost & ~(lost + first);
+        auto start = static_cast<std::size_t>(popcount(first - 1));
+        auto length = static_cast<std::size_t>(popcount(run));
+
+        Event loss;
+        loss.type = Event::Type::Loss;
+        loss.synteny = synteny;
+        loss.segment = Synteny::Segment{
+            start - removed, start - removed + length};
+
+        auto node = tree.wrap(child, loss);
+        ++inserted;
+        removed += length;
+        remaining &= ~run;
+        lost &= ~run;
+
+        if (remaining == 0)
+        {
+            tree.erase_children(node);
+            return true;
+        }
+
+        if (lost != 0)
+        {
+            synteny = SharedSynteny{get_subsequence(
+                ancestral_genes, deposit_bits(remaining, mask_parent))};
+        }
+    }
+
+    return false;
+}
+
+// Scratch buffers for the subsequences of a candidate, their indices in the
+// table of a child, and their distances to the candidate. Subsequences are
+// stored with the narrowest mask type that fits the ancestral synteny (see
+// `select_kernel`), which has a buffer of its own. Each thread owns its own
+// buffers
+struct Scratch
+{
+    std::tuple<
+        std::vector<std::uint8_t>,
+        std::vector<std::uint16_t>,
+        std::vector<std::uint32_t>,
+        std::vector<std::uint64_t>> sub_candidates;
+    std::vector<std::size_t> sub_indices;
+    std::vector<int> total_dists;
+    std::vector<int> partial_dists;
+
+    // Costs of the subsequences in the table of a child, and those costs
+    // increased by their distances to the candidate
+    std::vector<Cost> sub_costs;
+    std::vector<Cost> total_costs;
+    std::vector<Cost> partial_costs;
+
+    // Tables used for matching the syntenies of leaves
+    std::vector<char> prefix;
+    std::vector<char> suffix;
+};
+
+/**
+ * Find the positions of a base synteny that are used in any and in all the
+ * ways of extracting a target subsequence from the base synteny.
+ *
+ * @param base Base synteny.
+ * @param genes Target subsequence.
+ * @param [out] required Set to a set of positions used by all extractions.
+ * @param [out] allowed Set to the set of positions used by any extraction.
+ * @param scratch Scratch buffers of the calling thread.
+ */
+void find_subsequence_positions(
+    const std::vector<Gene>& base, const Synteny& genes,
+    Mask& required, Mask& allowed,
+    Scratch& scratch)
+{
+    auto n = base.size();
+    auto m = genes.size();
+    auto stride = m + 1;
+
+    // prefix[i][j] is true iff genes[0..j) can be extracted from base[0..i),
+    // suffix[i][j] is true iff genes[j..m) can be extracted from base[i..n).
+    // Both tables are stored row by row
+    auto& prefix = scratch.prefix;
+    auto& suffix = scratch.suffix;
+    prefix.assign((n + 1) * stride, false);
+    suffix.assign((n + 1) * stride, false);
+
+    for (std::size_t i = 0; i <= n; ++i)
+    {
+        prefix[i * stride] = true;
+        suffix[i * stride + m] = true;
+    }
+
+    for (std::size_t i = 1; i <= n; ++i)
+    {
+        for (std::size_t j = 1; j <= m; ++j)
+        {
+            prefix[i * stride + j] = prefix[(i - 1) * stride + j]
+                || (prefix[(i - 1) * stride + j - 1]
+                    && base[i - 1] == genes[j - 1]);
+        }
+    }
+
+    for (std::size_t i = n; i-- > 0;)
+    {
+        for (std::size_t j = m; j-- > 0;)
+        {
+            suffix[i * stride + j] = suffix[(i + 1) * stride + j]
+                || (suffix[(i + 1) * stride + j + 1] && base[i] == genes[j]);
+        }
+    }
+
+    required = allowed = 0;
+
+    // Position i can hold the j-th gene of the target iff the genes before
+    // and after it can be extracted around it. If the j-th gene can only be
+    // held by a single position, this position is used by all extractions
+    for (std::size_t j = 0; j < m; ++j)
+    {
+        Mask positions = 0;
+
+        for (std::size_t i = 0; i < n; ++i)
+        {
+            if (base[i] == genes[j] && prefix[i * stride + j]
+                    && suffix[(i + 1) * stride + j + 1])
+            {
+                positions |= Mask{1} << i;
+            }
+        }
+
+        allowed |= positions;
+
+        if (popcount(positions) == 1)
+        {
+            required |= positions;
+        }
+    }
+}
+
+/**
+ * Compute the candidate table of a leaf.
+ *
+ * @param leaf Leaf node.
+ * @param ancestral_genes Genes of the ancestral synteny.
+ * @param candidates Table to fill with the candidates of the leaf.
+ * @param scratch Scratch buffers of the calling thread.
+ * @return True if and only if at least one candidate has a finite cost.
+ */
+bool solve_leaf(
+    const Event& leaf,
+    const std::vector<Gene>& ancestral_genes,
+    CandidateTable& table,
+    Scratch& scratch)
+{
+    bool is_consistent = false;
+    Mask allowed = 0;
+
+    find_subsequence_positions(
+        ancestral_genes, leaf.synteny,
+        table.required, allowed,
+        scratch);
+
+    table.optional = allowed & ~table.required;
+    table.allocate(false);
+
+    // For leaves, the only possible candidates are the ones that spell out
+    // the synteny that is already affected: their cost is 0. We affect
+    // to all other candidates an infinite cost so that existing affectations
+    // are preserved
+    for (std::size_t index = 0; index < table.costs.size(); ++index)
+    {
+        auto candidate = table.mask(index);
+
+        if (popcount(candidate) != static_cast<int>(leaf.synteny.size()))
+        {
+            continue;
+        }
+
+        bool matches = true;
+        auto gene = std::cbegin(leaf.synteny);
+
+        for (auto rest = candidate; rest != 0; rest &= rest - 1, ++gene)
+        {
+            auto position = popcount(lowest_bit(rest) - 1);
+            matches = matches && ancestral_genes[position] == *gene;
+        }
+
+        if (matches)
+        {
+            table.costs[index] = 0;
+            is_consistent = true;
+        }
+    }
+
+    return is_consistent;
+}
+
+/**
+ * Choose the most advantageous scenario for a candidate of an internal node,
+ * given the best assignations of each of its children.
+ *
+ * @param is_duplication Whether the node is a duplication or a speciation.
+ * @param best_total_costs Least cost of each child when it is fully copied.
+ * @param best_partial_costs Least cost of each child when it is partially
+ * copied.
+ * @param best_total_indices Indices of the candidates of the children that
+ * reach the least costs when fully copied.
+ * @param best_partial_indices Indices of the candidates of the children that
+ * reach the least costs when partially copied.
+ * @param [info] Set to the child assignations of the chosen scenario.
+ * @return Cost of the chosen scenario.
+ */
+Cost choose_scenario(
+    bool is_duplication,
+    const Cost best_total_costs[2],
+    const Cost best_partial_costs[2],
+    const std::size_t best_total_indices[2],
+    const std::size_t best_partial_indices[2],
+    Choice& info)
+{
+    auto best_total_total = best_total_costs[0] + best_total_costs[1];
+    auto best_total_partial = best_total_costs[0] + best_partial_costs[1];
+    auto best_partial_total = best_partial_costs[0] + best_total_costs[1];
+
+    Cost cost;
+
+    if (!is_duplication)
+    {
+        // At speciation nodes, only one scenario is possible: both
+        // children were fully copied. If any losses occur, they are
+        // necessarily due to segmental losses following the speciation
+        // event and they have to be counted in the total cost
+        cost = best_total_total;
+        info.index_left = best_total_indices[0];
+        info.index_right = best_total_indices[1];
+    }
+    else
+    {
+        // At duplication nodes, we can consider at most one segmental
+        // duplication for one of the two children. We consider the most
+        // advantageous scenario between a full duplication, a segmental
+        // duplication on the left or a segmental duplication on the right
+        if (best_total_total <= best_total_partial
+            && best_total_total <= best_partial_total)
+        {
+            cost = Cost{1} + best_total_total;
+            info.index_left = best_total_indices[0];
+            info.index_right = best_total_indices[1];
+        }
+        else if (best_total_partial <= best_total_total
+            && best_total_partial <= best_partial_total)
+        {
+            cost = Cost{1} + best_total_partial;
+            info.index_left = best_total_indices[0];
+            info.index_right = best_partial_indices[1];
+            info.partial_right = true;
+        }
+        else if (best_partial_total <= best_total_total
+            && best_partial_total <= best_total_partial)
+        {
+            cost = Cost{1} + best_partial_total;
+            info.index_left = best_partial_indices[0];
+            info.partial_left = true;
+            info.index_right = best_total_indices[1];
+        }
+    }
+
+    return cost;
+}
+
+/**
+ * Compute a range of candidates of an internal node from the candidate
+ * tables of its two children.
+ *
+ * @tparam M Unsigned type in which candidates are handled, which must be
+ * wide enough for the ancestral synteny.
+ * @param node Internal node.
+ * @param left Left child of the node.
+ * @param left_table Candidate table of the left child.
+ * @param right Right child of the node.
+ * @param right_table Candidate table of the right child.
+ * @param first Index of the first candidate to compute.
+ * @param last Index of the last candidate to compute (inclusive).
+ * @param table Table of the node in which to store the candidates.
+ * @param scratch Scratch buffers of the calling thread.
+ * @return True if and only if at least one of the computed candidates
+ * has a finite cost.
+ */
+template<typename M>
+bool solve_candidates(
+    const Event& node,
+    const Event& left, const CandidateTable& left_table,
+    const Event& right, const CandidateTable& right_table,
+    std::size_t first, std::size_t last,
+    CandidateTable& table,
+    Scratch& scratch)
+{
+    bool is_consistent = false;
+    const Event* children[2] = {&left, &right};
+    const CandidateTable* children_tables[2] = {&left_table, &right_table};
+
+    for (std::size_t index = first; index <= last; ++index)
+    {
+        auto candidate = static_cast<M>(table.mask(index));
+        Cost best_total_costs[2], best_partial_costs[2];
+        std::size_t best_total_indices[2], best_partial_indices[2];
+
+        for (int child_index = 0; child_index < 2; ++child_index)
+        {
+            const auto& child = *children[child_index];
+            const auto& child_table = *children_tables[child_index];
+
+            Cost best_total_cost, best_partial_cost;
+            std::size_t best_total_index = 0, best_partial_index = 0;
+
+            best_total_cost = best_partial_cost = Cost::positiveInfinity();
+
+            // The child can only be assigned a subsequence of this
+            // candidate: if it needs positions that are absent from the
+            // candidate, the candidate is not valid
+            auto child_required = static_cast<M>(child_table.required);
+
+            if ((child_required & ~candidate) == 0)
+            {
+                // Enumerate the child candidates included in the current
+                // one, in increasing order (the subtraction borrows through
+                // the unset bits), and their indices in the child table.
+                // Since submasks of the optional positions and of their
+                // compressed counterpart are enumerated in the same order,
+                // both are advanced in lockstep
+                auto shared = static_cast<M>(
+                    candidate & child_table.optional);
+                auto shared_indices = extract_bits(
+                    Mask{shared}, child_table.optional);
+
+                auto& sub_candidates = std::get<std::vector<M>>(
+                    scratch.sub_candidates);
+                auto& sub_indices = scratch.sub_indices;
+                sub_candidates.clear();
+                sub_indices.clear();
+
+                M sub_candidate = 0;
+                Mask sub_index = 0;
+
+                do
+                {
+                    sub_candidates.push_back(child_required | sub_candidate);
+                    sub_indices.push_back(sub_index);
+                    sub_candidate = (sub_candidate - shared) & shared;
+                    sub_index = (sub_index - shared_indices) & shared_indices;
+                }
+                while (sub_candidate != 0);
+
+                auto sub_count = sub_candidates.size();
+                auto& total_dists = scratch.total_dists;
+                auto& partial_dists = scratch.partial_dists;
+                total_dists.resize(sub_count);
+                partial_dists.resize(sub_count);
+
+                // The distance to a child loss node is always zero,
+                // because it encodes a loss **from** this node’s synteny
+                if (child.type == Event::Type::Loss)
+                {
+                    std::fill(
+                        std::begin(total_dists),
+                        std::end(total_dists), 0);
+                    std::fill(
+                        std::begin(partial_dists),
+                        std::end(partial_dists), 0);
+                }
+                else
+                {
+                    distance(
+                        candidate, sub_candidates.data(), sub_count,
+                        total_dists.data());
+
+                    distance(
+                        candidate, sub_candidates.data(), sub_count,
+                        partial_dists.data(), true);
+                }
+
+                auto& sub_costs = scratch.sub_costs;
+                auto& total_costs = scratch.total_costs;
+                auto& partial_costs = scratch.partial_costs;
+                sub_costs.resize(sub_count);
+                total_costs.resize(sub_count);
+                partial_costs.resize(sub_count);
+
+                for (std::size_t i = 0; i < sub_count; ++i)
+                {
+                    sub_costs[i] = child_table.costs[sub_indices[i]];
+                }
+
+                // Search for the syntenies that have the least total cost
+                // and for the ones that have the least partial cost
+                add_each(
+                    sub_costs.data(), total_dists.data(), sub_count,
+                    total_costs.data());
+                add_each(
+                    sub_costs.data(), partial_dists.data(), sub_count,
+                    partial_costs.data());
+
+                auto best_total = find_min(total_costs.data(), sub_count);
+                best_total_cost = total_costs[best_total];
+                best_total_index = sub_indices[best_total];
+
+                auto best_partial = find_min(
+                    partial_costs.data(), sub_count);
+                best_partial_cost = partial_costs[best_partial];
+                best_partial_index = sub_indices[best_partial];
+            }
+
+            best_total_costs[child_index] = best_total_cost;
+            best_partial_costs[child_index] = best_partial_cost;
+            best_total_indices[child_index] = best_total_index;
+            best_partial_indices[child_index] = best_partial_index;
+        } // end loop on children
+
+        auto& cost = table.costs[index];
+        cost = choose_scenario(
+            node.type == Event::Type::Duplication,
+            best_total_costs, best_partial_costs,
+            best_total_indices, best_partial_indices,
+            table.choices[index]);
+
+        if (!cost.isInfinity())
+        {
+            is_consistent = true;
+        }
+    } // end loop on candidates
+
+    return is_consistent;
+}
+
+// Signature shared by all the specializations of `solve_candidates`
+using CandidatesKernel = bool (*)(
+    const Event&,
+    const Event&, const CandidateTable&,
+    const Event&, const CandidateTable&,
+    std::size_t, std::size_t,
+    CandidateTable&,
+    Scratch&);
+
+/**
+ * Select the specialization of `solve_candidates` that handles candidates
+ * in the narrowest type that fits an ancestral synteny. Narrower masks fit
+ * more subsequences in each cache line and in each vector register when
+ * computing distances, and syntenies of at most 8 genes use precomputed
+ * distances (see `distance` in Mask.hpp).
+ *
+ * @param width Number of genes in the ancestral synteny.
+ * @return Specialized kernel.
+ */
+CandidatesKernel select_kernel(std::size_t width)
+{
+    if (width <= 8)
+    {
+        return &solve_candidates<std::uint8_t>;
+    }
+
+    if (width <= 16)
+    {
+        return &solve_candidates<std::uint16_t>;
+    }
+
+    if (width <= 32)
+    {
+        return &solve_candidates<std::uint32_t>;
+    }
+
+    return &solve_candidates<std::uint64_t>;
+}
+
+/**
+ * Compute all the candidates of an internal node on the default OpenMP
+ * target device, with the same rules as `solve_candidates`. Each candidate
+ * is evaluated by a device thread that enumerates the subsequences of the
+ * candidate in the tables of the children directly, without scratch
+ * buffers. If no device is available, the computation falls back to the
+ * host.
+ *
+ * The costs of both children must already be present on the device (see
+ * `DeviceTables`), and the costs of the node are left there so that its
+ * parent can read them. Only the child assignations of the candidates are
+ * copied back to the host.
+ *
+ * @param node Internal node.
+ * @param left Left child of the node.
+ * @param left_table Candidate table of the left child.
+ * @param right Right child of the node.
+ * @param right_table Candidate table of the right child.
+ * @param table Table of the node in which to store the candidates.
+ * @return True if and only if at least one candidate has a finite cost.
+ */
+bool solve_candidates_on_device(
+    const Event& node,
+    const Event& left, const CandidateTable& left_table,
+    const Event& right, const CandidateTable& right_table,
+    CandidateTable& table)
+{
+    bool is_duplication = node.type == Event::Type::Duplication;
+    bool is_left_loss = left.type == Event::Type::Loss;
+    bool is_right_loss = right.type == Event::Type::Loss;
+
+    // Only scalars and arrays can be mapped to the device
+    const Cost* left_costs = left_table.costs.data();
+    const Cost* right_costs = right_table.costs.data();
+    auto left_size = left_table.size();
+    auto right_size = right_table.size();
+    Mask left_required = left_table.required;
+    Mask left_optional = left_table.optional;
+    Mask right_required = right_table.required;
+    Mask right_optional = right_table.optional;
+
+    Cost* costs = table.costs.data();
+    Choice* choices = table.choices.data();
+    auto size = table.size();
+    Mask required = table.required;
+    Mask optional = table.optional;
+    bool is_consistent = false;
+
+    #pragma omp target teams distribute parallel for \
+        map(to: left_costs[0:left_size], right_costs[0:right_size]) \
+        map(alloc: costs[0:size]) map(from: choices[0:size]) \
+        reduction(||: is_consistent)
+    for (std::size_t index = 0; index < size; ++index)
+    {
+        Mask candidate = required | deposit_bits<Mask>(index, optional);
+        Mask first_position = lowest_bit(candidate);
+        Mask last_position = highest_bit(candidate);
+        Cost best_total_costs[2], best_partial_costs[2];
+        std::size_t best_total_indices[2], best_partial_indices[2];
+
+        for (int child_index = 0; child_index < 2; ++child_index)
+        {
+            const Cost* child_costs = child_index == 0
+                ? left_costs : right_costs;
+            Mask child_required = child_index == 0
+                ? left_required : right_required;
+            Mask child_optional = child_index == 0
+                ? left_optional : right_optional;
+            bool is_loss = child_index == 0 ? is_left_loss : is_right_loss;
+
+            auto best_total_cost = Cost::positiveInfinity();
+            auto best_partial_cost = Cost::positiveInfinity();
+            std::size_t best_total_index = 0, best_partial_index = 0;
+
+            if ((child_required & ~candidate) == 0)
+            {
+                // Enumerate the subsequences in the same order as
+                // `solve_candidates`, keeping the first best ones
+                Mask shared = candidate & child_optional;
+                Mask shared_indices = extract_bits(shared, child_optional);
+                Mask sub_candidate = 0;
+                Mask sub_index = 0;
+
+                do
+                {
+                    auto sub_cost = child_costs[sub_index];
+                    Cost total_cost = sub_cost;
+                    Cost partial_cost = sub_cost;
+
+                    // The distance to a child loss node is always zero,
+                    // because it encodes a loss **from** this node’s synteny
+                    if (!is_loss)
+                    {
+                        auto child_mask = child_required | sub_candidate;
+                        total_cost += Cost{static_cast<std::uint32_t>(
+                            detail::distance(
+                                candidate, child_mask,
+                                first_position, last_position, false))};
+                        partial_cost += Cost{static_cast<std::uint32_t>(
+                            detail::distance(
+                                candidate, child_mask,
+                                first_position, last_position, true))};
+                    }
+
+                    if (total_cost < best_total_cost)
+                    {
+                        best_total_cost = total_cost;
+                        best_total_index = sub_index;
+                    }
+
+                    if (partial_cost < best_partial_cost)
+                    {
+                        best_partial_cost = partial_cost;
+                        best_partial_index = sub_index;
+                    }
+
+                    sub_candidate = (sub_candidate - shared) & shared;
+                    sub_index = (sub_index - shared_indices) & shared_indices;
+                }
+                while (sub_candidate != 0);
+            }
+
+            best_total_costs[child_index] = best_total_cost;
+            best_partial_costs[child_index] = best_partial_cost;
+            best_total_indices[child_index] = best_total_index;
+            best_partial_indices[child_index] = best_partial_index;
+        }
+
+        Choice info;
+        costs[index] = choose_scenario(
+            is_duplication,
+            best_total_costs, best_partial_costs,
+            best_total_indices, best_partial_indices,
+            info);
+        choices[index] = info;
+        is_consistent = is_consistent || !costs[index].isInfinity();
+    }
+
+    return is_consistent;
+}
+
+/**
+ * Costs of the candidate tables that are present on the OpenMP target
+ * device, by postfix index of their node. Tables are removed from the
+ * device when their costs are released, and the remaining ones when the
+ * computation ends, even if it fails.
+ */
+class DeviceTables
+{
+public:
+    explicit DeviceTables(std::size_t node_count)
+    : tables(node_count, nullptr)
+    {}
+
+    DeviceTables(const DeviceTables&) = delete;
+    DeviceTables& operator=(const DeviceTables&) = delete;
+
+    ~DeviceTables()
+    {
+        for (std::size_t index = 0; index < this->tables.size(); ++index)
+        {
+            this->remove(index);
+        }
+    }
+
+    /**
+     * Copy the costs of a table computed on the host to the device.
+     */
+    void upload(std::size_t index, CandidateTable& table)
+    {
+        transfer(Transfer::Upload, table.costs.data(), table.costs.size());
+        this->tables[index] = &table;
+    }
+
+    /**
+     * Allocate the costs of a table that is computed on the device.
+     */
+    void allocate(std::size_t index, CandidateTable& table)
+    {
+        transfer(Transfer::Allocate, table.costs.data(), table.costs.size());
+        this->tables[index] = &table;
+    }
+
+    /**
+     * Copy the costs of a table computed on the device back to the host.
+     */
+    void download(std::size_t index)
+    {
+        auto& costs = this->tables[index]->costs;
+        transfer(Transfer::Download, costs.data(), costs.size());
+    }
+
+    /**
+     * Remove the costs of a table from the device, if they are present.
+     */
+    void remove(std::size_t index)
+    {
+        if (this->tables[index] == nullptr)
+        {
+            return;
+        }
+
+        auto& costs = this->tables[index]->costs;
+        transfer(Transfer::Remove, costs.data(), costs.size());
+        this->tables[index] = nullptr;
+    }
+
+private:
+    std::vector<CandidateTable*> tables;
+
+    enum class Transfer { Upload, Allocate, Download, Remove };
+
+    static void transfer(Transfer transfer, Cost* costs, std::size_t size)
+    {
+        if (transfer == Transfer::Upload)
+        {
+            #pragma omp target enter data map(to: costs[0:size])
+        }
+        else if (transfer == Transfer::Allocate)
+        {
+            #pragma omp target enter data map(alloc: costs[0:size])
+        }
+        else if (transfer == Transfer::Download)
+        {
+            #pragma omp target update from(costs[0:size])
+        }
+        else
+        {
+            #pragma omp target exit data map(delete: costs[0:size])
+        }
+    }
+};
+
+/**
+ * Nodes of an event tree indexed in postfix order. In this order, the
+ * subtree rooted at node i spans the indices [i - size(i) + 1, i], its
+ * right child is i - 1 and its left child is i - 1 - size(i - 1).
+ */
+struct PostOrder
+{
+    // Iterators to the nodes of the tree
+    std::vector<::tree<Event>::iterator> nodes;
+
+    // Index of the parent of each node, or `none` for the root node
+    std::vector<std::size_t> parents;
+
+    // Number of nodes in the subtree rooted at each node
+    std::vector<std::size_t> sizes;
+
+    static constexpr std::size_t none = static_cast<std::size_t>(-1);
+
+    std::size_t left(std::size_t index) const
+    {
+        return index - 1 - this->sizes[index - 1];
+    }
+
+    std::size_t right(std::size_t index) const
+    {
+        return index - 1;
+    }
+};
+
+constexpr std::size_t PostOrder::none;
+
+/**
+ * Index the nodes of a tree in postfix order.
+ *
+ * @param tree Tree to index.
+ * @param [result] Filled with the indexed nodes.
+ * @throws std::invalid_argument If the tree contains a node that has
+ * neither zero nor two children.
+ */
+void index_post_order(::tree<Event>& tree, PostOrder& result)
+{
+    auto count = tree.size();
+    result.nodes.clear();
+    result.nodes.reserve(count);
+    result.parents.assign(count, PostOrder::none);
+    result.sizes.clear();
+    result.sizes.reserve(count);
+
+    for (auto it = tree.begin_post(); it != tree.end_post(); ++it)
+    {
+        auto index = result.nodes.size();
+        auto children_count = tree.number_of_children(it);
+
+        if (children_count != 0 && children_count != 2)
+        {
+            std::ostringstream message;
+            message << "There is no valid candidate for the node "
+                << *it << " because it has " << children_count
+                << " children.";
+            throw std::invalid_argument{message.str()};
+        }
+
+        if (children_count == 2 && it->type != Event::Type::Speciation
+                && it->type != Event::Type::Duplication)
+        {
+            std::ostringstream message;
+            message << "Invalid event type on an internal node: "
+                << it->type;
+            throw std::invalid_argument{message.str()};
+        }
+
+        std::size_t size = 1;
+
+        if (children_count == 2)
+        {
+            auto right = index - 1;
+            auto left = right - result.sizes[right];
+            result.parents[left] = result.parents[right] = index;
+            size += result.sizes[left] + result.sizes[right];
+        }
+
+        result.nodes.push_back(it);
+        result.sizes.push_back(size);
+    }
+}
+
+/**
+ * Check whether a tree still has the shape that it had when its nodes were
+ * indexed, so that the indices can be reused.
+ *
+ * @param tree Tree to check.
+ * @param post_order Nodes of the tree when it was indexed.
+ * @return True if and only if the tree has the same nodes, in the same
+ * postfix order and under the same parents.
+ */
+bool has_same_shape(const ::tree<Event>& tree, const PostOrder& post_order)
+{
+    std::size_t index = 0;
+
+    for (auto it = tree.begin_post(); it != tree.end_post(); ++it, ++index)
+    {
+        if (index == post_order.nodes.size()
+                || post_order.nodes[index].node != it.node)
+        {
+            return false;
+        }
+
+        auto parent = post_order.parents[index];
+        auto expected = parent == PostOrder::none
+            ? nullptr
+            : post_order.nodes[parent].node;
+
+        if (it.node->parent != expected)
+        {
+            return false;
+        }
+    }
+
+    return index == post_order.nodes.size();
+}
+
+// Two subtrees belong to the same class if they have the same shape, the
+// same events and the same leaf syntenies, in which case their candidate
+// tables are identical. A class is identified by the type and synteny of
+// a leaf, or by the type and the classes of the children of an internal
+// node, encoded in the following key
+using ClassKey = std::vector<std::size_t>;
+
+struct ClassKeyHash
+{
+    std::size_t operator()(const ClassKey& key) const
+    {
+        return boost::hash_range(std::begin(key), std::end(key));
+    }
+};
+
+using ClassMap = std::unordered_map<ClassKey, std::size_t, ClassKeyHash>;
+
+/**
+ * Find the class of each node of a tree, adding the classes that were
+ * never seen before to a map.
+ *
+ * @param post_order Nodes of the tree in postfix order.
+ * @param classes Map of the known classes to their identifiers.
+ * @param key Scratch buffer for building the keys.
+ * @param [result] Filled with the class of each node. The root node is
+ * assigned an identifier of its own that is not added to the map, since
+ * its candidates differ from the ones of other nodes.
+ */
+void find_classes(
+    const PostOrder& post_order,
+    ClassMap& classes,
+    ClassKey& key,
+    std::vector<std::size_t>& result)
+{
+    auto node_count = post_order.nodes.size();
+    result.resize(node_count);
+
+    for (std::size_t index = 0; index + 1 < node_count; ++index)
+    {
+        const auto& node = *post_order.nodes[index];
+        key.clear();
+        key.push_back(static_cast<std::size_t>(node.type));
+
+        if (post_order.sizes[index] == 1)
+        {
+            for (const auto& gene : node.synteny)
+            {
+                key.push_back(gene.getId());
+            }
+        }
+        else
+        {
+            // Marker that no gene identifier can take, so that the keys of
+            // internal nodes never collide with the ones of leaves
+            key.push_back(static_cast<std::size_t>(-1));
+            key.push_back(result[post_order.left(index)]);
+            key.push_back(result[post_order.right(index)]);
+        }
+
+        auto found = classes.find(key);
+
+        if (found == classes.end())
+        {
+            found = classes.emplace(key, classes.size()).first;
+        }
+
+        result[index] = found->second;
+    }
+
+    result[node_count - 1] = classes.size();
+}
+}
+
+struct SuperReconciliationWorkspace::Buffers
+{
+    PostOrder post_order;
+    std::vector<CandidateTable> candidates_per_node;
+
+    // Class of each node, and for each class, the table that holds its
+    // candidates, the node that owns this table (or `none` if the table is
+    // cached) and the number of parents that remain to be solved from it
+    std::vector<std::size_t> node_classes;
+    std::vector<const CandidateTable*> class_tables;
+    std::vector<std::size_t> class_owners;
+    std::vector<std::size_t> class_uses;
+    ClassMap classes;
+    ClassKey class_key;
+
+    // Tables kept between computations, by class, which are valid for
+    // trees whose ancestral synteny is `cache_genes`
+    std::unordered_map<std::size_t, CandidateTable> cache;
+    std::vector<Gene> cache_genes;
+    std::size_t cache_candidates = 0;
+
+    // Whether the candidates of all the nodes of the last computed tree were
+    // kept, the postfix index of each node of that tree, the nodes that need
+    // to be solved again, and the nodes of the tree traced back into when it
+    // is not the computed one
+    bool is_retained = false;
+    std::unordered_map<const void*, std::size_t> retained_indices;
+    std::vector<char> dirty;
+    PostOrder output_order;
+
+    CostPool cost_pool;
+    std::vector<Gene> ancestral_genes;
+    std::vector<Scratch> scratches;
+    std::vector<std::size_t> initial_tasks;
+
+    // Mask of the assigned synteny of each node, and nodes that remain to be
+    // visited, during the traceback
+    std::vector<Mask> masks;
+    std::vector<std::size_t> traceback_stack;
+};
 
 namespace
 {
 /**
- * Make sure that, in an event tree, the distance in terms of losses between
- * a parent and one of its children is at most 1 for loss nodes and at most
- * 0 (ie. they have the same synteny) for other nodes by inserting loss nodes
- * where needed.
+ * Index the nodes of a tree, find their classes and find which nodes need
+ * to be solved, before solving all the nodes of a tree.
  *
- * @param tree Tree on which to check the condition.
- * @param parent Parent node.
- * @param child Child node.
- * @param substring Whether to check distances in substring mode or not.
+ * @param tree Tree to solve.
+ * @param buffers Buffers of the computation.
+ * @param params Parameters of the computation.
+ * @param is_shared Whether to solve identical subtrees only once.
  */
-void resolve_losses(
+void prepare_tables(
     ::tree<Event>& tree,
-    ::tree<Event>::iterator_base parent, ::tree<Event>::iterator_base child,
-    bool substring)
+    SuperReconciliationWorkspace::Buffers& buffers,
+    const SuperReconciliationParams& params,
+    bool is_shared)
 {
-    auto synteny_parent = parent->synteny;
-    auto synteny_child = child->synteny;
+    const auto& ancestral_synteny = std::begin(tree)->synteny;
+
+    // Associate each tree node (by postfix index) to its candidate syntenies.
+    // Tables left over from previous computations give their costs back to
+    // the pool, but keep their choices, which are overwritten when reused
+    auto& post_order = buffers.post_order;
+    index_post_order(tree, post_order);
+    auto node_count = post_order.nodes.size();
+    auto& candidates_per_node = buffers.candidates_per_node;
+    auto& cost_pool = buffers.cost_pool;
 
-    // If the parent is a loss node, consider its synteny to be as if the loss
-    // had already occurred
-    if (parent->type == Event::Type::Loss)
+    if (candidates_per_node.size() < node_count)
     {
-        synteny_parent.erase(
-            std::next(std::cbegin(synteny_parent), parent->segment.first),
-            std::next(std::cbegin(synteny_parent), parent->segment.second));
+        candidates_per_node.resize(node_count);
     }
 
-    // Edge case: if we happen to generate a internal node which has an empty
-    // synteny, we must make sure that it does not have any child, because
-    // there can be no evolution from an empty set of genes
-    if (synteny_parent.empty())
+    for (auto& table : candidates_per_node)
     {
-        tree.erase_children(parent);
-        parent->type = Event::Type::Loss;
-        return;
+        cost_pool.give(table.costs);
     }
 
-    // If the distance between the parent and the child syntenies is at
-    // least one, loss nodes need to be introduced between them
-    auto losses = synteny_parent.reconcile(synteny_child, substring);
+    // Genes of the ancestral synteny, indexed by position
+    auto& ancestral_genes = buffers.ancestral_genes;
+    ancestral_genes.assign(
+        std::cbegin(ancestral_synteny),
+        std::cend(ancestral_synteny));
+
+    auto& node_classes = buffers.node_classes;
+    auto& classes = buffers.classes;
+    auto& cache = buffers.cache;
+    std::size_t class_count = node_count;
 
-    if (losses.size() >= 1)
+    // Cached tables are only valid under the same ancestral synteny, and
+    // class identifiers are forgotten along with the cache so that the map
+    // of classes does not grow without bounds
+    if (!is_shared
+            || params.cache_size == 0
+            || buffers.cache_genes != ancestral_genes
+            || classes.size() > params.cache_classes)
     {
-        Event new_node;
-        new_node.type = Event::Type::Loss;
-        new_node.synteny = synteny_parent;
-        new_node.segment = losses.front();
+        cache.clear();
+        classes.clear();
+        buffers.cache_genes = ancestral_genes;
+        buffers.cache_candidates = 0;
+    }
 
-        auto new_child = tree.wrap(child, new_node);
-        resolve_losses(tree, new_child, child, substring);
-        return;
+    if (is_shared)
+    {
+        find_classes(post_order, classes, buffers.class_key, node_classes);
+        class_count = classes.size() + 1;
     }
-}
+    else
+    {
+        node_classes.resize(node_count);
 
-Synteny::Segment find_duplicated_segment(
-    const Synteny& synteny_parent,
-    const Synteny& synteny_child)
-{
-    auto losses = synteny_parent.reconcile(
-        synteny_child, false,
-        ExtendedNumber<int>::positiveInfinity());
+        for (std::size_t index = 0; index < node_count; ++index)
+        {
+            node_classes[index] = index;
+        }
+    }
 
-    auto max = synteny_parent.size();
-    auto result = Synteny::Segment(0, max);
+    // Find which nodes need to be solved: the first node of each class
+    // whose table is not cached. Tables of a class are kept until all the
+    // solved parents of that class are solved
+    auto& class_tables = buffers.class_tables;
+    auto& class_owners = buffers.class_owners;
+    auto& class_uses = buffers.class_uses;
+    class_tables.assign(class_count, nullptr);
+    class_owners.assign(class_count, PostOrder::none);
+    class_uses.assign(class_count, 0);
 
-    // We are interested in segments at the very start or end of the
-    // parent synteny. Those induce a reduction in the duplicated segment
-    for (const auto& loss : losses)
+    for (std::size_t index = 0; index < node_count; ++index)
     {
-        if (loss.first == 0)
+        auto node_class = node_classes[index];
+        auto cached = cache.find(node_class);
+
+        if (cached != cache.end())
         {
-            result.first = loss.second;
+            class_tables[node_class] = &cached->second;
         }
-
-        if (loss.second == max)
+        else if (class_owners[node_class] == PostOrder::none)
         {
-            result.second = loss.first;
+            class_owners[node_class] = index;
+
+            if (post_order.sizes[index] != 1)
+            {
+                ++class_uses[node_classes[post_order.left(index)]];
+                ++class_uses[node_classes[post_order.right(index)]];
+            }
         }
     }
-
-    return result;
 }
 
-unsigned get_dl_score_helper(tree<Event>& tree, ::tree<Event>::iterator root)
+/**
+ * Compute a Super-Reconciliation, or update a previous one.
+ *
+ * @param tree Synteny tree to reconcile.
+ * @param output Tree in which to store the result. If this is `tree`, the
+ * computation happens in place. Otherwise, `tree` is left unmodified, the
+ * result is traced back into a copy of it, and all the candidates are kept
+ * so that the computation can be updated later.
+ * @param buffers Buffers of the computation.
+ * @param params Parameters of the computation.
+ * @param edited If not null, nodes of `tree` that were edited since it was
+ * last computed with the same buffers. Only those nodes and their ancestors
+ * are solved again, if possible.
+ */
+void compute_super_reconciliation(
+    ::tree<Event>& tree,
+    ::tree<Event>& output,
+    SuperReconciliationWorkspace::Buffers& buffers,
+    const SuperReconciliationParams& params,
+    const std::vector<::tree<Event>::iterator>* edited)
 {
-    unsigned score = 0;
-
-    if (root->type == Event::Type::Duplication
-            || root->type == Event::Type::Loss)
+    // Exact solution to the problem using a dynamic programming approach,
+    // implementing the method described in “Reconstructing the History of
+    // Syntenies Through Super-Reconciliation” (El-Mabrouk et al., 2015)
+    if (tree.empty())
     {
-        score = 1;
+        if (&output != &tree)
+        {
+            output = tree;
+        }
+
+        if (params.stats != nullptr)
+        {
+            params.stats->dl_score = 0;
+        }
+
+        return;
     }
 
-    for (auto it = tree.begin(root); it != tree.end(root); ++it)
+    const auto& ancestral_synteny = std::begin(tree)->synteny;
+
+    if (ancestral_synteny.size() > max_mask_width)
     {
-        score += get_dl_score_helper(tree, it);
+        std::ostringstream message;
+        message << "The ancestral synteny (" << ancestral_synteny << ") must "
+            "contain at most " << max_mask_width << " genes.";
+        throw std::invalid_argument{message.str()};
     }
 
-    return score;
-}
-}
+    // Candidates are subsequences of the ancestral synteny, the ancestral
+    // synteny itself being the one with all positions
+    Mask ancestral_mask = (Mask{1} << ancestral_synteny.size()) - 1;
 
-int get_dl_score(tree<Event>& tree)
-{
-    return get_dl_score_helper(tree, std::begin(tree));
-}
+    auto& post_order = buffers.post_order;
+    auto& candidates_per_node = buffers.candidates_per_node;
+    auto& cost_pool = buffers.cost_pool;
+    auto& ancestral_genes = buffers.ancestral_genes;
+    auto& node_classes = buffers.node_classes;
+    auto& class_tables = buffers.class_tables;
+    auto& class_owners = buffers.class_owners;
+    auto& class_uses = buffers.class_uses;
+    auto& cache = buffers.cache;
 
-void super_reconciliation(tree<Event>& tree)
-{
-    // Exact solution to the problem using a dynamic programming approach,
-    // implementing the method described in “Reconstructing the History of
-    // Syntenies Through Super-Reconciliation” (El-Mabrouk et al., 2015)
-    if (tree.empty())
+    // An update only solves the edited nodes and their ancestors again. This
+    // requires the candidates of all the nodes of the same tree, with the
+    // same shape, to be kept from the previous computation, under the same
+    // ancestral synteny. Otherwise, all nodes are solved
+    bool is_retained = &output != &tree;
+    bool is_update = edited != nullptr
+        && buffers.is_retained
+        && has_same_shape(tree, post_order)
+        && ancestral_genes.size() == ancestral_synteny.size()
+        && std::equal(
+            std::cbegin(ancestral_genes), std::cend(ancestral_genes),
+            std::cbegin(ancestral_synteny))
+        && std::all_of(
+            std::cbegin(*edited), std::cend(*edited),
+            [&buffers](::tree<Event>::iterator node)
+            {
+                return buffers.retained_indices.count(node.node) != 0;
+            });
+
+    // Identical subtrees are only solved once when the computation is
+    // sequential, on the host and when candidates are not kept. Otherwise,
+    // each node is a class of its own
+    bool is_shared = params.share_subtrees && params.jobs == 1
+        && !is_retained && !params.device;
+
+    // Costs of retained candidates must stay on the host for later updates,
+    // and their choices in memory
+    bool use_device = params.device && !is_retained;
+    bool use_spill = !params.spill_directory.empty() && !is_retained;
+    buffers.is_retained = false;
+    auto& dirty = buffers.dirty;
+
+    if (is_update)
     {
-        return;
+        dirty.assign(post_order.nodes.size(), false);
+
+        for (auto node : *edited)
+        {
+            auto index = buffers.retained_indices[node.node];
+
+            while (index != PostOrder::none && !dirty[index])
+            {
+                dirty[index] = true;
+                index = post_order.parents[index];
+            }
+        }
+    }
+    else
+    {
+        prepare_tables(tree, buffers, params, is_shared);
+        dirty.assign(post_order.nodes.size(), true);
     }
 
-    // Costs (number of segmental duplications and losses) are modeled by an
-    // extended integer which correctly represents infinities
-    using Cost = ExtendedNumber<int>;
+    auto node_count = post_order.nodes.size();
+    DeviceTables device_tables{use_device ? node_count : 0};
+
+    // Choices of the solved internal nodes are moved out of memory as soon
+    // as their tables are complete, and read back by the traceback
+    std::unique_ptr<SpillFile> spill;
 
-    // For each node, we call a “candidate synteny” a possible synteny
-    // affectation for this node. The following structure stores information
-    // relative to a candidate synteny
-    struct Candidate
+    if (use_spill)
     {
-    public:
-        // Each candidate has a (potentially infinite) cost. It is the value
-        // of d(v, X) as defined in the article, such that v is the node for
-        // which X is a candidate synteny
-        Cost cost;
+        spill.reset(new SpillFile{params.spill_directory});
+    }
+
+    // Give the costs of a class back once its last solved parent is solved,
+    // unless all candidates are kept
+    auto release = [&](std::size_t index)
+    {
+        if (is_retained)
+        {
+            return;
+        }
+
+        auto node_class = node_classes[index];
+        auto owner = class_owners[node_class];
 
-        // If this candidate is optimal, then its two optimal child
-        // assignations are the following syntenies. If the node is a leaf,
-        // then these values are not significant
-        Synteny synteny_left;
-        Synteny synteny_right;
+        if (--class_uses[node_class] == 0 && owner != PostOrder::none)
+        {
+            if (use_device)
+            {
+                device_tables.remove(owner);
+            }
 
-        // If this is a duplication, the following flags mark whether one
-        // of the children were partially duplicated
-        bool partial_left = false;
-        bool partial_right = false;
+            cost_pool.give(candidates_per_node[owner].costs);
+        }
     };
 
-    // List of all possible candidates derived from the ancestral synteny
-    auto ancestral_synteny = std::begin(tree)->synteny;
-    auto possibilities = ancestral_synteny.generateSubsequences();
+    // Scratch buffers of each thread
+    auto thread_count = params.jobs == 0
+        ? static_cast<std::size_t>(omp_get_max_threads())
+        : std::size_t{params.jobs};
+    auto& scratches = buffers.scratches;
 
-    // Data structure storing all candidates for a given node. Here, we
-    // associate each candidate synteny (key of the map) to the informations
-    // relative to it (value of the map)
-    using CandidateMapping = std::map<Synteny, Candidate>;
+    if (scratches.size() < thread_count)
+    {
+        scratches.resize(thread_count);
+    }
 
-    // Associate each tree node (event) to its candidate syntenies
-    std::map<Event*, CandidateMapping> candidates_per_node;
+    if (params.stats != nullptr)
+    {
+        params.stats->candidates.assign(node_count, 0);
+        params.stats->finite_candidates.assign(node_count, 0);
+        params.stats->inserted_losses = 0;
+        params.stats->dl_score = 0;
+        params.stats->shared_nodes = 0;
+        params.stats->spilled_bytes = 0;
+    }
 
-    // Associate each tree node (event) to its best candidate synteny
-    std::map<Event*, Synteny> best_candidate_for_node;
+    auto solve_kernel = select_kernel(ancestral_synteny.size());
 
-    // Fill the `candidates_per_node` map with a dynamic programming,
-    // bottom-up (postfix order) approach
-    for (
-        auto it = tree.begin_post();
-        it != tree.end_post();
-        ++it)
+    // Compute the candidate table of a node whose children, if any, have
+    // already been solved
+    auto solve_node = [&](std::size_t index)
     {
-        CandidateMapping candidates;
+        const auto& node = *post_order.nodes[index];
+        auto& table = candidates_per_node[index];
         bool is_consistent = false;
-        auto children_count = tree.number_of_children(it);
 
-        if (children_count == 0)
+        // The sequential computation only has one scratch buffer, even when
+        // it runs inside a parallel region of the caller
+        auto scratch_index = [&params]()
+        {
+            return params.jobs == 1
+                ? std::size_t{0}
+                : static_cast<std::size_t>(omp_get_thread_num());
+        };
+
+        // Nodes that are solved again reuse their previous costs
+        if (table.costs.capacity() == 0)
+        {
+            table.costs = cost_pool.take();
+        }
+
+        if (post_order.sizes[index] == 1)
+        {
+            is_consistent = solve_leaf(
+                node, ancestral_genes, table,
+                scratches[scratch_index()]);
+
+            if (use_device)
+            {
+                device_tables.upload(index, table);
+            }
+        }
+        else
         {
-            // For leaves, the only possible candidate is the one that is
-            // already affected: its cost is 0. We affect to all other
-            // candidates an infinite cost so that existing affectations are
-            // preserved
-            for (const Synteny& candidate : possibilities)
+            auto left = post_order.left(index);
+            auto right = post_order.right(index);
+            const auto& left_table = *class_tables[node_classes[left]];
+            const auto& right_table = *class_tables[node_classes[right]];
+
+            // A candidate can only have a finite cost if it contains all
+            // positions that are required by its children. This is the same
+            // reasoning as in the initialization pass of the unordered
+            // Super-Reconciliation: genes that are present in a descendant
+            // must be present in its ancestors. In most trees, this set of
+            // positions is large, which leaves few candidates to evaluate.
+            // The root node is already assigned its synteny
+            table.required = left_table.required | right_table.required;
+
+            if (index + 1 == node_count)
+            {
+                table.required = ancestral_mask;
+            }
+
+            table.optional = ancestral_mask & ~table.required;
+            table.allocate(true);
+            std::size_t last = table.size() - 1;
+
+            if (use_device)
+            {
+                device_tables.allocate(index, table);
+                is_consistent = solve_candidates_on_device(
+                    node,
+                    *post_order.nodes[left], left_table,
+                    *post_order.nodes[right], right_table,
+                    table);
+
+                if (params.stats != nullptr)
+                {
+                    device_tables.download(index);
+                }
+            }
+            else if (params.jobs != 1 && table.size() >= params.split_size)
             {
-                Candidate info;
-                info.cost = Cost::positiveInfinity();
+                // Candidates are independent of each other. Wide tables are
+                // split into chunks that idle threads can pick up, which
+                // helps for narrow trees in which there are few independent
+                // subtrees to solve concurrently
+                std::atomic<bool> is_chunk_consistent{false};
 
-                if (candidate == it->synteny)
+                #pragma omp taskloop default(shared) \
+                    grainsize(params.grain_size)
+                for (std::size_t candidate = 0;
+                        candidate <= last;
+                        ++candidate)
                 {
-                    info.cost = 0;
-                    is_consistent = true;
+                    if (solve_kernel(
+                            node,
+                            *post_order.nodes[left], left_table,
+                            *post_order.nodes[right], right_table,
+                            candidate, candidate,
+                            table, scratches[scratch_index()]))
+                    {
+                        is_chunk_consistent = true;
+                    }
                 }
 
-                candidates.emplace(candidate, info);
+                is_consistent = is_chunk_consistent;
+            }
+            else
+            {
+                is_consistent = solve_kernel(
+                    node,
+                    *post_order.nodes[left], left_table,
+                    *post_order.nodes[right], right_table,
+                    0, last,
+                    table, scratches[scratch_index()]);
+            }
+        }
+
+        if (!is_consistent)
+        {
+            std::ostringstream message;
+            message << "There is no valid candidate for the node "
+                << node << " under the order of the root synteny ("
+                << ancestral_synteny << ").";
+            throw std::invalid_argument{message.str()};
+        }
+
+        if (params.stats != nullptr)
+        {
+            // Each node has its own entry, which can be written concurrently
+            params.stats->candidates[index] = table.size();
+            params.stats->finite_candidates[index] = std::count_if(
+                table.costs.cbegin(), table.costs.cend(),
+                [](Cost cost)
+                {
+                    return !cost.isInfinity();
+                });
+        }
+
+        // Costs of the children are not needed anymore once their parents
+        // are solved: only their optimal assignations are kept for traceback
+        if (post_order.sizes[index] != 1)
+        {
+            release(post_order.left(index));
+            release(post_order.right(index));
+        }
+
+        if (use_spill && post_order.sizes[index] != 1)
+        {
+            table.spill_offset = spill->append(
+                table.choices.data(),
+                table.choices.size() * sizeof(Choice));
+            std::vector<Choice>{}.swap(table.choices);
+        }
+
+        auto node_class = node_classes[index];
+        class_tables[node_class] = &table;
+
+        // Keep the table for later computations if it fits in the cache,
+        // along with the tables of its children since its choices refer
+        // to them
+        if (is_shared && !use_spill && index + 1 != node_count
+                && buffers.cache_candidates + table.size()
+                    <= params.cache_size
+                && (post_order.sizes[index] == 1
+                    || (cache.count(node_classes[post_order.left(index)])
+                        && cache.count(
+                            node_classes[post_order.right(index)]))))
+        {
+            buffers.cache_candidates += table.size();
+            auto& cached = cache[node_class];
+            cached = std::move(table);
+            table = CandidateTable{};
+            class_tables[node_class] = &cached;
+            class_owners[node_class] = PostOrder::none;
+        }
+    };
+
+    if (params.jobs == 1 || is_update)
+    {
+        // Fill the candidate tables with a dynamic programming, bottom-up
+        // (postfix order) approach
+        for (std::size_t index = 0; index < node_count; ++index)
+        {
+            if (!dirty[index])
+            {
+                continue;
+            }
+
+            if (class_owners[node_classes[index]] == index)
+            {
+                solve_node(index);
+            }
+            else if (params.stats != nullptr)
+            {
+                ++params.stats->shared_nodes;
             }
         }
-        else if (children_count == 2)
+    }
+    else
+    {
+        // Same dynamic programming, in which disjoint subtrees are solved
+        // concurrently. Subtrees smaller than the task size are solved
+        // sequentially by a single task. Each larger node waits for the
+        // completion of its two children: the task that completes the last
+        // child goes on to solve the parent, so that no task ever blocks
+        auto task_size = std::max<std::size_t>(params.task_size, 1);
+        std::vector<std::atomic<unsigned>> pending(node_count);
+        auto& initial_tasks = buffers.initial_tasks;
+        initial_tasks.clear();
+
+        for (std::size_t index = 0; index < node_count; ++index)
         {
-            for (const Synteny& candidate : possibilities)
+            auto parent = post_order.parents[index];
+
+            if (post_order.sizes[index] >= task_size)
             {
-                // For each candidate, evaluate the possible candidates that
-                // can be affected to the children. These children already have
-                // their candidates evaluated because the tree is traversed in
-                // postfix order
-                auto sub_possibilities = candidate.generateSubsequences();
-
-                std::vector<Cost> best_total_costs, best_partial_costs;
-                std::vector<Synteny> best_total_synts, best_partial_synts;
-
-                best_total_costs.reserve(children_count);
-                best_partial_costs.reserve(children_count);
-                best_total_synts.reserve(children_count);
-                best_partial_costs.reserve(children_count);
-
-                for (auto child = tree.begin(it);
-                     child != tree.end(it);
-                     ++child)
+                pending[index] = post_order.sizes[index] == 1 ? 0 : 2;
+
+                if (post_order.sizes[index] == 1)
                 {
-                    Cost best_total_cost, best_partial_cost;
-                    Synteny best_total_synt, best_partial_synt;
+                    initial_tasks.push_back(index);
+                }
+            }
+            else if (parent == PostOrder::none
+                    || post_order.sizes[parent] >= task_size)
+            {
+                initial_tasks.push_back(index);
+            }
+        }
 
-                    best_total_cost = best_partial_cost
-                        = Cost::positiveInfinity();
+        std::atomic<bool> has_failed{false};
+        std::exception_ptr failure;
 
-                    // Search for the syntenies that have the least total cost
-                    // and for the ones that have the least partial cost
-                    for (const Synteny& sub_candidate : sub_possibilities)
+        #pragma omp parallel num_threads(thread_count)
+        {
+            #pragma omp single
+            for (auto task : initial_tasks)
+            {
+                #pragma omp task firstprivate(task)
+                {
+                    try
                     {
-                        // The distance to a child loss node is always zero,
-                        // because it encodes a loss **from** this
-                        // node’s synteny
-                        auto total_dist = child->type != Event::Type::Loss
-                            ? candidate.distanceTo(sub_candidate) : 0;
-                        auto partial_dist = child->type != Event::Type::Loss
-                            ? candidate.distanceTo(sub_candidate, true) : 0;
-
-                        auto total_cost = total_dist + candidates_per_node
-                            .at(&*child).at(sub_candidate).cost;
-
-                        if (total_cost < best_total_cost)
+                        // Solve all nodes of the subtree in postfix order
+                        auto first = task + 1 - post_order.sizes[task];
+
+                        for (auto index = first;
+                                index <= task && !has_failed;
+                                ++index)
                         {
-                            best_total_cost = total_cost;
-                            best_total_synt = sub_candidate;
+                            solve_node(index);
                         }
 
-                        auto partial_cost = partial_dist + candidates_per_node
-                            .at(&*child).at(sub_candidate).cost;
+                        // Climb up as long as this task completes the
+                        // last pending child of the parent
+                        auto index = post_order.parents[task];
 
-                        if (partial_cost < best_partial_cost)
+                        while (!has_failed
+                                && index != PostOrder::none
+                                && --pending[index] == 0)
                         {
-                            best_partial_cost = partial_cost;
-                            best_partial_synt = sub_candidate;
+                            solve_node(index);
+                            index = post_order.parents[index];
                         }
                     }
+                    catch (...)
+                    {
+                        #pragma omp critical
+                        if (!has_failed)
+                        {
+                            has_failed = true;
+                            failure = std::current_exception();
+                        }
+                    }
+                }
+            }
+        }
 
-                    best_total_costs.push_back(best_total_cost);
-                    best_partial_costs.push_back(best_partial_cost);
-                    best_total_synts.push_back(best_total_synt);
-                    best_partial_synts.push_back(best_partial_synt);
-                } // end loop on children
+        if (has_failed)
+        {
+            std::rethrow_exception(failure);
+        }
+    }
 
-                auto best_total_total
-                    = best_total_costs.at(0) + best_total_costs.at(1);
+    // We know, for each node, a list of candidates and their associated cost.
+    // Each candidate fully determines the optimal assignation for the subtree
+    // below it. For the root node, we already know the optimal assignation: it
+    // is the one that was already assigned. Thus, it only remains to propagate
+    // the best assignations starting from the root node, in prefix order
+    //
+    // When candidates are retained, the assignation is written in a copy of
+    // the tree, so that the candidates keep referring to unchanged nodes
+    if (is_retained)
+    {
+        output = tree;
+        index_post_order(output, buffers.output_order);
+    }
 
-                auto best_total_partial
-                    = best_total_costs.at(0) + best_partial_costs.at(1);
+    const auto& targets = is_retained
+        ? buffers.output_order.nodes
+        : post_order.nodes;
 
-                auto best_partial_total
-                    = best_partial_costs.at(0) + best_total_costs.at(1);
+    const char* spilled = use_spill ? spill->map() : nullptr;
 
-                Candidate info;
+    if (use_spill && params.stats != nullptr)
+    {
+        params.stats->spilled_bytes = spill->size();
+    }
 
-                switch (it->type)
-                {
-                case Event::Type::Speciation:
-                    // At speciation nodes, only one scenario is possible:
-                    // both children were fully copied. If any losses occur,
-                    // they are necessarily due to segmental losses following
-                    // the speciation event and they have to be counted in the
-                    // total cost
-                    info.cost = best_total_total;
-                    info.synteny_left = best_total_synts.at(0);
-                    info.synteny_right = best_total_synts.at(1);
-                    break;
-
-                case Event::Type::Duplication:
-                    // At duplication nodes, we can consider at most one
-                    // segmental duplication for one of the two children.
-                    // We consider the most advantageous scenario between
-                    // a full duplication, a segmental duplication on the left
-                    // or a segmental duplication on the right
-                    if (best_total_total <= best_total_partial
-                        && best_total_total <= best_partial_total)
-                    {
-                        info.cost = 1 + best_total_total;
-                        info.synteny_left = best_total_synts.at(0);
-                        info.synteny_right = best_total_synts.at(1);
-                    }
-                    else if (best_total_partial <= best_total_total
-                        && best_total_partial <= best_partial_total)
-                    {
-                        info.cost = 1 + best_total_partial;
-                        info.synteny_left = best_total_synts.at(0);
-                        info.synteny_right = best_partial_synts.at(1);
-                        info.partial_right = true;
-                    }
-                    else if (best_partial_total <= best_total_total
-                        && best_partial_total <= best_total_partial)
-                    {
-                        info.cost = 1 + best_partial_total;
-                        info.synteny_left = best_partial_synts.at(0);
-                        info.partial_left = true;
-                        info.synteny_right = best_total_synts.at(1);
-                    }
-                    break;
+    auto& masks = buffers.masks;
+    auto& stack = buffers.traceback_stack;
+    masks.resize(node_count);
+    masks[node_count - 1] = ancestral_mask;
+    stack.assign(1, node_count - 1);
+    std::size_t inserted_losses = 0;
 
-                default:
-                {
-                    std::ostringstream message;
-                    message << "Invalid event type on an internal node: "
-                        << it->type;
-                    throw std::invalid_argument{message.str()};
-                }
-                } // end switch on node type
+    // Count the events of the visited nodes, whose type is final once their
+    // children are resolved, and add the inserted losses at the end. Nodes
+    // of removed subtrees are never visited
+    unsigned dl_score = 0;
 
-                if (!info.cost.isInfinity())
-                {
-                    is_consistent = true;
-                }
+    while (!stack.empty())
+    {
+        auto index = stack.back();
+        stack.pop_back();
 
-                candidates.emplace(candidate, info);
-            } // end loop on candidates
+        if (post_order.sizes[index] == 1)
+        {
+            dl_score += get_dl_cost(*targets[index]);
+            continue;
         }
 
-        if (!is_consistent)
+        auto parent = targets[index];
+        auto left = post_order.left(index);
+        auto right = post_order.right(index);
+        const auto& table = *class_tables[node_classes[index]];
+        const auto& left_table = *class_tables[node_classes[left]];
+        const auto& right_table = *class_tables[node_classes[right]];
+
+        auto mask_parent = masks[index];
+        auto info = table.choice(table.index(mask_parent), spilled);
+        auto mask_left = left_table.mask(info.index_left);
+        auto mask_right = right_table.mask(info.index_right);
+
+        // The synteny of each node is the subsequence of the ancestral genes
+        // given by its mask. Children that keep all the genes of their parent
+        // share its synteny instead of copying it
+        const auto& synteny_parent = parent->synteny;
+        auto synteny_left = mask_left == mask_parent
+            ? synteny_parent
+            : SharedSynteny{get_subsequence(ancestral_genes, mask_left)};
+        auto synteny_right = mask_right == mask_parent
+            ? synteny_parent
+            : SharedSynteny{get_subsequence(ancestral_genes, mask_right)};
+
+        auto child_left = targets[left];
+        auto child_right = targets[right];
+
+        if (info.partial_left)
         {
-            std::ostringstream message;
-            message << "There is no valid candidate for the node "
-                << *it << " under the order of the root synteny ("
-                << ancestral_synteny << ").";
-            throw std::invalid_argument{message.str()};
+            parent->segment = get_duplicated_segment(mask_parent, mask_left);
         }
 
-        candidates_per_node.emplace(&*it, candidates);
-    } // end postorder traversal
+        if (info.partial_right)
+        {
+            parent->segment = get_duplicated_segment(mask_parent, mask_right);
+        }
 
-    // We know, for each node, a list of candidates and their associated cost.
-    // Each candidate fully determines the optimal assignation for the subtree
-    // below it. For the root node, we already know the optimal assignation: it
-    // is the one that was already assigned. Thus, it only remains to propagate
-    // the best assignations starting from the root node
-    for (auto parent = tree.begin(); parent != tree.end(); ++parent)
+        masks[left] = mask_left;
+        child_left->synteny = std::move(synteny_left);
+        auto is_left_removed = insert_losses(
+            output, parent, child_left, mask_parent, mask_left,
+            info.partial_left, ancestral_genes, inserted_losses);
+
+        // Both children are removed if the parent synteny is empty
+        if (output.number_of_children(parent) == 0)
+        {
+            dl_score += get_dl_cost(*parent);
+            continue;
+        }
+
+        masks[right] = mask_right;
+        child_right->synteny = std::move(synteny_right);
+        auto is_right_removed = insert_losses(
+            output, parent, child_right, mask_parent, mask_right,
+            info.partial_right, ancestral_genes, inserted_losses);
+        dl_score += get_dl_cost(*parent);
+
+        // Visit the left subtree before the right one, skipping subtrees
+        // that were removed while resolving losses
+        if (!is_right_removed)
+        {
+            stack.push_back(right);
+        }
+
+        if (!is_left_removed)
+        {
+            stack.push_back(left);
+        }
+    }
+
+    if (params.stats != nullptr)
+    {
+        params.stats->inserted_losses = inserted_losses;
+        params.stats->dl_score = dl_score + inserted_losses;
+    }
+
+    if (is_retained)
     {
-        if (tree.number_of_children(parent) == 2)
+        if (!is_update)
         {
-            auto synteny_parent = parent->synteny;
-            auto child_left = tree.child(parent, 0);
-            auto child_right = tree.child(parent, 1);
-            auto info = candidates_per_node.at(&*parent).at(synteny_parent);
+            buffers.retained_indices.clear();
 
-            if (info.partial_left)
+            for (std::size_t index = 0; index < node_count; ++index)
             {
-                parent->segment = find_duplicated_segment(
-                    synteny_parent,
-                    info.synteny_left);
+                buffers.retained_indices.emplace(
+                    post_order.nodes[index].node, index);
             }
+        }
 
-            if (info.partial_right)
-            {
-                parent->segment = find_duplicated_segment(
-                    synteny_parent,
-                    info.synteny_right);
-            }
+        buffers.is_retained = true;
+    }
+}
+}
 
-            child_left->synteny = info.synteny_left;
-            resolve_losses(tree, parent, child_left, info.partial_left);
+SuperReconciliationWorkspace::SuperReconciliationWorkspace()
+: buffers(new Buffers)
+{}
 
-            child_right->synteny = info.synteny_right;
-            resolve_losses(tree, parent, child_right, info.partial_right);
-        }
+SuperReconciliationWorkspace::SuperReconciliationWorkspace(
+    SuperReconciliationWorkspace&&) noexcept = default;
+
+SuperReconciliationWorkspace& SuperReconciliationWorkspace::operator=(
+    SuperReconciliationWorkspace&&) noexcept = default;
+
+SuperReconciliationWorkspace::~SuperReconciliationWorkspace() = default;
+
+unsigned get_dl_cost(const Event& event)
+{
+    return event.type == Event::Type::Duplication
+        || event.type == Event::Type::Loss;
+}
+
+unsigned get_dl_score(const tree<Event>& tree)
+{
+    unsigned score = 0;
+
+    for (const auto& event : tree)
+    {
+        score += get_dl_cost(event);
     }
+
+    return score;
+}
+
+void super_reconciliation(
+    tree<Event>& tree,
+    const SuperReconciliationParams& params)
+{
+    SuperReconciliationWorkspace workspace;
+    super_reconciliation(tree, workspace, params);
+}
+
+void super_reconciliation(
+    tree<Event>& tree,
+    SuperReconciliationWorkspace& workspace,
+    const SuperReconciliationParams& params)
+{
+    compute_super_reconciliation(
+        tree, tree, *workspace.buffers, params, nullptr);
+}
+
+::tree<Event> start_super_reconciliation(
+    ::tree<Event>& tree,
+    SuperReconciliationWorkspace& workspace,
+    const SuperReconciliationParams& params)
+{
+    ::tree<Event> result;
+    compute_super_reconciliation(
+        tree, result, *workspace.buffers, params, nullptr);
+    return result;
+}
+
+::tree<Event> update_super_reconciliation(
+    ::tree<Event>& tree,
+    SuperReconciliationWorkspace& workspace,
+    const std::vector<::tree<Event>::iterator>& edited,
+    const SuperReconciliationParams& params)
+{
+    ::tree<Event> result;
+    compute_super_reconciliation(
+        tree, result, *workspace.buffers, params, &edited);
+    return result;
 }
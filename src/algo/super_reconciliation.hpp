@@ -3,15 +3,168 @@
 
 #include "../model/Event.hpp"
 #include "../model/Synteny.hpp"
+#include "ReconciliationStats.hpp"
+#include <cstddef>
+#include <memory>
+#include <string>
 #include <tree.hh>
+#include <vector>
 
 /**
- * Compute the duplication-loss score of a fully labelled tree.
+ * Get the contribution of an event to the duplication-loss score of its
+ * tree.
+ *
+ * @param event Event to count.
+ * @return 1 if the event is a duplication or a loss, 0 otherwise.
+ */
+unsigned get_dl_cost(const Event& event);
+
+/**
+ * Compute the duplication-loss score of a fully labelled tree. The
+ * reconciliation algorithms report the score of their result in their
+ * statistics (see `ReconciliationStats::dl_score`), which avoids this pass.
  *
  * @param tree Tree for which to compute the duplication-loss score.
  * @return Computed duplication-loss score.
  */
-unsigned get_dl_score(tree<Event>& tree);
+unsigned get_dl_score(const tree<Event>& tree);
+
+/**
+ * Parameters for computing an ordered Super-Reconciliation.
+ *
+ * @see super_reconciliation
+ */
+struct SuperReconciliationParams
+{
+    /**
+     * Number of threads to use for computing the candidates of each node.
+     * Independent subtrees are solved concurrently by OpenMP tasks. If 0, use
+     * the default number of threads chosen by OpenMP. Set to 1 to disable
+     * multithreading.
+     */
+    unsigned jobs = 1;
+
+    /**
+     * Minimum number of nodes in a subtree for its root to be solved in a
+     * task of its own. Smaller subtrees are solved sequentially in a single
+     * task, to amortize the scheduling overhead.
+     */
+    std::size_t task_size = 8;
+
+    /**
+     * Minimum number of candidates (that is, of subsequences of the ancestral
+     * synteny) above which the candidates of each node are also evaluated
+     * concurrently. Has no effect if multithreading is disabled.
+     */
+    std::size_t split_size = 1 << 10;
+
+    /**
+     * Number of consecutive candidates of a node evaluated by each task when
+     * candidates are evaluated concurrently.
+     */
+    std::size_t grain_size = 64;
+
+    /**
+     * Whether to solve identical subtrees only once. Two subtrees are
+     * identical if they have the same shape, the same events and the same
+     * leaf syntenies, in which case they have the same candidates. Only
+     * applies to sequential computations (see `jobs`), since concurrent
+     * computations solve disjoint subtrees independently.
+     */
+    bool share_subtrees = true;
+
+    /**
+     * Maximum number of candidates kept in a workspace between computations,
+     * so that the subtrees of a tree that were already solved in a previous
+     * tree with the same ancestral synteny are not solved again. If 0,
+     * nothing is kept. Only applies if subtrees are shared.
+     */
+    std::size_t cache_size = 0;
+
+    /**
+     * Maximum number of subtree classes remembered in a workspace between
+     * computations, so that the subtrees of later trees can be matched
+     * with cached candidates. Classes and cached candidates are forgotten
+     * together once this is exceeded. Only applies if `cache_size` is not
+     * 0.
+     */
+    std::size_t cache_classes = std::size_t{1} << 20;
+
+    /**
+     * Whether to evaluate the candidates of internal nodes on the default
+     * OpenMP target device (for example, a GPU) instead of the host. The
+     * costs of each node stay on the device until its parent is solved, and
+     * only the child assignations are copied back for the traceback. If the
+     * program was built without offloading support or if no device is
+     * available, the same kernel runs on the host. Identical subtrees are
+     * not shared, and computations that keep their candidates for later
+     * updates always run on the host.
+     */
+    bool device = false;
+
+    /**
+     * If not empty, directory in which to create a temporary file to which
+     * the child assignations of each internal node are moved as soon as the
+     * node is solved. They make up most of the memory of the computation,
+     * since costs are released once the parent of a node is solved, and
+     * the traceback only reads back one assignation per node. This leaves
+     * the costs of O(depth) nodes in memory for sequential computations.
+     * Solved subtrees are then not cached (see `cache_size`), and
+     * computations that keep their candidates for later updates keep them
+     * in memory.
+     */
+    std::string spill_directory;
+
+    /**
+     * Number of candidates kept for each node by the approximate algorithm
+     * (see beam_super_reconciliation). Not used by the exact algorithm.
+     */
+    std::size_t beam = 16;
+
+    /**
+     * If not null, filled with statistics about the computation.
+     */
+    ReconciliationStats* stats = nullptr;
+};
+
+/**
+ * Buffers that are reused across calls to `super_reconciliation` (candidate
+ * tables, node indices and per-thread scratch buffers). Buffers grow to fit
+ * the largest tree seen so far and are kept afterwards, so that reconciling
+ * many trees of similar sizes with the same workspace does not need to
+ * allocate memory once the buffers have grown. A workspace can only be used
+ * by one computation at a time.
+ */
+class SuperReconciliationWorkspace
+{
+public:
+    SuperReconciliationWorkspace();
+    SuperReconciliationWorkspace(SuperReconciliationWorkspace&&) noexcept;
+    SuperReconciliationWorkspace& operator=(
+        SuperReconciliationWorkspace&&) noexcept;
+    ~SuperReconciliationWorkspace();
+
+    struct Buffers;
+
+private:
+    std::unique_ptr<Buffers> buffers;
+
+    friend void super_reconciliation(
+        tree<Event>&,
+        SuperReconciliationWorkspace&,
+        const SuperReconciliationParams&);
+
+    friend tree<Event> start_super_reconciliation(
+        tree<Event>&,
+        SuperReconciliationWorkspace&,
+        const SuperReconciliationParams&);
+
+    friend tree<Event> update_super_reconciliation(
+        tree<Event>&,
+        SuperReconciliationWorkspace&,
+        const std::vector<tree<Event>::iterator>&,
+        const SuperReconciliationParams&);
+};
 
 /**
  * Compute synteny assignations of internal nodes in a synteny tree so as to
@@ -24,9 +177,73 @@ unsigned get_dl_score(tree<Event>& tree);
  * root node is labeled with the ancestral synteny to consider. This tree is
  * modified so that the optimal synteny assignation is set in each internal
  * node.
+ * @param [params] Parameters of the computation.
+ *
+ * @throws If the order is not consistent or if the tree is improperly labeled.
+ */
+void super_reconciliation(
+    tree<Event>& tree,
+    const SuperReconciliationParams& = SuperReconciliationParams{});
+
+/**
+ * Compute a Super-Reconciliation using the buffers of a workspace.
+ *
+ * @param tree Synteny tree to reconcile (see above).
+ * @param workspace Buffers to use for the computation.
+ * @param [params] Parameters of the computation.
+ *
+ * @throws If the order is not consistent or if the tree is improperly labeled.
+ */
+void super_reconciliation(
+    tree<Event>& tree,
+    SuperReconciliationWorkspace&,
+    const SuperReconciliationParams& = SuperReconciliationParams{});
+
+/**
+ * Compute a Super-Reconciliation that can be updated after local edits.
+ *
+ * Instead of modifying the tree, the result is written in a copy of it, and
+ * the workspace keeps the candidates of all the nodes of the tree, which
+ * refers to its nodes. Identical subtrees are not shared, since any of them
+ * can be edited afterwards.
+ *
+ * @param tree Synteny tree to reconcile (see above), which is not modified
+ * and must outlive the use of the workspace for updates.
+ * @param workspace Buffers to use for the computation, which keep the
+ * candidates of the tree afterwards.
+ * @param [params] Parameters of the computation.
+ * @return Reconciled copy of the tree.
+ *
+ * @throws If the order is not consistent or if the tree is improperly labeled.
+ */
+tree<Event> start_super_reconciliation(
+    tree<Event>& tree,
+    SuperReconciliationWorkspace&,
+    const SuperReconciliationParams& = SuperReconciliationParams{});
+
+/**
+ * Update a Super-Reconciliation started with `start_super_reconciliation`
+ * after some nodes of the tree were edited in place (for example, the
+ * synteny of a leaf or the event of an internal node). Only the edited nodes
+ * and their ancestors are solved again, before tracing the result back.
+ *
+ * If the ancestral synteny or the shape of the tree changed, or if the
+ * workspace was used for another computation since, all the nodes are
+ * solved again.
+ *
+ * @param tree Tree that was passed to `start_super_reconciliation`.
+ * @param workspace Workspace that was passed to `start_super_reconciliation`,
+ * which keeps the updated candidates afterwards.
+ * @param edited Nodes of the tree that were edited.
+ * @param [params] Parameters of the computation.
+ * @return Reconciled copy of the edited tree.
  *
  * @throws If the order is not consistent or if the tree is improperly labeled.
  */
-void super_reconciliation(tree<Event>& tree);
+tree<Event> update_super_reconciliation(
+    tree<Event>& tree,
+    SuperReconciliationWorkspace&,
+    const std::vector<::tree<Event>::iterator>& edited,
+    const SuperReconciliationParams& = SuperReconciliationParams{});
 
 #endif // ALGO_SUPER_RECONCILIATION_HPP
@@ -0,0 +1,398 @@
+#include "super_reconciliation.hpp"
+#include "erase.hpp"
+#include "simulate.hpp"
+#include "../io/nhx.hpp"
+#include "../model/Event.hpp"
+#include "../util/tree.hpp"
+#include <catch.hpp>
+#include <random>
+
+namespace
+{
+void expect_equal_trees(
+    const ::tree<Event>& reconciled_event,
+    const ::tree<Event>& expected_event)
+{
+    auto it_reconciled = reconciled_event.begin();
+    auto it_expected = expected_event.begin();
+
+    while (it_reconciled != reconciled_event.end()
+            && it_expected != expected_event.end())
+    {
+        REQUIRE(*it_reconciled == *it_expected);
+        REQUIRE(it_reconciled.number_of_children()
+                == it_expected.number_of_children());
+
+        ++it_reconciled;
+        ++it_expected;
+    }
+
+    REQUIRE(it_reconciled == reconciled_event.end());
+    REQUIRE(it_expected == expected_event.end());
+}
+
+void expect_reconciles_to(
+    const ::tree<TaggedNode>& input,
+    const ::tree<TaggedNode>& expected)
+{
+    auto reconciled_event = tree_cast<TaggedNode, Event>(input);
+    super_reconciliation(reconciled_event);
+    auto expected_event = tree_cast<TaggedNode, Event>(expected);
+    expect_equal_trees(reconciled_event, expected_event);
+}
+}
+
+TEST_CASE("Super-Reconciliation examples")
+{
+    SECTION("Simple example from the paper")
+    {
+        auto input_tree = parse_nhx_tree(R"NHX(
+            (
+                (
+                    "x x' x''",
+                    [&&NHX:event=loss]
+                )[&&NHX:event=speciation],
+                (
+                    "x",
+                    (
+                        "x x''",
+                        "x x'"
+                    )[&&NHX:event=duplication]
+                )[&&NHX:event=speciation]
+            )"x x' x''"[&&NHX:event=duplication];
+        )NHX");
+
+        auto expected_tree = parse_nhx_tree(R"NHX(
+            (
+                (
+                    "x x' x''",
+                    "x x' x''"[&&NHX:event=loss:segment="0 - 3"]
+                )"x x' x''"[&&NHX:event=speciation],
+                (
+                    (x)"x x' x''"[&&NHX:event=loss:segment="1 - 3"],
+                    (
+                        ("x x''")"x x' x''"[&&NHX:event=loss:segment="1 - 2"],
+                        "x x'"
+                    )"x x' x''"[&&NHX:event=duplication:segment="0 - 2"]
+                )"x x' x''"[&&NHX:event=speciation]
+            )"x x' x''"[&&NHX:event=duplication];
+        )NHX");
+
+        expect_reconciles_to(input_tree, expected_tree);
+    }
+
+    SECTION("Segmental duplications")
+    {
+        auto input_tree = parse_nhx_tree(R"NHX(
+            (
+                (
+                    "a d",
+                    (
+                        "a b c",
+                        "a b d"
+                    )[&&NHX:event=duplication]
+                )[&&NHX:event=speciation],
+                (
+                    (
+                        "a b c d",
+                        "a b c"
+                    )[&&NHX:event=speciation],
+                    (
+                        "b c d",
+                        (
+                            "b d",
+                            "d"
+                        )[&&NHX:event=speciation]
+                    )[&&NHX:event=speciation]
+                )[&&NHX:event=duplication]
+            )"a b c d"[&&NHX:event=speciation];
+        )NHX");
+
+        auto expected_tree = parse_nhx_tree(R"NHX(
+            (
+                (
+                    ("a d")"a b c d"[&&NHX:event=loss:segment="1 - 3"],
+                    (
+                        "a b c",
+                        ("a b d")"a b c d"[&&NHX:event=loss:segment="2 - 3"]
+                    )"a b c d"[&&NHX:event=duplication:segment="0 - 3"]
+                )"a b c d"[&&NHX:event=speciation],
+                (
+                    (
+                        "a b c d",
+                        ("a b c")"a b c d"[&&NHX:event=loss:segment="3 - 4"]
+                    )"a b c d"[&&NHX:event=speciation],
+                    (
+                        "b c d",
+                        (
+                            (
+                                "b d",
+                                (d)"b d"[&&NHX:event=loss:segment="0 - 1"]
+                            )"b d"[&&NHX:event=speciation]
+                        )"b c d"[&&NHX:event=loss:segment="1 - 2"]
+                    )"b c d"[&&NHX:event=speciation]
+                )"a b c d"[&&NHX:event=duplication:segment="1 - 4"]
+            )"a b c d"[&&NHX:event=speciation];
+        )NHX");
+
+        expect_reconciles_to(input_tree, expected_tree);
+    }
+
+    SECTION("Repeated gene families in the ancestral synteny")
+    {
+        auto input_tree = parse_nhx_tree(R"NHX(
+            (
+                (
+                    "a b",
+                    "a"
+                )[&&NHX:event=duplication],
+                "b a"
+            )"a b a b"[&&NHX:event=speciation];
+        )NHX");
+
+        auto expected_tree = parse_nhx_tree(R"NHX(
+            (
+                (
+                    (
+                        "a b",
+                        "a"
+                    )"a b"[&&NHX:event=duplication:segment="0 - 1"]
+                )"a b a b"[&&NHX:event=loss:segment="2 - 4"],
+                (
+                    ("b a")"b a b"[&&NHX:event=loss:segment="2 - 3"]
+                )"a b a b"[&&NHX:event=loss:segment="0 - 1"]
+            )"a b a b"[&&NHX:event=speciation];
+        )NHX");
+
+        expect_reconciles_to(input_tree, expected_tree);
+    }
+
+    SECTION("Reject leaves that do not follow the ancestral order")
+    {
+        auto input_tree = parse_nhx_tree(R"NHX(
+            ("b a", "a")"a b"[&&NHX:event=speciation];
+        )NHX");
+
+        auto event_tree = tree_cast<TaggedNode, Event>(input_tree);
+        REQUIRE_THROWS_AS(
+            super_reconciliation(event_tree),
+            std::invalid_argument);
+
+        SuperReconciliationParams device_params;
+        device_params.device = true;
+        REQUIRE_THROWS_AS(
+            super_reconciliation(event_tree, device_params),
+            std::invalid_argument);
+    }
+
+    SECTION("Parallel computation yields the same result")
+    {
+        std::mt19937 prng{42};
+        SimulationParams params;
+        params.base = Synteny::generateDummy(6);
+        params.depth = 6;
+
+        for (int sample = 0; sample < 10; ++sample)
+        {
+            auto input_tree = simulate_evolution(prng, params);
+            erase_tree(input_tree, std::begin(input_tree));
+
+            auto sequential_tree = input_tree;
+            super_reconciliation(sequential_tree);
+
+            SuperReconciliationParams parallel_params;
+            parallel_params.jobs = 4;
+            parallel_params.task_size = 1;
+
+            auto parallel_tree = input_tree;
+            super_reconciliation(parallel_tree, parallel_params);
+
+            expect_equal_trees(parallel_tree, sequential_tree);
+
+            parallel_params.split_size = 1;
+            parallel_params.grain_size = 4;
+
+            auto split_tree = input_tree;
+            super_reconciliation(split_tree, parallel_params);
+
+            expect_equal_trees(split_tree, sequential_tree);
+        }
+    }
+
+    SECTION("Scores are counted while labeling")
+    {
+        std::mt19937 prng{11};
+        SimulationParams params;
+        params.base = Synteny::generateDummy(6);
+        params.depth = 6;
+        params.p_loss = 0.4;
+
+        for (int sample = 0; sample < 30; ++sample)
+        {
+            unsigned reference_score;
+            auto reference_tree = simulate_evolution(
+                prng, params, &reference_score);
+            REQUIRE(reference_score == get_dl_score(reference_tree));
+
+            ReconciliationStats stats;
+            SuperReconciliationParams stats_params;
+            stats_params.stats = &stats;
+
+            auto input_tree = get_erased_tree(reference_tree);
+            super_reconciliation(input_tree, stats_params);
+            REQUIRE(stats.dl_score == get_dl_score(input_tree));
+            REQUIRE(stats.dl_score <= reference_score);
+        }
+    }
+
+    SECTION("Device computation yields the same result")
+    {
+        std::mt19937 prng{42};
+        SimulationParams params;
+        params.base = Synteny::generateDummy(10);
+        params.depth = 6;
+
+        for (int sample = 0; sample < 10; ++sample)
+        {
+            auto input_tree = simulate_evolution(prng, params);
+            erase_tree(input_tree, std::begin(input_tree));
+
+            ReconciliationStats host_stats;
+            SuperReconciliationParams host_params;
+            host_params.stats = &host_stats;
+            host_params.share_subtrees = false;
+
+            auto host_tree = input_tree;
+            super_reconciliation(host_tree, host_params);
+
+            ReconciliationStats device_stats;
+            SuperReconciliationParams device_params;
+            device_params.stats = &device_stats;
+            device_params.device = true;
+
+            auto device_tree = input_tree;
+            super_reconciliation(device_tree, device_params);
+
+            expect_equal_trees(device_tree, host_tree);
+            REQUIRE(device_stats.finite_candidates
+                == host_stats.finite_candidates);
+
+            device_params.stats = nullptr;
+            device_params.jobs = 4;
+            device_params.task_size = 1;
+
+            auto parallel_tree = input_tree;
+            super_reconciliation(parallel_tree, device_params);
+
+            expect_equal_trees(parallel_tree, host_tree);
+        }
+    }
+
+    SECTION("Spilled computation yields the same result")
+    {
+        std::mt19937 prng{42};
+        SimulationParams params;
+        params.base = Synteny::generateDummy(8);
+        params.depth = 6;
+
+        for (int sample = 0; sample < 10; ++sample)
+        {
+            auto input_tree = simulate_evolution(prng, params);
+            erase_tree(input_tree, std::begin(input_tree));
+
+            auto memory_tree = input_tree;
+            super_reconciliation(memory_tree);
+
+            ReconciliationStats stats;
+            SuperReconciliationParams spill_params;
+            spill_params.spill_directory = "/tmp";
+            spill_params.stats = &stats;
+
+            auto spill_tree = input_tree;
+            super_reconciliation(spill_tree, spill_params);
+
+            expect_equal_trees(spill_tree, memory_tree);
+            REQUIRE(stats.spilled_bytes > 0);
+
+            spill_params.jobs = 4;
+            spill_params.task_size = 1;
+            spill_params.device = true;
+
+            auto parallel_tree = input_tree;
+            super_reconciliation(parallel_tree, spill_params);
+
+            expect_equal_trees(parallel_tree, memory_tree);
+        }
+
+        SuperReconciliationParams missing_params;
+        missing_params.spill_directory = "/nonexistent/directory";
+        auto input_tree = simulate_evolution(prng, params);
+        erase_tree(input_tree, std::begin(input_tree));
+
+        REQUIRE_THROWS_AS(
+            super_reconciliation(input_tree, missing_params),
+            std::runtime_error);
+    }
+
+    SECTION("Identical subtrees are solved once")
+    {
+        auto input_tree = parse_nhx_tree<Event>(R"NHX(
+            (
+                (("a b","a c")[&&NHX:event=speciation],b)
+                    [&&NHX:event=duplication],
+                (("a b","a c")[&&NHX:event=speciation],b)
+                    [&&NHX:event=duplication]
+            )"a b c"[&&NHX:event=speciation];
+        )NHX");
+
+        SuperReconciliationParams separate_params;
+        separate_params.share_subtrees = false;
+
+        auto separate_tree = input_tree;
+        super_reconciliation(separate_tree, separate_params);
+
+        ReconciliationStats stats;
+        SuperReconciliationParams shared_params;
+        shared_params.stats = &stats;
+
+        auto shared_tree = input_tree;
+        super_reconciliation(shared_tree, shared_params);
+
+        expect_equal_trees(shared_tree, separate_tree);
+
+        // The second copy of the duplication subtree has 5 nodes
+        REQUIRE(stats.shared_nodes == 5);
+        REQUIRE(stats.candidates[5] == 0);
+        REQUIRE(stats.candidates[9] == 0);
+    }
+
+    SECTION("Inserted nodes share the synteny of their parent")
+    {
+        auto input_tree = parse_nhx_tree<Event>(R"NHX(
+            (
+                ("a b c","a c")[&&NHX:event=speciation],
+                "b"
+            )"a b c"[&&NHX:event=duplication];
+        )NHX");
+
+        super_reconciliation(input_tree);
+        std::size_t shared_count = 0;
+
+        for (auto it = input_tree.begin(); it != input_tree.end(); ++it)
+        {
+            auto parent = ::tree<Event>::parent(it);
+
+            if (input_tree.is_valid(parent)
+                    && parent->type != Event::Type::Loss
+                    && it->synteny == parent->synteny)
+            {
+                REQUIRE(it->synteny.isSharedWith(parent->synteny));
+                ++shared_count;
+            }
+        }
+
+        // The speciation, its left child and the loss above its right child
+        REQUIRE(shared_count == 3);
+        REQUIRE(std::begin(input_tree)->synteny.useCount() == 4);
+    }
+}
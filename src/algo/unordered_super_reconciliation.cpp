@@ -1,111 +1,532 @@
+#include "unordered_super_reconciliation.hpp"
+#include "super_reconciliation.hpp"
 #include "../model/Event.hpp"
-#include "../util/ExtendedNumber.hpp"
-#include "../util/set.hpp"
+#include "../util/bits.hpp"
 #include <algorithm>
-#include <map>
+#include <atomic>
+#include <cstdint>
+#include <exception>
+#include <omp.h>
+#include <stdexcept>
 #include <tree.hh>
+#include <unordered_map>
+#include <vector>
 
 namespace
 {
+// Word of a gene set, in which each bit stands for a family of the alphabet
+using Word = std::uint64_t;
+constexpr std::size_t word_width = 64;
+
+// Minimum number of nodes in a subtree for its root to be visited on its
+// own when passes run on several threads. Smaller subtrees are visited
+// sequentially by a single task, since each node only takes a few
+// operations on gene sets
+constexpr std::size_t task_size = 1 << 10;
+
 /**
- * Hold genes and propagation information regarding a nodes in a tree
+ * Hold genes and propagation information regarding the nodes of a tree
  * (see the three passes below for a more in-depth explanation).
+ *
+ * Nodes are indexed in postfix order. Gene sets are bitsets over the
+ * alphabet of the families that appear in the leaves, sorted by name so
+ * that listing a set in bit order yields the same order as a `std::set`
+ * of genes. All sets are stored in a single buffer, one after the other.
  */
-struct TreeInfoValue
+struct TreeInfo
 {
-    // Contain the set of genes that must be present in the final
-    // synteny of this node so that the labeling is valid and minimal.
-    std::set<Gene> genes;
+    // Iterators to the nodes of the tree
+    std::vector<::tree<Event>::iterator> nodes;
+
+    // Index of the first two children of each node, if applicable
+    std::vector<std::size_t> lefts;
+    std::vector<std::size_t> rights;
+
+    // Index of the parent of each node, or `none` for the root node
+    std::vector<std::size_t> parents;
+    static constexpr std::size_t none = static_cast<std::size_t>(-1);
+
+    // Number of nodes in the subtree of each node, which spans the indices
+    // from `index + 1 - sizes[index]` to `index`
+    std::vector<std::size_t> sizes;
+
+    // Families of the alphabet, sorted by name
+    std::vector<Gene> alphabet;
+
+    // Rank in the alphabet of each family, indexed by family identifier
+    std::vector<std::size_t> ranks;
+
+    // Number of words in each gene set
+    std::size_t words = 0;
+
+    // Contain, for each node, the set of genes that must be present in
+    // the final synteny of this node so that the labeling is valid
+    // and minimal
+    std::vector<Word> genes;
+
+    // Signal, for each node, that this node should receive the same set
+    // of genes as its parent node because it would result in less losses
+    std::vector<char> should_propagate;
+
+    // Gene sets of the initialization pass, before any propagation, kept
+    // when a computation can be updated
+    std::vector<Word> initial_genes;
+
+    // Roots of the subtrees that were completely visited while indexing,
+    // whose parents are yet to be visited
+    std::vector<std::size_t> pending;
+
+    // Gene sets used while resolving each node, and number of loss nodes
+    // inserted, for each thread
+    struct Scratch
+    {
+        std::vector<Word> s1, s2, s3, s4;
+        std::size_t inserted_losses = 0;
+    };
+
+    std::vector<Scratch> scratches;
+
+    // Roots of the subtrees visited by the initial tasks of a pass
+    std::vector<std::size_t> tasks;
+
+    // Duplication-loss score of the resolved subtree of each node
+    std::vector<unsigned> scores;
+
+    Word* getGenes(std::size_t index)
+    {
+        return this->genes.data() + index * this->words;
+    }
 
-    // Signal that this node should receive the same set of genes as
-    // its parent node because it would result in less losses.
-    bool should_propagate;
+    const Word* getGenes(std::size_t index) const
+    {
+        return this->genes.data() + index * this->words;
+    }
+
+    /**
+     * Compare the gene sets of two nodes.
+     */
+    bool hasSameGenes(std::size_t first, std::size_t second) const
+    {
+        return std::equal(
+            this->getGenes(first),
+            this->getGenes(first) + this->words,
+            this->getGenes(second));
+    }
+
+    /**
+     * Check whether the gene set of a node is empty.
+     */
+    bool hasNoGenes(std::size_t index) const
+    {
+        const auto* set = this->getGenes(index);
+        return std::all_of(set, set + this->words, [](Word word)
+        {
+            return word == 0;
+        });
+    }
 };
 
-using TreeInfo = std::map<Event*, TreeInfoValue>;
+constexpr std::size_t TreeInfo::none;
 
 /**
- * Perform the initialization pass on the event tree.
+ * Index the nodes of an event tree and build the alphabet of its leaves.
  *
- * Compute, for each node, the minimal set of gene families that must
- * be present in its synteny and whether it should propagate or not.
- *
- * @param tree Input event tree, in which only the leaves are labelled.
- * @return Dictionary associating each node to its genes and propagation
- * information. In this pass, the gene sets are only the minimal sets
- * required for the labeling to be valid.
+ * @param tree Input event tree.
+ * @param [info] Filled with the indexed nodes and empty gene sets.
+ * @throws std::invalid_argument If the tree contains an unary node.
  */
-TreeInfo initialize(tree<Event>& tree)
+void index_tree(tree<Event>& tree, TreeInfo& info)
 {
-    TreeInfo info;
+    auto count = tree.size();
+    info.nodes.clear();
+    info.nodes.reserve(count);
+    info.lefts.clear();
+    info.lefts.reserve(count);
+    info.rights.clear();
+    info.rights.reserve(count);
+    info.parents.assign(count, TreeInfo::none);
+    info.sizes.clear();
+    info.sizes.reserve(count);
+    info.alphabet.clear();
+
+    auto& pending = info.pending;
+    pending.clear();
 
     for (
         auto parent = tree.begin_post();
         parent != tree.end_post();
         ++parent)
     {
-        if (tree.number_of_children(parent) == 0)
+        auto index = info.nodes.size();
+        auto children_count = tree.number_of_children(parent);
+
+        if (children_count == 1)
         {
-            info.emplace(&*parent, TreeInfoValue{
-                // A leaf simply contains all the genes that it was labeled
-                // with in the input
-                std::set<Gene>(
-                    cbegin(parent->synteny),
-                    cend(parent->synteny)),
-
-                // No leaves should be ever modified, so we should not
-                // propagate on them
-                /* should_propagate = */ false
-            });
+            throw std::invalid_argument{"Unexpected unary node."};
         }
-        else if (tree.number_of_children(parent) == 1)
+
+        info.nodes.push_back(parent);
+
+        if (children_count == 0)
         {
-            throw new std::invalid_argument{"Unexpected unary node."};
+            info.lefts.push_back(index);
+            info.rights.push_back(index);
+            info.sizes.push_back(1);
+
+            for (const auto& gene : parent->synteny)
+            {
+                info.alphabet.push_back(gene);
+            }
         }
         else
         {
-            auto child_left = tree.child(parent, 0);
-            const auto& info_left = info.at(&*child_left);
-
-            auto child_right = tree.child(parent, 1);
-            const auto& info_right = info.at(&*child_right);
-
-            auto genes_union = info_left.genes + info_right.genes;
-
-            info.emplace(&*parent, TreeInfoValue{
-                // An internal node must always contain all the genes that
-                // must belong to its children
-                genes_union,
-
-                // All cases in which it is more advantageous to propagate
-                // the parent synteny to this node
-                /* should_propagate = */
-                (
-                    // For any kind of node, if both of its children already
-                    // generate a loss, propagate or are full losses, it should
-                    // propagate from its parent: any difference will be either
-                    // merged into already-existing losses or be propagated,
-                    // yielding at worst a same-cost solution and at best a
-                    // more parsimonious solution
-                    (info_left.genes != genes_union
-                        || info_left.should_propagate
-                        || child_left->type == Event::Type::Loss)
-                 && (info_right.genes != genes_union
-                        || info_right.should_propagate
-                        || child_right->type == Event::Type::Loss))
-                || (
-                    // For duplications, if any child is a full loss or
-                    // propagates, it is always more advantageous to propagate
-                    parent->type == Event::Type::Duplication
-                 && (child_left->type == Event::Type::Loss
-                        || info_left.should_propagate
-                        || child_right->type == Event::Type::Loss
-                        || info_right.should_propagate))
-            });
+            auto first_child = pending.size() - children_count;
+            info.lefts.push_back(pending[first_child]);
+            info.rights.push_back(pending[first_child + 1]);
+            info.parents[pending[first_child]] = index;
+            info.parents[pending[first_child + 1]] = index;
+            info.sizes.push_back(
+                index - pending[first_child]
+                + info.sizes[pending[first_child]]);
+            pending.resize(first_child);
+        }
+
+        pending.push_back(index);
+    }
+
+    std::sort(std::begin(info.alphabet), std::end(info.alphabet));
+    info.alphabet.erase(
+        std::unique(std::begin(info.alphabet), std::end(info.alphabet)),
+        std::end(info.alphabet));
+
+    // Ranks are indexed by the identifiers of the genes of the tree, which
+    // may be far fewer than the genes of the whole dictionary
+    Gene::Id max_id = 0;
+
+    for (const auto& gene : info.alphabet)
+    {
+        max_id = std::max(max_id, gene.getId());
+    }
+
+    info.ranks.resize(std::size_t{max_id} + 1);
+
+    for (std::size_t rank = 0; rank < info.alphabet.size(); ++rank)
+    {
+        info.ranks[info.alphabet[rank].getId()] = rank;
+    }
+
+    info.words = (info.alphabet.size() + word_width - 1) / word_width;
+    info.genes.assign(count * info.words, 0);
+    info.should_propagate.assign(count, false);
+}
+
+/**
+ * Check whether a tree still has the shape that it had when it was indexed,
+ * so that the indices can be reused.
+ *
+ * @param tree Tree to check.
+ * @param info Indexed tree.
+ * @return True if and only if the tree has the same nodes, in the same
+ * postfix order and under the same parents.
+ */
+bool has_same_shape(const ::tree<Event>& tree, const TreeInfo& info)
+{
+    std::size_t index = 0;
+
+    for (auto it = tree.begin_post(); it != tree.end_post(); ++it, ++index)
+    {
+        if (index == info.nodes.size() || info.nodes[index].node != it.node)
+        {
+            return false;
+        }
+
+        auto parent = info.parents[index];
+        auto expected = parent == TreeInfo::none
+            ? nullptr
+            : info.nodes[parent].node;
+
+        if (it.node->parent != expected)
+        {
+            return false;
+        }
+    }
+
+    return index == info.nodes.size();
+}
+
+/**
+ * Visit all the nodes of an indexed tree, each after all its children.
+ *
+ * On several threads, disjoint subtrees are visited concurrently by OpenMP
+ * tasks. Subtrees smaller than the task size are visited sequentially by a
+ * single task. Each larger node waits for the completion of its children:
+ * the task that completes the last child goes on to visit the parent, so
+ * that no task ever blocks.
+ *
+ * @param info Indexed tree.
+ * @param thread_count Number of threads to use.
+ * @param visit Function called with the index of each node and the index
+ * of the calling thread, lower than `thread_count`.
+ */
+template<typename Visit>
+void visit_bottom_up(
+    TreeInfo& info,
+    std::size_t thread_count,
+    const Visit& visit)
+{
+    auto count = info.nodes.size();
+
+    if (thread_count <= 1 || count < task_size)
+    {
+        for (std::size_t index = 0; index < count; ++index)
+        {
+            visit(index, std::size_t{0});
+        }
+
+        return;
+    }
+
+    std::vector<std::atomic<unsigned>> pending(count);
+    auto& tasks = info.tasks;
+    tasks.clear();
+
+    for (std::size_t index = 0; index < count; ++index)
+    {
+        auto parent = info.parents[index];
+
+        if (info.sizes[index] < task_size
+                && (parent == TreeInfo::none
+                    || info.sizes[parent] >= task_size))
+        {
+            tasks.push_back(index);
+        }
+
+        if (parent != TreeInfo::none && info.sizes[parent] >= task_size)
+        {
+            ++pending[parent];
+        }
+    }
+
+    std::atomic<bool> has_failed{false};
+    std::exception_ptr failure;
+
+    #pragma omp parallel num_threads(thread_count)
+    {
+        #pragma omp single
+        for (auto task : tasks)
+        {
+            #pragma omp task firstprivate(task)
+            {
+                try
+                {
+                    auto thread = static_cast<std::size_t>(
+                        omp_get_thread_num());
+
+                    for (auto index = task + 1 - info.sizes[task];
+                            index <= task && !has_failed;
+                            ++index)
+                    {
+                        visit(index, thread);
+                    }
+
+                    // Climb up as long as this task completes the last
+                    // pending child of the parent
+                    auto index = info.parents[task];
+
+                    while (!has_failed
+                            && index != TreeInfo::none
+                            && --pending[index] == 0)
+                    {
+                        visit(index, thread);
+                        index = info.parents[index];
+                    }
+                }
+                catch (...)
+                {
+                    #pragma omp critical
+                    if (!has_failed)
+                    {
+                        has_failed = true;
+                        failure = std::current_exception();
+                    }
+                }
+            }
+        }
+    }
+
+    if (has_failed)
+    {
+        std::rethrow_exception(failure);
+    }
+}
+
+/**
+ * Visit all the nodes of an indexed tree, each before all its children.
+ *
+ * On several threads, once a node larger than the task size is visited,
+ * its children are visited concurrently. A child is only handed to a new
+ * OpenMP task if both children are larger than the task size, so that long
+ * chains of nodes do not create a task per node.
+ *
+ * @param info Indexed tree.
+ * @param thread_count Number of threads to use.
+ * @param visit Function called with the index of each node, which must not
+ * throw.
+ */
+template<typename Visit>
+void visit_top_down(
+    const TreeInfo& info,
+    std::size_t thread_count,
+    const Visit& visit)
+{
+    auto count = info.nodes.size();
+
+    if (thread_count <= 1 || count < task_size)
+    {
+        // Reverse postfix order
+        for (auto index = count; index-- > 0;)
+        {
+            visit(index);
         }
+
+        return;
     }
 
-    return info;
+    auto visit_subtree = [&info, &visit](
+        std::size_t root, const auto& self) -> void
+    {
+        while (info.sizes[root] >= task_size)
+        {
+            visit(root);
+
+            // Go on with the largest child and visit the other one apart
+            auto next = info.lefts[root];
+            auto other = info.rights[root];
+
+            if (info.sizes[next] < info.sizes[other])
+            {
+                std::swap(next, other);
+            }
+
+            if (info.sizes[other] >= task_size)
+            {
+                #pragma omp task firstprivate(other)
+                self(other, self);
+            }
+            else
+            {
+                self(other, self);
+            }
+
+            root = next;
+        }
+
+        for (auto index = root + 1; index-- > root + 1 - info.sizes[root];)
+        {
+            visit(index);
+        }
+    };
+
+    #pragma omp parallel num_threads(thread_count)
+    #pragma omp single
+    visit_subtree(count - 1, visit_subtree);
+}
+
+/**
+ * Perform the initialization pass on a node of the event tree, whose
+ * children were already initialized.
+ *
+ * Compute the minimal set of gene families that must be present in the
+ * synteny of the node and whether it should propagate or not.
+ *
+ * @param tree Input event tree, in which only the leaves are labelled.
+ * @param info Genes and propagation information of each node, in which the
+ * entries of the node are set.
+ * @param index Index of the node to initialize.
+ */
+void initialize_node(tree<Event>& tree, TreeInfo& info, std::size_t index)
+{
+    auto parent = info.nodes[index];
+    auto* genes = info.getGenes(index);
+
+    if (tree.number_of_children(parent) == 0)
+    {
+        // A leaf simply contains all the genes that it was labeled
+        // with in the input. No leaves should be ever modified, so
+        // we should not propagate on them
+        std::fill(genes, genes + info.words, 0);
+        info.should_propagate[index] = false;
+
+        for (const auto& gene : parent->synteny)
+        {
+            auto rank = info.ranks[gene.getId()];
+            genes[rank / word_width] |= Word{1} << (rank % word_width);
+        }
+    }
+    else
+    {
+        auto left = info.lefts[index];
+        auto child_left = info.nodes[left];
+        const auto* genes_left = info.getGenes(left);
+
+        auto right = info.rights[index];
+        auto child_right = info.nodes[right];
+        const auto* genes_right = info.getGenes(right);
+
+        // An internal node must always contain all the genes that
+        // must belong to its children
+        for (std::size_t word = 0; word < info.words; ++word)
+        {
+            genes[word] = genes_left[word] | genes_right[word];
+        }
+
+        // All cases in which it is more advantageous to propagate
+        // the parent synteny to this node
+        info.should_propagate[index] =
+            (
+                // For any kind of node, if both of its children already
+                // generate a loss, propagate or are full losses, it should
+                // propagate from its parent: any difference will be either
+                // merged into already-existing losses or be propagated,
+                // yielding at worst a same-cost solution and at best a
+                // more parsimonious solution
+                (!info.hasSameGenes(left, index)
+                    || info.should_propagate[left]
+                    || child_left->type == Event::Type::Loss)
+             && (!info.hasSameGenes(right, index)
+                    || info.should_propagate[right]
+                    || child_right->type == Event::Type::Loss))
+            || (
+                // For duplications, if any child is a full loss or
+                // propagates, it is always more advantageous to propagate
+                parent->type == Event::Type::Duplication
+             && (child_left->type == Event::Type::Loss
+                    || info.should_propagate[left]
+                    || child_right->type == Event::Type::Loss
+                    || info.should_propagate[right]));
+    }
+}
+
+/**
+ * Perform the initialization pass on the event tree.
+ *
+ * Compute, for each node, the minimal set of gene families that must
+ * be present in its synteny and whether it should propagate or not.
+ *
+ * @param tree Input event tree, in which only the leaves are labelled.
+ * @param [info] Filled with the genes and propagation information of each
+ * node. In this pass, the gene sets are only the minimal sets required for
+ * the labeling to be valid.
+ * @param thread_count Number of threads to use.
+ */
+void initialize(tree<Event>& tree, TreeInfo& info, std::size_t thread_count)
+{
+    index_tree(tree, info);
+    visit_bottom_up(info, thread_count,
+        [&tree, &info](std::size_t index, std::size_t)
+        {
+            initialize_node(tree, info, index);
+        });
 }
 
 /**
@@ -114,29 +535,209 @@ TreeInfo initialize(tree<Event>& tree)
  * For any node x which must be propagated, x’s parent synteny is copied
  * as x’s synteny.
  *
- * @param tree Input event tree, in which only the leaves are labelled.
- * @param info Dictionary associating each node to its genes and propagation
- * information. After this pass, the gene sets minimize the number of losses
- * that must be introduced by the resolution pass to make the labeling valid.
+ * @param info Genes and propagation information of each node. After this
+ * pass, the gene sets minimize the number of losses that must be introduced
+ * by the resolution pass to make the labeling valid.
+ * @param thread_count Number of threads to use.
  */
-void propagate(tree<Event>& tree, TreeInfo& info)
+void propagate(TreeInfo& info, std::size_t thread_count)
 {
-    for (
-        auto parent = tree.begin();
-        parent != tree.end();
-        ++parent)
+    // Visit parents before their children
+    visit_top_down(info, thread_count, [&info](std::size_t parent)
+    {
+        if (info.lefts[parent] == parent)
+        {
+            return;
+        }
+
+        for (auto child : {info.lefts[parent], info.rights[parent]})
+        {
+            if (info.should_propagate[child])
+            {
+                std::copy(
+                    info.getGenes(parent),
+                    info.getGenes(parent) + info.words,
+                    info.getGenes(child));
+            }
+        }
+    });
+}
+
+/**
+ * Append the genes of a set to a synteny, in the order of the alphabet.
+ *
+ * @param synteny Synteny to extend.
+ * @param info Tree information holding the alphabet.
+ * @param set Words of the set of genes to append.
+ * @return Number of appended genes.
+ */
+std::size_t append_genes(
+    Synteny& synteny,
+    const TreeInfo& info,
+    const std::vector<Word>& set)
+{
+    std::size_t count = 0;
+
+    for (std::size_t word = 0; word < info.words; ++word)
+    {
+        for (auto rest = set[word]; rest != 0; rest &= rest - 1)
+        {
+            auto bit = popcount(lowest_bit(rest) - 1);
+            synteny.push_back(info.alphabet[word * word_width + bit]);
+            ++count;
+        }
+    }
+
+    return count;
+}
+
+/**
+ * Perform the resolution pass on a node of the event tree, whose children
+ * were already resolved.
+ *
+ * @param tree Event tree in which to resolve the node.
+ * @param info Genes information of each node, in which the score of the
+ * node is set.
+ * @param nodes Nodes of the tree to resolve, in the same order as those of
+ * `info`.
+ * @param index Index of the node to resolve.
+ * @param scratch Gene sets used for resolving the node, and counter of the
+ * inserted loss nodes.
+ */
+void resolve_node(
+    tree<Event>& tree,
+    TreeInfo& info,
+    const std::vector<::tree<Event>::iterator>& nodes,
+    std::size_t index,
+    TreeInfo::Scratch& scratch)
+{
+    auto& s1 = scratch.s1;
+    auto& s2 = scratch.s2;
+    auto& s3 = scratch.s3;
+    auto& s4 = scratch.s4;
+    auto parent = nodes[index];
+    std::size_t inserted_losses = 0;
+    auto& score = info.scores[index];
+    score = 0;
+
+    // Edge case: if we happen to find an internal node whose minimal
+    // set of families is empty, we can safely discard all its children
+    // because there can be no evolution from an empty set of genes
+    if (info.hasNoGenes(index))
+    {
+        tree.erase_children(parent);
+        parent->type = Event::Type::Loss;
+    }
+    else if (tree.number_of_children(parent) == 2)
     {
-        for (
-            auto child = tree.begin(parent);
-            child != tree.end(parent);
-            ++child)
+        const auto* genes_parent = info.getGenes(index);
+        score = info.scores[info.lefts[index]]
+            + info.scores[info.rights[index]];
+
+        auto child_left = nodes[info.lefts[index]];
+        const auto* genes_left = info.getGenes(info.lefts[index]);
+
+        auto child_right = nodes[info.rights[index]];
+        const auto* genes_right = info.getGenes(info.rights[index]);
+
+        for (std::size_t word = 0; word < info.words; ++word)
         {
-            if (info.at(&*child).should_propagate)
+            s1[word] = genes_left[word] & genes_right[word];
+            s2[word] = genes_left[word] & ~genes_right[word];
+            s3[word] = genes_parent[word]
+                & ~(genes_left[word] | genes_right[word]);
+            s4[word] = genes_right[word] & ~genes_left[word];
+        }
+
+        // parent := s1 . s2 . s3 . s4
+        Synteny synteny_parent;
+        auto s1_size = append_genes(synteny_parent, info, s1);
+        auto s2_size = append_genes(synteny_parent, info, s2);
+        auto s3_size = append_genes(synteny_parent, info, s3);
+        auto s4_size = append_genes(synteny_parent, info, s4);
+
+        // left := s1 . s2
+        Synteny synteny_left{
+            std::cbegin(synteny_parent),
+            std::next(std::cbegin(synteny_parent), s1_size + s2_size)};
+
+        // right := s1 . s4
+        Synteny synteny_right{
+            std::cbegin(synteny_parent),
+            std::next(std::cbegin(synteny_parent), s1_size)};
+        synteny_right.insert(
+            std::end(synteny_right),
+            std::next(
+                std::cbegin(synteny_parent),
+                s1_size + s2_size + s3_size),
+            std::cend(synteny_parent));
+
+        parent->synteny = synteny_parent;
+        bool is_segmental_left = false;
+
+        if (synteny_left != synteny_parent
+                && child_left->type != Event::Type::Loss)
+        {
+            if (parent->type == Event::Type::Duplication)
             {
-                info.at(&*child).genes = info.at(&*parent).genes;
+                // If the left child differs from its parent, we take
+                // advantage that the parent is a duplication node and
+                // duplicate the `s1 . s2` segment only. This removes
+                // the need to introduce a loss for the left child.
+                is_segmental_left = true;
+                parent->segment = std::make_pair(0, s1_size + s2_size);
+            }
+            else
+            {
+                Event loss;
+                loss.type = Event::Type::Loss;
+                loss.synteny = parent->synteny;
+                loss.segment = std::make_pair(
+                    s1_size + s2_size,
+                    s1_size + s2_size + s3_size + s4_size);
+
+                tree.wrap(child_left, loss);
+                ++inserted_losses;
             }
         }
+
+        if (parent->type == Event::Type::Duplication && !is_segmental_left)
+        {
+            // If the left child has the exact same synteny as its parent
+            // (or is a full loss), there are no additional incurred losses
+            // on the left. Therefore, we are free to choose any duplicated
+            // segment to better fit the right child.
+            if (child_left->type == Event::Type::Loss)
+            {
+                // If the left child is a full loss, `s1` is necessarily
+                // empty, therefore `right = s4`
+                parent->segment = std::make_pair(
+                    s1_size + s2_size + s3_size,
+                    s1_size + s2_size + s3_size + s4_size);
+            }
+            else
+            {
+                // If the left child is exactly equal to its parent, `s4`
+                // is necessarily empty, therefore `right = s1`
+                parent->segment = std::make_pair(0, s1_size);
+            }
+        }
+        else if (synteny_right != synteny_parent
+                && child_right->type != Event::Type::Loss)
+        {
+            Event loss;
+            loss.type = Event::Type::Loss;
+            loss.synteny = parent->synteny;
+            loss.segment = std::make_pair(
+                s1_size,
+                s1_size + s2_size + s3_size);
+            tree.wrap(child_right, loss);
+            ++inserted_losses;
+        }
     }
+
+    score += get_dl_cost(*parent) + static_cast<unsigned>(inserted_losses);
+    scratch.inserted_losses += inserted_losses;
 }
 
 /**
@@ -146,140 +747,272 @@ void propagate(tree<Event>& tree, TreeInfo& info)
  * while introducing a minimal number of losses. Modify the tree to
  * insert the required losses and set syntenies.
  *
+ * On several threads, disjoint subtrees are resolved concurrently. Loss
+ * nodes are only ever inserted between a node and its children, which are
+ * resolved by the same thread, so that threads never modify the same part
+ * of the tree.
+ *
  * @param tree Input event tree, in which only the leaves are labelled. After
  * this pass, all internal nodes are correctly labeled, losses are introduced
  * where necessary and duplicated segments are specified.
- * @param info Dictionary associating each node to its genes information.
+ * @param info Genes information of each node. After this pass, `scores`
+ * holds the duplication-loss score of the resolved subtree of each node.
+ * @param nodes Nodes of the tree to resolve, in the same order as those of
+ * `info`.
+ * @param thread_count Number of threads to use.
+ * @return Number of inserted loss nodes.
  */
-void resolve(tree<Event>& tree, TreeInfo& info)
+std::size_t resolve(
+    tree<Event>& tree,
+    TreeInfo& info,
+    const std::vector<::tree<Event>::iterator>& nodes,
+    std::size_t thread_count)
 {
-    for (
-        auto parent = tree.begin_post();
-        parent != tree.end_post();
-        ++parent)
+    if (info.scratches.size() < thread_count)
+    {
+        info.scratches.resize(thread_count);
+    }
+
+    for (auto& scratch : info.scratches)
     {
-        const auto& genes_parent = info.at(&*parent).genes;
+        scratch.s1.resize(info.words);
+        scratch.s2.resize(info.words);
+        scratch.s3.resize(info.words);
+        scratch.s4.resize(info.words);
+        scratch.inserted_losses = 0;
+    }
 
-        // Edge case: if we happen to find an internal node whose minimal
-        // set of families is empty, we can safely discard all its children
-        // because there can be no evolution from an empty set of genes
-        if (genes_parent.empty())
+    info.scores.resize(info.nodes.size());
+    visit_bottom_up(info, thread_count,
+        [&tree, &info, &nodes](std::size_t index, std::size_t thread)
         {
-            tree.erase_children(parent);
-            parent->type = Event::Type::Loss;
-        }
-        else if (tree.number_of_children(parent) == 2)
+            resolve_node(tree, info, nodes, index, info.scratches[thread]);
+        });
+
+    std::size_t inserted_losses = 0;
+
+    for (const auto& scratch : info.scratches)
+    {
+        inserted_losses += scratch.inserted_losses;
+    }
+
+    return inserted_losses;
+}
+}
+
+struct UnorderedSuperReconciliationWorkspace::Buffers
+{
+    TreeInfo info;
+
+    // Whether the initial genes of the last computed tree were kept, the
+    // postfix index of each node of that tree, the nodes that need to be
+    // initialized again, and the nodes of the tree resolved in its stead
+    bool is_retained = false;
+    std::unordered_map<const void*, std::size_t> retained_indices;
+    std::vector<char> dirty;
+    std::vector<::tree<Event>::iterator> output_nodes;
+};
+
+namespace
+{
+/**
+ * Check whether all the genes of a synteny belong to the alphabet of a tree.
+ */
+bool is_in_alphabet(const Synteny& synteny, const TreeInfo& info)
+{
+    return std::all_of(
+        std::cbegin(synteny), std::cend(synteny),
+        [&info](const Gene& gene)
         {
-            auto child_left = tree.child(parent, 0);
-            const auto& genes_left = info.at(&*child_left).genes;
-
-            auto child_right = tree.child(parent, 1);
-            const auto& genes_right = info.at(&*child_right).genes;
-
-            auto s1 = genes_left & genes_right;
-            auto s1_size = s1.size();
-
-            auto s2 = genes_left - genes_right;
-            auto s2_size = s2.size();
-
-            auto s3 = genes_parent - (genes_left + genes_right);
-            auto s3_size = s3.size();
-
-            auto s4 = genes_right - genes_left;
-            auto s4_size = s4.size();
-
-            // parent := s1 . s2 . s3 . s4
-            Synteny synteny_parent{std::cbegin(s1), std::cend(s1)};
-            synteny_parent.insert(
-                std::end(synteny_parent),
-                std::cbegin(s2), std::cend(s2));
-            synteny_parent.insert(
-                std::end(synteny_parent),
-                std::cbegin(s3), std::cend(s3));
-            synteny_parent.insert(
-                std::end(synteny_parent),
-                std::cbegin(s4), std::cend(s4));
-
-            // left := s1 . s2
-            Synteny synteny_left{std::cbegin(s1), std::cend(s1)};
-            synteny_left.insert(
-                std::end(synteny_left),
-                std::cbegin(s2), std::cend(s2));
-
-            // right := s1 . s4
-            Synteny synteny_right{std::cbegin(s1), std::cend(s1)};
-            synteny_right.insert(
-                std::end(synteny_right),
-                std::cbegin(s4), std::cend(s4));
-
-            parent->synteny = synteny_parent;
-            bool is_segmental_left = false;
-
-            if (synteny_left != synteny_parent
-                    && child_left->type != Event::Type::Loss)
+            return gene.getId() < info.ranks.size()
+                && info.ranks[gene.getId()] < info.alphabet.size()
+                && info.alphabet[info.ranks[gene.getId()]] == gene;
+        });
+}
+
+/**
+ * Compute an unordered Super-Reconciliation, or update a previous one.
+ *
+ * @param tree Synteny tree to reconcile.
+ * @param output Tree in which to store the result. If this is `tree`, the
+ * computation happens in place. Otherwise, `tree` is left unmodified, the
+ * result is resolved in a copy of it, and the initial genes of all nodes are
+ * kept so that the computation can be updated later.
+ * @param buffers Buffers of the computation.
+ * @param stats If not null, filled with statistics about the computation.
+ * @param edited If not null, nodes of `tree` that were edited since it was
+ * last computed with the same buffers. Only those nodes and their ancestors
+ * are initialized again, if possible.
+ * @param jobs Number of threads to use, or 0 for the default number of
+ * threads chosen by OpenMP.
+ */
+void compute_unordered_super_reconciliation(
+    ::tree<Event>& tree,
+    ::tree<Event>& output,
+    UnorderedSuperReconciliationWorkspace::Buffers& buffers,
+    ReconciliationStats* stats,
+    const std::vector<::tree<Event>::iterator>* edited,
+    unsigned jobs)
+{
+    auto& info = buffers.info;
+    bool is_retained = &output != &tree;
+    auto thread_count = jobs == 0
+        ? static_cast<std::size_t>(omp_get_max_threads())
+        : std::size_t{jobs};
+
+    // An update requires the initial genes of the same tree, with the same
+    // shape, to be kept from the previous computation, and the edited
+    // leaves to only contain genes of the same alphabet. Otherwise, all
+    // nodes are initialized
+    bool is_update = edited != nullptr
+        && buffers.is_retained
+        && has_same_shape(tree, info)
+        && std::all_of(
+            std::cbegin(*edited), std::cend(*edited),
+            [&buffers, &tree, &info](::tree<Event>::iterator node)
             {
-                if (parent->type == Event::Type::Duplication)
-                {
-                    // If the left child differs from its parent, we take
-                    // advantage that the parent is a duplication node and
-                    // duplicate the `s1 . s2` segment only. This removes
-                    // the need to introduce a loss for the left child.
-                    is_segmental_left = true;
-                    parent->segment = std::make_pair(0, s1_size + s2_size);
-                }
-                else
-                {
-                    Event loss;
-                    loss.type = Event::Type::Loss;
-                    loss.synteny = synteny_parent;
-                    loss.segment = std::make_pair(
-                        s1_size + s2_size,
-                        s1_size + s2_size + s3_size + s4_size);
-
-                    tree.wrap(child_left, loss);
-                }
+                return buffers.retained_indices.count(node.node) != 0
+                    && (tree.number_of_children(node) != 0
+                        || is_in_alphabet(node->synteny, info));
+            });
+
+    buffers.is_retained = false;
+
+    if (is_update)
+    {
+        auto& dirty = buffers.dirty;
+        dirty.assign(info.nodes.size(), false);
+
+        for (auto node : *edited)
+        {
+            auto index = buffers.retained_indices[node.node];
+
+            while (index != TreeInfo::none && !dirty[index])
+            {
+                dirty[index] = true;
+                index = info.parents[index];
             }
+        }
 
-            if (parent->type == Event::Type::Duplication && !is_segmental_left)
+        // Ancestors come after their descendants in postfix order
+        std::copy(
+            std::cbegin(info.initial_genes), std::cend(info.initial_genes),
+            std::begin(info.genes));
+
+        for (std::size_t index = 0; index < info.nodes.size(); ++index)
+        {
+            if (dirty[index])
             {
-                // If the left child has the exact same synteny as its parent
-                // (or is a full loss), there are no additional incurred losses
-                // on the left. Therefore, we are free to choose any duplicated
-                // segment to better fit the right child.
-                if (child_left->type == Event::Type::Loss)
-                {
-                    // If the left child is a full loss, `s1` is necessarily
-                    // empty, therefore `right = s4`
-                    parent->segment = std::make_pair(
-                        s1_size + s2_size + s3_size,
-                        s1_size + s2_size + s3_size + s4_size);
-                }
-                else
-                {
-                    // If the left child is exactly equal to its parent, `s4`
-                    // is necessarily empty, therefore `right = s1`
-                    parent->segment = std::make_pair(0, s1_size);
-                }
+                initialize_node(tree, info, index);
             }
-            else if (synteny_right != synteny_parent
-                    && child_right->type != Event::Type::Loss)
+        }
+    }
+    else
+    {
+        initialize(tree, info, thread_count);
+    }
+
+    if (is_retained)
+    {
+        info.initial_genes = info.genes;
+    }
+
+    propagate(info, thread_count);
+    std::size_t inserted_losses = 0;
+
+    if (is_retained)
+    {
+        output = tree;
+        auto& output_nodes = buffers.output_nodes;
+        output_nodes.clear();
+
+        for (auto it = output.begin_post(); it != output.end_post(); ++it)
+        {
+            output_nodes.push_back(it);
+        }
+
+        inserted_losses = resolve(
+            output, info, output_nodes, thread_count);
+
+        if (!is_update)
+        {
+            buffers.retained_indices.clear();
+
+            for (std::size_t index = 0; index < info.nodes.size(); ++index)
             {
-                Event loss;
-                loss.type = Event::Type::Loss;
-                loss.synteny = synteny_parent;
-                loss.segment = std::make_pair(
-                    s1_size,
-                    s1_size + s2_size + s3_size);
-                tree.wrap(child_right, loss);
+                buffers.retained_indices.emplace(
+                    info.nodes[index].node, index);
             }
         }
+
+        buffers.is_retained = true;
+    }
+    else
+    {
+        inserted_losses = resolve(tree, info, info.nodes, thread_count);
+    }
+
+    if (stats != nullptr)
+    {
+        stats->candidates.clear();
+        stats->finite_candidates.clear();
+        stats->inserted_losses = inserted_losses;
+        stats->dl_score = info.scores.empty() ? 0 : info.scores.back();
     }
 }
 }
 
+UnorderedSuperReconciliationWorkspace::UnorderedSuperReconciliationWorkspace()
+: buffers(new Buffers)
+{}
+
+UnorderedSuperReconciliationWorkspace::UnorderedSuperReconciliationWorkspace(
+    UnorderedSuperReconciliationWorkspace&&) noexcept = default;
+
+UnorderedSuperReconciliationWorkspace&
+UnorderedSuperReconciliationWorkspace::operator=(
+    UnorderedSuperReconciliationWorkspace&&) noexcept = default;
+
+UnorderedSuperReconciliationWorkspace::~UnorderedSuperReconciliationWorkspace()
+    = default;
+
 void unordered_super_reconciliation(tree<Event>& tree)
 {
-    auto info = initialize(tree);
-    propagate(tree, info);
-    resolve(tree, info);
+    UnorderedSuperReconciliationWorkspace workspace;
+    unordered_super_reconciliation(tree, workspace);
+}
+
+void unordered_super_reconciliation(
+    tree<Event>& tree,
+    UnorderedSuperReconciliationWorkspace& workspace,
+    ReconciliationStats* stats,
+    unsigned jobs)
+{
+    compute_unordered_super_reconciliation(
+        tree, tree, *workspace.buffers, stats, nullptr, jobs);
+}
+
+::tree<Event> start_unordered_super_reconciliation(
+    ::tree<Event>& tree,
+    UnorderedSuperReconciliationWorkspace& workspace,
+    ReconciliationStats* stats,
+    unsigned jobs)
+{
+    ::tree<Event> result;
+    compute_unordered_super_reconciliation(
+        tree, result, *workspace.buffers, stats, nullptr, jobs);
+    return result;
+}
+
+::tree<Event> update_unordered_super_reconciliation(
+    ::tree<Event>& tree,
+    UnorderedSuperReconciliationWorkspace& workspace,
+    const std::vector<::tree<Event>::iterator>& edited,
+    ReconciliationStats* stats,
+    unsigned jobs)
+{
+    ::tree<Event> result;
+    compute_unordered_super_reconciliation(
+        tree, result, *workspace.buffers, stats, &edited, jobs);
+    return result;
 }
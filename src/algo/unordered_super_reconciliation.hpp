@@ -3,8 +3,117 @@
 
 #include "../model/Event.hpp"
 #include "../model/Synteny.hpp"
+#include "ReconciliationStats.hpp"
+#include <memory>
 #include <tree.hh>
+#include <vector>
+
+/**
+ * Buffers that are reused across calls to `unordered_super_reconciliation`
+ * (node indices and gene sets). Buffers grow to fit the largest tree seen so
+ * far and are kept afterwards. A workspace can only be used by one
+ * computation at a time.
+ */
+class UnorderedSuperReconciliationWorkspace
+{
+public:
+    UnorderedSuperReconciliationWorkspace();
+    UnorderedSuperReconciliationWorkspace(
+        UnorderedSuperReconciliationWorkspace&&) noexcept;
+    UnorderedSuperReconciliationWorkspace& operator=(
+        UnorderedSuperReconciliationWorkspace&&) noexcept;
+    ~UnorderedSuperReconciliationWorkspace();
+
+    struct Buffers;
+
+private:
+    std::unique_ptr<Buffers> buffers;
+
+    friend void unordered_super_reconciliation(
+        tree<Event>&,
+        UnorderedSuperReconciliationWorkspace&,
+        ReconciliationStats*,
+        unsigned);
+
+    friend tree<Event> start_unordered_super_reconciliation(
+        tree<Event>&,
+        UnorderedSuperReconciliationWorkspace&,
+        ReconciliationStats*,
+        unsigned);
+
+    friend tree<Event> update_unordered_super_reconciliation(
+        tree<Event>&,
+        UnorderedSuperReconciliationWorkspace&,
+        const std::vector<tree<Event>::iterator>&,
+        ReconciliationStats*,
+        unsigned);
+};
 
 void unordered_super_reconciliation(tree<Event>& tree);
 
+/**
+ * Compute an unordered Super-Reconciliation using the buffers of a workspace.
+ *
+ * @param tree Synteny tree to reconcile.
+ * @param workspace Buffers to use for the computation.
+ * @param [stats] If not null, filled with statistics about the computation.
+ * @param [jobs] Number of threads to use. Disjoint subtrees are computed
+ * concurrently by OpenMP tasks, which yields the same result as a
+ * sequential computation. If 0, use the default number of threads chosen by
+ * OpenMP.
+ */
+void unordered_super_reconciliation(
+    tree<Event>& tree,
+    UnorderedSuperReconciliationWorkspace&,
+    ReconciliationStats* = nullptr,
+    unsigned jobs = 1);
+
+/**
+ * Compute an unordered Super-Reconciliation that can be updated after local
+ * edits. Instead of modifying the tree, the result is written in a copy of
+ * it, and the workspace keeps the gene sets of all the nodes of the tree,
+ * which refers to its nodes.
+ *
+ * @param tree Synteny tree to reconcile, which is not modified and must
+ * outlive the use of the workspace for updates.
+ * @param workspace Buffers to use for the computation, which keep the gene
+ * sets of the tree afterwards.
+ * @param [stats] If not null, filled with statistics about the computation.
+ * @param [jobs] Number of threads to use (see
+ * `unordered_super_reconciliation`).
+ * @return Reconciled copy of the tree.
+ */
+tree<Event> start_unordered_super_reconciliation(
+    tree<Event>& tree,
+    UnorderedSuperReconciliationWorkspace&,
+    ReconciliationStats* = nullptr,
+    unsigned jobs = 1);
+
+/**
+ * Update an unordered Super-Reconciliation started with
+ * `start_unordered_super_reconciliation` after some nodes of the tree were
+ * edited in place. Only the gene sets of the edited nodes and their
+ * ancestors are computed again, before the propagation and resolution
+ * passes.
+ *
+ * If the shape of the tree changed, if an edited leaf contains a gene that
+ * did not appear in the tree, or if the workspace was used for another
+ * computation since, all the nodes are computed again.
+ *
+ * @param tree Tree that was passed to `start_unordered_super_reconciliation`.
+ * @param workspace Workspace that was passed to
+ * `start_unordered_super_reconciliation`.
+ * @param edited Nodes of the tree that were edited.
+ * @param [stats] If not null, filled with statistics about the computation.
+ * @param [jobs] Number of threads to use (see
+ * `unordered_super_reconciliation`).
+ * @return Reconciled copy of the edited tree.
+ */
+tree<Event> update_unordered_super_reconciliation(
+    tree<Event>& tree,
+    UnorderedSuperReconciliationWorkspace&,
+    const std::vector<::tree<Event>::iterator>& edited,
+    ReconciliationStats* = nullptr,
+    unsigned jobs = 1);
+
 #endif // ALGO_UNORDERED_SUPER_RECONCILIATION_HPP
@@ -1,8 +1,14 @@
 #include "unordered_super_reconciliation.hpp"
+#include "erase.hpp"
+#include "simulate.hpp"
+#include "super_reconciliation.hpp"
 #include "../io/nhx.hpp"
 #include "../model/Event.hpp"
 #include "../util/tree.hpp"
+#include <algorithm>
 #include <catch.hpp>
+#include <random>
+#include <vector>
 
 void expect_reconciles_to(
     const ::tree<TaggedNode>& input,
@@ -370,3 +376,125 @@ TEST_CASE("Unordered Super-Reconciliation examples")
         expect_reconciles_to(input_tree, expected_tree);
     }
 }
+
+TEST_CASE("Unordered Super-Reconciliation with many gene families")
+{
+    // More families than there are bits in a word of a gene set
+    auto genes = Synteny::generateDummy(100);
+    Synteny left{std::cbegin(genes), std::next(std::cbegin(genes), 70)};
+    Synteny right{std::next(std::cbegin(genes), 30), std::cend(genes)};
+
+    Event root;
+    root.type = Event::Type::Speciation;
+
+    Event leaf_left;
+    leaf_left.synteny = left;
+
+    Event leaf_right;
+    leaf_right.synteny = right;
+
+    ::tree<Event> event_tree;
+    auto root_it = event_tree.set_head(root);
+    event_tree.append_child(root_it, leaf_left);
+    event_tree.append_child(root_it, leaf_right);
+
+    unordered_super_reconciliation(event_tree);
+
+    // The root is labeled with the shared families, then those of the left
+    // child, then those of the right child, each group being in name order
+    auto sorted = [](std::vector<Gene> genes)
+    {
+        std::sort(std::begin(genes), std::end(genes));
+        return genes;
+    };
+
+    auto shared = sorted({
+        std::next(std::cbegin(genes), 30),
+        std::next(std::cbegin(genes), 70)});
+    auto only_left = sorted({
+        std::cbegin(genes),
+        std::next(std::cbegin(genes), 30)});
+    auto only_right = sorted({
+        std::next(std::cbegin(genes), 70),
+        std::cend(genes)});
+
+    Synteny expected_root{std::cbegin(shared), std::cend(shared)};
+    expected_root.insert(
+        std::end(expected_root),
+        std::cbegin(only_left), std::cend(only_left));
+    expected_root.insert(
+        std::end(expected_root),
+        std::cbegin(only_right), std::cend(only_right));
+
+    REQUIRE(std::begin(event_tree)->synteny == expected_root);
+
+    // Both children lose the families of the other one
+    auto child_left = event_tree.child(std::begin(event_tree), 0);
+    REQUIRE(child_left->type == Event::Type::Loss);
+    REQUIRE(child_left->segment == Synteny::Segment(70, 100));
+    REQUIRE(event_tree.begin(child_left)->synteny == left);
+
+    auto child_right = event_tree.child(std::begin(event_tree), 1);
+    REQUIRE(child_right->type == Event::Type::Loss);
+    REQUIRE(child_right->segment == Synteny::Segment(40, 70));
+    REQUIRE(event_tree.begin(child_right)->synteny == right);
+}
+
+TEST_CASE("Unordered Super-Reconciliation scores")
+{
+    std::mt19937 prng{11};
+    SimulationParams params;
+    params.base = Synteny::generateDummy(6);
+    params.depth = 6;
+    params.p_loss = 0.4;
+
+    for (int sample = 0; sample < 30; ++sample)
+    {
+        auto input_tree = get_erased_tree(simulate_evolution(prng, params));
+
+        ReconciliationStats stats;
+        UnorderedSuperReconciliationWorkspace workspace;
+        unordered_super_reconciliation(input_tree, workspace, &stats);
+        REQUIRE(stats.dl_score == get_dl_score(input_tree));
+    }
+}
+
+TEST_CASE("Unordered Super-Reconciliation on several threads")
+{
+    std::mt19937 prng{23};
+    SimulationParams params;
+    params.base = Synteny::generateDummy(12);
+    params.depth = 14;
+    params.p_loss = 0.3;
+
+    for (int sample = 0; sample < 5; ++sample)
+    {
+        // Trees large enough to be split into several tasks
+        auto input_tree = get_erased_tree(simulate_evolution(prng, params));
+        auto sequential_tree = input_tree;
+        ReconciliationStats sequential_stats;
+        UnorderedSuperReconciliationWorkspace sequential_workspace;
+        unordered_super_reconciliation(
+            sequential_tree, sequential_workspace, &sequential_stats);
+
+        for (unsigned jobs : {2, 4})
+        {
+            auto parallel_tree = input_tree;
+            ReconciliationStats parallel_stats;
+            UnorderedSuperReconciliationWorkspace parallel_workspace;
+            unordered_super_reconciliation(
+                parallel_tree, parallel_workspace, &parallel_stats, jobs);
+
+            REQUIRE(stringify_nhx_tree(parallel_tree)
+                == stringify_nhx_tree(sequential_tree));
+            REQUIRE(parallel_stats.inserted_losses
+                == sequential_stats.inserted_losses);
+            REQUIRE(parallel_stats.dl_score == sequential_stats.dl_score);
+
+            auto started_tree = start_unordered_super_reconciliation(
+                input_tree, parallel_workspace, nullptr, jobs);
+            REQUIRE(stringify_nhx_tree(started_tree)
+                == stringify_nhx_tree(sequential_tree));
+        }
+    }
+}
@@ -0,0 +1,472 @@
+#include "algo/erase.hpp"
+#include "algo/simulate.hpp"
+#include "algo/super_reconciliation.hpp"
+#include "algo/unordered_super_reconciliation.hpp"
+#include "io/nhx.hpp"
+#include "model/Synteny.hpp"
+#include "util/AllocationTracker.hpp"
+#include "util/tree.hpp"
+#include <boost/program_options.hpp>
+#include <chrono>
+#include <cstdlib>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace po = boost::program_options;
+namespace chrono = std::chrono;
+using perf_clock = chrono::steady_clock;
+
+/**
+ * All arguments that can be passed to the program.
+ * See below for a description of each argument.
+ */
+struct Arguments
+{
+    std::string filter;
+    unsigned min_time;
+    unsigned seed;
+    bool list;
+};
+
+/**
+ * Read arguments passed to the program and produce the
+ * help message if requested by the user.
+ *
+ * @param result Filled with arguments passed to the program or
+ * appropriate default values.
+ * @param argc Number of arguments in argv.
+ * @param argv Tokenized list of arguments passed to the program.
+ * @return True if the program may continue, or false if it has
+ * to be stopped.
+ */
+bool read_arguments(Arguments& result, int argc, const char* argv[])
+{
+    po::options_description root{"General options"};
+    root.add_options()
+        ("help,h", "show this help message")
+        ("filter,f",
+         po::value(&result.filter)
+            ->value_name("TEXT")
+            ->default_value(""),
+         "only run the benchmarks whose name contains the given text")
+        ("min-time,t",
+         po::value(&result.min_time)
+            ->value_name("MS")
+            ->default_value(200),
+         "minimum time in milliseconds during which each benchmark is "
+         "repeated")
+        ("seed,S",
+         po::value(&result.seed)
+            ->value_name("SEED")
+            ->default_value(1),
+         "seed for generating the inputs of the benchmarks, so that runs "
+         "with the same seed measure the same inputs")
+        ("list,l",
+         po::bool_switch(&result.list),
+         "list the names of the benchmarks instead of running them")
+    ;
+
+    po::variables_map values;
+    po::store(
+        po::command_line_parser(argc, argv)
+            .options(root)
+            .run(),
+        values);
+
+    if (values.count("help"))
+    {
+        std::cout << "Usage: " << argv[0] << " [options...]\n";
+        std::cout << "\nMeasure the time and allocations taken by the core "
+            "operations.\n";
+        std::cout << root;
+        return false;
+    }
+
+    po::notify(values);
+    return true;
+}
+
+/**
+ * Measurements of a benchmark.
+ */
+struct BenchmarkResult
+{
+    // Mean time taken by one operation
+    double nanoseconds;
+
+    // Mean number of heap allocations made by one operation
+    double allocations;
+
+    // Number of operations that were measured
+    std::size_t iterations;
+};
+
+/**
+ * Measurements of a batch of operations.
+ */
+struct BatchResult
+{
+    perf_clock::duration elapsed;
+    std::size_t allocations;
+};
+
+/**
+ * Make a batch that repeats an operation.
+ *
+ * @param operation Operation to repeat, called without arguments.
+ * @return Function that runs a given number of operations and measures
+ * them.
+ */
+template<typename Operation>
+auto repeat(Operation operation)
+{
+    return [operation](std::size_t iterations)
+    {
+        // Workers of the parallel ordered algorithm allocate too
+        AllocationTracker tracker{AllocationTracker::Scope::Process};
+        auto start = perf_clock::now();
+
+        for (std::size_t i = 0; i < iterations; ++i)
+        {
+            operation();
+        }
+
+        return BatchResult{
+            perf_clock::now() - start,
+            tracker.getAllocations()};
+    };
+}
+
+/**
+ * Make a batch that repeats an operation which modifies its input. Copies
+ * of the input are made before each batch, so that only the operation
+ * itself is measured.
+ *
+ * @param input Input of the operation.
+ * @param operation Operation to repeat, called with a copy of the input.
+ * @return Function that runs a given number of operations and measures
+ * them.
+ */
+template<typename Input, typename Operation>
+auto repeat_on_copies(Input input, Operation operation)
+{
+    return [input, operation](std::size_t iterations)
+    {
+        std::vector<Input> copies(iterations, input);
+        AllocationTracker tracker{AllocationTracker::Scope::Process};
+        auto start = perf_clock::now();
+
+        for (auto& copy : copies)
+        {
+            operation(copy);
+        }
+
+        return BatchResult{
+            perf_clock::now() - start,
+            tracker.getAllocations()};
+    };
+}
+
+/**
+ * Measure a batch of operations. After an untimed run to warm caches and
+ * buffers up, the number of operations is doubled until they take at least
+ * the given time.
+ *
+ * @param batch Batch to measure.
+ * @param min_time Minimum duration of the measurement.
+ * @return Measurements of the operation.
+ */
+template<typename Batch>
+BenchmarkResult measure(Batch batch, chrono::milliseconds min_time)
+{
+    batch(1);
+    std::size_t iterations = 1;
+
+    while (true)
+    {
+        auto result = batch(iterations);
+
+        if (result.elapsed >= min_time
+                || iterations >= (std::size_t{1} << 30))
+        {
+            return {
+                static_cast<double>(chrono::duration_cast<
+                    chrono::nanoseconds>(result.elapsed).count())
+                    / iterations,
+                static_cast<double>(result.allocations) / iterations,
+                iterations
+            };
+        }
+
+        iterations *= 2;
+    }
+}
+
+/**
+ * Benchmark that can be run by name.
+ */
+struct Benchmark
+{
+    std::string name;
+    std::function<BenchmarkResult(chrono::milliseconds)> run;
+};
+
+/**
+ * Generate a random subsequence of a synteny.
+ */
+template<typename PRNG>
+Synteny random_subsequence(PRNG& prng, const Synteny& synteny)
+{
+    std::bernoulli_distribution keep{0.6};
+    Synteny result;
+
+    for (const auto& gene : synteny)
+    {
+        if (keep(prng))
+        {
+            result.push_back(gene);
+        }
+    }
+
+    return result;
+}
+
+/**
+ * Simulate a full synteny tree and its erased counterpart.
+ */
+template<typename PRNG>
+std::pair<::tree<Event>, ::tree<Event>> random_trees(
+    PRNG& prng,
+    unsigned base_size,
+    int depth)
+{
+    SimulationParams params;
+    params.base = Synteny::generateDummy(base_size);
+    params.depth = depth;
+
+    auto full = simulate_evolution(prng, params);
+    auto erased = full;
+    erase_tree(erased, std::begin(erased));
+    return {std::move(full), std::move(erased)};
+}
+
+/**
+ * Build the list of all benchmarks, with inputs of varied sizes.
+ */
+std::vector<Benchmark> make_benchmarks(unsigned seed)
+{
+    std::mt19937 prng{seed};
+    std::vector<Benchmark> result;
+
+    auto add = [&result](const std::string& name, unsigned size,
+        std::function<BenchmarkResult(chrono::milliseconds)> run)
+    {
+        result.push_back({name + "/" + std::to_string(size), std::move(run)});
+    };
+
+    for (unsigned size : {8, 32, 128})
+    {
+        auto base = Synteny::generateDummy(size);
+        auto target = random_subsequence(prng, base);
+
+        add("synteny/distance_to", size, [=](chrono::milliseconds time)
+        {
+            return measure(repeat([&base, &target]()
+            {
+                volatile auto distance = base.distanceTo(target);
+                (void) distance;
+            }), time);
+        });
+
+        add("synteny/reconcile", size, [=](chrono::milliseconds time)
+        {
+            return measure(repeat([&base, &target]()
+            {
+                auto segments = base.reconcile(target);
+                (void) segments;
+            }), time);
+        });
+    }
+
+    for (unsigned size : {4, 8, 12})
+    {
+        auto base = Synteny::generateDummy(size);
+
+        add("synteny/generate_subsequences", size,
+            [=](chrono::milliseconds time)
+            {
+                return measure(repeat([&base]()
+                {
+                    auto subsequences = base.generateSubsequences();
+                    (void) subsequences;
+                }), time);
+            });
+
+        add("synteny/subsequences", size, [=](chrono::milliseconds time)
+        {
+            return measure(repeat([&base]()
+            {
+                std::size_t total = 0;
+
+                for (auto mask : base.subsequences())
+                {
+                    total += base.getSubsequence(mask).size();
+                }
+
+                volatile auto result = total;
+                (void) result;
+            }), time);
+        });
+    }
+
+    for (int depth : {4, 8, 12})
+    {
+        SimulationParams params;
+        params.base = Synteny::generateDummy(8);
+        params.depth = depth;
+
+        add("simulate/evolution", depth, [=](chrono::milliseconds time)
+        {
+            std::mt19937 simulation_prng{static_cast<unsigned>(depth)};
+
+            return measure(repeat([&simulation_prng, &params]()
+            {
+                auto tree = simulate_evolution(simulation_prng, params);
+                (void) tree;
+            }), time);
+        });
+    }
+
+    for (int depth : {4, 8, 12})
+    {
+        auto trees = random_trees(prng, 8, depth);
+        auto nhx = stringify_nhx_tree(trees.first);
+        auto tagged = tree_cast<Event, TaggedNode>(trees.first);
+
+        add("nhx/parse", depth, [=](chrono::milliseconds time)
+        {
+            return measure(repeat([&nhx]()
+            {
+                auto tree = parse_nhx_tree<Event>(nhx);
+                (void) tree;
+            }), time);
+        });
+
+        add("nhx/stringify", depth, [=](chrono::milliseconds time)
+        {
+            return measure(repeat([&trees]()
+            {
+                auto output = stringify_nhx_tree(trees.first);
+                (void) output;
+            }), time);
+        });
+
+        add("tree/cast", depth, [=](chrono::milliseconds time)
+        {
+            return measure(repeat([&tagged]()
+            {
+                auto events = tree_cast<TaggedNode, Event>(tagged);
+                (void) events;
+            }), time);
+        });
+
+        add("tree/erase", depth, [=](chrono::milliseconds time)
+        {
+            return measure(repeat_on_copies(trees.first, [](::tree<Event>& tree)
+            {
+                erase_tree(tree, std::begin(tree));
+            }), time);
+        });
+
+        add("tree/erased_copy", depth, [=](chrono::milliseconds time)
+        {
+            return measure(repeat([&trees]()
+            {
+                auto erased = get_erased_tree(trees.first);
+                (void) erased;
+            }), time);
+        });
+    }
+
+    for (unsigned size : {4, 8, 12})
+    {
+        auto erased = random_trees(prng, size, 6).second;
+
+        add("reconcile/ordered", size, [=](chrono::milliseconds time)
+        {
+            return measure(repeat_on_copies(erased, [](::tree<Event>& tree)
+            {
+                super_reconciliation(tree);
+            }), time);
+        });
+    }
+
+    for (unsigned size : {8, 32, 128})
+    {
+        SimulationParams params;
+        params.base = Synteny::generateDummy(size);
+        params.p_rearr = 0.7;
+
+        auto erased = simulate_evolution(prng, params);
+        erase_tree(erased, std::begin(erased));
+
+        add("reconcile/unordered", size, [=](chrono::milliseconds time)
+        {
+            return measure(repeat_on_copies(erased, [](::tree<Event>& tree)
+            {
+                unordered_super_reconciliation(tree);
+            }), time);
+        });
+    }
+
+    return result;
+}
+
+int main(int argc, const char* argv[])
+{
+    Arguments args;
+
+    if (!read_arguments(args, argc, argv))
+    {
+        return EXIT_SUCCESS;
+    }
+
+    auto benchmarks = make_benchmarks(args.seed);
+    chrono::milliseconds min_time{args.min_time};
+
+    if (!args.list)
+    {
+        std::cout << std::left << std::setw(36) << "benchmark"
+            << std::right << std::setw(14) << "ns/op"
+            << std::setw(14) << "allocs/op"
+            << std::setw(12) << "iterations" << "\n";
+    }
+
+    for (const auto& benchmark : benchmarks)
+    {
+        if (benchmark.name.find(args.filter) == std::string::npos)
+        {
+            continue;
+        }
+
+        if (args.list)
+        {
+            std::cout << benchmark.name << "\n";
+            continue;
+        }
+
+        auto result = benchmark.run(min_time);
+
+        std::cout << std::left << std::setw(36) << benchmark.name
+            << std::right << std::fixed
+            << std::setw(14) << std::setprecision(1) << result.nanoseconds
+            << std::setw(14) << std::setprecision(2) << result.allocations
+            << std::setw(12) << result.iterations << std::endl;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -1,7 +1,6 @@
 #include "algo/erase.hpp"
-#include "io/nhx.hpp"
+#include "io/format.hpp"
 #include "io/util.hpp"
-#include "util/tree.hpp"
 #include <boost/program_options.hpp>
 #include <cstdlib>
 #include <iostream>
@@ -17,6 +16,7 @@ struct Arguments
 {
     std::string input_path;
     std::string output_path;
+    TreeFormat format;
 };
 
 /**
@@ -47,6 +47,13 @@ bool read_arguments(Arguments& result, int argc, const char* argv[])
             ->default_value("-"),
          "path of the file in which the output tree should be stored, or '-' "
             "to store it in standard output")
+        ("format,F",
+         po::value(&result.format)
+            ->value_name("FORMAT")
+            ->default_value(TreeFormat::NHX),
+         "format of the output tree, either 'nhx' or 'binary' for a compact "
+            "format that is faster to exchange between programs. Input "
+            "trees are accepted in both formats")
     ;
 
     po::variables_map values;
@@ -78,18 +85,17 @@ int main(int argc, const char* argv[])
         return EXIT_SUCCESS;
     }
 
-    auto input_tree = parse_nhx_tree(read_all_from(
+    auto event_tree = get_erased_tree(parse_event_tree(read_all_from(
         args.input_path,
         "Input the tree to be erased, "
-            "and finish with Ctrl-D:"));
-
-    auto event_tree = tree_cast<TaggedNode, Event>(input_tree);
-    erase_tree(event_tree, std::begin(event_tree));
-    auto result_tree = tree_cast<Event, TaggedNode>(event_tree);
+            "and finish with Ctrl-D:")));
 
     write_all_to(
         args.output_path,
-        stringify_nhx_tree(result_tree),
+        [&event_tree, &args](std::ostream& out)
+        {
+            write_event_tree(out, event_tree, args.format);
+        },
         "Erased tree (use `viz` to visualize):");
 
     return EXIT_SUCCESS;
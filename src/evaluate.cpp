@@ -1,20 +1,35 @@
 #include "algo/simulate.hpp"
+#include "algo/beam_super_reconciliation.hpp"
 #include "algo/erase.hpp"
 #include "algo/super_reconciliation.hpp"
 #include "algo/unordered_super_reconciliation.hpp"
-#include "util/containers.hpp"
+#include "util/AllocationTracker.hpp"
 #include "util/MultivaluedNumber.hpp"
-#include "util/tree.hpp"
+#include "util/PerfCounters.hpp"
+#include "util/ThreadPlacement.hpp"
+#include "util/random.hpp"
 #include "io/nhx.hpp"
 #include <boost/program_options.hpp>
 #include <cassert>
+#include <algorithm>
+#include <array>
+#include <atomic>
 #include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
 #include <fstream>
 #include <iomanip>
 #include <iostream>
+#include <memory>
+#include <mutex>
 #include <nlohmann/json.hpp>
 #include <omp.h>
-#include <unordered_map>
+#include <random>
+#include <string>
+#include <thread>
+#include <utility>
 #include <vector>
 
 namespace po = boost::program_options;
@@ -23,6 +38,63 @@ using perf_clock = chrono::steady_clock;
 using us = chrono::microseconds;
 using json = nlohmann::json;
 
+/**
+ * Metrics that can be evaluated on each sample.
+ */
+enum class Metric : unsigned
+{
+    // Difference between the number of duplications and losses of the
+    // reference and the reconciled trees
+    DLScore,
+
+    // Duration of the reconciliation step
+    Duration,
+
+    // Duration of the simulation step
+    SimulateDuration,
+
+    // Duration of the erasure step
+    EraseDuration,
+
+    // Hardware counters of the reconciliation step
+    Cycles,
+    Instructions,
+    CacheMisses,
+
+    // Peak heap usage of the reconciliation step, in bytes
+    Memory,
+
+    // Number of heap allocations of the reconciliation step
+    Allocations,
+};
+
+constexpr std::size_t metric_count = 9;
+
+/**
+ * Name of each metric, as given on the command line and in the output.
+ * Durations are in microseconds.
+ */
+const char* const metric_names[metric_count] = {
+    "dlscore",
+    "duration",
+    "simulate_duration",
+    "erase_duration",
+    "cycles",
+    "instructions",
+    "cache_misses",
+    "memory",
+    "allocations",
+};
+
+/**
+ * Hardware counters that measure each of the counter metrics.
+ */
+const std::pair<Metric, PerfCounters::Event> metric_counters[] = {
+    {Metric::Cycles, PerfCounters::Event::Cycles},
+    {Metric::Instructions, PerfCounters::Event::Instructions},
+    {Metric::CacheMisses, PerfCounters::Event::CacheMisses},
+};
+
 /**
  * Input/output structure for specifying which metrics have to be evaluated in
  * a simulation-evaluation step and to provide the results of this evaluation.
@@ -30,25 +102,24 @@ using json = nlohmann::json;
 struct EvaluationResults
 {
     /**
-     * DL-score, difference between the number of duplications and losses
-     * between the reference and the reconciled trees.
+     * Value of each metric, indexed by `Metric`.
      */
-    unsigned dlscore = 0;
+    std::array<long, metric_count> values{};
 
     /**
-     * Duration of the reconciliation step in microseconds.
+     * Whether to evaluate each metric, indexed by `Metric`.
      */
-    long duration = 0;
+    std::array<bool, metric_count> needs{};
 
-    /**
-     * Whether to compute the DL-score.
-     */
-    bool needs_dlscore = false;
+    long& operator[](Metric metric)
+    {
+        return this->values[static_cast<std::size_t>(metric)];
+    }
 
-    /**
-     * Whether to measure the reconciliation time.
-     */
-    bool needs_duration = false;
+    bool isNeeded(Metric metric) const
+    {
+        return this->needs[static_cast<std::size_t>(metric)];
+    }
 };
 
 /**
@@ -58,63 +129,139 @@ struct EvaluationResults
  * @param prng Pseudo-random number generator to use for the simulation.
  * @param use_unordered Whether to use the unordered reconciliation
  * algorithm (if true) or not (if false).
+ * @param beam Number of candidates kept for each node by the approximate
+ * ordered algorithm, or 0 to use the exact algorithm.
  * @param results Input/output argument for the metrics.
  * @param params Simulation parameters.
+ * @param counters Hardware counters to read around the reconciliation
+ * step, opening the events of `metric_counters` that are needed in order,
+ * or null if no counter metric is needed.
  */
 template<typename PRNG>
 void evaluate(
     PRNG& prng,
     bool use_unordered,
+    std::size_t beam,
     EvaluationResults& results,
-    SimulationParams& params)
+    SimulationParams& params,
+    PerfCounters* counters)
 {
+    // Run one step of the evaluation, measuring its duration if needed
+    auto step = [&results](Metric metric, auto&& run)
+    {
+        if (!results.isNeeded(metric))
+        {
+            run();
+            return;
+        }
+
+        auto start = perf_clock::now();
+        run();
+        auto end = perf_clock::now();
+        results[metric] = chrono::duration_cast<us, long>(end - start)
+            .count();
+    };
+
     // Simulate the evolution of a fixed-size synteny by performing random
     // speciations, duplications and losses
-    auto reference_tree = simulate_evolution(prng, params);
+    ::tree<Event> reference_tree;
+    unsigned ref_score = 0;
+
+    step(Metric::SimulateDuration, [&]()
+    {
+        reference_tree = simulate_evolution(prng, params, &ref_score);
+    });
 
     // Erase loss and internal synteny labelling information from the
     // reference tree to make the input for the reconciliation algorithm
-    auto reconciled_tree = reference_tree;
-    erase_tree(reconciled_tree, std::begin(reconciled_tree));
+    ::tree<Event> reconciled_tree;
 
-    chrono::time_point<perf_clock> start;
-    chrono::time_point<perf_clock> end;
+    step(Metric::EraseDuration, [&]()
+    {
+        reconciled_tree = get_erased_tree(reference_tree);
+    });
 
-    if (results.needs_duration)
+    if (counters != nullptr)
     {
-        start = perf_clock::now();
+        counters->start();
     }
 
-    if (use_unordered)
+    // The algorithms report the score of their result, so that the trees
+    // are not walked again. Statistics per node are allocated beforehand,
+    // to keep them out of the memory metrics
+    bool needs_score = results.isNeeded(Metric::DLScore);
+    ReconciliationStats stats;
+    stats.candidates.reserve(reconciled_tree.size());
+    stats.finite_candidates.reserve(reconciled_tree.size());
+
+    auto reconcile = [&]()
     {
-        unordered_super_reconciliation(reconciled_tree);
+        if (use_unordered)
+        {
+            UnorderedSuperReconciliationWorkspace workspace;
+            unordered_super_reconciliation(
+                reconciled_tree, workspace,
+                needs_score ? &stats : nullptr);
+        }
+        else
+        {
+            SuperReconciliationParams reconcile_params;
+            reconcile_params.beam = beam;
+            reconcile_params.stats = needs_score ? &stats : nullptr;
+
+            if (beam > 0)
+            {
+                beam_super_reconciliation(reconciled_tree, reconcile_params);
+            }
+            else
+            {
+                super_reconciliation(reconciled_tree, reconcile_params);
+            }
+        }
+    };
+
+    if (results.isNeeded(Metric::Memory)
+            || results.isNeeded(Metric::Allocations))
+    {
+        // Samples are evaluated concurrently, each one on a single thread
+        AllocationTracker tracker{AllocationTracker::Scope::Thread};
+        step(Metric::Duration, reconcile);
+        results[Metric::Memory] = tracker.getPeakBytes();
+        results[Metric::Allocations] = tracker.getAllocations();
     }
     else
     {
-        super_reconciliation(reconciled_tree);
+        step(Metric::Duration, reconcile);
     }
 
-    if (results.needs_duration)
+    if (counters != nullptr)
     {
-        end = perf_clock::now();
-        results.duration = chrono::duration_cast<us, long>(end - start)
-            .count();
+        counters->stop();
+        std::size_t index = 0;
+
+        for (const auto& counter : metric_counters)
+        {
+            if (results.isNeeded(counter.first))
+            {
+                results[counter.first] = static_cast<long>(
+                    counters->get(index));
+                ++index;
+            }
+        }
     }
 
-    if (results.needs_dlscore)
+    if (needs_score)
     {
-        auto ref_score = get_dl_score(reference_tree);
-        auto rec_score = get_dl_score(reconciled_tree);
+        unsigned rec_score = stats.dl_score;
 
-        if (ref_score < rec_score)
+        // The approximate algorithm may be less parsimonious than the
+        // reference, in which case the metric is negative
+        if (ref_score < rec_score && beam == 0)
         {
             // If the reconciled tree is less parsimonious than what
             // we started with, there is a flaw in the algorithm
-            auto ref_tree = tree_cast<Event, TaggedNode>(reference_tree);
-            auto ref_tree_nhx = stringify_nhx_tree(ref_tree);
-
-            auto rec_tree = tree_cast<Event, TaggedNode>(reconciled_tree);
-            auto rec_tree_nhx = stringify_nhx_tree(rec_tree);
+            auto ref_tree_nhx = stringify_nhx_tree(reference_tree);
+            auto rec_tree_nhx = stringify_nhx_tree(reconciled_tree);
 
             throw std::runtime_error{
                 "The reconciled tree is less parsimonious than the reference "
@@ -124,10 +271,104 @@ void evaluate(
                     + std::to_string(rec_score) + "):\n" + rec_tree_nhx};
         }
 
-        results.dlscore = ref_score - rec_score;
+        results[Metric::DLScore] = static_cast<long>(ref_score)
+            - static_cast<long>(rec_score);
     }
 }
 
+/**
+ * Part of the tasks of an evaluation that is computed by one process, when
+ * an evaluation is split between several processes or machines.
+ */
+struct Shard
+{
+    // Index of this part, between 0 and count - 1
+    unsigned index = 0;
+
+    // Total number of parts
+    unsigned count = 1;
+};
+
+/**
+ * Read a shard description in the 'INDEX/COUNT' format.
+ */
+std::istream& operator>>(std::istream& in, Shard& shard)
+{
+    char separator = '\0';
+    in >> shard.index >> separator >> shard.count;
+
+    if (separator != '/' || shard.count == 0 || shard.index >= shard.count)
+    {
+        in.setstate(std::ios::failbit);
+    }
+
+    return in;
+}
+
+/**
+ * Print a shard description in the 'INDEX/COUNT' format.
+ */
+std::ostream& operator<<(std::ostream& out, const Shard& shard)
+{
+    return out << shard.index << '/' << shard.count;
+}
+
+/**
+ * Formats in which results can be written.
+ */
+enum class ResultsFormat
+{
+    // Single JSON array holding one object per set of parameters, with the
+    // values of each metric for all its samples, written once all the
+    // samples are computed
+    JSON,
+
+    // One JSON object per line for each sample, written as samples are
+    // computed, after a header line (see `load_journal`)
+    JSONLines,
+};
+
+/**
+ * Read a results format from its name ('json' or 'jsonl').
+ */
+std::istream& operator>>(std::istream& in, ResultsFormat& format)
+{
+    std::string name;
+    in >> name;
+
+    if (name == "json")
+    {
+        format = ResultsFormat::JSON;
+    }
+    else if (name == "jsonl")
+    {
+        format = ResultsFormat::JSONLines;
+    }
+    else
+    {
+        in.setstate(std::ios::failbit);
+    }
+
+    return in;
+}
+
+/**
+ * Print the name of a results format.
+ */
+std::ostream& operator<<(std::ostream& out, const ResultsFormat& format)
+{
+    switch (format)
+    {
+    case ResultsFormat::JSON:
+        return out << "json";
+
+    case ResultsFormat::JSONLines:
+        return out << "jsonl";
+    }
+
+    return out;
+}
+
 /**
  * All arguments that can be passed to the program.
  * See below for a description of each argument.
@@ -135,11 +376,20 @@ void evaluate(
 struct Arguments
 {
     std::string output;
+    ResultsFormat format;
     std::vector<std::string> metrics;
 
     bool use_unordered;
+    std::size_t beam;
     unsigned sample_size;
+    double precision;
+    unsigned min_samples;
     unsigned jobs;
+    ThreadPlacement bind;
+    std::uint64_t seed;
+    bool resume;
+    Shard shard;
+    std::vector<std::string> merge;
 
     MultivaluedNumber<unsigned> base_size;
     MultivaluedNumber<unsigned> depth;
@@ -176,7 +426,12 @@ bool read_arguments(Arguments& result, int argc, const char* argv[])
          po::value(&result.metrics)
             ->value_name("METRIC")
             ->required(),
-         "the metrics to evaluate, either 'dlscore' or 'duration'")
+         "the metrics to evaluate: 'dlscore', the times in microseconds of "
+         "each step ('simulate_duration', 'erase_duration' and 'duration' "
+         "for the reconciliation) or the hardware counters of the "
+         "reconciliation ('cycles', 'instructions' and 'cache_misses', on "
+         "Linux only), its peak heap usage in bytes ('memory') and its "
+         "number of heap allocations ('allocations')")
     ;
     root.add(req_group);
 
@@ -186,11 +441,45 @@ bool read_arguments(Arguments& result, int argc, const char* argv[])
         ("unordered,U",
          po::bool_switch(&result.use_unordered),
          "use the unordered super-reconciliation algorithm")
+        ("beam,B",
+         po::value(&result.beam)
+            ->value_name("K")
+            ->default_value(0),
+         "use the approximate ordered super-reconciliation algorithm that "
+         "only keeps the K best candidates of each node. The 'dlscore' "
+         "metric is then negative for samples on which the approximation is "
+         "less parsimonious than the reference tree. If 0, use the exact "
+         "algorithm")
+        ("format,F",
+         po::value(&result.format)
+            ->value_name("FORMAT")
+            ->default_value(ResultsFormat::JSON),
+         "format of the output file: 'json' for a single array holding the "
+         "samples of each set of parameters, written at the end, or 'jsonl' "
+         "for one line per sample, written as samples are computed. In the "
+         "latter format, the output file is its own journal, so that no "
+         "result is kept in memory")
         ("sample-size,S",
          po::value(&result.sample_size)
             ->value_name("SIZE")
             ->default_value(1),
-         "number of samples to take for each set of parameters")
+         "number of samples to take for each set of parameters, or maximum "
+         "number of samples with --precision")
+        ("precision,P",
+         po::value(&result.precision)
+            ->value_name("REL")
+            ->default_value(0),
+         "stop sampling a set of parameters as soon as the 95% confidence "
+         "interval of the mean of each metric is narrower than REL times "
+         "this mean on each side, after at least --min-samples samples. "
+         "Threads that are freed move on to the sets that have not "
+         "converged yet. If 0, take --sample-size samples of each set")
+        ("min-samples",
+         po::value(&result.min_samples)
+            ->value_name("SIZE")
+            ->default_value(10),
+         "minimum number of samples of each set of parameters before "
+         "checking the convergence of its metrics with --precision")
         ("jobs,j",
          po::value(&result.jobs)
             ->value_name("JOBS")
@@ -198,6 +487,46 @@ bool read_arguments(Arguments& result, int argc, const char* argv[])
          "number of threads to use for computing. If 0, automatically "
          "evaluate the best amount of threads based on the resources "
          "of the machine. Set to 1 to disable multithreading")
+        ("bind",
+         po::value(&result.bind)
+            ->value_name("PLACEMENT")
+            ->default_value(ThreadPlacement::None),
+         "how to bind the computing threads to cores: 'none' to let the "
+         "system move them, 'close' to fill the cores of each NUMA node in "
+         "turn, or 'spread' to distribute them evenly across cores. Sets "
+         "OMP_PROC_BIND to the placement and OMP_PLACES to 'cores' (unless "
+         "already set) before restarting the program. Bound threads keep "
+         "the memory they allocate on their own node")
+        ("seed",
+         po::value(&result.seed)
+            ->value_name("SEED")
+            ->default_value(0),
+         "master seed from which the seed of each sample is derived, based "
+         "on its index and parameters, so that results do not depend on the "
+         "number of threads. The special value 0 instructs the program to "
+         "grab a random seed from one of the system’s entropy sources")
+        ("resume",
+         po::bool_switch(&result.resume),
+         "resume an interrupted evaluation. Results are appended to a "
+         "journal file next to the output file ('<output>.partial') as they "
+         "are computed, and samples found in the journal are not computed "
+         "again. The seed of the interrupted evaluation is reused")
+        ("shard",
+         po::value(&result.shard)
+            ->value_name("INDEX/COUNT")
+            ->default_value(Shard{}),
+         "only compute one of COUNT parts of the tasks, for splitting an "
+         "evaluation between several processes. All parts must be given the "
+         "same arguments and an explicit seed. Instead of the final results, "
+         "the output file receives the journal of the part, and parts are "
+         "then combined with --merge")
+        ("merge",
+         po::value(&result.merge)
+            ->value_name("PATH")
+            ->multitoken(),
+         "combine the outputs of all the parts of a split evaluation into "
+         "the final results, instead of computing anything. Simulation "
+         "parameters and metrics must match the ones given to the parts")
     ;
     root.add(gen_opt_group);
 
@@ -268,62 +597,662 @@ bool read_arguments(Arguments& result, int argc, const char* argv[])
     }
 
     po::notify(values);
+
+    if (result.shard.count > 1 && result.seed == 0)
+    {
+        throw po::error{"the --shard option requires an explicit --seed"};
+    }
+
+    if (result.precision > 0
+            && (result.shard.count > 1 || !result.merge.empty()))
+    {
+        throw po::error{"the --precision option cannot be combined with "
+            "--shard or --merge"};
+    }
+
     return true;
 }
 
 /**
- * Lifecycle object that is private to each worker thread.
- * (derived from https://stackoverflow.com/a/10737658)
+ * Display the progress of tasks on standard output. Workers only increment
+ * an atomic counter, which is displayed periodically by a separate thread,
+ * so that they never have to wait for each other or for the output.
  */
-struct ThreadLifecycle
+class ProgressReporter
 {
+public:
     /**
-     * Normal constructor for non-multithreaded scenarios.
+     * Start reporting the progress of a given number of tasks.
+     *
+     * @param total Total number of tasks.
      */
-    ThreadLifecycle()
+    explicit ProgressReporter(unsigned long total)
+    : total(total)
     {
-        seed();
+        this->print(0);
+        this->thread = std::thread{&ProgressReporter::run, this};
+    }
+
+    ProgressReporter(const ProgressReporter&) = delete;
+    ProgressReporter& operator=(const ProgressReporter&) = delete;
+
+    ~ProgressReporter()
+    {
+        this->stop();
     }
 
     /**
-     * This copy constructor gets called for each new worker thread
-     * and serves as the initialization function.
+     * Signal that a task was performed.
      */
-    ThreadLifecycle(const ThreadLifecycle&)
+    void advance()
     {
-        seed();
+        this->performed.fetch_add(1, std::memory_order_relaxed);
     }
 
-    // Thread-local pseudo-random number generator
-    std::mt19937 prng;
+    /**
+     * Stop reporting, after displaying the final progress.
+     */
+    void stop()
+    {
+        if (!this->thread.joinable())
+        {
+            return;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock{this->mutex};
+            this->is_stopped = true;
+        }
+
+        this->wakeup.notify_one();
+        this->thread.join();
+    }
 
 private:
-    void seed()
+    // Delay between two reports
+    static constexpr auto period = chrono::milliseconds{250};
+
+    std::atomic<unsigned long> performed{0};
+    unsigned long total;
+
+    std::mutex mutex;
+    std::condition_variable wakeup;
+    bool is_stopped = false;
+    std::thread thread;
+
+    void run()
     {
-        std::random_device rd;
-        this->prng.seed(rd());
+        unsigned long reported = 0;
+        std::unique_lock<std::mutex> lock{this->mutex};
+
+        while (true)
+        {
+            bool is_stopped = this->wakeup.wait_for(lock, period, [this]()
+            {
+                return this->is_stopped;
+            });
+
+            auto performed = this->performed.load(std::memory_order_relaxed);
+
+            if (performed != reported)
+            {
+                this->print(performed);
+                reported = performed;
+            }
+
+            if (is_stopped)
+            {
+                return;
+            }
+        }
+    }
+
+    void print(unsigned long performed) const
+    {
+        auto ratio = this->total == 0
+            ? 1.
+            : static_cast<double>(performed) / this->total;
+
+        std::cout << std::fixed << std::setprecision(2) << "["
+            << std::setw(6) << (ratio * 100)
+            << "%] " << performed << "/" << this->total << " tasks performed"
+            << std::endl;
     }
 };
 
+constexpr chrono::milliseconds ProgressReporter::period;
+
 /**
- * Display progress on standard output.
+ * Grid of the sets of parameters to evaluate. Sets are numbered in the
+ * order of the grid, the last parameter varying fastest.
  */
-void report_progress(unsigned long performed, unsigned long total)
+struct ParamsGrid
 {
-    if (performed != total && performed % 10 != 0)
+    std::vector<unsigned> base_sizes;
+    std::vector<unsigned> depths;
+    std::vector<double> p_dups;
+    std::vector<double> p_dup_lengths;
+    std::vector<double> p_losses;
+    std::vector<double> p_loss_lengths;
+    std::vector<double> p_rearrs;
+
+    explicit ParamsGrid(const Arguments& args)
+    : base_sizes(args.base_size.getValues()),
+      depths(args.depth.getValues()),
+      p_dups(args.p_dup.getValues()),
+      p_dup_lengths(args.p_dup_length.getValues()),
+      p_losses(args.p_loss.getValues()),
+      p_loss_lengths(args.p_loss_length.getValues()),
+      p_rearrs(args.p_rearr.getValues())
+    {}
+
+    /**
+     * Get the number of sets of parameters in the grid.
+     */
+    std::size_t size() const
     {
-        return;
+        return this->base_sizes.size() * this->depths.size()
+            * this->p_dups.size() * this->p_dup_lengths.size()
+            * this->p_losses.size() * this->p_loss_lengths.size()
+            * this->p_rearrs.size();
     }
 
-    std::cout << std::fixed << std::setprecision(2) << "["
-        << std::setw(6) << ((static_cast<double>(performed) / total) * 100)
-        << "%] " << performed << "/" << total << " tasks performed"
-        << std::endl;
+    /**
+     * Values of the parameters of a set of the grid.
+     */
+    struct Point
+    {
+        unsigned base_size;
+        unsigned depth;
+        double p_dup;
+        double p_dup_length;
+        double p_loss;
+        double p_loss_length;
+        double p_rearr;
+    };
+
+    /**
+     * Get the values of a set of parameters from its index.
+     */
+    Point at(std::size_t index) const
+    {
+        // Decode the index of each parameter, the last one varying fastest
+        auto next = [&index](const auto& values)
+        {
+            auto result = values[index % values.size()];
+            index /= values.size();
+            return result;
+        };
+
+        Point result;
+        result.p_rearr = next(this->p_rearrs);
+        result.p_loss_length = next(this->p_loss_lengths);
+        result.p_loss = next(this->p_losses);
+        result.p_dup_length = next(this->p_dup_lengths);
+        result.p_dup = next(this->p_dups);
+        result.depth = next(this->depths);
+        result.base_size = next(this->base_sizes);
+        return result;
+    }
+
+    /**
+     * Get the JSON description of a set of parameters.
+     */
+    json describe(std::size_t index) const
+    {
+        auto point = this->at(index);
+
+        return {
+            {"base_size", point.base_size},
+            {"depth", point.depth},
+            {"p_dup", point.p_dup},
+            {"p_dup_length", point.p_dup_length},
+            {"p_loss", point.p_loss},
+            {"p_loss_length", point.p_loss_length},
+            {"p_rearr", point.p_rearr}
+        };
+    }
+
+    /**
+     * Find the index of a set of parameters from its JSON description.
+     *
+     * @param params Description of the parameters.
+     * @param [index] Set to the index of the parameters.
+     * @return Whether the parameters are part of the grid.
+     */
+    bool find(const json& params, std::size_t& index) const
+    {
+        index = 0;
+
+        auto next = [&index, &params](const auto& values, const char* name)
+        {
+            using Value = typename std::decay_t<decltype(values)>::value_type;
+            auto value = params.at(name).template get<Value>();
+            auto it = std::find(values.cbegin(), values.cend(), value);
+            index = index * values.size() + (it - values.cbegin());
+            return it != values.cend();
+        };
+
+        return next(this->base_sizes, "base_size")
+            && next(this->depths, "depth")
+            && next(this->p_dups, "p_dup")
+            && next(this->p_dup_lengths, "p_dup_length")
+            && next(this->p_losses, "p_loss")
+            && next(this->p_loss_lengths, "p_loss_length")
+            && next(this->p_rearrs, "p_rearr");
+    }
+};
+
+/**
+ * Estimate the relative cost of evaluating a sample with a set of
+ * parameters, used for scheduling the most expensive samples first.
+ *
+ * The simulated tree has about 2^depth leaves. The ordered algorithm
+ * considers every subsequence of the ancestral synteny at each node, while
+ * the unordered one only works on gene sets of a size bounded by the
+ * ancestral synteny’s and the approximate one combines the pairs of
+ * candidates of the children of each node.
+ *
+ * @param point Set of parameters.
+ * @param use_unordered Whether the unordered algorithm is used.
+ * @param beam Number of candidates kept for each node by the approximate
+ * algorithm, or 0 if the exact algorithm is used.
+ * @return Estimated cost, in arbitrary units.
+ */
+double estimate_cost(
+    const ParamsGrid::Point& point,
+    bool use_unordered,
+    std::size_t beam)
+{
+    auto nodes = std::ldexp(1., static_cast<int>(point.depth) + 1);
+    auto size = static_cast<double>(point.base_size) + 1;
+
+    if (use_unordered)
+    {
+        return nodes * size;
+    }
+
+    if (beam > 0)
+    {
+        auto width = static_cast<double>(beam);
+        return nodes * size * width * width * width;
+    }
+
+    return nodes * size * std::ldexp(1., static_cast<int>(point.base_size));
+}
+
+/**
+ * Sample to be evaluated.
+ */
+struct Task
+{
+    // Index of the set of parameters in the grid
+    std::size_t params_index;
+
+    // Index of the sample for these parameters
+    unsigned sample_id;
+
+    // Estimated cost of the evaluation
+    double cost;
+};
+
+/**
+ * Value of each metric for each slot, empty for the metrics that are not
+ * evaluated.
+ */
+using MetricValues = std::array<std::vector<long>, metric_count>;
+
+/**
+ * Convergence of the metrics of a set of parameters, in adaptive mode.
+ * Samples are taken into account in order, once all the previous ones are
+ * computed, so that the number of samples kept for each set does not
+ * depend on the order in which they are computed.
+ */
+struct Convergence
+{
+    // Number of consecutive samples, from the first one, that are computed
+    // and taken into account
+    std::atomic<unsigned> prefix{0};
+
+    // Mean of each metric over these samples and sum of the squares of the
+    // deviations from that mean (see Welford’s online algorithm)
+    std::array<double, metric_count> means{};
+    std::array<double, metric_count> deviations{};
+
+    // Number of samples kept for the set of parameters. Samples after this
+    // one are not computed anymore
+    std::atomic<unsigned> count{0};
+};
+
+/**
+ * Take the newly computed samples of a set of parameters into account,
+ * and stop its sampling if all its metrics have converged.
+ *
+ * @param args Arguments of the evaluation.
+ * @param params_index Index of the set of parameters.
+ * @param is_done Marks the slots of the computed samples.
+ * @param values Metrics of each sample.
+ * @param convergence Convergence of the set of parameters to update.
+ */
+void update_convergence(
+    const Arguments& args,
+    std::size_t params_index,
+    const std::vector<char>& is_done,
+    const MetricValues& values,
+    Convergence& convergence)
+{
+    // Quantile of the normal distribution for a 95% confidence interval
+    constexpr double quantile = 1.96;
+    auto first = params_index * args.sample_size;
+
+    while (convergence.prefix < convergence.count
+            && is_done[first + convergence.prefix])
+    {
+        auto slot = first + convergence.prefix;
+        auto size = ++convergence.prefix;
+        bool has_converged = size >= args.min_samples && size > 1;
+
+        for (std::size_t metric = 0; metric < metric_count; ++metric)
+        {
+            if (values[metric].empty())
+            {
+                continue;
+            }
+
+            auto value = static_cast<double>(values[metric][slot]);
+            auto& mean = convergence.means[metric];
+            auto& deviation = convergence.deviations[metric];
+            auto delta = value - mean;
+            mean += delta / size;
+            deviation += delta * (value - mean);
+
+            auto half_width = quantile
+                * std::sqrt(deviation / (size - 1) / size);
+            has_converged = has_converged
+                && half_width <= args.precision * std::abs(mean);
+        }
+
+        if (has_converged)
+        {
+            convergence.count = size;
+        }
+    }
+}
+
+/**
+ * Load the results of the samples that were computed by an interrupted
+ * evaluation from its journal. The journal starts with a header line
+ * holding the master seed and the algorithm, followed by one line per
+ * sample. Lines that cannot be parsed (such as a line that was being
+ * written when the evaluation was interrupted) and samples that are not
+ * part of the current grid or that lack a metric are ignored.
+ *
+ * @param path Path to the journal.
+ * @param args Arguments of the current evaluation.
+ * @param grid Grid of parameters of the current evaluation.
+ * @param needs Metrics that each sample must have.
+ * @param [seed] Set to the master seed of the interrupted evaluation.
+ * @param [is_done] Marks the slots of all loaded samples.
+ * @param [values] Filled with the loaded metrics, except for the metrics
+ * whose vector is empty.
+ * @return Number of loaded samples.
+ * @throws std::runtime_error If the journal cannot be read or if it was
+ * created by an incompatible evaluation.
+ */
+unsigned long load_journal(
+    const std::string& path,
+    const Arguments& args,
+    const ParamsGrid& grid,
+    const std::array<bool, metric_count>& needs,
+    std::uint64_t& seed,
+    std::vector<char>& is_done,
+    MetricValues& values)
+{
+    std::ifstream journal{path};
+
+    if (!journal)
+    {
+        throw std::runtime_error{"Cannot open the journal " + path
+            + " to resume from"};
+    }
+
+    std::string line;
+    json header;
+
+    if (!std::getline(journal, line)
+            || !(header = json::parse(line, nullptr, false)).is_object()
+            || !header.count("seed") || !header.count("unordered"))
+    {
+        throw std::runtime_error{"Invalid journal header in " + path};
+    }
+
+    if (header["unordered"].get<bool>() != args.use_unordered
+            || header.value("beam", std::size_t{0}) != args.beam)
+    {
+        throw std::runtime_error{"The journal " + path + " was created "
+            "with the other reconciliation algorithm"};
+    }
+
+    seed = header["seed"].get<std::uint64_t>();
+
+    if (args.seed != 0 && args.seed != seed)
+    {
+        throw std::runtime_error{"The journal " + path + " was created "
+            "with the seed " + std::to_string(seed)};
+    }
+
+    unsigned long loaded = 0;
+
+    while (std::getline(journal, line))
+    {
+        auto record = json::parse(line, nullptr, false);
+        std::size_t params_index;
+
+        if (!record.is_object() || !record.count("params")
+                || !record.count("sample"))
+        {
+            continue;
+        }
+
+        bool has_metrics = true;
+
+        for (std::size_t metric = 0; metric < metric_count; ++metric)
+        {
+            if (needs[metric] && !record.count(metric_names[metric]))
+            {
+                has_metrics = false;
+            }
+        }
+
+        if (!has_metrics)
+        {
+            continue;
+        }
+
+        try
+        {
+            auto sample_id = record["sample"].get<unsigned>();
+
+            if (!grid.find(record["params"], params_index)
+                    || sample_id >= args.sample_size)
+            {
+                continue;
+            }
+
+            auto slot = params_index * args.sample_size + sample_id;
+
+            for (std::size_t metric = 0; metric < metric_count; ++metric)
+            {
+                if (!values[metric].empty())
+                {
+                    values[metric][slot]
+                        = record[metric_names[metric]].get<long>();
+                }
+            }
+
+            if (!is_done[slot])
+            {
+                is_done[slot] = true;
+                ++loaded;
+            }
+        }
+        catch (const json::exception&)
+        {
+            continue;
+        }
+    }
+
+    return loaded;
+}
+
+/**
+ * Write the header line of a journal.
+ *
+ * @param out Output stream.
+ * @param args Arguments of the evaluation.
+ * @param seed Master seed of the evaluation.
+ */
+void write_journal_header(
+    std::ostream& out,
+    const Arguments& args,
+    std::uint64_t seed)
+{
+    out << json{
+        {"seed", seed},
+        {"unordered", args.use_unordered},
+        {"beam", args.beam}}
+        << "\n";
+}
+
+/**
+ * Write the results of all samples to the output file. In JSON format,
+ * samples are grouped by set of parameters in the order of the grid. In
+ * JSON Lines format, samples are written one per line in the same order,
+ * after a journal header.
+ *
+ * @param args Arguments of the evaluation.
+ * @param grid Grid of parameters of the evaluation.
+ * @param seed Master seed of the evaluation.
+ * @param values Metrics of each sample.
+ * @param counts Number of samples to write for each set of parameters.
+ * @return Whether the output file was successfully written.
+ */
+bool write_results(
+    const Arguments& args,
+    const ParamsGrid& grid,
+    std::uint64_t seed,
+    const MetricValues& values,
+    const std::vector<unsigned>& counts)
+{
+    if (args.format == ResultsFormat::JSONLines)
+    {
+        std::ofstream output(args.output);
+        write_journal_header(output, args, seed);
+
+        for (std::size_t params_index = 0;
+                params_index < grid.size();
+                ++params_index)
+        {
+            auto params = grid.describe(params_index);
+
+            for (unsigned sample_id = 0;
+                    sample_id < counts[params_index];
+                    ++sample_id)
+            {
+                json record = {{"params", params}, {"sample", sample_id}};
+                auto slot = params_index * args.sample_size + sample_id;
+
+                for (std::size_t metric = 0; metric < metric_count; ++metric)
+                {
+                    if (!values[metric].empty())
+                    {
+                        record[metric_names[metric]] = values[metric][slot];
+                    }
+                }
+
+                output << record << "\n";
+            }
+        }
+
+        output.close();
+        return static_cast<bool>(output);
+    }
+
+    json results = json::array();
+
+    for (std::size_t params_index = 0;
+            params_index < grid.size();
+            ++params_index)
+    {
+        json sample_result = {{"params", grid.describe(params_index)}};
+        auto first = params_index * args.sample_size;
+        auto last = first + counts[params_index];
+
+        for (std::size_t metric = 0; metric < metric_count; ++metric)
+        {
+            if (!values[metric].empty())
+            {
+                sample_result[metric_names[metric]] = std::vector<long>(
+                    values[metric].begin() + first,
+                    values[metric].begin() + last);
+            }
+        }
+
+        results.push_back(std::move(sample_result));
+    }
+
+    std::ofstream output(args.output);
+    output << results;
+    output.close();
+    return static_cast<bool>(output);
+}
+
+/**
+ * Combine the outputs of all parts of a split evaluation.
+ *
+ * @param args Arguments of the evaluation.
+ * @param grid Grid of parameters of the evaluation.
+ * @param needs Metrics of the evaluation.
+ * @param [seed] Set to the master seed of the parts.
+ * @param [is_done] Marks the slots of all loaded samples.
+ * @param [values] Filled with the loaded metrics.
+ * @throws std::runtime_error If a part cannot be read, if parts come from
+ * incompatible evaluations or if some samples are missing.
+ */
+void merge_shards(
+    const Arguments& args,
+    const ParamsGrid& grid,
+    const std::array<bool, metric_count>& needs,
+    std::uint64_t& seed,
+    std::vector<char>& is_done,
+    MetricValues& values)
+{
+    // All parts must share the seed of the first one
+    Arguments part_args = args;
+    unsigned long loaded = 0;
+
+    for (const auto& path : args.merge)
+    {
+        loaded += load_journal(
+            path, part_args, grid, needs,
+            part_args.seed, is_done, values);
+    }
+
+    seed = part_args.seed;
+
+    std::cout << "Merged " << loaded << " samples from "
+        << args.merge.size() << " parts\n";
+
+    if (loaded != is_done.size())
+    {
+        throw std::runtime_error{
+            std::to_string(is_done.size() - loaded)
+            + " samples are missing from the merged parts"};
+    }
 }
 
 int main(int argc, const char* argv[])
 {
-    using namespace std::string_literals;
     Arguments args;
 
     if (!read_arguments(args, argc, argv))
@@ -336,79 +1265,272 @@ int main(int argc, const char* argv[])
         omp_set_num_threads(args.jobs);
     }
 
-    ThreadLifecycle lifecycle;
-    bool needs_dlscore = contains(args.metrics, "dlscore"s);
-    bool needs_duration = contains(args.metrics, "duration"s);
+    try
+    {
+        // Each sample is evaluated by a single thread, so that its trees
+        // and tables are allocated on the node of that thread
+        place_threads(args.bind, argv);
+    }
+    catch (const std::exception& err)
+    {
+        std::cerr << "Error: " << err.what() << "\n";
+        return EXIT_FAILURE;
+    }
+
+    std::array<bool, metric_count> needs{};
 
-    // Stores all the results for all samples of each set of parameters
-    json results = json::array();
+    for (const auto& name : args.metrics)
+    {
+        auto it = std::find(
+            std::begin(metric_names), std::end(metric_names), name);
+
+        if (it == std::end(metric_names))
+        {
+            std::cerr << "Error: Unknown metric '" << name << "'\n";
+            return EXIT_FAILURE;
+        }
+
+        needs[it - std::begin(metric_names)] = true;
+    }
+
+    // Hardware counters are opened by each thread for itself
+    std::vector<PerfCounters::Event> counter_events;
 
-    // For each set of parameters, store the index in the results array
-    // at which measurements are stored
-    std::unordered_map<SimulationParams, std::size_t> find_params_index;
+    for (const auto& counter : metric_counters)
+    {
+        if (needs[static_cast<std::size_t>(counter.first)])
+        {
+            counter_events.push_back(counter.second);
+        }
+    }
+
+    if (!counter_events.empty())
+    {
+        try
+        {
+            PerfCounters check{counter_events};
+        }
+        catch (const std::exception& err)
+        {
+            std::cerr << "Error: " << err.what() << "\n";
+            return EXIT_FAILURE;
+        }
+    }
+
+    std::vector<std::unique_ptr<PerfCounters>> counters(
+        omp_get_max_threads());
 
     // If at least one evaluation fails, this flag is set to true to
     // signal other threads to stop computations
-    bool has_failed = false;
+    std::atomic<bool> has_failed{false};
+
+    ParamsGrid grid{args};
+    unsigned long params_count = grid.size();
+    unsigned long total_tasks = args.sample_size * params_count;
+
+    // If the evaluation is split, the output of each part is its journal,
+    // and so is the output in JSON Lines format
+    bool is_sharded = args.shard.count > 1;
+    bool is_streamed = is_sharded
+        || args.format == ResultsFormat::JSONLines;
+    auto journal_path = is_streamed ? args.output : args.output + ".partial";
 
-    // Track task progression
-    unsigned long performed_tasks = 0;
-    unsigned long total_tasks = args.sample_size
-        * args.base_size.size()
-        * args.depth.size()
-        * args.p_dup.size()
-        * args.p_dup_length.size()
-        * args.p_loss.size()
-        * args.p_loss_length.size()
-        * args.p_rearr.size();
+    // In adaptive mode, each set of parameters is sampled until its metrics
+    // converge. Otherwise, all sets get the same number of samples
+    bool is_adaptive = args.precision > 0;
+    std::vector<Convergence> convergences(is_adaptive ? params_count : 0);
+
+    for (auto& convergence : convergences)
+    {
+        convergence.count = args.sample_size;
+    }
 
-    report_progress(performed_tasks, total_tasks);
+    // Samples of a set of parameters only start when they are less than
+    // this many samples ahead of the ones taken into account, so that
+    // threads do not compute samples far past the convergence of the set
+    const unsigned sample_window = omp_get_max_threads();
+
+    // Each task stores its results at its own slot, so that tasks never
+    // contend for the results. The results of the sample `sample_id` for
+    // the set of parameters `params_index` are stored at index
+    // `params_index * sample_size + sample_id`. Results are only kept if
+    // they are written at the end, if parts are merged or if convergence
+    // is checked
+    MetricValues values;
+
+    for (std::size_t metric = 0; metric < metric_count; ++metric)
+    {
+        if (needs[metric]
+                && (!is_streamed || !args.merge.empty() || is_adaptive))
+        {
+            values[metric].resize(total_tasks);
+        }
+    }
+
+    // Slots of the samples that were computed by an interrupted evaluation
+    std::vector<char> is_done(total_tasks, false);
+    unsigned long resumed_tasks = 0;
+
+    // Seed of each sample is derived from the master seed, the index of the
+    // sample and its parameters
+    std::uint64_t seed = args.seed;
+
+    try
+    {
+        if (!args.merge.empty())
+        {
+            merge_shards(args, grid, needs, seed, is_done, values);
+            return write_results(
+                    args, grid, seed, values,
+                    std::vector<unsigned>(params_count, args.sample_size))
+                ? EXIT_SUCCESS
+                : EXIT_FAILURE;
+        }
+
+        if (args.resume)
+        {
+            resumed_tasks = load_journal(
+                journal_path, args, grid, needs,
+                seed, is_done, values);
+
+            for (std::size_t params_index = 0;
+                    params_index < convergences.size();
+                    ++params_index)
+            {
+                update_convergence(
+                    args, params_index, is_done, values,
+                    convergences[params_index]);
+            }
+        }
+    }
+    catch (const std::exception& err)
+    {
+        std::cerr << "Error: " << err.what() << "\n";
+        return EXIT_FAILURE;
+    }
+
+    if (seed == 0)
+    {
+        std::random_device rd;
+        seed = (std::uint64_t{rd()} << 32) | rd();
+    }
+
+    std::cout << "Seed: " << seed << "\n";
+
+    if (args.resume)
+    {
+        std::cout << "Resuming " << resumed_tasks
+            << " samples from " << journal_path << "\n";
+    }
+
+    // Results are appended to the journal as they are computed. Each thread
+    // gathers its records in its own buffer and appends it to the journal
+    // when it grows too large or too old
+    std::ofstream journal{
+        journal_path,
+        args.resume ? std::ios::app : std::ios::trunc};
+
+    if (!args.resume)
+    {
+        write_journal_header(journal, args, seed);
+    }
+
+    journal.flush();
+
+    std::vector<std::string> journal_buffers(omp_get_max_threads());
+    std::vector<perf_clock::time_point> journal_flushes(
+        journal_buffers.size(), perf_clock::now());
+    constexpr std::size_t journal_buffer_size = 1 << 12;
+    constexpr auto journal_period = chrono::seconds{1};
+
+    auto flush_journal = [&](std::size_t thread)
+    {
+        auto& buffer = journal_buffers[thread];
+
+        if (!buffer.empty())
+        {
+            #pragma omp critical(journal)
+            {
+                journal << buffer;
+                journal.flush();
+            }
+
+            buffer.clear();
+        }
+
+        journal_flushes[thread] = perf_clock::now();
+    };
+
+    // Build the list of tasks. Costs grow exponentially with some
+    // parameters, so that a few tasks take most of the time: starting with
+    // the most expensive ones avoids leaving threads idle at the end
+    std::vector<Task> tasks;
+    tasks.reserve(total_tasks);
+
+    for (std::size_t params_index = 0;
+            params_index < params_count;
+            ++params_index)
+    {
+        auto cost = estimate_cost(
+            grid.at(params_index), args.use_unordered, args.beam);
+
+        for (unsigned sample_id = 0; sample_id < args.sample_size; ++sample_id)
+        {
+            tasks.push_back({params_index, sample_id, cost});
+        }
+    }
+
+    // In adaptive mode, the samples of all the sets of parameters are taken
+    // in rounds, so that threads always move on to the next sample of the
+    // sets that have not converged yet
+    std::stable_sort(tasks.begin(), tasks.end(),
+        [is_adaptive](const Task& lhs, const Task& rhs)
+        {
+            if (is_adaptive && lhs.sample_id != rhs.sample_id)
+            {
+                return lhs.sample_id < rhs.sample_id;
+            }
+
+            return lhs.cost > rhs.cost;
+        });
+
+    // When the evaluation is split, parts take tasks in turn from the
+    // sorted list so that each one receives a similar share of the cost.
+    // Tasks computed by an interrupted evaluation are then dropped
+    std::vector<Task> part;
+    unsigned long part_tasks = 0;
+
+    for (std::size_t position = args.shard.index;
+            position < tasks.size();
+            position += args.shard.count)
+    {
+        const auto& task = tasks[position];
+        ++part_tasks;
+
+        if (!is_done[task.params_index * args.sample_size + task.sample_id])
+        {
+            part.push_back(task);
+        }
+    }
+
+    tasks = std::move(part);
+    ProgressReporter progress{part_tasks};
+
+    for (auto i = tasks.size(); i < part_tasks; ++i)
+    {
+        progress.advance();
+    }
 
     #pragma omp parallel for                                                   \
         firstprivate(                                                          \
-            lifecycle, args, total_tasks,                                      \
-            needs_dlscore, needs_duration)                                     \
+            args, seed, needs, journal_period, is_adaptive, sample_window)     \
         shared(                                                                \
-            results, find_params_index, performed_tasks,                       \
-            std::cout, has_failed)                                             \
+            tasks, values, grid, counter_events, counters, journal_buffers,    \
+            journal_flushes, flush_journal, progress, std::cout, has_failed,   \
+            metric_names, is_done, convergences)                               \
         default(none)                                                          \
-        collapse(8) schedule(dynamic)
-    for (unsigned sample_id = 0; sample_id < args.sample_size; ++sample_id)
-    {
-    for (
-        auto base_size = args.base_size.begin();
-        base_size < args.base_size.end();
-        ++base_size)
-    {
-    for (
-        auto depth = args.depth.begin();
-        depth < args.depth.end();
-        ++depth)
-    {
-    for (
-        auto p_dup = args.p_dup.begin();
-        p_dup < args.p_dup.end();
-        ++p_dup)
-    {
-    for (
-        auto p_dup_length = args.p_dup_length.begin();
-        p_dup_length < args.p_dup_length.end();
-        ++p_dup_length)
-    {
-    for (
-        auto p_loss = args.p_loss.begin();
-        p_loss < args.p_loss.end();
-        ++p_loss)
-    {
-    for (
-        auto p_loss_length = args.p_loss_length.begin();
-        p_loss_length < args.p_loss_length.end();
-        ++p_loss_length)
-    {
-    for (
-        auto p_rearr = args.p_rearr.begin();
-        p_rearr < args.p_rearr.end();
-        ++p_rearr)
+        schedule(dynamic, 1)
+    for (std::size_t task = 0; task < tasks.size(); ++task)
     {
         if (has_failed)
         {
@@ -418,90 +1540,178 @@ int main(int argc, const char* argv[])
             continue;
         }
 
+        auto params_index = tasks[task].params_index;
+        auto sample_id = tasks[task].sample_id;
+        auto slot = params_index * args.sample_size + sample_id;
+        auto point = grid.at(params_index);
+
+        if (is_adaptive)
+        {
+            // Wait for the previous samples of the set to be taken into
+            // account. They come earlier in the list of tasks and are
+            // therefore already handed out to other threads
+            auto& convergence = convergences[params_index];
+
+            while (!has_failed
+                    && sample_id < convergence.count
+                    && sample_id >= convergence.prefix + sample_window)
+            {
+                std::this_thread::sleep_for(chrono::milliseconds{1});
+            }
+
+            if (sample_id >= convergence.count)
+            {
+                // The metrics of this set of parameters already converged
+                progress.advance();
+                continue;
+            }
+        }
+
+        auto sample_seed = derive_seed(seed, sample_id);
+        sample_seed = derive_seed(sample_seed, point.base_size);
+        sample_seed = derive_seed(sample_seed, point.depth);
+        sample_seed = derive_seed(sample_seed, point.p_dup);
+        sample_seed = derive_seed(sample_seed, point.p_dup_length);
+        sample_seed = derive_seed(sample_seed, point.p_loss);
+        sample_seed = derive_seed(sample_seed, point.p_loss_length);
+        sample_seed = derive_seed(sample_seed, point.p_rearr);
+        auto prng = make_prng<std::mt19937>(sample_seed);
+
         SimulationParams sample_params;
-        sample_params.base = Synteny::generateDummy(*base_size);
-        sample_params.depth = *depth;
-        sample_params.p_dup = *p_dup;
-        sample_params.p_dup_length = *p_dup_length;
-        sample_params.p_loss = *p_loss;
-        sample_params.p_loss_length = *p_loss_length;
-        sample_params.p_rearr = *p_rearr;
+        sample_params.base = Synteny::generateDummy(point.base_size);
+        sample_params.depth = point.depth;
+        sample_params.p_dup = point.p_dup;
+        sample_params.p_dup_length = point.p_dup_length;
+        sample_params.p_loss = point.p_loss;
+        sample_params.p_loss_length = point.p_loss_length;
+        sample_params.p_rearr = point.p_rearr;
 
         EvaluationResults sample_info;
-        sample_info.needs_dlscore = needs_dlscore;
-        sample_info.needs_duration = needs_duration;
+        sample_info.needs = needs;
+        auto thread = omp_get_thread_num();
 
         try
         {
+            auto& thread_counters = counters[thread];
+
+            if (!thread_counters && !counter_events.empty())
+            {
+                thread_counters.reset(new PerfCounters{counter_events});
+            }
+
             evaluate(
-                lifecycle.prng, args.use_unordered,
-                sample_info, sample_params);
+                prng, args.use_unordered, args.beam,
+                sample_info, sample_params,
+                thread_counters.get());
         }
         catch (const std::exception& err)
         {
             has_failed = true;
+
+            #pragma omp critical
             std::cout << "\nError: " << err.what() << "\n";
+
+            continue;
         }
 
-        #pragma omp critical
+        json record = {
+            {"params", grid.describe(params_index)},
+            {"sample", sample_id}
+        };
+
+        for (std::size_t metric = 0; metric < metric_count; ++metric)
         {
-            // If no entry exist for the current set of params exist, create
-            // one. Otherwise, directly append results to the existing one
-            // by using the stored index
-            if (!find_params_index.count(sample_params))
+            if (needs[metric])
             {
-                json sample_result = {
-                    {"params", {
-                        {"base_size", *base_size},
-                        {"depth", *depth},
-                        {"p_dup", *p_dup},
-                        {"p_dup_length", *p_dup_length},
-                        {"p_loss", *p_loss},
-                        {"p_loss_length", *p_loss_length},
-                        {"p_rearr", *p_rearr}
-                    }}
-                };
-
-                if (needs_dlscore)
-                {
-                    sample_result["dlscore"] = json::array();
-                }
-
-                if (needs_duration)
-                {
-                    sample_result["duration"] = json::array();
-                }
-
-                find_params_index.emplace(sample_params, results.size());
-                results.push_back(std::move(sample_result));
+                record[metric_names[metric]] = sample_info.values[metric];
             }
 
-            json& sample_result = results.at(
-                find_params_index.at(sample_params));
-
-            if (needs_dlscore)
+            if (!values[metric].empty())
             {
-                sample_result["dlscore"].push_back(sample_info.dlscore);
+                values[metric][slot] = sample_info.values[metric];
             }
+        }
 
-            if (needs_duration)
+        if (is_adaptive)
+        {
+            #pragma omp critical(convergence)
             {
-                sample_result["duration"].push_back(sample_info.duration);
+                is_done[slot] = true;
+                update_convergence(
+                    args, params_index, is_done, values,
+                    convergences[params_index]);
             }
+        }
 
-            ++performed_tasks;
-            report_progress(performed_tasks, total_tasks);
+        auto& buffer = journal_buffers[thread];
+        buffer += record.dump();
+        buffer += '\n';
+
+        if (buffer.size() >= journal_buffer_size
+                || perf_clock::now() - journal_flushes[thread]
+                    >= journal_period)
+        {
+            flush_journal(thread);
         }
-    }}}}}}}}
+
+        progress.advance();
+    }
+
+    for (std::size_t thread = 0; thread < journal_buffers.size(); ++thread)
+    {
+        flush_journal(thread);
+    }
+
+    progress.stop();
 
     if (has_failed)
     {
         return EXIT_FAILURE;
     }
-    else
+
+    std::vector<unsigned> counts(params_count, args.sample_size);
+
+    if (is_adaptive)
     {
-        std::ofstream output(args.output);
-        output << results;
+        unsigned long converged = 0;
+        unsigned long kept = 0;
+
+        for (std::size_t params_index = 0;
+                params_index < params_count;
+                ++params_index)
+        {
+            counts[params_index] = convergences[params_index].count;
+            converged += counts[params_index] < args.sample_size;
+            kept += counts[params_index];
+        }
+
+        std::cout << "Converged " << converged << " of " << params_count
+            << " sets of parameters with " << kept << " of " << total_tasks
+            << " samples\n";
+    }
+
+    if (is_streamed && !is_adaptive)
+    {
+        // The journal is the output
         return EXIT_SUCCESS;
     }
+
+    // In adaptive mode, the journal may hold samples computed after the
+    // convergence of their set, which are dropped from the output
+    journal.close();
+
+    if (is_streamed)
+    {
+        return write_results(args, grid, seed, values, counts)
+            ? EXIT_SUCCESS
+            : EXIT_FAILURE;
+    }
+
+    if (write_results(args, grid, seed, values, counts))
+    {
+        // All results are in the output file: the journal is not needed
+        std::remove(journal_path.c_str());
+    }
+
+    return EXIT_SUCCESS;
 }
@@ -0,0 +1,518 @@
+#include "binary.hpp"
+#include "../model/Gene.hpp"
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace
+{
+
+const char magic[] = {'S', 'R', 'T', 'B'};
+constexpr unsigned char version = 1;
+
+// Layout of the flags byte of each node
+constexpr unsigned type_mask = 0x3;
+constexpr unsigned segment_flag = 0x4;
+constexpr unsigned synteny_shift = 3;
+constexpr unsigned synteny_mask = 0x3;
+
+// Encodings of the synteny of each node
+enum SyntenyEncoding : unsigned
+{
+    EmptySynteny = 0,
+    ParentSynteny = 1,
+    MaskedSynteny = 2,
+    ExplicitSynteny = 3,
+};
+
+unsigned encode_type(Event::Type type)
+{
+    switch (type)
+    {
+    case Event::Type::None:
+        return 0;
+
+    case Event::Type::Duplication:
+        return 1;
+
+    case Event::Type::Speciation:
+        return 2;
+
+    case Event::Type::Loss:
+        return 3;
+    }
+
+    return 0;
+}
+
+Event::Type decode_type(unsigned type)
+{
+    switch (type)
+    {
+    case 1:
+        return Event::Type::Duplication;
+
+    case 2:
+        return Event::Type::Speciation;
+
+    case 3:
+        return Event::Type::Loss;
+
+    default:
+        return Event::Type::None;
+    }
+}
+
+/**
+ * Append an unsigned integer to a buffer as a LEB128 varint.
+ */
+void put_varint(std::string& out, std::uint64_t value)
+{
+    while (value >= 0x80)
+    {
+        out += static_cast<char>((value & 0x7F) | 0x80);
+        value >>= 7;
+    }
+
+    out += static_cast<char>(value);
+}
+
+/**
+ * Get the number of bytes taken by an unsigned integer as a varint.
+ */
+std::size_t varint_size(std::uint64_t value)
+{
+    std::size_t result = 1;
+
+    while (value >= 0x80)
+    {
+        value >>= 7;
+        ++result;
+    }
+
+    return result;
+}
+
+/**
+ * Compute the mask of the positions of a parent synteny that are kept in
+ * a child synteny, if the child is a subsequence of the parent. Genes are
+ * matched greedily from left to right.
+ *
+ * @param parent Parent synteny.
+ * @param child Child synteny.
+ * @param [mask] Filled with the mask bytes.
+ * @return Whether the child is a subsequence of the parent.
+ */
+bool subsequence_mask(
+    const Synteny& parent,
+    const Synteny& child,
+    std::string& mask)
+{
+    mask.assign((parent.size() + 7) / 8, '\0');
+    std::size_t matched = 0;
+
+    for (std::size_t i = 0; i < parent.size() && matched < child.size(); ++i)
+    {
+        if (parent[i] == child[matched])
+        {
+            mask[i / 8] = static_cast<char>(
+                static_cast<unsigned char>(mask[i / 8]) | (1u << (i % 8)));
+            ++matched;
+        }
+    }
+
+    return matched == child.size();
+}
+
+/**
+ * Cursor over binary input that checks bounds on each read.
+ */
+class Decoder
+{
+public:
+    explicit Decoder(boost::string_ref input)
+    : start(reinterpret_cast<const unsigned char*>(input.data())),
+      current(start),
+      end(start + input.size())
+    {}
+
+    [[noreturn]] void fail(const std::string& message) const
+    {
+        throw std::invalid_argument{
+            "Invalid binary tree: " + message + " at byte "
+            + std::to_string(this->current - this->start)};
+    }
+
+    unsigned char byte()
+    {
+        if (this->current == this->end)
+        {
+            this->fail("unexpected end of input");
+        }
+
+        return *this->current++;
+    }
+
+    std::uint64_t varint()
+    {
+        std::uint64_t result = 0;
+        unsigned shift = 0;
+
+        while (true)
+        {
+            auto next = this->byte();
+
+            if (shift >= 64)
+            {
+                this->fail("varint overflow");
+            }
+
+            result |= static_cast<std::uint64_t>(next & 0x7F) << shift;
+            shift += 7;
+
+            if ((next & 0x80) == 0)
+            {
+                return result;
+            }
+        }
+    }
+
+    // Read a varint that must be smaller than a given bound
+    std::size_t index(std::uint64_t bound, const char* what)
+    {
+        auto result = this->varint();
+
+        if (result >= bound)
+        {
+            this->fail(std::string{"invalid "} + what);
+        }
+
+        return static_cast<std::size_t>(result);
+    }
+
+    boost::string_ref bytes(std::size_t count)
+    {
+        if (static_cast<std::size_t>(this->end - this->current) < count)
+        {
+            this->fail("unexpected end of input");
+        }
+
+        boost::string_ref result{
+            reinterpret_cast<const char*>(this->current), count};
+        this->current += count;
+        return result;
+    }
+
+    // Check that only whitespace remains
+    void finish()
+    {
+        while (this->current != this->end)
+        {
+            auto chr = *this->current;
+
+            if (chr != ' ' && chr != '\t' && chr != '\n' && chr != '\r')
+            {
+                this->fail("trailing data");
+            }
+
+            ++this->current;
+        }
+    }
+
+private:
+    const unsigned char* start;
+    const unsigned char* current;
+    const unsigned char* end;
+};
+
+/**
+ * Append the binary representation of a tree to a buffer, flushing the
+ * buffer to an output stream whenever it grows past a given size.
+ *
+ * @param [buffer] Buffer to append to.
+ * @param out Stream to flush the buffer to, or null to never flush.
+ * @param tree Tree to write.
+ */
+void write_binary_tree_helper(
+    std::string& buffer,
+    std::ostream* out,
+    const ::tree<Event>& tree)
+{
+    constexpr std::size_t flush_size = 1 << 16;
+    constexpr auto no_index = std::numeric_limits<std::uint32_t>::max();
+
+    buffer.append(magic, sizeof(magic));
+    buffer += static_cast<char>(version);
+
+    // Number the genes of the tree in order of first appearance
+    std::vector<std::uint32_t> local_index(Gene::count(), no_index);
+    std::vector<Gene> genes;
+
+    for (const auto& event : tree)
+    {
+        for (const auto& gene : event.synteny)
+        {
+            auto& index = local_index[gene.getId()];
+
+            if (index == no_index)
+            {
+                index = static_cast<std::uint32_t>(genes.size());
+                genes.push_back(gene);
+            }
+        }
+    }
+
+    put_varint(buffer, genes.size());
+
+    for (const auto& gene : genes)
+    {
+        put_varint(buffer, gene.getName().size());
+        buffer += gene.getName();
+    }
+
+    put_varint(buffer, tree.size());
+    std::string mask;
+
+    for (auto it = tree.begin(); it != tree.end(); ++it)
+    {
+        const auto& event = *it;
+        const SharedSynteny* parent = it.node->parent == nullptr
+            ? nullptr
+            : &it.node->parent->data.synteny;
+
+        unsigned encoding = ExplicitSynteny;
+
+        if (event.synteny.empty())
+        {
+            encoding = EmptySynteny;
+        }
+        else if (parent != nullptr && *parent == event.synteny)
+        {
+            encoding = ParentSynteny;
+        }
+        else if (parent != nullptr
+                && subsequence_mask(*parent, event.synteny, mask))
+        {
+            // Only use the mask if it is smaller than the explicit list
+            std::size_t explicit_size = varint_size(event.synteny.size());
+
+            for (const auto& gene : event.synteny)
+            {
+                explicit_size += varint_size(local_index[gene.getId()]);
+            }
+
+            if (mask.size() <= explicit_size)
+            {
+                encoding = MaskedSynteny;
+            }
+        }
+
+        bool has_segment = event.segment != Synteny::NoSegment;
+        unsigned flags = encode_type(event.type)
+            | (has_segment ? segment_flag : 0)
+            | (encoding << synteny_shift);
+
+        buffer += static_cast<char>(flags);
+        put_varint(buffer, tree.number_of_children(it));
+
+        if (has_segment)
+        {
+            put_varint(buffer, event.segment.first);
+            put_varint(buffer, event.segment.second);
+        }
+
+        if (encoding == MaskedSynteny)
+        {
+            buffer += mask;
+        }
+        else if (encoding == ExplicitSynteny)
+        {
+            put_varint(buffer, event.synteny.size());
+
+            for (const auto& gene : event.synteny)
+            {
+                put_varint(buffer, local_index[gene.getId()]);
+            }
+        }
+
+        if (out != nullptr && buffer.size() >= flush_size)
+        {
+            out->write(buffer.data(), buffer.size());
+            buffer.clear();
+        }
+    }
+}
+
+} // namespace
+
+bool is_binary_tree(boost::string_ref input)
+{
+    return input.size() >= sizeof(magic)
+        && input.substr(0, sizeof(magic))
+            == boost::string_ref(magic, sizeof(magic));
+}
+
+::tree<Event> parse_binary_tree(boost::string_ref input)
+{
+    using Iterator = ::tree<Event>::iterator;
+
+    Decoder decoder{input};
+
+    if (!is_binary_tree(input))
+    {
+        decoder.fail("missing magic sequence");
+    }
+
+    decoder.bytes(sizeof(magic));
+
+    if (decoder.byte() != version)
+    {
+        decoder.fail("unsupported version");
+    }
+
+    // Read the gene dictionary
+    auto gene_count = decoder.varint();
+    std::vector<Gene> genes;
+    std::string name;
+
+    for (std::uint64_t i = 0; i < gene_count; ++i)
+    {
+        auto length = decoder.index(
+            std::numeric_limits<std::size_t>::max(), "name length");
+        auto bytes = decoder.bytes(length);
+        name.assign(bytes.data(), bytes.size());
+        genes.emplace_back(name);
+    }
+
+    // Read nodes in prefix order. Each open node is stored along with
+    // the number of children that remain to be read
+    auto node_count = decoder.varint();
+    ::tree<Event> result;
+    std::vector<std::pair<Iterator, std::uint64_t>> open;
+
+    for (std::uint64_t i = 0; i < node_count; ++i)
+    {
+        while (!open.empty() && open.back().second == 0)
+        {
+            open.pop_back();
+        }
+
+        if (i > 0 && open.empty())
+        {
+            decoder.fail("more than one root");
+        }
+
+        Event event;
+        auto flags = decoder.byte();
+        auto children = decoder.varint();
+
+        event.type = decode_type(flags & type_mask);
+
+        if (flags & segment_flag)
+        {
+            auto first = decoder.varint();
+            auto second = decoder.varint();
+            event.segment = Synteny::Segment{
+                static_cast<std::size_t>(first),
+                static_cast<std::size_t>(second)};
+        }
+
+        const SharedSynteny* parent = open.empty()
+            ? nullptr
+            : &open.back().first->synteny;
+
+        switch ((flags >> synteny_shift) & synteny_mask)
+        {
+        case EmptySynteny:
+            break;
+
+        case ParentSynteny:
+            if (parent == nullptr)
+            {
+                decoder.fail("root cannot refer to its parent");
+            }
+
+            event.synteny = *parent;
+            break;
+
+        case MaskedSynteny:
+        {
+            if (parent == nullptr)
+            {
+                decoder.fail("root cannot refer to its parent");
+            }
+
+            auto mask = decoder.bytes((parent->size() + 7) / 8);
+            auto& synteny = event.synteny.mutate();
+
+            for (std::size_t position = 0;
+                    position < parent->size();
+                    ++position)
+            {
+                auto bits = static_cast<unsigned char>(mask[position / 8]);
+
+                if (bits & (1u << (position % 8)))
+                {
+                    synteny.push_back((*parent)[position]);
+                }
+            }
+
+            break;
+        }
+
+        case ExplicitSynteny:
+        {
+            auto length = decoder.varint();
+            auto& synteny = event.synteny.mutate();
+
+            for (std::uint64_t j = 0; j < length; ++j)
+            {
+                synteny.push_back(
+                    genes[decoder.index(genes.size(), "gene index")]);
+            }
+
+            break;
+        }
+        }
+
+        Iterator node;
+
+        if (open.empty())
+        {
+            node = result.set_head(event);
+        }
+        else
+        {
+            node = result.append_child(open.back().first, event);
+            --open.back().second;
+        }
+
+        open.emplace_back(node, children);
+    }
+
+    for (const auto& node : open)
+    {
+        if (node.second != 0)
+        {
+            decoder.fail("missing nodes");
+        }
+    }
+
+    decoder.finish();
+    return result;
+}
+
+void write_binary_tree(std::ostream& out, const ::tree<Event>& tree)
+{
+    std::string buffer;
+    write_binary_tree_helper(buffer, &out, tree);
+    out.write(buffer.data(), buffer.size());
+}
+
+void write_binary_tree(std::string& out, const ::tree<Event>& tree)
+{
+    write_binary_tree_helper(out, nullptr, tree);
+}
@@ -0,0 +1,73 @@
+#ifndef IO_BINARY_HPP
+#define IO_BINARY_HPP
+
+#include "../model/Event.hpp"
+#include <boost/utility/string_ref.hpp>
+#include <ostream>
+#include <string>
+#include <tree.hh>
+
+/**
+ * Compact binary format for event trees, meant for passing trees between
+ * programs without the cost of formatting and parsing text. All integers
+ * are unsigned LEB128 varints. A tree is encoded as:
+ *
+ * tree ::= magic version dictionary node_count node*
+ * magic ::= 'S' 'R' 'T' 'B'
+ * version ::= <byte: 1>
+ * dictionary ::= gene_count (name_length <name bytes>)*
+ * node ::= flags children_count segment? synteny
+ *
+ * Nodes are listed in prefix order, each one followed by the number of
+ * its children. The flags byte holds the event type (bits 0-1: none,
+ * duplication, speciation or loss), whether the node has a segment
+ * (bit 2, followed by its two bounds) and how its synteny is encoded
+ * (bits 3-4):
+ *
+ * - 0: empty synteny, nothing follows;
+ * - 1: same synteny as the parent, nothing follows;
+ * - 2: subsequence of the parent synteny, followed by a bit mask of the
+ *   kept positions of the parent (one bit per position, least-significant
+ *   bit first, padded to whole bytes);
+ * - 3: explicit synteny, followed by its length and by the index of each
+ *   of its genes in the dictionary.
+ *
+ * Trailing whitespace after the last node is ignored, so that the format
+ * can be written by tools that end their output with a newline.
+ */
+
+/**
+ * Check whether an input starts like a binary tree.
+ *
+ * @param input Input data.
+ * @return True if and only if the input starts with the magic sequence.
+ */
+bool is_binary_tree(boost::string_ref);
+
+/**
+ * Decode an event tree from the binary format.
+ *
+ * @param input Input data to decode.
+ *
+ * @throws std::invalid_argument If the input is not a valid binary tree.
+ * @return Decoded tree.
+ */
+::tree<Event> parse_binary_tree(boost::string_ref);
+
+/**
+ * Encode an event tree in the binary format.
+ *
+ * @param out Output stream to write to.
+ * @param tree Tree to encode.
+ */
+void write_binary_tree(std::ostream&, const ::tree<Event>&);
+
+/**
+ * Append the binary encoding of an event tree to a string.
+ *
+ * @param out String to append to.
+ * @param tree Tree to encode.
+ */
+void write_binary_tree(std::string&, const ::tree<Event>&);
+
+#endif // IO_BINARY_HPP
@@ -0,0 +1,138 @@
+#include "binary.hpp"
+#include "nhx.hpp"
+#include "../algo/erase.hpp"
+#include "../algo/simulate.hpp"
+#include <catch.hpp>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+
+namespace
+{
+
+std::string encode(const ::tree<Event>& tree)
+{
+    std::ostringstream out;
+    write_binary_tree(out, tree);
+    return out.str();
+}
+
+} // namespace
+
+TEST_CASE("Read and write event trees in binary format")
+{
+    SECTION("Round-trip of a tree with all kinds of nodes")
+    {
+        std::string input = "((\"a c\"[&&NHX:event=loss:segment=\"1 - 2\"],"
+            "\"c a\",\"\"[&&NHX:event=loss])\"a b c\"[&&NHX:event=speciation],"
+            "\"a b c\")\"a b c\"[&&NHX:event=duplication:segment=\"0 - 3\"];";
+
+        auto tree = parse_nhx_tree<Event>(input);
+        auto data = encode(tree);
+
+        REQUIRE(is_binary_tree(data));
+        REQUIRE_FALSE(is_binary_tree(input));
+        REQUIRE(stringify_nhx_tree(parse_binary_tree(data)) == input);
+
+        // Trailing whitespace is accepted
+        REQUIRE(stringify_nhx_tree(parse_binary_tree(data + "\n")) == input);
+    }
+
+    SECTION("Round-trip of simulated and erased trees")
+    {
+        std::mt19937 prng{42};
+        SimulationParams params;
+        params.base = Synteny::generateDummy(12);
+        params.depth = 6;
+        params.p_rearr = 0.8;
+
+        for (int i = 0; i < 20; ++i)
+        {
+            auto tree = simulate_evolution(prng, params);
+            auto expected = stringify_nhx_tree(tree);
+            REQUIRE(stringify_nhx_tree(parse_binary_tree(encode(tree)))
+                == expected);
+
+            erase_tree(tree, tree.begin());
+            expected = stringify_nhx_tree(tree);
+            REQUIRE(stringify_nhx_tree(parse_binary_tree(encode(tree)))
+                == expected);
+        }
+    }
+
+    SECTION("Subsequences of the parent are encoded as masks")
+    {
+        std::string names;
+
+        for (int i = 0; i < 64; ++i)
+        {
+            names += "g" + std::to_string(i) + " ";
+        }
+
+        // The child keeps every other gene of its parent
+        std::string child;
+
+        for (int i = 0; i < 64; i += 2)
+        {
+            child += "g" + std::to_string(i) + " ";
+        }
+
+        names.pop_back();
+        child.pop_back();
+
+        auto tree = parse_nhx_tree<Event>(
+            "(\"" + child + "\",\"" + names + "\")\"" + names + "\";");
+        auto data = encode(tree);
+
+        // Dictionary, then root header and explicit synteny, first child
+        // header and 8-byte mask, then second child header only
+        std::size_t dictionary = 1;
+
+        for (int i = 0; i < 64; ++i)
+        {
+            dictionary += 1 + std::to_string(i).size() + 1;
+        }
+
+        REQUIRE(data.size() == 5 + dictionary + 1 + (2 + 1 + 64)
+            + (2 + 8) + 2);
+        REQUIRE(stringify_nhx_tree(parse_binary_tree(data))
+            == stringify_nhx_tree(tree));
+    }
+
+    SECTION("Empty tree")
+    {
+        ::tree<Event> tree;
+        auto data = encode(tree);
+        REQUIRE(parse_binary_tree(data).empty());
+    }
+
+    SECTION("Invalid inputs")
+    {
+        auto tree = parse_nhx_tree<Event>("(\"a\",\"b\")\"a b\";");
+        auto data = encode(tree);
+
+        REQUIRE_THROWS_AS(parse_binary_tree("(a,b)c;"), std::invalid_argument);
+        REQUIRE_THROWS_WITH(
+            parse_binary_tree("(a,b)c;"),
+            "Invalid binary tree: missing magic sequence at byte 0");
+
+        for (std::size_t size = 4; size < data.size(); ++size)
+        {
+            REQUIRE_THROWS_AS(
+                parse_binary_tree(data.substr(0, size)),
+                std::invalid_argument);
+        }
+
+        REQUIRE_THROWS_WITH(
+            parse_binary_tree(data + "x"),
+            "Invalid binary tree: trailing data at byte "
+                + std::to_string(data.size()));
+
+        auto bad_version = data;
+        bad_version[4] = 2;
+        REQUIRE_THROWS_WITH(
+            parse_binary_tree(bad_version),
+            "Invalid binary tree: unsupported version at byte 5");
+    }
+}
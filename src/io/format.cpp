@@ -0,0 +1,83 @@
+#include "format.hpp"
+#include "binary.hpp"
+#include "nhx.hpp"
+#include <string>
+
+std::istream& operator>>(std::istream& in, TreeFormat& format)
+{
+    std::string name;
+    in >> name;
+
+    if (name == "nhx")
+    {
+        format = TreeFormat::NHX;
+    }
+    else if (name == "binary")
+    {
+        format = TreeFormat::Binary;
+    }
+    else
+    {
+        in.setstate(std::ios_base::failbit);
+    }
+
+    return in;
+}
+
+std::ostream& operator<<(std::ostream& out, const TreeFormat& format)
+{
+    switch (format)
+    {
+    case TreeFormat::NHX:
+        return out << "nhx";
+
+    case TreeFormat::Binary:
+        return out << "binary";
+    }
+
+    return out;
+}
+
+::tree<Event> parse_event_tree(boost::string_ref input)
+{
+    if (is_binary_tree(input))
+    {
+        return parse_binary_tree(input);
+    }
+
+    return parse_nhx_tree<Event>(input);
+}
+
+void write_event_tree(
+    std::ostream& out,
+    const ::tree<Event>& tree,
+    TreeFormat format)
+{
+    switch (format)
+    {
+    case TreeFormat::NHX:
+        write_nhx_tree(out, tree);
+        break;
+
+    case TreeFormat::Binary:
+        write_binary_tree(out, tree);
+        break;
+    }
+}
+
+void write_event_tree(
+    std::string& out,
+    const ::tree<Event>& tree,
+    TreeFormat format)
+{
+    switch (format)
+    {
+    case TreeFormat::NHX:
+        write_nhx_tree(out, tree);
+        break;
+
+    case TreeFormat::Binary:
+        write_binary_tree(out, tree);
+        break;
+    }
+}
@@ -0,0 +1,71 @@
+#ifndef IO_FORMAT_HPP
+#define IO_FORMAT_HPP
+
+#include "../model/Event.hpp"
+#include <boost/utility/string_ref.hpp>
+#include <istream>
+#include <ostream>
+#include <string>
+#include <tree.hh>
+
+/**
+ * Formats in which event trees can be exchanged between programs.
+ */
+enum class TreeFormat
+{
+    // Human-readable New Hampshire Extended format (see nhx.hpp)
+    NHX,
+
+    // Compact binary format (see binary.hpp)
+    Binary,
+};
+
+/**
+ * Read a tree format from its name ('nhx' or 'binary').
+ *
+ * @param in Input stream.
+ * @param [format] Set to the read format. If the name is unknown, the
+ * failbit of the stream is set.
+ * @return Input stream.
+ */
+std::istream& operator>>(std::istream&, TreeFormat&);
+
+/**
+ * Print the name of a tree format.
+ *
+ * @param out Output stream.
+ * @param format Format to print.
+ * @return Output stream.
+ */
+std::ostream& operator<<(std::ostream&, const TreeFormat&);
+
+/**
+ * Parse an event tree, detecting whether it is in the NHX or in the
+ * binary format.
+ *
+ * @param input Input data to parse.
+ *
+ * @throws std::invalid_argument If the input is not a valid tree.
+ * @return Parsed tree.
+ */
+::tree<Event> parse_event_tree(boost::string_ref);
+
+/**
+ * Write an event tree in a given format.
+ *
+ * @param out Output stream to write to.
+ * @param tree Tree to write.
+ * @param format Format to use.
+ */
+void write_event_tree(std::ostream&, const ::tree<Event>&, TreeFormat);
+
+/**
+ * Append an event tree in a given format to a string.
+ *
+ * @param out String to append to.
+ * @param tree Tree to write.
+ * @param format Format to use.
+ */
+void write_event_tree(std::string&, const ::tree<Event>&, TreeFormat);
+
+#endif // IO_FORMAT_HPP
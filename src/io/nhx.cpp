@@ -1,365 +1,545 @@
 #include "nhx.hpp"
-#include <tree.hh>
-#include <boost/fusion/include/std_pair.hpp>
-#include <boost/spirit/include/qi.hpp>
-#include <boost/spirit/include/phoenix_bind.hpp>
-#include <boost/spirit/include/phoenix_function.hpp>
-#include <boost/spirit/include/phoenix_operator.hpp>
-#include <boost/spirit/include/phoenix_object.hpp>
-
-namespace qi = boost::spirit::qi;
-namespace ascii = boost::spirit::ascii;
-namespace phx = boost::phoenix;
-namespace phxarg = phx::placeholders;
+#include <boost/utility/string_ref.hpp>
+#include <cstdlib>
+#include <cstring>
+#include <sstream>
+#include <stdexcept>
+
+namespace
+{
 
 /**
- * Given a root node and a list of subtrees, builds a parent tree.
- *
- * @param event Root node for the parent tree.
- * @param children Optional list of subtrees to graft to the root.
- * @return Resulting parent tree.
+ * Check whether a character is ASCII whitespace.
  */
-template<typename Node>
-::tree<Node> build_tree(
-    Node node,
-    boost::optional<std::vector<::tree<Node>>> children)
+bool is_space(char chr)
 {
-    ::tree<Node> result{node};
+    return chr == ' ' || chr == '\t' || chr == '\n'
+        || chr == '\v' || chr == '\f' || chr == '\r';
+}
 
-    if (children)
+/**
+ * Check whether a character may not appear in an unquoted identifier.
+ */
+bool is_delimiter(char chr)
+{
+    switch (chr)
     {
-        for (const auto& subtree : *children)
+    case '(': case ')': case '[': case ']':
+    case ',': case ':': case ';': case '=':
+        return true;
+
+    default:
+        return false;
+    }
+}
+
+/**
+ * Check whether a character is an ASCII decimal digit.
+ */
+bool is_digit(char chr)
+{
+    return chr >= '0' && chr <= '9';
+}
+
+} // namespace
+
+bool NHXNodeView::findTag(
+    boost::string_ref key,
+    boost::string_ref& value) const
+{
+    for (const auto& tag : this->tags)
+    {
+        if (tag.first == key)
         {
-            result.append_child(result.begin(), subtree.begin());
+            value = tag.second;
+            return true;
         }
     }
 
-    return result;
+    return false;
 }
 
-// This is to circumvent not being able to put commas
-// inside a macro invocation (below)
-using MapStringString = std::map<std::string, std::string>;
+NHXReader::NHXReader(boost::string_ref input)
+: start(input.data()),
+  current(input.data()),
+  end(input.data() + input.size())
+{}
 
-// Make Boost see the TaggedNode structure as a tuple
-BOOST_FUSION_ADAPT_STRUCT(
-    TaggedNode,
-    (std::string, name)
-    (double, length)
-    (MapStringString, tags)
-);
+bool NHXReader::openChildren()
+{
+    return this->accept('(');
+}
 
-/**
- * Grammar for lexemes that must be skipped while parsing a NHX tree.
- */
-template<typename Iterator>
-struct NHXSkipGrammar : qi::grammar<Iterator>
+bool NHXReader::nextChild()
+{
+    return this->accept(',');
+}
+
+void NHXReader::closeChildren()
+{
+    this->expect(')');
+}
+
+void NHXReader::readNode(NHXNodeView& node)
 {
-    NHXSkipGrammar() : NHXSkipGrammar::base_type(skip, "NHXSkipGrammar")
+    node.name = this->readIdent(0);
+    node.length = 0.;
+    node.tags.clear();
+
+    if (this->accept(':'))
     {
-        skip = whitespace | comment;
-        whitespace = ascii::space;
-
-        // Comments are enclosed by square brackets and must not start
-        // with the NHX start sequence that is reserved for custom
-        // tag lists
-        comment = open_bracket >> !nhx_start
-            >> qi::omit[*(qi::char_ - qi::char_(']'))]
-            >> close_bracket;
-
-        nhx_start = qi::lit("&&NHX");
-        open_bracket = qi::lit('[');
-        close_bracket = qi::lit(']');
-
-        skip.name("skip");
-        whitespace.name("whitespace");
-        comment.name("comment");
-
-        nhx_start.name("&&NHX");
-        open_bracket.name("[");
-        close_bracket.name("]");
+        node.length = this->readNumber();
     }
 
-    qi::rule<Iterator> skip;
-    qi::rule<Iterator> whitespace;
-    qi::rule<Iterator> comment;
+    this->skip();
 
-    qi::rule<Iterator> nhx_start;
-    qi::rule<Iterator> open_bracket;
-    qi::rule<Iterator> close_bracket;
-};
+    if (this->startsWith("[&&NHX"))
+    {
+        this->current += 6;
+        this->expect(':');
 
-/**
- * Grammar for NHX trees defined using Boost Spirit.
- */
-template<typename Iterator, typename Skipper = NHXSkipGrammar<Iterator>>
-struct NHXGrammar : qi::grammar<Iterator, Skipper, ::tree<TaggedNode>()>
+        do
+        {
+            auto buffer = 1 + 2 * node.tags.size();
+            auto key = this->readIdent(buffer);
+            this->expect('=');
+            auto value = this->readIdent(buffer + 1);
+            node.tags.emplace_back(key, value);
+        }
+        while (this->accept(':'));
+
+        this->expect(']');
+    }
+}
+
+void NHXReader::finish()
 {
-    NHXGrammar() : NHXGrammar::base_type(tree, "NHXGrammar")
+    this->expect(';');
+    this->skip();
+
+    if (this->current != this->end)
     {
-        // This rule forces the root to be followed by a semicolon. But
-        // otherwise, the root node has the exact same syntax as others
-        tree = subtree > semicolon;
-
-        // A subtree is composed of an optional list of child subtrees
-        // (omitted for leaf nodes) and of a root node, in this order
-        subtree = (-children >> node)
-                [qi::_val = phx::bind(&build_tree<TaggedNode>, qi::_2, qi::_1)];
-
-        // The child subtrees are separated by a comma and enclosed
-        // by parentheses
-        children = open_paren > subtree > *(comma > subtree) > close_paren;
-
-        // A node is composed of a name, a length tag and a list of
-        // custom tags. Each of those components is optional but the
-        // order must be respected
-        node = name
-            >> (length | qi::attr(0.))
-            >> (tagmap | qi::attr(std::map<std::string, std::string>{}));
-
-        name = ident.alias();
-        length = colon > qi::double_;
-
-        // The custom tag list contains attributes that can be attached
-        // to any node in the tree. Each tag is stored in a :key=value format
-        tagmap = nhx_start > +tag > nhx_end;
-        tag = colon > ident > equals > ident;
-
-        // Identifiers can either by unquoted or quoted. Unquoted identifiers
-        // may not contain the following chars: (, ), [, ], ',', :, ;.
-        // Whitespace is preserved inside unquoted identifiers, but not around
-        // them. To preserve surrounding whitespace, use a quoted identifier.
-        // Quoted identifiers may contain any char, but double quotes must be
-        // double-escaped
-        ident = quoted_string | unquoted_string;
-        unquoted_string
-            = qi::lexeme[*(qi::char_ - qi::char_("()[],:;="))];
-        quoted_string = quote > qi::no_skip[*(
-            (qi::lit('"') >> qi::char_('"')) // escaped double quotes
-            | (qi::char_ - qi::char_('"')) // normal chars
-        )] > quote;
-
-        // Definition of literal symbols
-        semicolon = qi::lit(';');
-        open_paren = qi::lit('(');
-        close_paren = qi::lit(')');
-        comma = qi::lit(',');
-        nhx_start = qi::lit("[&&NHX");
-        nhx_end = qi::lit(']');
-        colon = qi::lit(':');
-        equals = qi::lit('=');
-        quote = qi::lit('"');
-
-        // Naming of all rules to ease debugging
-        tree.name("tree");
-        subtree.name("subtree");
-        children.name("children");
-        node.name("node");
-        name.name("name");
-        length.name("length");
-        tagmap.name("tagmap");
-        tag.name("tag");
-        ident.name("ident");
-        unquoted_string.name("unquoted_string");
-        quoted_string.name("quoted_string");
-
-        semicolon.name(";");
-        open_paren.name("(");
-        close_paren.name(")");
-        comma.name(",");
-        nhx_start.name("[&&NHX;");
-        nhx_end.name("]");
-        colon.name(":");
-        equals.name("=");
-        quote.name("\"");
+        std::ostringstream message;
+        message << "Syntax error: expected <end> at character "
+            << this->offset() << " but found \""
+            << std::string(this->current, this->end) << "\"";
+
+        throw std::invalid_argument{message.str()};
     }
+}
 
-    template<typename Productions>
-    using NaryRule = qi::rule<Iterator, Skipper, Productions>;
-
-    NaryRule<::tree<TaggedNode>()> tree;
-    NaryRule<::tree<TaggedNode>()> subtree;
-    NaryRule<std::vector<::tree<TaggedNode>>()> children;
-    NaryRule<TaggedNode()> node;
-    NaryRule<std::string()> name;
-    NaryRule<double()> length;
-    NaryRule<std::map<std::string, std::string>> tagmap;
-    NaryRule<std::pair<std::string, std::string>> tag;
-    NaryRule<std::string()> ident;
-    NaryRule<std::string()> unquoted_string;
-    NaryRule<std::string()> quoted_string;
-
-    using NullaryRule = qi::rule<Iterator, Skipper>;
-
-    NullaryRule semicolon;
-    NullaryRule open_paren;
-    NullaryRule close_paren;
-    NullaryRule comma;
-    NullaryRule nhx_start;
-    NullaryRule nhx_end;
-    NullaryRule colon;
-    NullaryRule equals;
-    NullaryRule quote;
-};
-
-tree<TaggedNode> parse_nhx_tree(const std::string& input)
+std::ptrdiff_t NHXReader::offset() const
 {
-    using Iterator = std::string::const_iterator;
-
-    tree<TaggedNode> result;
-    NHXGrammar<Iterator> grammar;
-    NHXSkipGrammar<Iterator> skip;
+    return this->current - this->start;
+}
 
-    auto start = std::begin(input);
-    auto end = std::end(input);
-    bool success = false;
+void NHXReader::fail(const std::string& expected) const
+{
+    std::ostringstream message;
+    message << "Syntax error: expected '" << expected << "' at"
+        " character " << this->offset() << " but found ";
 
-    try
+    if (this->current == this->end)
     {
-        success = qi::phrase_parse(start, end, grammar, skip, result);
+        message << "<end>";
     }
-    catch (const qi::expectation_failure<Iterator>& err)
+    else
     {
-        std::ostringstream message;
-        message << "Syntax error: expected '" << err.what_.tag << "' at"
-            " character "
-            << std::to_string(std::distance(std::cbegin(input), err.first))
-            << " but found ";
+        message << "'" << std::string(this->current, this->end) << "'";
+    }
 
-        if (err.first == std::cend(input))
+    throw std::invalid_argument{message.str()};
+}
+
+bool NHXReader::startsWith(boost::string_ref prefix) const
+{
+    return static_cast<std::size_t>(this->end - this->current)
+            >= prefix.size()
+        && std::memcmp(this->current, prefix.data(), prefix.size()) == 0;
+}
+
+void NHXReader::skip()
+{
+    while (this->current != this->end)
+    {
+        if (is_space(*this->current))
         {
-            message << "<end>";
+            ++this->current;
+        }
+        else if (*this->current == '[' && !this->startsWith("[&&NHX"))
+        {
+            // Comments are enclosed by square brackets and must not start
+            // with the NHX start sequence that is reserved for custom
+            // tag lists
+            auto close = static_cast<const char*>(std::memchr(
+                this->current, ']', this->end - this->current));
+
+            if (close == nullptr)
+            {
+                // Unterminated comments are not comments
+                return;
+            }
+
+            this->current = close + 1;
         }
         else
         {
-            std::string sub(err.first, err.last);
-            message << "'" << sub << "'";
+            return;
         }
+    }
+}
 
-        throw std::invalid_argument{message.str()};
+bool NHXReader::accept(char chr)
+{
+    this->skip();
+
+    if (this->current != this->end && *this->current == chr)
+    {
+        ++this->current;
+        return true;
     }
 
-    if (!success)
+    return false;
+}
+
+void NHXReader::expect(char chr)
+{
+    if (!this->accept(chr))
     {
-        throw std::invalid_argument{"Syntax error: cannot parse input"};
+        this->fail(std::string(1, chr));
     }
+}
 
-    if (start != end)
+boost::string_ref NHXReader::readIdent(std::size_t buffer_index)
+{
+    this->skip();
+
+    if (this->current == this->end || *this->current != '"')
     {
-        std::ostringstream message;
-        std::string sub(start, end);
+        auto begin = this->current;
 
-        message << "Syntax error: expected <end> at character "
-            << std::to_string(std::distance(std::cbegin(input), start))
-            << " but found \"" << sub << "\"";
+        while (this->current != this->end
+                && !is_delimiter(*this->current))
+        {
+            ++this->current;
+        }
 
-        throw std::invalid_argument{message.str()};
+        return {begin, static_cast<std::size_t>(this->current - begin)};
     }
 
-    return result;
+    ++this->current;
+    auto begin = this->current;
+    std::string* buffer = nullptr;
+
+    while (true)
+    {
+        auto quote = static_cast<const char*>(std::memchr(
+            this->current, '"', this->end - this->current));
+
+        if (quote == nullptr)
+        {
+            this->current = this->end;
+            this->fail("\"");
+        }
+
+        if (quote + 1 == this->end || quote[1] != '"')
+        {
+            // Closing quote
+            this->current = quote + 1;
+
+            if (buffer == nullptr)
+            {
+                return {begin, static_cast<std::size_t>(quote - begin)};
+            }
+
+            buffer->append(begin, quote);
+            return *buffer;
+        }
+
+        // Escaped double quote, keep only one of the two
+        if (buffer == nullptr)
+        {
+            if (this->buffers.size() <= buffer_index)
+            {
+                this->buffers.resize(buffer_index + 1);
+            }
+
+            buffer = &this->buffers[buffer_index];
+            buffer->clear();
+        }
+
+        buffer->append(begin, quote + 1);
+        this->current = begin = quote + 2;
+    }
 }
 
-/**
- * Helper function to espace a NHX identifier string if need be. Only
- * strings that contain (, ), [, ], ',', :, ;, = or whitespace need to
- * be escaped.
- *
- * @param source Original, unescaped string.
- *
- * @return Escaped version.
- */
-std::string nhx_escape_ident(std::string source)
+double NHXReader::readNumber()
 {
-    if (source.find_first_of("()[],:;= \t\r\n") == std::string::npos)
+    this->skip();
+
+    // Match a case-insensitive keyword
+    auto at = [this](const char* position, const char* lower)
     {
-        // Nothing to be escaped
-        return source;
-    }
+        auto length = std::strlen(lower);
 
-    std::string result = "\"";
-    result.reserve(source.size() * 2 + 2);
+        if (static_cast<std::size_t>(this->end - position) < length)
+        {
+            return false;
+        }
+
+        for (std::size_t i = 0; i < length; ++i)
+        {
+            if ((position[i] | 0x20) != lower[i])
+            {
+                return false;
+            }
+        }
 
-    for (const auto& chr : source)
+        return true;
+    };
+
+    auto position = this->current;
+
+    if (position != this->end && (*position == '+' || *position == '-'))
     {
-        if (chr == '"')
+        ++position;
+    }
+
+    if (at(position, "nan"))
+    {
+        position += 3;
+    }
+    else if (at(position, "infinity"))
+    {
+        position += 8;
+    }
+    else if (at(position, "inf"))
+    {
+        position += 3;
+    }
+    else
+    {
+        bool has_digits = false;
+
+        while (position != this->end && is_digit(*position))
         {
-            // Escape contained double quotes as they occur
-            result += "\"\"";
+            ++position;
+            has_digits = true;
         }
-        else
+
+        if (position != this->end && *position == '.')
+        {
+            ++position;
+
+            while (position != this->end && is_digit(*position))
+            {
+                ++position;
+                has_digits = true;
+            }
+        }
+
+        if (!has_digits)
         {
-            result += chr;
+            this->fail("real");
+        }
+
+        // The exponent is only part of the number if it has digits
+        if (position != this->end && (*position | 0x20) == 'e')
+        {
+            auto exponent = position + 1;
+
+            if (exponent != this->end
+                    && (*exponent == '+' || *exponent == '-'))
+            {
+                ++exponent;
+            }
+
+            if (exponent != this->end && is_digit(*exponent))
+            {
+                position = exponent;
+
+                while (position != this->end && is_digit(*position))
+                {
+                    ++position;
+                }
+            }
         }
     }
 
-    result += "\"";
-    return result;
+    // Copy the number so that `strtod` cannot read past its end
+    std::string number{this->current, position};
+    this->current = position;
+    return std::strtod(number.c_str(), nullptr);
 }
 
-/**
- * Convert a subtree to NHX format.
- *
- * @param tree Tree containing the subtree to be converted.
- * @param root Iterator to the root of the subtree.
- *
- * @return NHX representation for the subtree.
- */
-std::string stringify_nhx_tree_helper(
-    const ::tree<TaggedNode>& tree,
-    typename ::tree<TaggedNode>::iterator root)
+std::size_t NHXSplitter::next(boost::string_ref buffer, bool at_end)
 {
-    std::string result;
+    auto begin = buffer.data();
+    auto current = begin + this->position;
+    auto end = begin + buffer.size();
 
-    if (tree.number_of_children(root) > 0)
+    while (current != end)
     {
-        result += "(";
+        if (*current == '"')
+        {
+            // Skip quoted identifiers, in which escaped quotes come in
+            // pairs and therefore cancel out
+            auto close = static_cast<const char*>(
+                std::memchr(current + 1, '"', end - current - 1));
 
-        for (auto it = tree.begin(root); it != tree.end(root); ++it)
+            if (close == nullptr && !at_end)
+            {
+                break;
+            }
+
+            current = close == nullptr ? end : close + 1;
+            this->has_content = true;
+        }
+        else if (*current == '[')
         {
-            result += stringify_nhx_tree_helper(tree, it);
+            auto available = static_cast<std::size_t>(end - current);
 
-            if (std::next(it) != tree.end(root))
+            if (available < 6 && !at_end)
             {
-                result += ",";
+                // Not enough data to tell comments from tag lists
+                break;
             }
+
+            if (available >= 6 && std::memcmp(current, "[&&NHX", 6) == 0)
+            {
+                this->has_content = true;
+                current += 6;
+                continue;
+            }
+
+            // Skip comments, unless they are unterminated
+            auto close = static_cast<const char*>(
+                std::memchr(current, ']', available));
+
+            if (close == nullptr && !at_end)
+            {
+                break;
+            }
+
+            if (close == nullptr)
+            {
+                this->has_content = true;
+                ++current;
+            }
+            else
+            {
+                current = close + 1;
+            }
+        }
+        else if (*current == ';')
+        {
+            this->position = 0;
+            this->has_content = false;
+            return static_cast<std::size_t>(current + 1 - begin);
+        }
+        else
+        {
+            this->has_content |= !is_space(*current);
+            ++current;
         }
+    }
+
+    this->position = static_cast<std::size_t>(current - begin);
 
-        result += ")";
+    if (at_end && current == end)
+    {
+        bool has_content = this->has_content;
+        this->position = 0;
+        this->has_content = false;
+        return has_content ? buffer.size() : 0;
     }
 
-    const TaggedNode& node = *root;
+    return 0;
+}
+
+std::vector<boost::string_ref> split_nhx_trees(boost::string_ref input)
+{
+    std::vector<boost::string_ref> result;
+    NHXSplitter splitter;
 
+    while (auto length = splitter.next(input, true))
+    {
+        result.push_back(input.substr(0, length));
+        input.remove_prefix(length);
+    }
+
+    return result;
+}
+
+void write_nhx_ident(std::string& out, boost::string_ref ident)
+{
+    if (ident.find_first_of("()[],:;= \t\r\n") == boost::string_ref::npos)
+    {
+        // Nothing to be escaped
+        out.append(ident.data(), ident.size());
+        return;
+    }
+
+    out += '"';
+
+    for (auto chr : ident)
+    {
+        if (chr == '"')
+        {
+            // Escape contained double quotes as they occur
+            out += "\"\"";
+        }
+        else
+        {
+            out += chr;
+        }
+    }
+
+    out += '"';
+}
+
+void read_nhx_node(TaggedNode& node, const NHXNodeView& view)
+{
+    node.name.assign(view.name.data(), view.name.size());
+    node.length = view.length;
+
+    for (const auto& tag : view.tags)
+    {
+        node.tags.emplace(
+            std::string(tag.first.data(), tag.first.size()),
+            std::string(tag.second.data(), tag.second.size()));
+    }
+}
+
+void write_nhx_node(std::string& out, const TaggedNode& node)
+{
     if (node.name.empty())
     {
-        result += "\"\"";
+        out += "\"\"";
     }
     else
     {
-        result += nhx_escape_ident(node.name);
+        write_nhx_ident(out, node.name);
     }
 
     if (node.length != 0.)
     {
-        result += ":" + std::to_string(node.length);
+        out += ':';
+        out += std::to_string(node.length);
     }
 
     if (!node.tags.empty())
     {
-        result += "[&&NHX";
+        out += "[&&NHX";
 
         for (const auto& entry : node.tags)
         {
-            result += ":" + nhx_escape_ident(entry.first)
-                + "=" + nhx_escape_ident(entry.second);
+            out += ':';
+            write_nhx_ident(out, entry.first);
+            out += '=';
+            write_nhx_ident(out, entry.second);
         }
 
-        result += "]";
+        out += ']';
     }
-
-    return result;
-}
-
-std::string stringify_nhx_tree(const ::tree<TaggedNode>& tree)
-{
-    return stringify_nhx_tree_helper(tree, std::begin(tree)) + ";";
 }
@@ -1,9 +1,15 @@
 #ifndef IO_NHX_HPP
 #define IO_NHX_HPP
 
+#include <boost/utility/string_ref.hpp>
+#include <cstddef>
+#include <deque>
 #include <map>
+#include <ostream>
 #include <string>
 #include <tree.hh>
+#include <utility>
+#include <vector>
 
 /**
  * Contain data for a tagged node in a tree, parsed from a NHX-formatted
@@ -22,8 +28,127 @@ struct TaggedNode
 };
 
 /**
- * Parse a NHX-formatted input string of characters into a tree of
- * tagged nodes. The grammar is:
+ * View on the label of a node being read from a NHX-formatted string.
+ * Identifiers refer either to the input string or to buffers owned by the
+ * reader, and are only valid until the next node is read.
+ */
+struct NHXNodeView
+{
+    // Name of the node
+    boost::string_ref name;
+
+    // Length of the branch
+    double length = 0.;
+
+    // Custom tags attached to the node, in input order
+    std::vector<std::pair<boost::string_ref, boost::string_ref>> tags;
+
+    /**
+     * Find the value of the first tag with a given key.
+     *
+     * @param key Key to look for.
+     * @param [value] Set to the value of the tag, if found.
+     * @return Whether there is a tag with this key.
+     */
+    bool findTag(boost::string_ref, boost::string_ref&) const;
+};
+
+/**
+ * Tokenizer for NHX-formatted strings, reading a tree one structural
+ * token or node label at a time (see `parse_nhx_tree` for the grammar).
+ * The reader does not build any tree: callers drive it in prefix order
+ * and store nodes as they see fit.
+ *
+ * Whitespace and comments are skipped before each token. All reading
+ * methods throw `std::invalid_argument` with the position of the error
+ * if the input does not conform to the grammar.
+ */
+class NHXReader
+{
+public:
+    /**
+     * Create a reader for an input string.
+     *
+     * @param input Input string to read, which must outlive the reader.
+     */
+    explicit NHXReader(boost::string_ref);
+
+    /**
+     * Consume the opening parenthesis of a list of children, if any.
+     *
+     * @return Whether a list of children was opened.
+     */
+    bool openChildren();
+
+    /**
+     * Consume the comma that separates two children, if any.
+     *
+     * @return Whether there is another child in the current list.
+     */
+    bool nextChild();
+
+    /**
+     * Consume the closing parenthesis of a list of children.
+     */
+    void closeChildren();
+
+    /**
+     * Read the name, length and custom tags of a node, each of which is
+     * optional.
+     *
+     * @param [node] View to fill with the node label.
+     */
+    void readNode(NHXNodeView&);
+
+    /**
+     * Consume the semicolon that ends the tree and check that nothing
+     * else follows.
+     */
+    void finish();
+
+private:
+    // Beginning of the input
+    const char* start;
+
+    // Next character to be read
+    const char* current;
+
+    // End of the input
+    const char* end;
+
+    // Scratch buffers for unescaped quoted identifiers, one for the name
+    // and then two for each tag (key and value). A deque is used so that
+    // growing it does not invalidate views on existing buffers
+    std::deque<std::string> buffers;
+
+    // Offset of the next character to be read
+    std::ptrdiff_t offset() const;
+
+    // Report that a given token was expected at the current position
+    [[noreturn]] void fail(const std::string&) const;
+
+    // Check whether the remaining input starts with a given string
+    bool startsWith(boost::string_ref) const;
+
+    // Skip whitespace and comments
+    void skip();
+
+    // Skip to the next token and consume it if it is a given character,
+    // or fail if it is not (`expect`)
+    bool accept(char);
+    void expect(char);
+
+    // Read an identifier, unescaping it into the given buffer if needed
+    boost::string_ref readIdent(std::size_t);
+
+    // Read a floating-point number, with the same syntax as `strtod`
+    // except for hexadecimal numbers
+    double readNumber();
+};
+
+/**
+ * Parse a NHX-formatted input string of characters into a tree. The
+ * grammar is:
  *
  * tree ::= subtree ';'
  * subtree ::= children? node
@@ -42,21 +167,131 @@ struct TaggedNode
  * Whitespace and comments (enclosed by square brackets) are ignored
  * during parsing, except inside identifiers.
  *
+ * Each node is built from its label by calling
+ * `read_nhx_node(Node&, const NHXNodeView&)` on a default-constructed
+ * node, which must be declared for the chosen node type.
+ *
  * @param input Input string to parse.
  *
  * @throws std::invalid_argument If the input string does not conform to the
  * above syntax.
- * @return Resulting labeled synteny tree.
+ * @return Resulting tree.
  */
-::tree<TaggedNode> parse_nhx_tree(const std::string&);
+template<typename Node = TaggedNode>
+::tree<Node> parse_nhx_tree(boost::string_ref);
 
 /**
- * Convert a tree of tagged nodes into a NHX-formatted string.
+ * Incremental scanner that finds where each tree of a sequence of NHX
+ * trees ends, for inputs that arrive in chunks. Semicolons inside quoted
+ * identifiers and comments do not end a tree. Trees are not parsed, so
+ * that malformed trees can be reported one by one.
+ */
+class NHXSplitter
+{
+public:
+    /**
+     * Look for the end of the current tree.
+     *
+     * The buffer must start at the beginning of the current tree and
+     * hold all of its data received so far. It may grow (and move)
+     * between calls until the end of the tree is found. Scanning resumes
+     * where the previous call stopped, so that each character is only
+     * scanned once.
+     *
+     * @param buffer Data of the current tree received so far.
+     * @param at_end Whether the buffer holds all the remaining input.
+     * @return Length of the current tree including its terminating
+     * semicolon, or zero if more data is needed. If `at_end` is true, an
+     * unterminated last tree spans the whole buffer, and zero means that
+     * only whitespace and comments remain. The scanner is reset to look
+     * for the next tree whenever a non-zero length is returned.
+     */
+    std::size_t next(boost::string_ref, bool);
+
+private:
+    // Offset up to which the current tree has been scanned
+    std::size_t position = 0;
+
+    // Whether the current tree has anything else than whitespace
+    // and comments
+    bool has_content = false;
+};
+
+/**
+ * Split a string containing a sequence of NHX trees, each terminated by a
+ * semicolon, into one string per tree. Semicolons inside quoted
+ * identifiers and comments do not end a tree. The trees themselves are
+ * not parsed, so that malformed trees can be reported one by one when
+ * each piece is parsed with `parse_nhx_tree`. Trailing whitespace and
+ * comments after the last tree are ignored.
+ *
+ * @param input Input string to split.
+ * @return Views into the input string, one for each tree including its
+ * terminating semicolon (except possibly for an unterminated last tree).
+ */
+std::vector<boost::string_ref> split_nhx_trees(boost::string_ref);
+
+/**
+ * Write a tree in NHX format to an output stream. The output is built in
+ * a buffer of bounded size that is flushed to the stream as it fills up,
+ * so that large trees are never held in memory as a whole string.
+ *
+ * The label of each node is written by calling
+ * `write_nhx_node(std::string&, const Node&)`, which must be declared
+ * for the chosen node type. Nodes are visited without recursion, so that
+ * trees of any depth can be written.
+ *
+ * @param out Output stream to write to.
+ * @param tree Tree to write.
+ */
+template<typename Node>
+void write_nhx_tree(std::ostream&, const ::tree<Node>&);
+
+/**
+ * Append a tree in NHX format to a string, which can be reused across
+ * calls to avoid reallocating.
+ *
+ * @param [out] String to append to.
+ * @param tree Tree to write.
+ */
+template<typename Node>
+void write_nhx_tree(std::string&, const ::tree<Node>&);
+
+/**
+ * Convert a tree into a NHX-formatted string (see `write_nhx_tree`).
  *
  * @param input Input tree to convert into a string.
  *
  * @return Resulting string representation for the tree.
  */
-std::string stringify_nhx_tree(const ::tree<TaggedNode>&);
+template<typename Node>
+std::string stringify_nhx_tree(const ::tree<Node>&);
+
+/**
+ * Append an identifier to a NHX-formatted string, quoting it if it
+ * contains (, ), [, ], ',', :, ;, = or whitespace.
+ *
+ * @param [out] String to append to.
+ * @param ident Identifier to write.
+ */
+void write_nhx_ident(std::string&, boost::string_ref);
+
+/**
+ * Fill a tagged node from the label read by a NHX reader.
+ *
+ * @param [node] Node to fill.
+ * @param view Label read from the input.
+ */
+void read_nhx_node(TaggedNode&, const NHXNodeView&);
+
+/**
+ * Append the label of a tagged node to a NHX-formatted string.
+ *
+ * @param [out] String to append to.
+ * @param node Node to write.
+ */
+void write_nhx_node(std::string&, const TaggedNode&);
+
+#include "nhx.tpp"
 
 #endif // IO_NHX_HPP
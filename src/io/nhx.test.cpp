@@ -1,5 +1,8 @@
 #include "nhx.hpp"
 #include <catch.hpp>
+#include <sstream>
+#include <stdexcept>
+#include <string>
 
 TEST_CASE("Parse NHX trees")
 {
@@ -193,9 +196,196 @@ TEST_CASE("Parse NHX trees")
         ++it;
         REQUIRE(it == tree.end());
     }
+
+    SECTION("Skip comments and whitespace around tokens")
+    {
+        std::string input
+            = " [c] ( [c] \"a\"\"b\" [c] , b:1[x] ) r [c] ; [c]";
+        auto tree = parse_nhx_tree(input);
+
+        auto it = tree.begin();
+        REQUIRE(it->name == "r ");
+        REQUIRE(tree.number_of_children(it) == 2);
+
+        ++it;
+        REQUIRE(it->name == "a\"b");
+        REQUIRE(it->length == Approx(0.0));
+
+        ++it;
+        REQUIRE(it->name == "b");
+        REQUIRE(it->length == Approx(1.));
+
+        ++it;
+        REQUIRE(it == tree.end());
+    }
+
+    SECTION("Parse deeply nested trees")
+    {
+        std::size_t depth = 100000;
+        std::string input(depth, '(');
+        input += "leaf";
+
+        for (std::size_t i = 0; i < depth; ++i)
+        {
+            input += ",x)";
+        }
+
+        input += ";";
+        auto tree = parse_nhx_tree(input);
+
+        REQUIRE(tree.size() == 2 * depth + 1);
+        REQUIRE(tree.max_depth() == static_cast<int>(depth));
+    }
+
+    SECTION("Report syntax errors with their position")
+    {
+        auto message = [](const std::string& input)
+        {
+            try
+            {
+                parse_nhx_tree(input);
+            }
+            catch (const std::invalid_argument& err)
+            {
+                return std::string{err.what()};
+            }
+
+            return std::string{};
+        };
+
+        REQUIRE(message("(a,b") == "Syntax error: expected ')' at "
+            "character 4 but found <end>");
+        REQUIRE(message("(a,b)c") == "Syntax error: expected ';' at "
+            "character 6 but found <end>");
+        REQUIRE(message("(a:x);") == "Syntax error: expected 'real' at "
+            "character 3 but found 'x);'");
+        REQUIRE(message("a[&&NHX:k  v];") == "Syntax error: expected '=' "
+            "at character 12 but found '];'");
+        REQUIRE(message("a[&&NHX:k=v;") == "Syntax error: expected ']' at "
+            "character 11 but found ';'");
+        REQUIRE(message("\"abc;") == "Syntax error: expected '\"' at "
+            "character 5 but found <end>");
+        REQUIRE(message("a;  ;") == "Syntax error: expected <end> at "
+            "character 4 but found \";\"");
+    }
 }
 
 TEST_CASE("Serialise NHX trees")
 {
-    // TODO (mdelabre): test NHX serialization
+    SECTION("Write names, lengths and tags")
+    {
+        std::string input = "((00,\"0 1\":2.500000)0,(\"a\"\" b\","
+            "\"\"[&&NHX:empty=:key=\"(value)\"])1)r;";
+        auto tree = parse_nhx_tree(input);
+
+        REQUIRE(stringify_nhx_tree(tree) == input);
+    }
+
+    SECTION("Write to a stream or to a reused string")
+    {
+        auto tree = parse_nhx_tree("((a,b)c,d)e;");
+
+        std::ostringstream out;
+        write_nhx_tree(out, tree);
+        REQUIRE(out.str() == "((a,b)c,d)e;");
+
+        std::string buffer = "first ";
+        write_nhx_tree(buffer, tree);
+        REQUIRE(buffer == "first ((a,b)c,d)e;");
+    }
+
+    SECTION("Write deeply nested trees")
+    {
+        std::size_t depth = 100000;
+        std::string input(depth, '(');
+        input += "leaf";
+
+        for (std::size_t i = 0; i < depth; ++i)
+        {
+            input += ",x)n";
+        }
+
+        input += ";";
+        auto tree = parse_nhx_tree(input);
+
+        std::ostringstream out;
+        write_nhx_tree(out, tree);
+        REQUIRE(out.str() == input);
+    }
+}
+
+TEST_CASE("Split sequences of NHX trees")
+{
+    SECTION("Split on semicolons outside of identifiers and comments")
+    {
+        std::string input = "(a,b)c;\n\"x;y\"[&&NHX:k=\"v;w\"];"
+            "[comment;] d;\n[trailing comment;]\n";
+        auto trees = split_nhx_trees(input);
+
+        REQUIRE(trees.size() == 3);
+        REQUIRE(trees[0] == "(a,b)c;");
+        REQUIRE(trees[1] == "\n\"x;y\"[&&NHX:k=\"v;w\"];");
+        REQUIRE(trees[2] == "[comment;] d;");
+
+        REQUIRE(parse_nhx_tree(trees[1]).begin()->name == "x;y");
+        REQUIRE(parse_nhx_tree(trees[2]).begin()->name == "d");
+    }
+
+    SECTION("Keep an unterminated last tree")
+    {
+        auto trees = split_nhx_trees("a;  ;(b,c");
+
+        REQUIRE(trees.size() == 3);
+        REQUIRE(trees[0] == "a;");
+        REQUIRE(trees[1] == "  ;");
+        REQUIRE(trees[2] == "(b,c");
+        REQUIRE_THROWS_AS(parse_nhx_tree(trees[2]), std::invalid_argument);
+    }
+
+    SECTION("Ignore empty inputs")
+    {
+        REQUIRE(split_nhx_trees("").empty());
+        REQUIRE(split_nhx_trees(" \n[comment]\n").empty());
+    }
+}
+
+TEST_CASE("Split NHX trees arriving in chunks")
+{
+    std::string input = "(a,b)c;\"x;\"\"y\"[&&NHX:k=\"v;]w\"];"
+        "[comment;] d[c];  [unterminated; x\n";
+
+    // Feed the splitter one more character at a time, as if each
+    // character came in a chunk of its own
+    std::vector<std::string> trees;
+    NHXSplitter splitter;
+    std::size_t start = 0;
+
+    for (std::size_t end = 0; end <= input.size(); ++end)
+    {
+        boost::string_ref buffer{input.data() + start, end - start};
+        bool at_end = end == input.size();
+
+        while (auto length = splitter.next(buffer, at_end))
+        {
+            trees.emplace_back(buffer.data(), length);
+            buffer.remove_prefix(length);
+            start += length;
+        }
+    }
+
+    std::vector<std::string> expected;
+
+    for (auto tree : split_nhx_trees(input))
+    {
+        expected.emplace_back(tree.data(), tree.size());
+    }
+
+    REQUIRE(expected == std::vector<std::string>{
+        "(a,b)c;",
+        "\"x;\"\"y\"[&&NHX:k=\"v;]w\"];",
+        "[comment;] d[c];",
+        "  [unterminated;",
+        " x\n",
+    });
+    REQUIRE(trees == expected);
 }
@@ -0,0 +1,138 @@
+#include <cstddef>
+#include <ostream>
+
+template<typename Node>
+::tree<Node> parse_nhx_tree(boost::string_ref input)
+{
+    using Iterator = typename ::tree<Node>::iterator;
+
+    NHXReader reader{input};
+    NHXNodeView view;
+    ::tree<Node> result;
+
+    // Nodes whose list of children is still open. Their label only comes
+    // after their children, so they are created empty and filled later
+    std::vector<Iterator> open;
+
+    auto add_node = [&result, &open]()
+    {
+        return open.empty()
+            ? result.set_head(Node{})
+            : result.append_child(open.back(), Node{});
+    };
+
+    do
+    {
+        // Open parentheses down to the next leaf
+        while (reader.openChildren())
+        {
+            open.push_back(add_node());
+        }
+
+        reader.readNode(view);
+        read_nhx_node(*add_node(), view);
+
+        // Close parentheses up to the next sibling subtree, reading
+        // the node that follows each closing parenthesis
+        while (!open.empty() && !reader.nextChild())
+        {
+            reader.closeChildren();
+            reader.readNode(view);
+            read_nhx_node(*open.back(), view);
+            open.pop_back();
+        }
+    }
+    while (!open.empty());
+
+    reader.finish();
+    return result;
+}
+
+namespace detail
+{
+    /**
+     * Append the NHX representation of a tree to a buffer, flushing the
+     * buffer to an output stream whenever it grows past a given size.
+     * Nodes are visited iteratively, so that the call stack does not grow
+     * with the depth of the tree.
+     *
+     * @param [buffer] Buffer to append to.
+     * @param out Stream to flush the buffer to, or null to never flush.
+     * @param tree Tree to write.
+     */
+    template<typename Node>
+    void write_nhx_tree_helper(
+        std::string& buffer,
+        std::ostream* out,
+        const ::tree<Node>& tree)
+    {
+        constexpr std::size_t flush_size = 1 << 16;
+        auto root = tree.begin();
+
+        if (root == tree.end())
+        {
+            return;
+        }
+
+        auto node = root;
+
+        while (true)
+        {
+            // Open parentheses down to the first leaf of the subtree
+            while (tree.begin(node) != tree.end(node))
+            {
+                buffer += '(';
+                node = tree.begin(node);
+            }
+
+            write_nhx_node(buffer, *node);
+
+            // Close parentheses up to the next sibling subtree, writing
+            // the label of each parent after its children
+            while (node != root && node.node->next_sibling == nullptr)
+            {
+                node = ::tree<Node>::parent(node);
+                buffer += ')';
+                write_nhx_node(buffer, *node);
+            }
+
+            if (out != nullptr && buffer.size() >= flush_size)
+            {
+                out->write(buffer.data(), buffer.size());
+                buffer.clear();
+            }
+
+            if (node == root)
+            {
+                break;
+            }
+
+            buffer += ',';
+            node = node.node->next_sibling;
+        }
+
+        buffer += ';';
+    }
+}
+
+template<typename Node>
+void write_nhx_tree(std::ostream& out, const ::tree<Node>& tree)
+{
+    std::string buffer;
+    detail::write_nhx_tree_helper(buffer, &out, tree);
+    out.write(buffer.data(), buffer.size());
+}
+
+template<typename Node>
+void write_nhx_tree(std::string& out, const ::tree<Node>& tree)
+{
+    detail::write_nhx_tree_helper(out, nullptr, tree);
+}
+
+template<typename Node>
+std::string stringify_nhx_tree(const ::tree<Node>& tree)
+{
+    std::string result;
+    write_nhx_tree(result, tree);
+    return result;
+}
@@ -5,9 +5,20 @@
 #include <fstream>
 #include <iostream>
 
+#include <stdexcept>
+#include <streambuf>
+#include <vector>
+
 #ifdef linux
 #include <unistd.h>
 #include <cstdio>
+#include <fcntl.h>
+#include <cerrno>
+#include <cstring>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
 #endif
 
 namespace
@@ -35,13 +46,119 @@ bool is_output_interactive()
     return true;
 #endif
 }
+
+#ifdef linux
+/**
+ * Stream buffer that reads from and writes to a connected socket.
+ */
+class SocketBuffer : public std::streambuf
+{
+public:
+    explicit SocketBuffer(int descriptor)
+    : descriptor(descriptor), input(buffer_size), output(buffer_size)
+    {
+        this->setg(this->input.data(), this->input.data(),
+            this->input.data());
+        this->setp(this->output.data(),
+            this->output.data() + this->output.size());
+    }
+
+protected:
+    int_type underflow() override
+    {
+        ssize_t count;
+
+        do
+        {
+            count = recv(
+                this->descriptor, this->input.data(), this->input.size(), 0);
+        }
+        while (count < 0 && errno == EINTR);
+
+        if (count <= 0)
+        {
+            return traits_type::eof();
+        }
+
+        this->setg(this->input.data(), this->input.data(),
+            this->input.data() + count);
+        return traits_type::to_int_type(*this->gptr());
+    }
+
+    int_type overflow(int_type chr) override
+    {
+        if (this->sync() != 0)
+        {
+            return traits_type::eof();
+        }
+
+        if (!traits_type::eq_int_type(chr, traits_type::eof()))
+        {
+            *this->pptr() = traits_type::to_char_type(chr);
+            this->pbump(1);
+        }
+
+        return traits_type::not_eof(chr);
+    }
+
+    int sync() override
+    {
+        const char* data = this->pbase();
+
+        while (data < this->pptr())
+        {
+            // Do not get killed by SIGPIPE if the peer has disconnected
+            auto count = send(
+                this->descriptor, data, this->pptr() - data, MSG_NOSIGNAL);
+
+            if (count < 0 && errno == EINTR)
+            {
+                continue;
+            }
+
+            if (count <= 0)
+            {
+                return -1;
+            }
+
+            data += count;
+        }
+
+        this->setp(this->output.data(),
+            this->output.data() + this->output.size());
+        return 0;
+    }
+
+private:
+    static constexpr std::size_t buffer_size = 1 << 16;
+
+    int descriptor;
+    std::vector<char> input;
+    std::vector<char> output;
+};
+#endif
 }
 
 std::string read_all_from(
     const std::string& path,
     const std::string& prompt)
 {
-    std::ostringstream result;
+    std::string result;
+
+    // Read directly into the resulting string, whose size is known
+    // in advance for regular files
+    auto read_stream = [&result](std::istream& stream)
+    {
+        constexpr std::size_t chunk_size = 1 << 16;
+
+        while (stream)
+        {
+            auto size = result.size();
+            result.resize(size + chunk_size);
+            stream.read(&result[size], chunk_size);
+            result.resize(size + static_cast<std::size_t>(stream.gcount()));
+        }
+    };
 
     if (path == "-")
     {
@@ -50,21 +167,164 @@ std::string read_all_from(
             std::cerr << prompt << "\n";
         }
 
-        result << std::cin.rdbuf();
+        read_stream(std::cin);
     }
     else
     {
-        std::ifstream file{path};
-        result << file.rdbuf();
+        std::ifstream file{path, std::ios::binary | std::ios::ate};
+
+        if (file)
+        {
+            auto size = file.tellg();
+            file.seekg(0);
+
+            if (size > 0)
+            {
+                result.reserve(static_cast<std::size_t>(size));
+            }
+
+            read_stream(file);
+        }
     }
 
-    return result.str();
+    return result;
+}
+
+constexpr std::size_t TreeReader::chunk_size;
+
+TreeReader::TreeReader(const std::string& path, const std::string& prompt)
+{
+    if (path == "-")
+    {
+        if (is_input_interactive())
+        {
+            std::cerr << prompt << "\n";
+        }
+
+        this->stream = &std::cin;
+        return;
+    }
+
+#ifdef linux
+    int descriptor = open(path.c_str(), O_RDONLY);
+    struct stat status;
+
+    if (descriptor >= 0 && fstat(descriptor, &status) == 0
+            && S_ISREG(status.st_mode) && status.st_size > 0)
+    {
+        auto size = static_cast<std::size_t>(status.st_size);
+        void* address = mmap(
+            nullptr, size, PROT_READ, MAP_PRIVATE, descriptor, 0);
+
+        if (address != MAP_FAILED)
+        {
+            // Trees are read front to back, and pages that were read can
+            // be dropped as soon as the kernel needs them
+            madvise(address, size, MADV_SEQUENTIAL);
+            this->mapped = static_cast<const char*>(address);
+            this->mapped_size = size;
+            this->at_end = true;
+        }
+    }
+
+    if (descriptor >= 0)
+    {
+        close(descriptor);
+    }
+
+    if (this->mapped != nullptr)
+    {
+        return;
+    }
+#endif
+
+    this->file.open(path, std::ios::binary);
+
+    if (!this->file)
+    {
+        throw std::runtime_error{"Cannot open input file: " + path};
+    }
+
+    this->stream = &this->file;
+}
+
+TreeReader::~TreeReader()
+{
+#ifdef linux
+    if (this->mapped != nullptr)
+    {
+        munmap(const_cast<char*>(this->mapped), this->mapped_size);
+    }
+#endif
+}
+
+bool TreeReader::next(boost::string_ref& tree)
+{
+    if (this->mapped != nullptr)
+    {
+        boost::string_ref rest{
+            this->mapped + this->start,
+            this->mapped_size - this->start};
+
+        auto length = this->splitter.next(rest, true);
+        tree = rest.substr(0, length);
+        this->start += length;
+        return length != 0;
+    }
+
+    while (true)
+    {
+        boost::string_ref rest{
+            this->buffer.data() + this->start,
+            this->buffer.size() - this->start};
+
+        auto length = this->splitter.next(rest, this->at_end);
+
+        if (length != 0)
+        {
+            tree = rest.substr(0, length);
+            this->start += length;
+            return true;
+        }
+
+        if (this->at_end)
+        {
+            return false;
+        }
+
+        // Drop trees that were already handed out, then read more data
+        // for the current tree
+        this->buffer.erase(0, this->start);
+        this->start = 0;
+
+        auto size = this->buffer.size();
+        this->buffer.resize(size + chunk_size);
+        this->stream->read(&this->buffer[size], chunk_size);
+        this->buffer.resize(
+            size + static_cast<std::size_t>(this->stream->gcount()));
+
+        if (!*this->stream)
+        {
+            this->at_end = true;
+        }
+    }
 }
 
 void write_all_to(
     const std::string& path,
     const std::string& data,
     const std::string& message)
+{
+    write_all_to(path, [&data](std::ostream& out)
+    {
+        out.write(data.data(), data.size());
+    }, message);
+}
+
+void write_all_to(
+    const std::string& path,
+    const std::function<void(std::ostream&)>& writer,
+    const std::string& message)
 {
     if (path == "-")
     {
@@ -73,11 +333,89 @@ void write_all_to(
             std::cerr << message << "\n";
         }
 
-        std::cout << data << "\n";
+        writer(std::cout);
+        std::cout << "\n";
     }
     else
     {
         std::ofstream file{path};
-        file << data << "\n";
+        writer(file);
+        file << "\n";
     }
 }
+
+void serve_unix_socket(
+    const std::string& path,
+    const std::function<void(std::istream&, std::ostream&)>& handler)
+{
+#ifdef linux
+    sockaddr_un address;
+    std::memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+
+    if (path.size() >= sizeof(address.sun_path))
+    {
+        throw std::runtime_error{"Socket path is too long: " + path};
+    }
+
+    std::memcpy(address.sun_path, path.c_str(), path.size() + 1);
+
+    // Replace sockets left over by previous servers, but no other files
+    struct stat status;
+
+    if (stat(path.c_str(), &status) == 0 && S_ISSOCK(status.st_mode))
+    {
+        unlink(path.c_str());
+    }
+
+    int server = socket(AF_UNIX, SOCK_STREAM, 0);
+
+    if (server < 0
+            || bind(server, reinterpret_cast<sockaddr*>(&address),
+                sizeof(address)) != 0
+            || listen(server, SOMAXCONN) != 0)
+    {
+        auto message = std::string{"Cannot listen on socket "} + path
+            + ": " + std::strerror(errno);
+
+        if (server >= 0)
+        {
+            close(server);
+        }
+
+        throw std::runtime_error{message};
+    }
+
+    while (true)
+    {
+        int client = accept(server, nullptr, nullptr);
+
+        if (client < 0)
+        {
+            if (errno == EINTR || errno == ECONNABORTED)
+            {
+                continue;
+            }
+
+            auto message = std::string{"Cannot accept connections on "}
+                + path + ": " + std::strerror(errno);
+            close(server);
+            throw std::runtime_error{message};
+        }
+
+        {
+            SocketBuffer buffer{client};
+            std::istream in{&buffer};
+            std::ostream out{&buffer};
+            handler(in, out);
+            out.flush();
+        }
+
+        close(client);
+    }
+#else
+    (void) path;
+    (void) handler;
+    throw std::runtime_error{"Unix sockets are not supported on this system"};
+#endif
+}
@@ -1,6 +1,13 @@
 #ifndef IO_UTIL_HPP
 #define IO_UTIL_HPP
 
+#include "nhx.hpp"
+#include <boost/utility/string_ref.hpp>
+#include <cstddef>
+#include <fstream>
+#include <functional>
+#include <istream>
+#include <ostream>
 #include <string>
 
 /**
@@ -16,6 +23,69 @@ std::string read_all_from(
     const std::string&,
     const std::string& = "");
 
+/**
+ * Reader for files that contain a sequence of NHX trees, each terminated
+ * by a semicolon, which hands out one tree at a time so that trees can be
+ * processed while the rest of the file is still being read.
+ *
+ * Regular files are mapped in memory and trees are handed out as views
+ * into the mapping, without copying them. Other inputs (e.g. pipes or
+ * standard input) are read in fixed-size chunks into a buffer that only
+ * holds the current tree and the next chunk, so that memory use is
+ * bounded by the size of the largest tree instead of that of the input.
+ */
+class TreeReader
+{
+public:
+    /**
+     * Open an input for reading trees.
+     *
+     * @param path Path of the file to read from, or '-' to read from
+     * standard input.
+     * @param [prompt=''] Prompt string shown to the user if input is
+     * read from standard input and if standard input is a terminal.
+     *
+     * @throws std::runtime_error If the file cannot be opened.
+     */
+    explicit TreeReader(const std::string&, const std::string& = "");
+
+    TreeReader(const TreeReader&) = delete;
+    TreeReader& operator=(const TreeReader&) = delete;
+    ~TreeReader();
+
+    /**
+     * Read the next tree of the input, without parsing it.
+     *
+     * @param [tree] Set to a view on the next tree including its
+     * terminating semicolon, valid until the next call.
+     * @return Whether a tree was read, or false if the input is exhausted.
+     */
+    bool next(boost::string_ref&);
+
+private:
+    // Size of the chunks read from non-mapped inputs
+    static constexpr std::size_t chunk_size = 1 << 16;
+
+    // Mapped contents of regular files, or null for other inputs
+    const char* mapped = nullptr;
+    std::size_t mapped_size = 0;
+
+    // Stream of non-mapped inputs
+    std::istream* stream = nullptr;
+    std::ifstream file;
+
+    // Data of non-mapped inputs that was read but not handed out yet
+    std::string buffer;
+
+    // Offset of the start of the next tree in the mapping or buffer
+    std::size_t start = 0;
+
+    // Whether all the data of the input has been read
+    bool at_end = false;
+
+    NHXSplitter splitter;
+};
+
 /**
  * Overwrite a file with data.
  *
@@ -31,4 +101,37 @@ void write_all_to(
     const std::string&,
     const std::string& = "");
 
+/**
+ * Overwrite a file with data produced by a writer function, which writes
+ * directly to the file stream instead of building the data in memory.
+ *
+ * @param path Path of the file to write to, or '-' to write to
+ * standard output.
+ * @param writer Function that writes the data to a given stream.
+ * @param [message=''] Message shown to the user before the data
+ * if it is being written to standard output and if standard output
+ * is a terminal.
+ */
+void write_all_to(
+    const std::string&,
+    const std::function<void(std::ostream&)>&,
+    const std::string& = "");
+
+/**
+ * Listen for connections on a Unix socket and hand each one in turn to a
+ * handler, which reads requests from and writes responses to the client.
+ * A connection is closed after its handler returns. This function only
+ * returns by throwing.
+ *
+ * @param path Path of the socket to create. A socket already existing at
+ * this path is replaced.
+ * @param handler Function that serves a connection, given streams on it.
+ *
+ * @throws std::runtime_error If the socket cannot be created or if Unix
+ * sockets are not supported on this system.
+ */
+[[noreturn]] void serve_unix_socket(
+    const std::string&,
+    const std::function<void(std::istream&, std::ostream&)>&);
+
 #endif // IO_UTIL_HPP
@@ -1,69 +1,234 @@
 #include "Event.hpp"
 #include "../io/nhx.hpp"
+#include <cctype>
+#include <sstream>
+#include <string>
 
 static const char* EVENT_KEY = "event";
 static const char* SEGMENT_KEY = "segment";
 
+namespace
+{
+/**
+ * Read an unsigned number from a string in the same way as a stream
+ * extraction, skipping leading whitespace.
+ *
+ * @param [position] Position to read from, advanced past the number.
+ * @param end End of the string.
+ * @param [result] Set to the read number, or to zero on failure.
+ * @return Whether a number was read.
+ */
+bool read_unsigned(
+    const char*& position, const char* end,
+    std::size_t& result)
+{
+    while (position != end && std::isspace(
+                static_cast<unsigned char>(*position)))
+    {
+        ++position;
+    }
+
+    if (position != end && *position == '+')
+    {
+        ++position;
+    }
+
+    result = 0;
+    bool has_digits = false;
+
+    while (position != end && *position >= '0' && *position <= '9')
+    {
+        result = result * 10 + static_cast<std::size_t>(*position - '0');
+        ++position;
+        has_digits = true;
+    }
+
+    return has_digits;
+}
+}
+
 Event::Event(const TaggedNode& tagnode)
 {
-    // Read the event type
-    if (tagnode.tags.count(EVENT_KEY))
+    NHXNodeView view;
+    view.name = tagnode.name;
+    view.length = tagnode.length;
+
+    for (const auto& tag : tagnode.tags)
     {
-        const auto& event_str = tagnode.tags.at(EVENT_KEY);
+        view.tags.emplace_back(tag.first, tag.second);
+    }
 
+    read_nhx_node(*this, view);
+}
+
+void read_nhx_node(Event& event, const NHXNodeView& view)
+{
+    using Type = Event::Type;
+
+    event.type = Type::None;
+    event.synteny.clear();
+    event.segment = Synteny::NoSegment;
+
+    // Read the event type
+    boost::string_ref event_str;
+
+    if (view.findTag(EVENT_KEY, event_str))
+    {
         if (event_str == "duplication")
         {
-            this->type = Type::Duplication;
+            event.type = Type::Duplication;
         }
         else if (event_str == "speciation")
         {
-            this->type = Type::Speciation;
+            event.type = Type::Speciation;
         }
         else if (event_str == "loss")
         {
-            this->type = Type::Loss;
+            event.type = Type::Loss;
         }
     }
 
     // Read the synteny linked to this node, which is encoded as a
     // whitespace-separated list of strings
-    if (!tagnode.name.empty())
+    std::string gene;
+    auto position = view.name.data();
+    auto end = view.name.data() + view.name.size();
+
+    while (position != end)
     {
-        std::istringstream synteny_tok{tagnode.name};
+        while (position != end && std::isspace(
+                    static_cast<unsigned char>(*position)))
+        {
+            ++position;
+        }
 
-        while (synteny_tok)
+        auto begin = position;
+
+        while (position != end && !std::isspace(
+                    static_cast<unsigned char>(*position)))
         {
-            Gene gene;
-            synteny_tok >> gene;
+            ++position;
+        }
 
-            if (!gene.empty())
-            {
-                this->synteny.push_back(gene);
-            }
+        if (position != begin)
+        {
+            gene.assign(begin, position);
+            event.synteny.emplace_back(gene);
         }
     }
 
     // An empty leaf node is actually a full loss node
-    if (this->type == Type::None && this->synteny.empty())
+    if (event.type == Type::None && event.synteny.empty())
     {
-        this->type = Type::Loss;
+        event.type = Type::Loss;
     }
 
     // Read the segment linked to this node, if applicable, which is
     // formatted as a number followed by an hyphen and another number
-    if (tagnode.tags.count(SEGMENT_KEY)
-            && ((this->type == Type::Loss && !this->synteny.empty())
-                || this->type == Type::Duplication))
+    boost::string_ref segment_str;
+
+    if (((event.type == Type::Loss && !event.synteny.empty())
+                || event.type == Type::Duplication)
+            && view.findTag(SEGMENT_KEY, segment_str))
     {
-        std::istringstream segment_tok{tagnode.tags.at(SEGMENT_KEY)};
         std::size_t start = 0, end = 0;
+        auto position = segment_str.data();
+        auto segment_end = segment_str.data() + segment_str.size();
+
+        if (read_unsigned(position, segment_end, start))
+        {
+            while (position != segment_end && *position != '-')
+            {
+                ++position;
+            }
 
-        segment_tok >> start;
-        segment_tok.ignore(std::numeric_limits<std::streamsize>::max(), '-');
-        segment_tok >> end;
+            if (position != segment_end)
+            {
+                ++position;
+                read_unsigned(position, segment_end, end);
+            }
+        }
+
+        event.segment.first = start;
+        event.segment.second = end;
+    }
+}
+
+void write_nhx_node(std::string& out, const Event& event)
+{
+    using Type = Event::Type;
+
+    if (event.synteny.empty())
+    {
+        out += "\"\"";
+    }
+    else
+    {
+        std::string synteny_as_str;
+
+        for (auto it = std::cbegin(event.synteny);
+                it != std::cend(event.synteny);
+                ++it)
+        {
+            if (it != std::cbegin(event.synteny))
+            {
+                synteny_as_str += ' ';
+            }
+
+            synteny_as_str += it->getName();
+        }
+
+        write_nhx_ident(out, synteny_as_str);
+    }
+
+    const char* type_str = nullptr;
+
+    switch (event.type)
+    {
+    case Type::None:
+        break;
+
+    case Type::Duplication:
+        type_str = "duplication";
+        break;
+
+    case Type::Speciation:
+        type_str = "speciation";
+        break;
+
+    case Type::Loss:
+        type_str = "loss";
+        break;
+    }
+
+    bool has_segment = event.segment != Synteny::NoSegment
+        && (event.type == Type::Loss || event.type == Type::Duplication);
+
+    if (type_str != nullptr || has_segment)
+    {
+        // Tags are written in key order, as for tagged nodes
+        out += "[&&NHX";
+
+        if (type_str != nullptr)
+        {
+            out += ':';
+            out += EVENT_KEY;
+            out += '=';
+            out += type_str;
+        }
+
+        if (has_segment)
+        {
+            out += ':';
+            out += SEGMENT_KEY;
+            out += "=\"";
+            out += std::to_string(event.segment.first);
+            out += " - ";
+            out += std::to_string(event.segment.second);
+            out += '"';
+        }
 
-        this->segment.first = start;
-        this->segment.second = end;
+        out += ']';
     }
 }
 
@@ -97,7 +262,7 @@ Event::operator TaggedNode() const
                 it != std::cend(this->synteny);
                 ++it)
         {
-            synteny_as_str += *it;
+            synteny_as_str += it->getName();
 
             if (std::next(it) != std::cend(this->synteny))
             {
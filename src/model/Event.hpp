@@ -2,7 +2,9 @@
 #define MODEL_EVENT_HPP
 
 #include "../io/nhx.hpp"
+#include "SharedSynteny.hpp"
 #include "Synteny.hpp"
+#include <string>
 #include <utility>
 
 /**
@@ -50,9 +52,10 @@ struct Event
     Type type = Type::None;
 
     /**
-     * Synteny of the current event.
+     * Synteny of the current event. Copying an event shares its synteny
+     * instead of copying its genes (see SharedSynteny).
      */
-    Synteny synteny;
+    SharedSynteny synteny;
 
     /**
      * Segment of the current synteny which is involved in this event.
@@ -107,4 +110,24 @@ std::ostream& operator<<(std::ostream&, const Event&);
  */
 bool operator==(const Event&, const Event&);
 
+/**
+ * Fill an event from the label of a NHX node, without going through an
+ * intermediate tagged node. The name of the node is read as the
+ * whitespace-separated list of genes of the synteny, and the `event` and
+ * `segment` tags as the event type and segment.
+ *
+ * @param [event] Event to fill.
+ * @param view Label read from the input.
+ */
+void read_nhx_node(Event&, const NHXNodeView&);
+
+/**
+ * Append the label of an event to a NHX-formatted string, in the format
+ * read by `read_nhx_node`.
+ *
+ * @param [out] String to append to.
+ * @param event Event to write.
+ */
+void write_nhx_node(std::string&, const Event&);
+
 #endif // MODEL_EVENT_HPP
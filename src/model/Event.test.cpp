@@ -220,3 +220,47 @@ TEST_CASE("Write event nodes to tagged nodes")
         });
     }
 }
+
+TEST_CASE("Read and write event trees in NHX format")
+{
+    SECTION("Read an event tree directly from NHX")
+    {
+        auto tree = parse_nhx_tree<Event>(
+            "(\"a b\"[&&NHX:event=loss:segment=\"1 - 2\"],"
+            "\"a  b c\",)\"a b c\"[&&NHX:event=speciation];");
+
+        auto it = tree.begin();
+        REQUIRE(it->type == Event::Type::Speciation);
+        REQUIRE(it->synteny == Synteny{"a", "b", "c"});
+        REQUIRE(tree.number_of_children(it) == 3);
+
+        ++it;
+        REQUIRE(it->type == Event::Type::Loss);
+        REQUIRE(it->synteny == Synteny{"a", "b"});
+        REQUIRE(it->segment == Synteny::Segment{1, 2});
+
+        ++it;
+        REQUIRE(it->type == Event::Type::None);
+        REQUIRE(it->synteny == Synteny{"a", "b", "c"});
+
+        ++it;
+        REQUIRE(it->type == Event::Type::Loss);
+        REQUIRE(it->synteny == Synteny{});
+
+        ++it;
+        REQUIRE(it == tree.end());
+    }
+
+    SECTION("Write an event tree in the same format as tagged nodes")
+    {
+        std::string input = "(\"a b\"[&&NHX:event=loss:segment=\"1 - 2\"],"
+            "\"a b c\",\"\"[&&NHX:event=loss])\"a b c\""
+            "[&&NHX:event=duplication:segment=\"0 - 3\"];";
+
+        auto events = parse_nhx_tree<Event>(input);
+        auto tagged = parse_nhx_tree(input);
+
+        REQUIRE(stringify_nhx_tree(events) == input);
+        REQUIRE(stringify_nhx_tree(tagged) == input);
+    }
+}
@@ -0,0 +1,164 @@
+#include "Gene.hpp"
+#include <boost/functional/hash.hpp>
+#include <boost/utility/string_ref.hpp>
+#include <deque>
+#include <mutex>
+#include <unordered_map>
+
+struct Gene::Entry
+{
+    std::string name;
+    Id id;
+};
+
+namespace
+{
+// Process-wide dictionary of gene family names. Entries are stored in a
+// deque so that pointers to them stay valid when new names are added,
+// which lets genes read their name without locking
+struct Dictionary
+{
+    std::mutex mutex;
+    std::deque<Gene::Entry> entries;
+    std::unordered_map<std::string, const Gene::Entry*> index;
+
+    Dictionary()
+    {
+        this->find("");
+    }
+
+    const Gene::Entry* find(const std::string& name)
+    {
+        std::lock_guard<std::mutex> lock{this->mutex};
+        auto it = this->index.find(name);
+
+        if (it != std::end(this->index))
+        {
+            return it->second;
+        }
+
+        auto id = static_cast<Gene::Id>(this->entries.size());
+        this->entries.push_back(Gene::Entry{name, id});
+
+        const auto* entry = &this->entries.back();
+        this->index.emplace(name, entry);
+        return entry;
+    }
+};
+
+Dictionary& get_dictionary()
+{
+    static Dictionary dictionary;
+    return dictionary;
+}
+
+struct NameHash
+{
+    std::size_t operator()(boost::string_ref name) const noexcept
+    {
+        return boost::hash_range(std::begin(name), std::end(name));
+    }
+};
+
+// Entries already found by the calling thread, keyed by the names stored in
+// the entries themselves. Since entries are never removed, names that were
+// already seen are found without taking the lock of the dictionary
+const Gene::Entry* find_entry(const std::string& name)
+{
+    thread_local std::unordered_map<
+        boost::string_ref, const Gene::Entry*, NameHash> cache;
+    auto it = cache.find(name);
+
+    if (it != std::end(cache))
+    {
+        return it->second;
+    }
+
+    const auto* entry = get_dictionary().find(name);
+    cache.emplace(entry->name, entry);
+    return entry;
+}
+}
+
+Gene::Gene()
+{
+    static const Entry* empty = get_dictionary().find("");
+    this->entry = empty;
+}
+
+Gene::Gene(const std::string& name)
+: entry(find_entry(name))
+{}
+
+Gene::Gene(const char* name)
+: Gene(std::string{name})
+{}
+
+Gene::Id Gene::getId() const noexcept
+{
+    return this->entry->id;
+}
+
+const std::string& Gene::getName() const noexcept
+{
+    return this->entry->name;
+}
+
+bool Gene::empty() const noexcept
+{
+    return this->entry->name.empty();
+}
+
+std::size_t Gene::count()
+{
+    auto& dictionary = get_dictionary();
+    std::lock_guard<std::mutex> lock{dictionary.mutex};
+    return dictionary.entries.size();
+}
+
+bool Gene::operator==(const Gene& other) const noexcept
+{
+    return this->entry == other.entry;
+}
+
+bool Gene::operator!=(const Gene& other) const noexcept
+{
+    return this->entry != other.entry;
+}
+
+bool Gene::operator<(const Gene& other) const noexcept
+{
+    return this->entry != other.entry
+        && this->entry->name < other.entry->name;
+}
+
+bool Gene::operator>(const Gene& other) const noexcept
+{
+    return other < *this;
+}
+
+bool Gene::operator<=(const Gene& other) const noexcept
+{
+    return !(other < *this);
+}
+
+bool Gene::operator>=(const Gene& other) const noexcept
+{
+    return !(*this < other);
+}
+
+std::ostream& operator<<(std::ostream& out, const Gene& gene)
+{
+    return out << gene.getName();
+}
+
+std::size_t hash_value(const Gene& gene) noexcept
+{
+    return gene.getId();
+}
+
+std::hash<Gene>::result_type
+std::hash<Gene>::operator()(const argument_type& gene) const noexcept
+{
+    return gene.getId();
+}
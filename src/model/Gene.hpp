@@ -1,8 +1,120 @@
 #ifndef MODEL_GENE_HPP
 #define MODEL_GENE_HPP
 
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iostream>
 #include <string>
 
-using Gene = std::string;
+/**
+ * A gene family, identified by its name.
+ *
+ * Names are interned in a process-wide dictionary that maps each distinct
+ * family name to a dense integer identifier, such that two genes are equal
+ * if and only if they have the same identifier. Copying, comparing for
+ * equality and hashing genes therefore never touch their names, which are
+ * only looked up on input and output.
+ *
+ * Names are never removed from the dictionary, so that it grows with the
+ * number of distinct families seen by the process. Long-running processes
+ * that read unrelated inputs, such as the server mode of `reconcile`,
+ * should bound it (see `count`). Each thread remembers the names it already
+ * looked up, so that only names new to a thread take the dictionary lock.
+ */
+class Gene
+{
+public:
+    /**
+     * Dense identifier of a gene family. Identifiers are allocated from
+     * zero in the order in which names are first seen, the empty name
+     * having identifier zero.
+     */
+    using Id = std::uint32_t;
+
+    /**
+     * Create a gene with an empty name.
+     */
+    Gene();
+
+    /**
+     * Create a gene from the name of its family, adding the name to the
+     * dictionary if it is not already there. This is safe to call
+     * concurrently.
+     *
+     * @param name Name of the gene family.
+     */
+    Gene(const std::string&);
+    Gene(const char*);
+
+    /**
+     * Get the identifier of this gene family.
+     */
+    Id getId() const noexcept;
+
+    /**
+     * Get the name of this gene family.
+     */
+    const std::string& getName() const noexcept;
+
+    /**
+     * Check whether this gene has an empty name.
+     */
+    bool empty() const noexcept;
+
+    /**
+     * Get the number of distinct names in the dictionary, which is one
+     * more than the largest identifier allocated so far.
+     */
+    static std::size_t count();
+
+    /**
+     * Compare two genes for equality. This only compares identifiers.
+     */
+    bool operator==(const Gene&) const noexcept;
+    bool operator!=(const Gene&) const noexcept;
+
+    /**
+     * Order two genes by their names, so that ordered containers of genes
+     * do not depend on the order in which names were interned.
+     */
+    bool operator<(const Gene&) const noexcept;
+    bool operator>(const Gene&) const noexcept;
+    bool operator<=(const Gene&) const noexcept;
+    bool operator>=(const Gene&) const noexcept;
+
+    /**
+     * Entry of the dictionary, holding the name and identifier of a family.
+     */
+    struct Entry;
+
+private:
+    const Entry* entry;
+};
+
+/**
+ * Print the name of a gene on an output stream.
+ *
+ * @param out Output stream to print on.
+ * @param gene Gene to print.
+ *
+ * @return Used output stream.
+ */
+std::ostream& operator<<(std::ostream&, const Gene&);
+
+/**
+ * Hash a gene by its identifier (for Boost.Hash).
+ */
+std::size_t hash_value(const Gene&) noexcept;
+
+namespace std
+{
+    template<> struct hash<Gene>
+    {
+        using argument_type = Gene;
+        using result_type = std::size_t;
+        result_type operator()(const argument_type&) const noexcept;
+    };
+}
 
 #endif // MODEL_GENE_HPP
@@ -0,0 +1,76 @@
+#include "Gene.hpp"
+#include <catch.hpp>
+#include <functional>
+#include <set>
+#include <string>
+#include <vector>
+
+TEST_CASE("Gene interning")
+{
+    Gene a1{"gene-a"};
+    Gene a2{std::string{"gene-a"}};
+    Gene b{"gene-b"};
+
+    REQUIRE(a1 == a2);
+    REQUIRE(a1.getId() == a2.getId());
+    REQUIRE(a1 != b);
+    REQUIRE(a1.getId() != b.getId());
+
+    REQUIRE(a1.getName() == "gene-a");
+    REQUIRE(b.getName() == "gene-b");
+    REQUIRE(Gene::count() > std::max(a1.getId(), b.getId()));
+
+    REQUIRE(std::hash<Gene>{}(a1) == std::hash<Gene>{}(a2));
+}
+
+TEST_CASE("Empty gene")
+{
+    Gene empty;
+
+    REQUIRE(empty.empty());
+    REQUIRE(empty.getId() == 0);
+    REQUIRE(empty == Gene{""});
+    REQUIRE(!Gene{"x"}.empty());
+}
+
+TEST_CASE("Genes are ordered by name")
+{
+    // Intern names in an order that differs from their lexicographic order
+    Gene z{"order-z"};
+    Gene m{"order-m"};
+    Gene a{"order-a"};
+
+    REQUIRE(a < m);
+    REQUIRE(m < z);
+    REQUIRE(!(z < a));
+    REQUIRE(a <= a);
+    REQUIRE(!(a < a));
+    REQUIRE(z > m);
+    REQUIRE(z >= z);
+
+    std::set<Gene> genes{z, m, a};
+    REQUIRE(std::vector<Gene>(std::begin(genes), std::end(genes))
+        == std::vector<Gene>{a, m, z});
+}
+
+TEST_CASE("Concurrent interning yields consistent identifiers")
+{
+    constexpr int count = 256;
+    std::vector<Gene::Id> ids(2 * count);
+
+    #pragma omp parallel for
+    for (int i = 0; i < 2 * count; ++i)
+    {
+        ids[i] = Gene{"concurrent-" + std::to_string(i % count)}.getId();
+    }
+
+    std::set<Gene::Id> distinct;
+
+    for (int i = 0; i < count; ++i)
+    {
+        REQUIRE(ids[i] == ids[i + count]);
+        distinct.insert(ids[i]);
+    }
+
+    REQUIRE(distinct.size() == count);
+}
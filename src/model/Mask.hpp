@@ -0,0 +1,152 @@
+#ifndef MODEL_MASK_HPP
+#define MODEL_MASK_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+
+/**
+ * A mask encodes a subsequence of a reference synteny as a set of positions
+ * in that synteny: the i-th gene of the reference is part of the subsequence
+ * if and only if the i-th bit of the mask is set.
+ */
+using Mask = std::uint64_t;
+
+/**
+ * Maximum length of a reference synteny that can be addressed by a mask.
+ */
+constexpr unsigned max_mask_width = 63;
+
+/**
+ * Compute the minimum number of segmental losses required to turn a
+ * subsequence of a reference synteny into one of its own subsequences.
+ * This is the counterpart of `Synteny::distanceTo` for masks and it runs
+ * in constant time: the distance is the number of maximal runs of positions
+ * of `parent` that are absent from `child`, in the order of `parent`.
+ *
+ * @example distance(0b111111, 0b101001) == 2
+ *
+ * @param parent Mask of the source subsequence.
+ * @param child Mask of the target subsequence. Positions that are not
+ * part of `parent` are ignored.
+ * @param [substring=false] When set to true, does not count any initial
+ * or terminal segmental loss (see `Synteny::distanceTo`).
+ *
+ * @return Minimum number of segmental losses.
+ */
+template<typename M>
+int distance(M parent, M child, bool substring = false) noexcept;
+
+/**
+ * Compute the segmental loss distance from a subsequence to each of a
+ * batch of its own subsequences.
+ *
+ * @see distance
+ * @param parent Mask of the source subsequence.
+ * @param children Pointer to the first mask of the target subsequences.
+ * @param count Number of target subsequences.
+ * @param result Pointer to the first of `count` integers in which the
+ * resulting distances are stored.
+ * @param [substring=false] When set to true, does not count any initial
+ * or terminal segmental loss.
+ */
+template<typename M>
+void distance(
+    M parent,
+    const M* children,
+    std::size_t count,
+    int* result,
+    bool substring = false) noexcept;
+
+/**
+ * Compute the segmental loss distance from a subsequence of at most 8
+ * positions to each of a batch of its own subsequences. Distances between
+ * all pairs of 8-bit masks are computed at compile time, so that each
+ * distance is a single lookup in the 256 entries of the parent, which stay
+ * in the L1 cache for the whole batch.
+ *
+ * @see distance
+ */
+void distance(
+    std::uint8_t parent,
+    const std::uint8_t* children,
+    std::size_t count,
+    int* result,
+    bool substring = false) noexcept;
+
+/**
+ * Lazy range over all the submasks of a mask, that is, over all the
+ * subsequences of the subsequence that it encodes. Submasks are produced
+ * in increasing order, from zero to the mask itself, without allocating
+ * memory or storing them: the range of a mask of n bits holds 2^n submasks
+ * but its size is that of two masks.
+ *
+ * @example for (auto sub : submasks(Mask{0b101})) visits 0b000, 0b001,
+ * 0b100 and 0b101.
+ */
+template<typename M>
+class SubmaskRange
+{
+public:
+    /**
+     * Forward iterator over submasks.
+     */
+    class iterator
+    {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = M;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const M*;
+        using reference = M;
+
+        iterator() = default;
+        iterator(M mask, M current, bool at_end) noexcept;
+
+        M operator*() const noexcept;
+        iterator& operator++() noexcept;
+        iterator operator++(int) noexcept;
+
+        bool operator==(const iterator&) const noexcept;
+        bool operator!=(const iterator&) const noexcept;
+
+    private:
+        M mask = 0;
+        M current = 0;
+        bool at_end = true;
+    };
+
+    /**
+     * Create a range over the submasks of a mask.
+     *
+     * @param mask Mask whose submasks are enumerated.
+     */
+    explicit SubmaskRange(M mask) noexcept;
+
+    iterator begin() const noexcept;
+    iterator end() const noexcept;
+
+    /**
+     * Get the number of submasks in the range.
+     *
+     * @return Number of submasks, that is 2^n if `mask` has n set bits.
+     */
+    std::size_t size() const noexcept;
+
+private:
+    M mask;
+};
+
+/**
+ * Make a lazy range over the submasks of a mask.
+ *
+ * @see SubmaskRange
+ * @param mask Mask whose submasks are enumerated.
+ * @return Range of submasks.
+ */
+template<typename M>
+SubmaskRange<M> submasks(M mask) noexcept;
+
+#include "Mask.tpp"
+
+#endif // MODEL_MASK_HPP
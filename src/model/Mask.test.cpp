@@ -0,0 +1,146 @@
+#include "Mask.hpp"
+#include "Synteny.hpp"
+#include <catch.hpp>
+#include <vector>
+
+TEST_CASE("Segmental loss distance between masks")
+{
+    SECTION("Examples")
+    {
+        REQUIRE(distance(Mask{0b111111}, Mask{0b101001}) == 2);
+        REQUIRE(distance(Mask{0b111111}, Mask{0b101001}, true) == 2);
+        REQUIRE(distance(Mask{0b111111}, Mask{0b011100}) == 2);
+        REQUIRE(distance(Mask{0b111111}, Mask{0b011100}, true) == 0);
+        REQUIRE(distance(Mask{0b111111}, Mask{0b111111}) == 0);
+        REQUIRE(distance(Mask{0b111111}, Mask{0}) == 1);
+        REQUIRE(distance(Mask{0b111111}, Mask{0}, true) == 0);
+        REQUIRE(distance(Mask{0}, Mask{0}) == 0);
+        REQUIRE(distance(Mask{0}, Mask{0}, true) == 0);
+
+        // Positions that are absent from the parent do not split
+        // lost segments
+        REQUIRE(distance(Mask{0b1010101}, Mask{0b1000001}) == 1);
+        REQUIRE(distance(Mask{0b1010101}, Mask{0b0000100}) == 2);
+        REQUIRE(distance(Mask{0b1010101}, Mask{0b0000100}, true) == 0);
+    }
+
+    SECTION("Agrees with the distance between syntenies")
+    {
+        auto base = Synteny::generateDummy(7);
+        auto subsequences = base.generateSubsequences();
+        Mask full = subsequences.size() - 1;
+
+        for (Mask parent = 0; parent <= full; ++parent)
+        {
+            std::vector<Mask> children;
+            std::vector<int> total, partial;
+
+            for (Mask child = 0; child <= full; ++child)
+            {
+                if ((child & ~parent) == 0)
+                {
+                    children.push_back(child);
+                }
+            }
+
+            total.resize(children.size());
+            partial.resize(children.size());
+
+            distance(
+                parent, children.data(), children.size(),
+                total.data());
+
+            distance(
+                parent, children.data(), children.size(),
+                partial.data(), true);
+
+            for (std::size_t i = 0; i < children.size(); ++i)
+            {
+                const auto& synteny_parent = subsequences[parent];
+                const auto& synteny_child = subsequences[children[i]];
+
+                REQUIRE(distance(parent, children[i])
+                    == synteny_parent.distanceTo(synteny_child));
+                REQUIRE(distance(parent, children[i], true)
+                    == synteny_parent.distanceTo(synteny_child, true));
+                REQUIRE(total[i]
+                    == synteny_parent.distanceTo(synteny_child));
+                REQUIRE(partial[i]
+                    == synteny_parent.distanceTo(synteny_child, true));
+            }
+        }
+    }
+
+    SECTION("Precomputed distances between 8-bit masks")
+    {
+        std::vector<std::uint8_t> children(256);
+        std::vector<int> total(256), partial(256);
+
+        for (unsigned child = 0; child < 256; ++child)
+        {
+            children[child] = static_cast<std::uint8_t>(child);
+        }
+
+        for (unsigned parent = 0; parent < 256; ++parent)
+        {
+            auto mask = static_cast<std::uint8_t>(parent);
+
+            distance(
+                mask, children.data(), children.size(),
+                total.data());
+
+            distance(
+                mask, children.data(), children.size(),
+                partial.data(), true);
+
+            for (unsigned child = 0; child < 256; ++child)
+            {
+                REQUIRE(total[child] == distance(Mask{parent}, Mask{child}));
+                REQUIRE(partial[child]
+                    == distance(Mask{parent}, Mask{child}, true));
+            }
+        }
+    }
+}
+
+TEST_CASE("Lazy enumeration of submasks")
+{
+    SECTION("Submasks are visited in increasing order")
+    {
+        std::vector<Mask> visited;
+
+        for (auto sub : submasks(Mask{0b10110}))
+        {
+            visited.push_back(sub);
+        }
+
+        REQUIRE(visited == std::vector<Mask>{
+            0b00000, 0b00010, 0b00100, 0b00110,
+            0b10000, 0b10010, 0b10100, 0b10110});
+        REQUIRE(submasks(Mask{0b10110}).size() == visited.size());
+    }
+
+    SECTION("The empty mask only has itself as a submask")
+    {
+        auto range = submasks(Mask{0});
+        REQUIRE(range.size() == 1);
+        REQUIRE(std::distance(range.begin(), range.end()) == 1);
+        REQUIRE(*range.begin() == 0);
+    }
+
+    SECTION("Submasks of the widest masks")
+    {
+        Mask full = (Mask{1} << max_mask_width) - 1;
+        Mask sparse = full & ~(Mask{1} << 1) & ~(Mask{1} << 40);
+        Mask high = Mask{1} << (max_mask_width - 1);
+
+        // Only visit the few submasks of a mask with two unset positions
+        auto range = submasks(full ^ sparse);
+        REQUIRE(std::vector<Mask>(range.begin(), range.end())
+            == std::vector<Mask>{0, 0b10, Mask{1} << 40, (full ^ sparse)});
+
+        auto high_range = submasks(high);
+        REQUIRE(std::vector<Mask>(high_range.begin(), high_range.end())
+            == std::vector<Mask>{0, high});
+    }
+}
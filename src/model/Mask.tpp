@@ -0,0 +1,228 @@
+#include "../util/bits.hpp"
+
+namespace detail
+{
+    /**
+     * Find the positions of a parent mask whose preceding position in the
+     * parent mask belongs to a given set. Positions that are not part of
+     * the parent are skipped over, as if the parent mask was compressed.
+     *
+     * @param positions Set of positions of the parent mask.
+     * @param parent Parent mask.
+     * @return Positions of `parent` that directly follow a position of
+     * `positions` in the order of `parent`.
+     */
+    template<typename M>
+    constexpr M follow_positions(M positions, M parent) noexcept
+    {
+        // Gaps in the parent are jumped over by adding the bit that precedes
+        // each gap to the gap itself: the carry spans the whole gap and lands
+        // on the next position of the parent
+        M gaps = ~parent;
+        M shifted = positions << 1;
+        M carried = (gaps + (shifted & gaps)) ^ gaps;
+        return (shifted | carried) & parent;
+    }
+
+    template<typename M>
+    constexpr int distance(
+        M parent, M child,
+        M first_position, M last_position,
+        bool substring) noexcept
+    {
+        // A lost segment starts at each lost position that does not follow
+        // another lost position
+        M lost = parent & ~child;
+        int result = popcount(static_cast<M>(
+            lost & ~follow_positions(lost, parent)));
+
+        if (substring)
+        {
+            // Discount the initial and terminal lost segments, making sure
+            // not to discount the same segment twice if everything is lost
+            result -= (lost & first_position) != 0;
+            result -= (lost & last_position) != 0;
+            result += lost != 0 && lost == parent;
+        }
+
+        return result;
+    }
+
+    /**
+     * Distances between all pairs of 8-bit masks. The entry of a parent
+     * and a child, at index `parent << 8 | child`, holds the distance in
+     * its low nibble and the distance in substring mode in its high nibble.
+     */
+    struct SmallDistanceTable
+    {
+        std::uint8_t entries[1 << 16];
+
+        constexpr SmallDistanceTable() noexcept
+        : entries{}
+        {
+            for (unsigned parent = 0; parent < 256; ++parent)
+            {
+                auto mask = static_cast<std::uint8_t>(parent);
+                auto first_position = lowest_bit(mask);
+                std::uint8_t last_position = 0;
+
+                for (unsigned bit = 0; bit < 8; ++bit)
+                {
+                    if (mask & (1u << bit))
+                    {
+                        last_position = static_cast<std::uint8_t>(1u << bit);
+                    }
+                }
+
+                for (unsigned child = 0; child < 256; ++child)
+                {
+                    auto child_mask = static_cast<std::uint8_t>(child);
+                    auto total = distance(
+                        mask, child_mask,
+                        first_position, last_position, false);
+                    auto partial = distance(
+                        mask, child_mask,
+                        first_position, last_position, true);
+                    this->entries[parent << 8 | child]
+                        = static_cast<std::uint8_t>(total | partial << 4);
+                }
+            }
+        }
+    };
+
+    // Single instance of the table, defined in this header through a
+    // template so that every translation unit shares it
+    template<typename T = void>
+    struct SmallDistances
+    {
+        static constexpr SmallDistanceTable table{};
+    };
+
+    template<typename T>
+    constexpr SmallDistanceTable SmallDistances<T>::table;
+}
+
+template<typename M>
+int distance(M parent, M child, bool substring) noexcept
+{
+    return detail::distance(
+        parent, child,
+        lowest_bit(parent), highest_bit(parent),
+        substring);
+}
+
+template<typename M>
+void distance(
+    M parent,
+    const M* children,
+    std::size_t count,
+    int* result,
+    bool substring) noexcept
+{
+    // Hoist the bounds of the parent out of the loop so that the body is
+    // free of branches and can be vectorized
+    M first_position = lowest_bit(parent);
+    M last_position = highest_bit(parent);
+
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        result[i] = detail::distance(
+            parent, children[i],
+            first_position, last_position,
+            substring);
+    }
+}
+
+inline void distance(
+    std::uint8_t parent,
+    const std::uint8_t* children,
+    std::size_t count,
+    int* result,
+    bool substring) noexcept
+{
+    const auto* row = detail::SmallDistances<>::table.entries + (parent << 8);
+    int shift = substring ? 4 : 0;
+
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        result[i] = (row[children[i]] >> shift) & 0xF;
+    }
+}
+
+template<typename M>
+SubmaskRange<M>::iterator::iterator(M mask, M current, bool at_end) noexcept
+: mask(mask)
+, current(current)
+, at_end(at_end)
+{}
+
+template<typename M>
+M SubmaskRange<M>::iterator::operator*() const noexcept
+{
+    return this->current;
+}
+
+template<typename M>
+typename SubmaskRange<M>::iterator&
+SubmaskRange<M>::iterator::operator++() noexcept
+{
+    // The subtraction borrows through the unset bits of the mask, so that
+    // the next submask is obtained in constant time. It wraps around to
+    // zero after the mask itself, which ends the range
+    this->current = (this->current - this->mask) & this->mask;
+    this->at_end = this->current == 0;
+    return *this;
+}
+
+template<typename M>
+typename SubmaskRange<M>::iterator
+SubmaskRange<M>::iterator::operator++(int) noexcept
+{
+    auto result = *this;
+    ++*this;
+    return result;
+}
+
+template<typename M>
+bool SubmaskRange<M>::iterator::operator==(
+    const iterator& other) const noexcept
+{
+    return this->at_end == other.at_end
+        && (this->at_end || this->current == other.current);
+}
+
+template<typename M>
+bool SubmaskRange<M>::iterator::operator!=(
+    const iterator& other) const noexcept
+{
+    return !(*this == other);
+}
+
+template<typename M>
+SubmaskRange<M>::SubmaskRange(M mask) noexcept
+: mask(mask)
+{}
+
+template<typename M>
+typename SubmaskRange<M>::iterator SubmaskRange<M>::begin() const noexcept
+{
+    return iterator{this->mask, 0, false};
+}
+
+template<typename M>
+typename SubmaskRange<M>::iterator SubmaskRange<M>::end() const noexcept
+{
+    return iterator{this->mask, 0, true};
+}
+
+template<typename M>
+std::size_t SubmaskRange<M>::size() const noexcept
+{
+    return std::size_t{1} << popcount(this->mask);
+}
+
+template<typename M>
+SubmaskRange<M> submasks(M mask) noexcept
+{
+    return SubmaskRange<M>{mask};
+}
@@ -0,0 +1,225 @@
+#include "SharedSynteny.hpp"
+#include <atomic>
+#include <utility>
+
+struct SharedSynteny::Node
+{
+    std::atomic<std::size_t> references;
+    Synteny synteny;
+};
+
+namespace
+{
+const Synteny empty_synteny;
+}
+
+SharedSynteny::SharedSynteny() noexcept
+: node(nullptr)
+{}
+
+SharedSynteny::SharedSynteny(const Synteny& synteny)
+: node(synteny.empty() ? nullptr : new Node{{1}, synteny})
+{}
+
+SharedSynteny::SharedSynteny(Synteny&& synteny)
+: node(synteny.empty() ? nullptr : new Node{{1}, std::move(synteny)})
+{}
+
+SharedSynteny::SharedSynteny(const SharedSynteny& other) noexcept
+: node(other.node)
+{
+    if (this->node != nullptr)
+    {
+        this->node->references.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+SharedSynteny::SharedSynteny(SharedSynteny&& other) noexcept
+: node(other.node)
+{
+    other.node = nullptr;
+}
+
+SharedSynteny& SharedSynteny::operator=(const SharedSynteny& other) noexcept
+{
+    if (other.node != nullptr)
+    {
+        other.node->references.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    this->release();
+    this->node = other.node;
+    return *this;
+}
+
+SharedSynteny& SharedSynteny::operator=(SharedSynteny&& other) noexcept
+{
+    if (this != &other)
+    {
+        this->release();
+        this->node = other.node;
+        other.node = nullptr;
+    }
+
+    return *this;
+}
+
+SharedSynteny& SharedSynteny::operator=(const Synteny& synteny)
+{
+    return *this = SharedSynteny{synteny};
+}
+
+SharedSynteny& SharedSynteny::operator=(Synteny&& synteny)
+{
+    return *this = SharedSynteny{std::move(synteny)};
+}
+
+SharedSynteny::~SharedSynteny()
+{
+    this->release();
+}
+
+void SharedSynteny::release() noexcept
+{
+    if (this->node != nullptr
+            && this->node->references.fetch_sub(
+                1, std::memory_order_acq_rel) == 1)
+    {
+        delete this->node;
+    }
+
+    this->node = nullptr;
+}
+
+const Synteny& SharedSynteny::get() const noexcept
+{
+    return this->node == nullptr ? empty_synteny : this->node->synteny;
+}
+
+SharedSynteny::operator const Synteny&() const noexcept
+{
+    return this->get();
+}
+
+Synteny& SharedSynteny::mutate()
+{
+    if (this->node == nullptr)
+    {
+        this->node = new Node{{1}, Synteny{}};
+    }
+    else if (this->node->references.load(std::memory_order_acquire) != 1)
+    {
+        auto copy = new Node{{1}, this->node->synteny};
+        this->release();
+        this->node = copy;
+    }
+
+    return this->node->synteny;
+}
+
+bool SharedSynteny::isSharedWith(const SharedSynteny& other) const noexcept
+{
+    return this->node == other.node;
+}
+
+std::size_t SharedSynteny::useCount() const noexcept
+{
+    return this->node == nullptr
+        ? 0
+        : this->node->references.load(std::memory_order_relaxed);
+}
+
+const Gene& SharedSynteny::operator[](size_type index) const noexcept
+{
+    return this->get()[index];
+}
+
+const Gene& SharedSynteny::front() const noexcept
+{
+    return this->get().front();
+}
+
+const Gene& SharedSynteny::back() const noexcept
+{
+    return this->get().back();
+}
+
+SharedSynteny::const_iterator SharedSynteny::begin() const noexcept
+{
+    return this->get().begin();
+}
+
+SharedSynteny::const_iterator SharedSynteny::cbegin() const noexcept
+{
+    return this->get().cbegin();
+}
+
+SharedSynteny::const_iterator SharedSynteny::end() const noexcept
+{
+    return this->get().end();
+}
+
+SharedSynteny::const_iterator SharedSynteny::cend() const noexcept
+{
+    return this->get().cend();
+}
+
+bool SharedSynteny::empty() const noexcept
+{
+    return this->node == nullptr || this->node->synteny.empty();
+}
+
+SharedSynteny::size_type SharedSynteny::size() const noexcept
+{
+    return this->node == nullptr ? 0 : this->node->synteny.size();
+}
+
+void SharedSynteny::clear() noexcept
+{
+    this->release();
+}
+
+void SharedSynteny::push_back(const Gene& gene)
+{
+    this->mutate().push_back(gene);
+}
+
+Gene& SharedSynteny::emplace_back(const Gene& gene)
+{
+    return this->mutate().emplace_back(gene);
+}
+
+bool operator==(const SharedSynteny& lhs, const SharedSynteny& rhs)
+{
+    return lhs.isSharedWith(rhs) || lhs.get() == rhs.get();
+}
+
+bool operator!=(const SharedSynteny& lhs, const SharedSynteny& rhs)
+{
+    return !(lhs == rhs);
+}
+
+bool operator==(const SharedSynteny& lhs, const Synteny& rhs)
+{
+    return lhs.get() == rhs;
+}
+
+bool operator!=(const SharedSynteny& lhs, const Synteny& rhs)
+{
+    return lhs.get() != rhs;
+}
+
+bool operator==(const Synteny& lhs, const SharedSynteny& rhs)
+{
+    return lhs == rhs.get();
+}
+
+bool operator!=(const Synteny& lhs, const SharedSynteny& rhs)
+{
+    return lhs != rhs.get();
+}
+
+std::ostream& operator<<(std::ostream& out, const SharedSynteny& synteny)
+{
+    return out << synteny.get();
+}
@@ -0,0 +1,128 @@
+#ifndef MODEL_SHARED_SYNTENY_HPP
+#define MODEL_SHARED_SYNTENY_HPP
+
+#include "Synteny.hpp"
+#include <cstddef>
+#include <iostream>
+
+/**
+ * Handle to an immutable synteny that can be shared by several nodes of a
+ * tree, and by several trees. Copying a handle only increments a reference
+ * count, so that a loss node that reuses the synteny of its parent, or a
+ * copy of a whole tree, does not copy any gene. The synteny is copied when
+ * it is modified through a handle that shares it with others, so that the
+ * other handles never see the modification (copy-on-write).
+ *
+ * An empty synteny does not allocate any memory. Handles can be copied and
+ * destroyed concurrently by several threads, but a given handle must not be
+ * modified while it is being read or copied.
+ */
+class SharedSynteny
+{
+public:
+    using const_iterator = Synteny::const_iterator;
+    using iterator = Synteny::const_iterator;
+    using size_type = Synteny::size_type;
+    using value_type = Synteny::value_type;
+
+    /**
+     * Create a handle to an empty synteny.
+     */
+    SharedSynteny() noexcept;
+
+    /**
+     * Create a handle to a copy of a synteny.
+     *
+     * @param synteny Synteny to copy or move.
+     */
+    explicit SharedSynteny(const Synteny&);
+    explicit SharedSynteny(Synteny&&);
+
+    SharedSynteny(const SharedSynteny&) noexcept;
+    SharedSynteny(SharedSynteny&&) noexcept;
+    SharedSynteny& operator=(const SharedSynteny&) noexcept;
+    SharedSynteny& operator=(SharedSynteny&&) noexcept;
+
+    /**
+     * Reference a copy of a synteny instead of the current one.
+     *
+     * @param synteny Synteny to copy or move.
+     * @return Current instance.
+     */
+    SharedSynteny& operator=(const Synteny&);
+    SharedSynteny& operator=(Synteny&&);
+
+    ~SharedSynteny();
+
+    /**
+     * Get the referenced synteny.
+     */
+    const Synteny& get() const noexcept;
+    operator const Synteny&() const noexcept;
+
+    /**
+     * Get the referenced synteny for modifying it, after copying it if it
+     * is shared with other handles.
+     *
+     * @return Synteny that is only referenced by this handle. References to
+     * it are invalidated by any copy of this handle.
+     */
+    Synteny& mutate();
+
+    /**
+     * Check whether two handles reference the same synteny, which implies
+     * that their syntenies are equal.
+     */
+    bool isSharedWith(const SharedSynteny&) const noexcept;
+
+    /**
+     * Get the number of handles that reference the same synteny as this
+     * one, or zero for an empty synteny.
+     */
+    std::size_t useCount() const noexcept;
+
+    // Read access to the referenced synteny (see Synteny)
+    const Gene& operator[](size_type) const noexcept;
+    const Gene& front() const noexcept;
+    const Gene& back() const noexcept;
+    const_iterator begin() const noexcept;
+    const_iterator cbegin() const noexcept;
+    const_iterator end() const noexcept;
+    const_iterator cend() const noexcept;
+    bool empty() const noexcept;
+    size_type size() const noexcept;
+
+    // Modification of the referenced synteny, which is first copied if it
+    // is shared (see Synteny)
+    void clear() noexcept;
+    void push_back(const Gene&);
+    Gene& emplace_back(const Gene&);
+
+private:
+    struct Node;
+
+    // Shared synteny and its reference count, or null for an empty synteny
+    Node* node;
+
+    void release() noexcept;
+};
+
+// Comparison of the referenced syntenies
+bool operator==(const SharedSynteny&, const SharedSynteny&);
+bool operator!=(const SharedSynteny&, const SharedSynteny&);
+bool operator==(const SharedSynteny&, const Synteny&);
+bool operator!=(const SharedSynteny&, const Synteny&);
+bool operator==(const Synteny&, const SharedSynteny&);
+bool operator!=(const Synteny&, const SharedSynteny&);
+
+/**
+ * Print a shared synteny on an output stream.
+ *
+ * @param out Output stream to print on.
+ * @param synteny Shared synteny to print.
+ *
+ * @return Used output stream.
+ */
+std::ostream& operator<<(std::ostream&, const SharedSynteny&);
+
+#endif // MODEL_SHARED_SYNTENY_HPP
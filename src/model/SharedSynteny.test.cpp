@@ -0,0 +1,82 @@
+#include "SharedSynteny.hpp"
+#include <catch.hpp>
+#include <sstream>
+
+TEST_CASE("Shared syntenies")
+{
+    SECTION("Empty syntenies are not allocated")
+    {
+        SharedSynteny empty;
+        REQUIRE(empty.empty());
+        REQUIRE(empty.size() == 0);
+        REQUIRE(empty.useCount() == 0);
+        REQUIRE(empty.get() == Synteny{});
+
+        SharedSynteny converted{Synteny{}};
+        REQUIRE(converted.useCount() == 0);
+        REQUIRE(converted == empty);
+    }
+
+    SECTION("Copies share the same genes")
+    {
+        SharedSynteny original{Synteny{"a", "b", "c"}};
+        REQUIRE(original.useCount() == 1);
+
+        auto copy = original;
+        REQUIRE(copy.isSharedWith(original));
+        REQUIRE(original.useCount() == 2);
+        REQUIRE(copy == original);
+        REQUIRE(copy == Synteny{"a", "b", "c"});
+        REQUIRE(&copy.get() == &original.get());
+
+        {
+            SharedSynteny other;
+            other = copy;
+            REQUIRE(original.useCount() == 3);
+        }
+
+        REQUIRE(original.useCount() == 2);
+
+        auto moved = std::move(copy);
+        REQUIRE(moved.isSharedWith(original));
+        REQUIRE(original.useCount() == 2);
+    }
+
+    SECTION("Modifications copy shared genes")
+    {
+        SharedSynteny original{Synteny{"a", "b"}};
+        auto copy = original;
+
+        copy.push_back("c");
+        REQUIRE(!copy.isSharedWith(original));
+        REQUIRE(copy == Synteny{"a", "b", "c"});
+        REQUIRE(original == Synteny{"a", "b"});
+        REQUIRE(original.useCount() == 1);
+        REQUIRE(copy.useCount() == 1);
+
+        // Genes referenced by a single handle are modified in place
+        const auto* genes = &copy.get();
+        copy.mutate().erase(std::cbegin(copy.mutate()));
+        REQUIRE(&copy.get() == genes);
+        REQUIRE(copy == Synteny{"b", "c"});
+
+        copy.clear();
+        REQUIRE(copy.empty());
+        REQUIRE(copy.useCount() == 0);
+        REQUIRE(original == Synteny{"a", "b"});
+    }
+
+    SECTION("Read access")
+    {
+        SharedSynteny synteny{Synteny{"a", "b", "c"}};
+        REQUIRE(synteny.size() == 3);
+        REQUIRE(synteny[1] == Gene{"b"});
+        REQUIRE(synteny.front() == Gene{"a"});
+        REQUIRE(synteny.back() == Gene{"c"});
+        REQUIRE(std::distance(std::begin(synteny), std::end(synteny)) == 3);
+
+        std::ostringstream out;
+        out << synteny;
+        REQUIRE(out.str() == "a b c");
+    }
+}
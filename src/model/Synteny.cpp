@@ -1,6 +1,7 @@
 #include "Synteny.hpp"
 #include <sstream>
 #include <stdexcept>
+#include <string>
 
 constexpr Synteny::Segment Synteny::NoSegment;
 
@@ -9,11 +10,11 @@ Synteny Synteny::generateDummy(unsigned long length)
     unsigned long i = 0;
 
     Synteny result;
-    Gene current = "a";
+    std::string current = "a";
 
     while (i != length)
     {
-        result.push_back(current);
+        result.emplace_back(current);
         auto incr_pos = current.rbegin();
 
         while (*incr_pos == 'z' && incr_pos != current.rend())
@@ -39,22 +40,45 @@ Synteny Synteny::generateDummy(unsigned long length)
 
 std::vector<Synteny> Synteny::generateSubsequences() const
 {
-    if (this->empty())
+    std::vector<Synteny> result;
+    auto range = this->subsequences();
+    result.reserve(range.size());
+
+    for (auto mask : range)
     {
-        return {{}};
+        result.push_back(this->getSubsequence(mask));
     }
 
-    auto rest = *this;
-    rest.pop_front();
-    auto result_rest = rest.generateSubsequences();
+    return result;
+}
 
-    std::vector<Synteny> result;
+SubmaskRange<Mask> Synteny::subsequences() const
+{
+    if (this->size() > max_mask_width)
+    {
+        throw std::invalid_argument{"Cannot enumerate the subsequences of "
+            "a synteny of more than " + std::to_string(max_mask_width)
+            + " genes"};
+    }
 
-    for (auto subsequence : result_rest)
+    return submasks((Mask{1} << this->size()) - 1);
+}
+
+Synteny Synteny::getSubsequence(Mask mask) const
+{
+    Synteny result;
+
+    for (; mask != 0; mask &= mask - 1)
     {
-        result.push_back(subsequence);
-        subsequence.push_front(this->front());
-        result.push_back(std::move(subsequence));
+        auto position = static_cast<std::size_t>(
+            popcount(lowest_bit(mask) - 1));
+
+        if (position >= this->size())
+        {
+            break;
+        }
+
+        result.push_back((*this)[position]);
     }
 
     return result;
@@ -2,18 +2,25 @@
 #define MODEL_SYNTENY_HPP
 
 #include "../util/ExtendedNumber.hpp"
+#include "../util/SmallVector.hpp"
 #include "Gene.hpp"
+#include "Mask.hpp"
 #include <iostream>
-#include <list>
 #include <vector>
 
 /**
- * A synteny is an ordered block of genes.
+ * Number of genes that a synteny can hold without allocating memory.
  */
-class Synteny : public std::list<Gene>
+constexpr std::size_t synteny_inline_size = 32;
+
+/**
+ * A synteny is an ordered block of genes. Genes are stored contiguously,
+ * inline for syntenies of up to `synteny_inline_size` genes.
+ */
+class Synteny : public SmallVector<Gene, synteny_inline_size>
 {
 public:
-    using std::list<Gene>::list;
+    using SmallVector<Gene, synteny_inline_size>::SmallVector;
 
     /**
      * A segment in a synteny is a pair of indices (begin, end) such
@@ -42,10 +49,37 @@ public:
     /**
      * Generate all possible subsequences for this synteny.
      *
+     * Subsequences are ordered by mask (see Mask.hpp): the subsequence at
+     * index i contains the j-th gene of this synteny if and only if the
+     * j-th bit of i is set. This stores all the 2^n subsequences: prefer
+     * `subsequences` to visit them one at a time.
+     *
+     * @throws std::invalid_argument If this synteny is longer than
+     * `max_mask_width`.
      * @return List of all possible syntenies that are subsequences.
      */
     std::vector<Synteny> generateSubsequences() const;
 
+    /**
+     * Get a lazy range over the masks of all the subsequences of this
+     * synteny, in the same order as `generateSubsequences`. Masks can be
+     * spelled out with `getSubsequence` when needed.
+     *
+     * @throws std::invalid_argument If this synteny is longer than
+     * `max_mask_width`.
+     * @return Range of masks.
+     */
+    SubmaskRange<Mask> subsequences() const;
+
+    /**
+     * Spell out the subsequence of this synteny that is encoded by a mask.
+     *
+     * @param mask Mask of the subsequence. Positions beyond the end of
+     * this synteny are ignored.
+     * @return Subsequence synteny.
+     */
+    Synteny getSubsequence(Mask) const;
+
     /**
      * Compute the minimum number of segmental losses required to turn this
      * synteny into target subsequence.
@@ -32,6 +32,31 @@ TEST_CASE("Subsequence generation")
         {"a", "c"}, {"a", "b", "c"}});
 }
 
+TEST_CASE("Lazy subsequence enumeration")
+{
+    Synteny base = {"a", "b", "c", "d", "e"};
+    auto eager = base.generateSubsequences();
+    auto range = base.subsequences();
+
+    REQUIRE(range.size() == eager.size());
+
+    std::size_t index = 0;
+
+    for (auto mask : range)
+    {
+        REQUIRE(mask == index);
+        REQUIRE(base.getSubsequence(mask) == eager[index]);
+        ++index;
+    }
+
+    REQUIRE(index == eager.size());
+    REQUIRE(base.getSubsequence(0b10101) == Synteny{"a", "c", "e"});
+    REQUIRE(base.getSubsequence(0b1100000) == Synteny{});
+
+    auto long_synteny = Synteny::generateDummy(max_mask_width + 1);
+    REQUIRE_THROWS_AS(long_synteny.subsequences(), std::invalid_argument);
+}
+
 TEST_CASE("Synteny distance computation")
 {
     Synteny s0 = {"1", "2", "3", "4", "5", "6", "7", "8", "9"};
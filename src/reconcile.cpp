@@ -1,14 +1,28 @@
-#include "algo/super_reconciliation.hpp"
-#include "algo/unordered_super_reconciliation.hpp"
+#include "algo/ReconciliationEngine.hpp"
+#include "io/format.hpp"
 #include "io/nhx.hpp"
 #include "io/util.hpp"
-#include "util/tree.hpp"
+#include "util/AllocationTracker.hpp"
+#include "util/ThreadPlacement.hpp"
+#include <algorithm>
+#include <atomic>
 #include <boost/program_options.hpp>
+#include <chrono>
 #include <cstdlib>
+#include <deque>
+#include <fstream>
 #include <iostream>
+#include <limits>
+#include <memory>
+#include <nlohmann/json.hpp>
+#include <omp.h>
 #include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
 
 namespace po = boost::program_options;
+using json = nlohmann::json;
 
 /**
  * All arguments that can be passed to the program.
@@ -17,8 +31,24 @@ namespace po = boost::program_options;
 struct Arguments
 {
     bool use_unordered;
+    std::size_t beam;
+    bool search_order;
+    bool device;
+    std::string spill_directory;
+    bool batch;
+    bool server;
+    std::string socket_path;
+    bool timing;
+    std::size_t max_families;
+    std::size_t max_request_size;
+    bool memory;
+    bool stats;
+    unsigned jobs;
+    ThreadPlacement bind;
+    std::size_t cache_size;
     std::string input_path;
     std::string output_path;
+    TreeFormat format;
 };
 
 /**
@@ -40,6 +70,112 @@ bool read_arguments(Arguments& result, int argc, const char* argv[])
         ("unordered,U",
          po::bool_switch(&result.use_unordered),
          "use the unordered super-reconciliation algorithm")
+        ("beam,B",
+         po::value(&result.beam)
+            ->value_name("K")
+            ->default_value(0),
+         "use an approximate ordered super-reconciliation algorithm that "
+         "only keeps the K best candidates of each node, for ancestral "
+         "syntenies too long for the exact algorithm. The DL-score of the "
+         "result and its gap to a lower bound on the optimal DL-score are "
+         "reported on the standard error, except in batch and server modes. "
+         "If 0, use the exact algorithm")
+        ("search-order,O",
+         po::bool_switch(&result.search_order),
+         "find the order of the genes of the root synteny (or, if it is "
+         "empty, of the genes of the leaves) that leads to the most "
+         "parsimonious ordered super-reconciliation, exploring the orders "
+         "on --jobs threads and skipping the ones that cannot improve on "
+         "the best order found so far")
+        ("device,D",
+         po::bool_switch(&result.device),
+         "evaluate the candidates of the exact ordered algorithm on the "
+         "default OpenMP target device, such as a GPU. Falls back to the "
+         "host if the program was built without offloading support or if "
+         "no device is available")
+        ("spill-dir",
+         po::value(&result.spill_directory)
+            ->value_name("PATH"),
+         "move the child assignations of the exact ordered algorithm to a "
+         "temporary file created in the given directory as soon as each "
+         "node is solved, instead of keeping them in memory until the "
+         "traceback, for trees whose candidates do not fit in memory")
+        ("batch,b",
+         po::bool_switch(&result.batch),
+         "read a sequence of trees, each ended by a semicolon, and "
+         "reconcile each of them. Reconciled trees are written one per line "
+         "in input order, and trees that cannot be reconciled are reported "
+         "on the standard error without stopping the batch")
+        ("server,s",
+         po::bool_switch(&result.server),
+         "keep running and answer reconciliation requests read from the "
+         "input until it is closed. Each request is a line with the size in "
+         "bytes of the tree that follows, and each response is a line with "
+         "'ok' or 'error' and the size of the reconciled tree or error "
+         "message that follows")
+        ("socket",
+         po::value(&result.socket_path)
+            ->value_name("PATH"),
+         "in server mode, listen for connections on a Unix socket created at "
+         "the given path instead of using the input and output")
+        ("timing,t",
+         po::bool_switch(&result.timing),
+         "in server mode, add the number of microseconds spent on each "
+         "request to the line of its response")
+        ("max-request-size",
+         po::value(&result.max_request_size)
+            ->value_name("BYTES")
+            ->default_value(std::size_t{1} << 30),
+         "in server mode, answer an error to requests whose tree is larger "
+         "than the given number of bytes, without reading it in memory")
+        ("max-families",
+         po::value(&result.max_families)
+            ->value_name("COUNT")
+            ->default_value(0),
+         "in server mode, answer an error to requests once the process has "
+         "seen more than the given number of distinct gene families, whose "
+         "names are kept in memory until it exits. If 0, there is no limit")
+        ("memory,M",
+         po::bool_switch(&result.memory),
+         "report the peak heap usage and the number of heap allocations of "
+         "the reconciliation on the standard error. Ignored in batch and "
+         "server modes")
+        ("stats",
+         po::bool_switch(&result.stats),
+         "print a JSON record of statistics about the computation on the "
+         "standard error: durations in microseconds of each step, size of "
+         "the input tree and of its ancestral synteny, number of candidates "
+         "and of finite-cost candidates of each node (ordered mode only), "
+         "number of nodes taken from identical subtrees, number of inserted "
+         "losses, peak heap usage, with --beam, the DL-score and its lower "
+         "bound and, with --search-order, the number of solved and pruned "
+         "orders. Ignored in batch and server modes")
+        ("jobs,j",
+         po::value(&result.jobs)
+            ->value_name("JOBS")
+            ->default_value(1),
+         "number of threads to use for computing the ordered or unordered "
+         "super-reconciliation, or for reconciling trees concurrently in "
+         "batch mode. If 0, automatically evaluate the best amount "
+         "of threads based on the resources of the machine")
+        ("bind",
+         po::value(&result.bind)
+            ->value_name("PLACEMENT")
+            ->default_value(ThreadPlacement::None),
+         "how to bind the computing threads to cores: 'none' to let the "
+         "system move them, 'close' to fill the cores of each NUMA node in "
+         "turn, or 'spread' to distribute them evenly across cores. Sets "
+         "OMP_PROC_BIND to the placement and OMP_PLACES to 'cores' (unless "
+         "already set) before restarting the program. Bound threads keep "
+         "the memory they allocate on their own node")
+        ("cache-size,c",
+         po::value(&result.cache_size)
+            ->value_name("SIZE")
+            ->default_value(0),
+         "in batch and server modes, maximum number of candidates of the "
+         "ordered super-reconciliation kept between trees, so that subtrees "
+         "that already appeared under the same ancestral synteny are not "
+         "solved again. If 0, nothing is kept")
         ("input,I",
          po::value(&result.input_path)
             ->value_name("PATH")
@@ -52,6 +188,14 @@ bool read_arguments(Arguments& result, int argc, const char* argv[])
             ->default_value("-"),
          "path of the file in which the output tree should be stored, or '-' "
             "to store it in standard output")
+        ("format,F",
+         po::value(&result.format)
+            ->value_name("FORMAT")
+            ->default_value(TreeFormat::NHX),
+         "format of the output tree, either 'nhx' or 'binary' for a compact "
+            "format that is faster to exchange between programs. Input "
+            "trees are accepted in both formats. Batch mode only supports "
+            "'nhx'")
     ;
 
     po::variables_map values;
@@ -73,6 +217,299 @@ bool read_arguments(Arguments& result, int argc, const char* argv[])
     return true;
 }
 
+/**
+ * Tree of a batch that is waiting to be reconciled or written.
+ */
+struct BatchItem
+{
+    // Input tree in NHX format
+    std::string input;
+
+    // Reconciled tree in NHX format, or error message if it failed
+    std::string output;
+    bool has_failed = false;
+
+    // Whether a thread took charge of processing the item, and whether it
+    // was processed and can be written
+    std::atomic<bool> is_started{false};
+    std::atomic<bool> is_done{false};
+};
+
+/**
+ * Reconcile each tree of a batch and write the results in input order.
+ *
+ * The calling thread reads trees from the input and hands each tree to a
+ * task, in which it is parsed, reconciled and serialized. Results are
+ * written as soon as all previous trees are written, so that reading,
+ * reconciliation and output all overlap. The number of trees in flight
+ * is bounded, so that memory does not depend on the size of the batch:
+ * once the bound is reached, the calling thread only waits for the oldest
+ * tree, processing trees that no worker took yet in the meantime.
+ * Trees that cannot be parsed or reconciled are reported on the standard
+ * error and skipped without interrupting the batch. Each thread has its own
+ * engine, whose buffers are reused for all the trees that it reconciles.
+ *
+ * @param out Stream to write the reconciled trees to, one per line.
+ * @param input Reader from which to read the trees to reconcile.
+ * @param mode Algorithm to use.
+ * @param params Parameters of the ordered computations.
+ * @return Number of trees that could not be reconciled.
+ */
+std::size_t reconcile_batch(
+    std::ostream& out,
+    TreeReader& input,
+    ReconciliationEngine::Mode mode,
+    const SuperReconciliationParams& params)
+{
+    // Items are shared with their task, which may only start after the
+    // item was processed by another thread and written
+    std::deque<std::shared_ptr<BatchItem>> pending;
+    std::size_t next_index = 0;
+    std::size_t failures = 0;
+
+    // Write out the processed items at the front of the queue
+    auto write_done = [&]()
+    {
+        while (!pending.empty() && pending.front()->is_done)
+        {
+            const auto& item = *pending.front();
+
+            if (item.has_failed)
+            {
+                std::cerr << "Error in tree #" << next_index << ": "
+                    << item.output << "\n";
+                ++failures;
+            }
+            else
+            {
+                if (next_index != failures)
+                {
+                    out << "\n";
+                }
+
+                out << item.output;
+            }
+
+            pending.pop_front();
+            ++next_index;
+        }
+    };
+
+    #pragma omp parallel
+    #pragma omp single
+    {
+        auto thread_count = static_cast<std::size_t>(omp_get_num_threads());
+        auto max_pending = 4 * thread_count;
+        std::vector<ReconciliationEngine> engines;
+        engines.reserve(thread_count);
+
+        for (std::size_t i = 0; i < thread_count; ++i)
+        {
+            engines.emplace_back(params);
+        }
+
+        // Parse, reconcile and serialize an item, unless another thread
+        // already took charge of it. Returns whether the item was processed
+        auto process = [&](BatchItem& item)
+        {
+            if (item.is_started.exchange(true))
+            {
+                return false;
+            }
+
+            try
+            {
+                auto event_tree = parse_nhx_tree<Event>(item.input);
+                engines[omp_get_thread_num()].reconcile(event_tree, mode);
+                write_nhx_tree(item.output, event_tree);
+            }
+            catch (const std::exception& err)
+            {
+                item.output = err.what();
+                item.has_failed = true;
+            }
+
+            item.input.clear();
+            item.input.shrink_to_fit();
+            item.is_done = true;
+            return true;
+        };
+
+        boost::string_ref tree;
+
+        while (input.next(tree))
+        {
+            auto item = std::make_shared<BatchItem>();
+            pending.push_back(item);
+            item->input.assign(tree.data(), tree.size());
+
+            #pragma omp task firstprivate(item) shared(process)
+            process(*item);
+
+            // When too many trees are in flight, only wait for the oldest
+            // one, so that workers keep receiving new trees meanwhile. The
+            // reading thread processes trees that no worker took yet, so
+            // that waiting always makes progress, even on a single thread
+            while (pending.size() >= max_pending)
+            {
+                for (const auto& waiting : pending)
+                {
+                    if (process(*waiting))
+                    {
+                        break;
+                    }
+                }
+
+                if (!pending.front()->is_done)
+                {
+                    #pragma omp taskyield
+                }
+
+                write_done();
+            }
+
+            write_done();
+        }
+
+        #pragma omp taskwait
+        write_done();
+    }
+
+    return failures;
+}
+
+/**
+ * Answer reconciliation requests until the end of the input.
+ *
+ * Each request is a line holding the size in bytes of a tree, followed by
+ * the tree in NHX or binary format. Each response is a line holding either
+ * `ok` or `error`, the size in bytes of the payload and optionally the time
+ * spent on the request in microseconds, followed by the payload (either the
+ * reconciled tree or an error message) and a newline. Responses are flushed
+ * as soon as they are written. Buffers and the engine are reused between
+ * requests.
+ *
+ * @param in Stream from which to read requests.
+ * @param out Stream to which responses are written.
+ * @param engine Engine used to reconcile trees.
+ * @param mode Algorithm to use.
+ * @param format Format of the reconciled trees.
+ * @param timing Whether to report the time spent on each request.
+ * @param max_request_size Size in bytes above which requests are refused.
+ * The trees of refused requests are skipped without being stored.
+ * @param max_families Number of distinct gene families above which
+ * requests are refused, or 0 for no limit. Family names are never freed,
+ * so that this bounds the memory kept between requests.
+ */
+void serve(
+    std::istream& in,
+    std::ostream& out,
+    ReconciliationEngine& engine,
+    ReconciliationEngine::Mode mode,
+    TreeFormat format,
+    bool timing,
+    std::size_t max_request_size,
+    std::size_t max_families)
+{
+    std::string header;
+    std::string request;
+    std::string response;
+
+    while (std::getline(in, header))
+    {
+        if (header.empty() || header == "\r")
+        {
+            continue;
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        bool has_failed = false;
+        response.clear();
+
+        std::size_t size = 0;
+        std::istringstream header_stream{header};
+        header_stream >> size;
+
+        if (!header_stream || !(header_stream >> std::ws).eof())
+        {
+            // Requests cannot be delimited anymore: stop serving
+            response = "Invalid request header: " + header;
+            out << "error " << response.size() << "\n" << response << "\n";
+            out.flush();
+            return;
+        }
+
+        if (size > max_request_size)
+        {
+            // Answer before skipping the tree, which may never fully arrive
+            // if the size is bogus
+            response = "Request of " + std::to_string(size) + " bytes "
+                "exceeds the limit of " + std::to_string(max_request_size)
+                + " bytes";
+            out << "error " << response.size() << "\n" << response << "\n";
+            out.flush();
+            in.ignore(static_cast<std::streamsize>(std::min<std::size_t>(
+                size, std::numeric_limits<std::streamsize>::max() - 1)));
+
+            if (static_cast<std::size_t>(in.gcount()) != size || !out)
+            {
+                return;
+            }
+
+            continue;
+        }
+
+        request.resize(size);
+        in.read(&request[0], size);
+
+        if (static_cast<std::size_t>(in.gcount()) != size)
+        {
+            return;
+        }
+
+        try
+        {
+            auto event_tree = parse_event_tree(request);
+
+            if (max_families > 0 && Gene::count() > max_families + 1)
+            {
+                // The dictionary also holds the empty name
+                throw std::runtime_error{
+                    "Too many distinct gene families were seen by the "
+                    "server (the limit is "
+                    + std::to_string(max_families) + ")"};
+            }
+
+            engine.reconcile(event_tree, mode);
+            write_event_tree(response, event_tree, format);
+        }
+        catch (const std::exception& err)
+        {
+            response = err.what();
+            has_failed = true;
+        }
+
+        out << (has_failed ? "error " : "ok ") << response.size();
+
+        if (timing)
+        {
+            auto elapsed = std::chrono::steady_clock::now() - start;
+            out << " " << std::chrono::duration_cast<
+                std::chrono::microseconds>(elapsed).count();
+        }
+
+        out << "\n";
+        out.write(response.data(), response.size());
+        out << "\n";
+        out.flush();
+
+        if (!out)
+        {
+            return;
+        }
+    }
+}
+
 int main(int argc, const char* argv[])
 {
     Arguments args;
@@ -82,28 +519,267 @@ int main(int argc, const char* argv[])
         return EXIT_SUCCESS;
     }
 
-    auto input_tree = parse_nhx_tree(read_all_from(
+    if (args.use_unordered + (args.beam > 0) + args.search_order > 1)
+    {
+        std::cerr << "Only one of the --unordered, --beam and --search-order "
+            "options can be used\n";
+        return EXIT_FAILURE;
+    }
+
+    auto mode = args.use_unordered
+        ? ReconciliationEngine::Mode::Unordered
+        : args.beam > 0
+            ? ReconciliationEngine::Mode::Beam
+            : args.search_order
+                ? ReconciliationEngine::Mode::Search
+                : ReconciliationEngine::Mode::Ordered;
+
+    try
+    {
+        place_threads(args.bind, argv);
+    }
+    catch (const std::exception& err)
+    {
+        std::cerr << err.what() << "\n";
+        return EXIT_FAILURE;
+    }
+
+    if (args.server || !args.socket_path.empty())
+    {
+        SuperReconciliationParams params;
+        params.jobs = args.jobs;
+        params.cache_size = args.cache_size;
+        params.beam = args.beam;
+        params.device = args.device;
+        params.spill_directory = args.spill_directory;
+        ReconciliationEngine engine{params};
+
+        auto handler = [&](std::istream& in, std::ostream& out)
+        {
+            serve(
+                in, out, engine, mode, args.format, args.timing,
+                args.max_request_size, args.max_families);
+        };
+
+        if (!args.socket_path.empty())
+        {
+            try
+            {
+                serve_unix_socket(args.socket_path, handler);
+            }
+            catch (const std::exception& err)
+            {
+                std::cerr << err.what() << "\n";
+                return EXIT_FAILURE;
+            }
+        }
+
+        std::ios_base::sync_with_stdio(false);
+        std::ifstream input_file;
+        std::ofstream output_file;
+
+        if (args.input_path != "-")
+        {
+            input_file.open(args.input_path, std::ios::binary);
+
+            if (!input_file)
+            {
+                std::cerr << "Cannot open input file: "
+                    << args.input_path << "\n";
+                return EXIT_FAILURE;
+            }
+        }
+
+        if (args.output_path != "-")
+        {
+            output_file.open(args.output_path, std::ios::binary);
+
+            if (!output_file)
+            {
+                std::cerr << "Cannot open output file: "
+                    << args.output_path << "\n";
+                return EXIT_FAILURE;
+            }
+        }
+
+        handler(
+            args.input_path == "-" ? std::cin : input_file,
+            args.output_path == "-" ? std::cout : output_file);
+        return EXIT_SUCCESS;
+    }
+
+    if (args.batch)
+    {
+        if (args.format != TreeFormat::NHX)
+        {
+            std::cerr << "Batch mode only supports the 'nhx' format\n";
+            return EXIT_FAILURE;
+        }
+
+        if (args.jobs > 0)
+        {
+            omp_set_num_threads(args.jobs);
+        }
+
+        TreeReader input{
+            args.input_path,
+            "Input the trees to be reconciled, each ended by a semicolon, "
+                "and finish with Ctrl-D:"};
+
+        std::size_t failures = 0;
+
+        write_all_to(
+            args.output_path,
+            [&](std::ostream& out)
+            {
+                // Each engine reconciles its trees sequentially
+                SuperReconciliationParams params;
+                params.cache_size = args.cache_size;
+                params.beam = args.beam;
+                params.device = args.device;
+                params.spill_directory = args.spill_directory;
+                failures = reconcile_batch(out, input, mode, params);
+            },
+            "Reconciled trees (use `viz` to visualize):");
+
+        return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+
+    // Measure each step if statistics are requested
+    using stats_clock = std::chrono::steady_clock;
+    auto step_start = stats_clock::now();
+    json durations;
+
+    auto end_step = [&](const char* name)
+    {
+        auto now = stats_clock::now();
+        durations[name] = std::chrono::duration_cast<
+            std::chrono::microseconds>(now - step_start).count();
+        step_start = now;
+    };
+
+    auto input = read_all_from(
         args.input_path,
         "Input the tree to be reconciled "
-            "and finish with Ctrl-D:"));
+            "and finish with Ctrl-D:");
+    end_step("read");
+
+    auto event_tree = parse_event_tree(input);
+    end_step("parse");
+
+    std::size_t node_count = event_tree.size();
+    std::size_t leaf_count = 0;
+
+    for (auto it = event_tree.begin_leaf(); it != event_tree.end_leaf(); ++it)
+    {
+        ++leaf_count;
+    }
+
+    std::size_t ancestral_length = event_tree.empty()
+        ? 0
+        : event_tree.begin()->synteny.size();
 
-    auto event_tree = tree_cast<TaggedNode, Event>(input_tree);
+    SuperReconciliationParams params;
+    params.jobs = args.jobs;
+    params.beam = args.beam;
+    params.device = args.device;
+    params.spill_directory = args.spill_directory;
+    ReconciliationEngine engine{params};
+    ReconciliationStats stats;
+    std::size_t peak_bytes = 0;
+    std::size_t allocations = 0;
 
-    if (args.use_unordered)
     {
-        unordered_super_reconciliation(event_tree);
+        // Workers of the parallel ordered algorithm allocate too
+        std::unique_ptr<AllocationTracker> tracker;
+
+        if (args.memory || args.stats)
+        {
+            tracker.reset(new AllocationTracker{
+                AllocationTracker::Scope::Process});
+        }
+
+        step_start = stats_clock::now();
+        engine.reconcile(
+            event_tree, mode,
+            args.stats || mode == ReconciliationEngine::Mode::Beam
+                ? &stats : nullptr);
+        end_step("reconcile");
+
+        if (tracker)
+        {
+            peak_bytes = tracker->getPeakBytes();
+            allocations = tracker->getAllocations();
+        }
     }
-    else
+
+    if (args.memory)
     {
-        super_reconciliation(event_tree);
+        std::cerr << "Peak heap usage: " << peak_bytes
+            << " bytes in " << allocations << " allocations\n";
     }
 
-    auto result_tree = tree_cast<Event, TaggedNode>(event_tree);
+    if (mode == ReconciliationEngine::Mode::Beam)
+    {
+        std::cerr << "DL-score: " << stats.dl_score << " (lower bound: "
+            << stats.lower_bound << ", gap: "
+            << stats.dl_score - stats.lower_bound << ")\n";
+    }
 
     write_all_to(
         args.output_path,
-        stringify_nhx_tree(result_tree),
+        [&event_tree, &args](std::ostream& out)
+        {
+            write_event_tree(out, event_tree, args.format);
+        },
         "Reconciled tree (use `viz` to visualize):");
+    end_step("write");
+
+    if (args.stats)
+    {
+        std::size_t candidates = 0;
+        std::size_t finite_candidates = 0;
+
+        for (std::size_t index = 0; index < stats.candidates.size(); ++index)
+        {
+            candidates += stats.candidates[index];
+            finite_candidates += stats.finite_candidates[index];
+        }
+
+        json record = {
+            {"mode", args.use_unordered ? "unordered"
+                : args.beam > 0 ? "beam"
+                : args.search_order ? "search" : "ordered"},
+            {"durations", durations},
+            {"nodes", node_count},
+            {"leaves", leaf_count},
+            {"ancestral_length", ancestral_length},
+            {"candidates", candidates},
+            {"finite_candidates", finite_candidates},
+            {"candidates_per_node", stats.candidates},
+            {"finite_candidates_per_node", stats.finite_candidates},
+            {"shared_nodes", stats.shared_nodes},
+            {"inserted_losses", stats.inserted_losses},
+            {"dl_score", stats.dl_score},
+            {"spilled_bytes", stats.spilled_bytes},
+            {"peak_bytes", peak_bytes},
+            {"allocations", allocations}
+        };
+
+        if (mode == ReconciliationEngine::Mode::Beam)
+        {
+            record["beam"] = args.beam;
+            record["lower_bound"] = stats.lower_bound;
+        }
+
+        if (mode == ReconciliationEngine::Mode::Search)
+        {
+            record["solved_orders"] = stats.solved_orders;
+            record["pruned_orders"] = stats.pruned_orders;
+        }
+
+        std::cerr << record << "\n";
+    }
 
     return EXIT_SUCCESS;
 }
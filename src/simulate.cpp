@@ -1,8 +1,14 @@
 #include "algo/simulate.hpp"
-#include "util/tree.hpp"
+#include "io/format.hpp"
 #include "io/util.hpp"
+#include "util/random.hpp"
+#include <atomic>
 #include <boost/program_options.hpp>
+#include <deque>
 #include <iostream>
+#include <memory>
+#include <omp.h>
+#include <string>
 
 namespace po = boost::program_options;
 
@@ -21,7 +27,10 @@ struct Arguments
     double p_loss_length;
     double p_rearr;
 
+    std::size_t count;
+    unsigned jobs;
     std::string output_path;
+    TreeFormat format;
 };
 
 /**
@@ -48,6 +57,26 @@ bool read_arguments(Arguments& result, int argc, const char* argv[])
             ->default_value("-"),
          "path of the file in which the simulated tree should be stored, "
             "or '-' to store it in standard output")
+        ("format,F",
+         po::value(&result.format)
+            ->value_name("FORMAT")
+            ->default_value(TreeFormat::NHX),
+         "format of the output tree, either 'nhx' or 'binary' for a compact "
+            "format that is faster to exchange between programs")
+        ("count,n",
+         po::value(&result.count)
+            ->value_name("COUNT")
+            ->default_value(1),
+         "number of trees to simulate. Trees are written in order as soon "
+         "as they are simulated, one per line in NHX format, or each "
+         "preceded by a line holding its size in bytes in binary format")
+        ("jobs,j",
+         po::value(&result.jobs)
+            ->value_name("JOBS")
+            ->default_value(1),
+         "number of threads to use for simulating several trees "
+         "concurrently. If 0, automatically evaluate the best amount of "
+         "threads based on the resources of the machine")
     ;
     root.add(gen_opt_group);
 
@@ -59,7 +88,9 @@ bool read_arguments(Arguments& result, int argc, const char* argv[])
             ->default_value(0),
          "seed for the pseudo-random number generator. The special value 0 "
          "instructs the program to grab a random seed from one of the "
-         "system’s entropy sources")
+         "system’s entropy sources. When several trees are simulated, "
+         "each tree gets its own seed derived from this seed and from its "
+         "index, so that the output does not depend on the number of jobs")
         ("base-size,s",
          po::value(&result.base_size)
             ->value_name("SIZE")
@@ -122,6 +153,104 @@ bool read_arguments(Arguments& result, int argc, const char* argv[])
     return true;
 }
 
+/**
+ * Tree of a sequence that is being simulated or waiting to be written.
+ */
+struct SequenceItem
+{
+    // Simulated tree in the output format
+    std::string output;
+
+    // Whether the item was simulated and can be written
+    std::atomic<bool> is_done{false};
+};
+
+/**
+ * Simulate a sequence of trees and write them in order.
+ *
+ * Each tree is simulated in a task of its own, with a generator seeded
+ * from the master seed and from the index of the tree. Trees are written
+ * as soon as all previous trees are written, and the number of trees in
+ * flight is bounded, so that memory does not depend on the number of
+ * trees. In NHX format, trees are written one per line. In binary format,
+ * each tree is preceded by a line holding its size in bytes and followed
+ * by a newline, which is the request format of `reconcile --server`.
+ *
+ * @param out Stream to write the simulated trees to.
+ * @param params Parameters of the simulation.
+ * @param seed Master seed of the sequence.
+ * @param count Number of trees to simulate.
+ * @param format Format of the trees.
+ */
+void simulate_sequence(
+    std::ostream& out,
+    const SimulationParams& params,
+    std::uint64_t seed,
+    std::size_t count,
+    TreeFormat format)
+{
+    std::deque<std::unique_ptr<SequenceItem>> pending;
+    std::size_t next_index = 0;
+
+    // Write out the simulated items at the front of the queue
+    auto write_done = [&]()
+    {
+        while (!pending.empty() && pending.front()->is_done)
+        {
+            const auto& item = *pending.front();
+
+            if (format == TreeFormat::Binary)
+            {
+                out << item.output.size() << "\n" << item.output << "\n";
+            }
+            else
+            {
+                if (next_index != 0)
+                {
+                    out << "\n";
+                }
+
+                out << item.output;
+            }
+
+            pending.pop_front();
+            ++next_index;
+        }
+    };
+
+    #pragma omp parallel
+    #pragma omp single
+    {
+        auto thread_count = static_cast<std::size_t>(omp_get_num_threads());
+        auto max_pending = 4 * thread_count;
+
+        for (std::size_t index = 0; index < count; ++index)
+        {
+            pending.emplace_back(new SequenceItem);
+            auto item = pending.back().get();
+
+            #pragma omp task firstprivate(item, index) \
+                shared(params, seed, format)
+            {
+                auto prng = make_prng<std::mt19937>(derive_seed(seed, index));
+                auto event_tree = simulate_evolution(prng, params);
+                write_event_tree(item->output, event_tree, format);
+                item->is_done = true;
+            }
+
+            if (pending.size() >= max_pending)
+            {
+                #pragma omp taskwait
+            }
+
+            write_done();
+        }
+
+        #pragma omp taskwait
+        write_done();
+    }
+}
+
 int main(int argc, const char* argv[])
 {
     Arguments args;
@@ -138,8 +267,6 @@ int main(int argc, const char* argv[])
         seed = std::random_device()();
     }
 
-    std::mt19937 prng{seed};
-
     SimulationParams params;
     params.base = Synteny::generateDummy(args.base_size);
     params.depth = args.depth;
@@ -149,12 +276,33 @@ int main(int argc, const char* argv[])
     params.p_loss_length = args.p_loss_length;
     params.p_rearr = args.p_rearr;
 
+    if (args.count != 1)
+    {
+        if (args.jobs > 0)
+        {
+            omp_set_num_threads(args.jobs);
+        }
+
+        write_all_to(
+            args.output_path,
+            [&](std::ostream& out)
+            {
+                simulate_sequence(out, params, seed, args.count, args.format);
+            },
+            "Simulated evolution trees:");
+
+        return EXIT_SUCCESS;
+    }
+
+    std::mt19937 prng{seed};
     auto event_tree = simulate_evolution(prng, params);
-    auto result_tree = tree_cast<Event, TaggedNode>(event_tree);
 
     write_all_to(
         args.output_path,
-        stringify_nhx_tree(result_tree),
+        [&event_tree, &args](std::ostream& out)
+        {
+            write_event_tree(out, event_tree, args.format);
+        },
         "Simulated evolution tree:");
 
     return EXIT_SUCCESS;
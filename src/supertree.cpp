@@ -0,0 +1,133 @@
+#include "algo/SupertreeBuilder.hpp"
+#include "io/format.hpp"
+#include "io/util.hpp"
+#include <boost/program_options.hpp>
+#include <boost/utility/string_ref.hpp>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+
+namespace po = boost::program_options;
+
+/**
+ * All arguments that can be passed to the program.
+ * See below for a description of each argument.
+ */
+struct Arguments
+{
+    std::string input_path;
+    std::string output_path;
+    TreeFormat format;
+};
+
+/**
+ * Read arguments passed to the program and produce the
+ * help message if requested by the user.
+ *
+ * @param result Filled with arguments passed to the program or
+ * appropriate default values.
+ * @param argc Number of arguments in argv.
+ * @param argv Tokenized list of arguments passed to the program.
+ * @return True if the program may continue, or false if it has
+ * to be stopped.
+ */
+bool read_arguments(Arguments& result, int argc, const char* argv[])
+{
+    po::options_description root{"General options"};
+    root.add_options()
+        ("help,h", "show this help message")
+        ("input,I",
+         po::value(&result.input_path)
+            ->value_name("PATH")
+            ->default_value("-"),
+         "path of the file from which to read the gene trees, each ended "
+            "by a semicolon, or '-' to read them from standard input")
+        ("output,o",
+         po::value(&result.output_path)
+            ->value_name("PATH")
+            ->default_value("-"),
+         "path of the file in which the supertree should be stored, or '-' "
+            "to store it in standard output")
+        ("format,F",
+         po::value(&result.format)
+            ->value_name("FORMAT")
+            ->default_value(TreeFormat::NHX),
+         "format of the output tree, either 'nhx' or 'binary' for a compact "
+            "format that is faster to exchange between programs")
+    ;
+
+    po::variables_map values;
+    po::store(
+        po::command_line_parser(argc, argv)
+            .options(root)
+            .run(),
+        values);
+
+    if (values.count("help"))
+    {
+        std::cout << "Usage: " << argv[0] << " [options...]\n";
+        std::cout << "\nBuild the synteny supertree of a set of consistent "
+            "gene trees, one per gene family, to make it suitable for "
+            "super-reconciliation.\n";
+        std::cout << root;
+        return false;
+    }
+
+    po::notify(values);
+    return true;
+}
+
+int main(int argc, const char* argv[])
+{
+    Arguments args;
+
+    if (!read_arguments(args, argc, argv))
+    {
+        return EXIT_SUCCESS;
+    }
+
+    // Gene trees are stored in a compact form as soon as they are read
+    SupertreeBuilder builder;
+    ::tree<Event> supertree;
+
+    try
+    {
+        TreeReader input{
+            args.input_path,
+            "Input the gene trees, each ended by a semicolon, "
+                "and finish with Ctrl-D:"};
+
+        boost::string_ref gene_tree;
+
+        while (input.next(gene_tree))
+        {
+            try
+            {
+                builder.addGeneTree(gene_tree);
+            }
+            catch (const std::exception& err)
+            {
+                std::cerr << "Error in gene tree #" << builder.size()
+                    << ": " << err.what() << "\n";
+                return EXIT_FAILURE;
+            }
+        }
+
+        supertree = builder.build();
+    }
+    catch (const std::exception& err)
+    {
+        std::cerr << err.what() << "\n";
+        return EXIT_FAILURE;
+    }
+
+    write_all_to(
+        args.output_path,
+        [&supertree, &args](std::ostream& out)
+        {
+            write_event_tree(out, supertree, args.format);
+        },
+        "Supertree (use `reconcile` to reconcile it):");
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,235 @@
+#include "AllocationTracker.hpp"
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#include <stdexcept>
+
+namespace
+{
+
+// Size of the header that stores the size of each block, which keeps
+// blocks aligned as strictly as `malloc` does
+constexpr std::size_t header_size = alignof(std::max_align_t);
+
+struct Counters
+{
+    bool active;
+    long current;
+    long peak;
+    std::size_t allocations;
+};
+
+// Counters of the calling thread, only updated while a thread-scoped
+// tracker is alive. The type is trivial, so that it can be used from the
+// allocation operators without any initialization
+thread_local Counters thread_counters;
+
+// Counters of all threads, only updated while a process-scoped tracker is
+// alive
+std::atomic<bool> process_active{false};
+std::atomic<long> process_current{0};
+std::atomic<long> process_peak{0};
+std::atomic<std::size_t> process_allocations{0};
+
+void record_allocation(std::size_t size) noexcept
+{
+    auto& counters = thread_counters;
+
+    if (counters.active)
+    {
+        counters.current += static_cast<long>(size);
+        ++counters.allocations;
+
+        if (counters.current > counters.peak)
+        {
+            counters.peak = counters.current;
+        }
+    }
+
+    if (process_active.load(std::memory_order_relaxed))
+    {
+        auto current = process_current.fetch_add(
+            static_cast<long>(size), std::memory_order_relaxed)
+            + static_cast<long>(size);
+        process_allocations.fetch_add(1, std::memory_order_relaxed);
+        auto peak = process_peak.load(std::memory_order_relaxed);
+
+        while (current > peak && !process_peak.compare_exchange_weak(
+                    peak, current, std::memory_order_relaxed))
+        {
+        }
+    }
+}
+
+void record_deallocation(std::size_t size) noexcept
+{
+    auto& counters = thread_counters;
+
+    if (counters.active)
+    {
+        counters.current -= static_cast<long>(size);
+    }
+
+    if (process_active.load(std::memory_order_relaxed))
+    {
+        process_current.fetch_sub(
+            static_cast<long>(size), std::memory_order_relaxed);
+    }
+}
+
+void* allocate(std::size_t size) noexcept
+{
+    auto block = static_cast<char*>(std::malloc(size + header_size));
+
+    if (block == nullptr)
+    {
+        return nullptr;
+    }
+
+    *reinterpret_cast<std::size_t*>(block) = size;
+    record_allocation(size);
+    return block + header_size;
+}
+
+void* allocate_or_throw(std::size_t size)
+{
+    void* result;
+
+    while ((result = allocate(size)) == nullptr)
+    {
+        auto handler = std::get_new_handler();
+
+        if (handler == nullptr)
+        {
+            throw std::bad_alloc{};
+        }
+
+        handler();
+    }
+
+    return result;
+}
+
+void deallocate(void* pointer) noexcept
+{
+    if (pointer == nullptr)
+    {
+        return;
+    }
+
+    auto block = static_cast<char*>(pointer) - header_size;
+    record_deallocation(*reinterpret_cast<std::size_t*>(block));
+    std::free(block);
+}
+
+} // namespace
+
+AllocationTracker::AllocationTracker(Scope scope)
+: scope(scope)
+{
+    if (this->scope == Scope::Thread)
+    {
+        if (thread_counters.active)
+        {
+            throw std::logic_error{"Allocations of this thread are "
+                "already tracked"};
+        }
+
+        thread_counters = Counters{true, 0, 0, 0};
+    }
+    else
+    {
+        if (process_active.exchange(true))
+        {
+            throw std::logic_error{"Allocations of the process are "
+                "already tracked"};
+        }
+
+        process_current = 0;
+        process_peak = 0;
+        process_allocations = 0;
+    }
+}
+
+AllocationTracker::~AllocationTracker()
+{
+    if (this->scope == Scope::Thread)
+    {
+        thread_counters.active = false;
+    }
+    else
+    {
+        process_active = false;
+    }
+}
+
+std::size_t AllocationTracker::getPeakBytes() const
+{
+    return static_cast<std::size_t>(this->scope == Scope::Thread
+        ? thread_counters.peak
+        : process_peak.load());
+}
+
+std::size_t AllocationTracker::getAllocations() const
+{
+    return this->scope == Scope::Thread
+        ? thread_counters.allocations
+        : process_allocations.load();
+}
+
+void* operator new(std::size_t size)
+{
+    return allocate_or_throw(size);
+}
+
+void* operator new[](std::size_t size)
+{
+    return allocate_or_throw(size);
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept
+{
+    try
+    {
+        return allocate_or_throw(size);
+    }
+    catch (const std::bad_alloc&)
+    {
+        return nullptr;
+    }
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept
+{
+    return ::operator new(size, std::nothrow);
+}
+
+void operator delete(void* pointer) noexcept
+{
+    deallocate(pointer);
+}
+
+void operator delete[](void* pointer) noexcept
+{
+    deallocate(pointer);
+}
+
+void operator delete(void* pointer, std::size_t) noexcept
+{
+    deallocate(pointer);
+}
+
+void operator delete[](void* pointer, std::size_t) noexcept
+{
+    deallocate(pointer);
+}
+
+void operator delete(void* pointer, const std::nothrow_t&) noexcept
+{
+    deallocate(pointer);
+}
+
+void operator delete[](void* pointer, const std::nothrow_t&) noexcept
+{
+    deallocate(pointer);
+}
@@ -0,0 +1,66 @@
+#ifndef UTIL_ALLOCATION_TRACKER_HPP
+#define UTIL_ALLOCATION_TRACKER_HPP
+
+#include <cstddef>
+
+/**
+ * Measure the heap allocations made through `operator new` while the
+ * tracker is alive. Linking a program that uses this class replaces the
+ * global allocation operators with counting versions, which store the size
+ * of each block in a small header before it.
+ *
+ * Only one tracker can be alive at a time on each thread, and only one
+ * process-wide tracker can be alive at a time in the program.
+ */
+class AllocationTracker
+{
+public:
+    /**
+     * Set of allocations that are measured.
+     */
+    enum class Scope
+    {
+        // Allocations and deallocations made by the calling thread, which
+        // allows concurrent measurements on separate threads
+        Thread,
+
+        // Allocations and deallocations made by any thread, including
+        // workers started by the measured computation
+        Process,
+    };
+
+    /**
+     * Start measuring allocations.
+     *
+     * @param scope Set of allocations to measure.
+     * @throws std::logic_error If another tracker is already measuring
+     * the same set of allocations.
+     */
+    explicit AllocationTracker(Scope scope = Scope::Thread);
+
+    AllocationTracker(const AllocationTracker&) = delete;
+    AllocationTracker& operator=(const AllocationTracker&) = delete;
+
+    /**
+     * Stop measuring allocations.
+     */
+    ~AllocationTracker();
+
+    /**
+     * Get the highest number of bytes that were allocated at the same
+     * time since the start of the measurement, not counting blocks that
+     * were already allocated at the start.
+     */
+    std::size_t getPeakBytes() const;
+
+    /**
+     * Get the number of allocations made since the start of the
+     * measurement.
+     */
+    std::size_t getAllocations() const;
+
+private:
+    Scope scope;
+};
+
+#endif // UTIL_ALLOCATION_TRACKER_HPP
@@ -0,0 +1,64 @@
+#include "AllocationTracker.hpp"
+#include <catch.hpp>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+TEST_CASE("Allocation tracking")
+{
+    using Scope = AllocationTracker::Scope;
+
+    SECTION("Thread scope")
+    {
+        // Blocks allocated before the measurement are not counted
+        std::vector<char> previous(1 << 16);
+
+        AllocationTracker tracker;
+        REQUIRE(tracker.getPeakBytes() == 0);
+        REQUIRE(tracker.getAllocations() == 0);
+
+        {
+            std::vector<int> first(1000);
+            std::vector<char> second(500);
+        }
+
+        {
+            std::vector<int> third(100);
+        }
+
+        previous.clear();
+        previous.shrink_to_fit();
+
+        REQUIRE(tracker.getPeakBytes() == 1000 * sizeof(int) + 500);
+        REQUIRE(tracker.getAllocations() == 3);
+        REQUIRE_THROWS_AS(AllocationTracker{}, std::logic_error);
+    }
+
+    SECTION("Other threads are not counted in thread scope")
+    {
+        AllocationTracker tracker;
+
+        std::thread other{[]()
+        {
+            std::vector<int> values(1000);
+        }};
+
+        other.join();
+        REQUIRE(tracker.getPeakBytes() < 1000 * sizeof(int));
+    }
+
+    SECTION("Process scope")
+    {
+        AllocationTracker tracker{Scope::Process};
+
+        std::thread other{[]()
+        {
+            std::vector<int> values(1000);
+        }};
+
+        other.join();
+        REQUIRE(tracker.getPeakBytes() >= 1000 * sizeof(int));
+        REQUIRE(tracker.getAllocations() >= 1);
+        REQUIRE_THROWS_AS(AllocationTracker{Scope::Process}, std::logic_error);
+    }
+}
@@ -0,0 +1,138 @@
+#include "PerfCounters.hpp"
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+#ifdef linux
+#include <cerrno>
+#include <cstring>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+PerfCounters::PerfCounters(const std::vector<Event>& events)
+{
+#ifdef linux
+    for (auto event : events)
+    {
+        perf_event_attr attr{};
+        attr.size = sizeof(attr);
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.disabled = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+
+        switch (event)
+        {
+        case Event::Cycles:
+            attr.config = PERF_COUNT_HW_CPU_CYCLES;
+            break;
+
+        case Event::Instructions:
+            attr.config = PERF_COUNT_HW_INSTRUCTIONS;
+            break;
+
+        case Event::CacheMisses:
+            attr.config = PERF_COUNT_HW_CACHE_MISSES;
+            break;
+        }
+
+        // Count events of the calling thread on any CPU
+        auto descriptor = static_cast<int>(
+            syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+
+        if (descriptor == -1)
+        {
+            auto error = errno;
+            this->close();
+            throw std::runtime_error{"Cannot open performance counters: "
+                + std::string{std::strerror(error)}};
+        }
+
+        this->descriptors.push_back(descriptor);
+    }
+#else
+    (void) events;
+    throw std::runtime_error{"Performance counters are only supported on "
+        "Linux"};
+#endif
+}
+
+PerfCounters::PerfCounters(PerfCounters&& other) noexcept
+: descriptors(std::move(other.descriptors))
+{
+    other.descriptors.clear();
+}
+
+PerfCounters& PerfCounters::operator=(PerfCounters&& other) noexcept
+{
+    if (this != &other)
+    {
+        this->close();
+        this->descriptors = std::move(other.descriptors);
+        other.descriptors.clear();
+    }
+
+    return *this;
+}
+
+PerfCounters::~PerfCounters()
+{
+    this->close();
+}
+
+void PerfCounters::start()
+{
+#ifdef linux
+    for (auto descriptor : this->descriptors)
+    {
+        ioctl(descriptor, PERF_EVENT_IOC_RESET, 0);
+    }
+
+    for (auto descriptor : this->descriptors)
+    {
+        ioctl(descriptor, PERF_EVENT_IOC_ENABLE, 0);
+    }
+#endif
+}
+
+void PerfCounters::stop()
+{
+#ifdef linux
+    for (auto descriptor : this->descriptors)
+    {
+        ioctl(descriptor, PERF_EVENT_IOC_DISABLE, 0);
+    }
+#endif
+}
+
+std::uint64_t PerfCounters::get(std::size_t index) const
+{
+    std::uint64_t result = 0;
+
+#ifdef linux
+    if (read(this->descriptors.at(index), &result, sizeof(result))
+            != sizeof(result))
+    {
+        throw std::runtime_error{"Cannot read performance counter"};
+    }
+#else
+    (void) index;
+#endif
+
+    return result;
+}
+
+void PerfCounters::close()
+{
+#ifdef linux
+    for (auto descriptor : this->descriptors)
+    {
+        ::close(descriptor);
+    }
+#endif
+
+    this->descriptors.clear();
+}
@@ -0,0 +1,73 @@
+#ifndef UTIL_PERF_COUNTERS_HPP
+#define UTIL_PERF_COUNTERS_HPP
+
+#include <cstdint>
+#include <vector>
+
+/**
+ * Hardware performance counters of the calling thread, read through the
+ * `perf_event_open` interface of Linux. Only events happening in user
+ * space are counted.
+ */
+class PerfCounters
+{
+public:
+    /**
+     * Hardware events that can be counted.
+     */
+    enum class Event
+    {
+        // CPU cycles
+        Cycles,
+
+        // Retired instructions
+        Instructions,
+
+        // Misses of the last-level cache
+        CacheMisses,
+    };
+
+    /**
+     * Open counters for a set of events on the calling thread. Counters
+     * are initially stopped.
+     *
+     * @param events Events to count.
+     * @throws std::runtime_error If the counters are not supported on this
+     * platform or cannot be opened (for example, because of the access
+     * restrictions set by the `kernel.perf_event_paranoid` setting).
+     */
+    explicit PerfCounters(const std::vector<Event>& events);
+
+    PerfCounters(const PerfCounters&) = delete;
+    PerfCounters& operator=(const PerfCounters&) = delete;
+    PerfCounters(PerfCounters&&) noexcept;
+    PerfCounters& operator=(PerfCounters&&) noexcept;
+    ~PerfCounters();
+
+    /**
+     * Reset all counters to zero and start counting.
+     */
+    void start();
+
+    /**
+     * Stop counting.
+     */
+    void stop();
+
+    /**
+     * Get the value of a counter.
+     *
+     * @param index Index of the event in the list given on construction.
+     * @return Number of events counted between the last calls to `start`
+     * and `stop`.
+     */
+    std::uint64_t get(std::size_t index) const;
+
+private:
+    // File descriptor of each counter
+    std::vector<int> descriptors;
+
+    void close();
+};
+
+#endif // UTIL_PERF_COUNTERS_HPP
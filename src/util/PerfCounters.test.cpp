@@ -0,0 +1,38 @@
+#include "PerfCounters.hpp"
+#include <catch.hpp>
+#include <stdexcept>
+
+TEST_CASE("Performance counters")
+{
+    using Event = PerfCounters::Event;
+    std::vector<Event> events{Event::Instructions, Event::Cycles};
+
+    try
+    {
+        PerfCounters counters{events};
+
+        counters.start();
+        volatile unsigned sum = 0;
+
+        for (unsigned i = 0; i < 100000; ++i)
+        {
+            sum = sum + i;
+        }
+
+        counters.stop();
+
+        // Counters may be supported but report nothing, for example in
+        // virtual machines that do not expose them
+        auto instructions = counters.get(0);
+        auto cycles = counters.get(1);
+
+        counters.start();
+        counters.stop();
+        REQUIRE(counters.get(0) <= instructions);
+        REQUIRE(counters.get(1) <= cycles);
+    }
+    catch (const std::runtime_error& err)
+    {
+        WARN("Skipping performance counters test: " << err.what());
+    }
+}
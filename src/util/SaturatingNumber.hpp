@@ -0,0 +1,119 @@
+#ifndef UTIL_SATURATING_NUMBER_HPP
+#define UTIL_SATURATING_NUMBER_HPP
+
+#include <cstddef>
+#include <ostream>
+#include <type_traits>
+
+/**
+ * Unsigned number type with a positive infinity, for costs that are summed
+ * and compared in hot loops. Unlike `ExtendedNumber`, infinity is not a
+ * separate flag but the largest value of the wrapped type, and additions
+ * saturate at that value instead of wrapping around. Operations never
+ * branch nor throw, so that loops over arrays of such numbers can be
+ * vectorized. Any sum that reaches the largest value is infinite.
+ */
+template<typename T>
+class SaturatingNumber
+{
+    static_assert(std::is_unsigned<T>::value, "Expected an unsigned type");
+
+public:
+    /**
+     * Create a saturating number with value 0.
+     */
+    constexpr SaturatingNumber() noexcept;
+
+    /**
+     * Create a saturating number with the given value.
+     *
+     * @param value Value to give to the number.
+     */
+    constexpr SaturatingNumber(T) noexcept;
+
+    /**
+     * Create an instance representing positive infinity.
+     *
+     * @return Instance representing positive infinity.
+     */
+    static constexpr SaturatingNumber positiveInfinity() noexcept;
+
+    /**
+     * Check whether the current instance is infinity.
+     *
+     * @return True iff this is infinity.
+     */
+    constexpr bool isInfinity() const noexcept;
+
+    /**
+     * Get the wrapped value, which is the largest value of the wrapped type
+     * if this is infinity.
+     */
+    constexpr T value() const noexcept;
+
+    // Comparison operators between saturating numbers
+    constexpr bool operator<(const SaturatingNumber&) const noexcept;
+    constexpr bool operator==(const SaturatingNumber&) const noexcept;
+    constexpr bool operator!=(const SaturatingNumber&) const noexcept;
+    constexpr bool operator<=(const SaturatingNumber&) const noexcept;
+    constexpr bool operator>(const SaturatingNumber&) const noexcept;
+    constexpr bool operator>=(const SaturatingNumber&) const noexcept;
+
+    /**
+     * Add another saturating number to this and store the result into this.
+     * The sum is infinite if any operand is infinite or if it overflows.
+     *
+     * @param rhs Second operand.
+     * @return Current instance.
+     */
+    SaturatingNumber& operator+=(const SaturatingNumber&) noexcept;
+    constexpr SaturatingNumber operator+(const SaturatingNumber&)
+        const noexcept;
+
+private:
+    T raw;
+};
+
+/**
+ * Add a non-negative integer to each number of an array.
+ *
+ * @param values Pointer to the first of `count` numbers.
+ * @param addends Pointer to the first of `count` non-negative integers,
+ * each one added to the number at the same index.
+ * @param count Number of numbers.
+ * @param result Pointer to the first of `count` numbers in which the sums
+ * are stored. May be the same as `values`.
+ */
+template<typename T, typename A>
+void add_each(
+    const SaturatingNumber<T>* values,
+    const A* addends,
+    std::size_t count,
+    SaturatingNumber<T>* result) noexcept;
+
+/**
+ * Find the first smallest number of an array.
+ *
+ * @param values Pointer to the first of `count` numbers.
+ * @param count Number of numbers, which must be positive.
+ * @return Index of the first number that is not greater than any other.
+ */
+template<typename T>
+std::size_t find_min(
+    const SaturatingNumber<T>* values,
+    std::size_t count) noexcept;
+
+/**
+ * Print a saturating number on an output stream.
+ *
+ * @param out Output stream to print on.
+ * @param number Saturating number to print.
+ *
+ * @return Used output stream.
+ */
+template<typename T>
+std::ostream& operator<<(std::ostream&, const SaturatingNumber<T>&);
+
+#include "SaturatingNumber.tpp"
+
+#endif // UTIL_SATURATING_NUMBER_HPP
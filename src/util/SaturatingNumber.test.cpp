@@ -0,0 +1,81 @@
+#include "SaturatingNumber.hpp"
+#include <catch.hpp>
+#include <cstdint>
+#include <sstream>
+#include <vector>
+
+TEST_CASE("Supports saturating operations on numbers")
+{
+    using Number = SaturatingNumber<std::uint8_t>;
+    Number a = 10, b = 8;
+    auto inf = Number::positiveInfinity();
+
+    SECTION("Comparisons")
+    {
+        REQUIRE_FALSE(a < b);
+        REQUIRE_FALSE(a == b);
+        REQUIRE(a != b);
+        REQUIRE_FALSE(a <= b);
+        REQUIRE(a > b);
+        REQUIRE(a >= b);
+        REQUIRE(a < inf);
+        REQUIRE(inf == Number::positiveInfinity());
+    }
+
+    SECTION("Arithmetic")
+    {
+        REQUIRE((a + b).value() == 18);
+        REQUIRE_FALSE((a + b).isInfinity());
+
+        a += b;
+        REQUIRE(a.value() == 18);
+    }
+
+    SECTION("Saturation")
+    {
+        REQUIRE((a + inf).isInfinity());
+        REQUIRE((inf + a).isInfinity());
+        REQUIRE((inf + inf).isInfinity());
+        REQUIRE((inf + Number{0}).isInfinity());
+        REQUIRE((Number{200} + Number{100}).isInfinity());
+        REQUIRE((Number{200} + Number{55}).isInfinity());
+        REQUIRE((Number{200} + Number{54}).value() == 254);
+    }
+
+    SECTION("Printing")
+    {
+        std::ostringstream out;
+        out << a << ' ' << inf;
+        REQUIRE(out.str() == "10 +∞");
+    }
+}
+
+TEST_CASE("Operates on arrays of saturating numbers")
+{
+    using Number = SaturatingNumber<std::uint32_t>;
+    auto inf = Number::positiveInfinity();
+
+    std::vector<Number> values = {7, inf, 3, 5, 3, inf, 12, 4, 3};
+    std::vector<int> addends = {0, 1, 2, 0, 1, 0, 0, 2, 4};
+    std::vector<Number> sums(values.size());
+
+    SECTION("Element-wise addition")
+    {
+        add_each(values.data(), addends.data(), values.size(), sums.data());
+        REQUIRE(sums == std::vector<Number>{
+            7, inf, 5, 5, 4, inf, 12, 6, 7});
+
+        add_each(values.data(), addends.data(), values.size(), values.data());
+        REQUIRE(values == sums);
+    }
+
+    SECTION("Index of the first smallest value")
+    {
+        REQUIRE(find_min(values.data(), values.size()) == 2);
+        REQUIRE(find_min(values.data(), 2) == 0);
+        REQUIRE(find_min(values.data() + 1, 1) == 0);
+
+        std::vector<Number> infinities(3, inf);
+        REQUIRE(find_min(infinities.data(), infinities.size()) == 0);
+    }
+}
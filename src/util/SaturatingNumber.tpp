@@ -0,0 +1,140 @@
+#include <limits>
+
+template<typename T>
+constexpr SaturatingNumber<T>::SaturatingNumber() noexcept
+: raw(0)
+{}
+
+template<typename T>
+constexpr SaturatingNumber<T>::SaturatingNumber(T value) noexcept
+: raw(value)
+{}
+
+template<typename T>
+constexpr SaturatingNumber<T> SaturatingNumber<T>::positiveInfinity() noexcept
+{
+    return SaturatingNumber{std::numeric_limits<T>::max()};
+}
+
+template<typename T>
+constexpr bool SaturatingNumber<T>::isInfinity() const noexcept
+{
+    return this->raw == std::numeric_limits<T>::max();
+}
+
+template<typename T>
+constexpr T SaturatingNumber<T>::value() const noexcept
+{
+    return this->raw;
+}
+
+template<typename T>
+constexpr bool SaturatingNumber<T>::operator<(
+    const SaturatingNumber& rhs) const noexcept
+{
+    return this->raw < rhs.raw;
+}
+
+template<typename T>
+constexpr bool SaturatingNumber<T>::operator==(
+    const SaturatingNumber& rhs) const noexcept
+{
+    return this->raw == rhs.raw;
+}
+
+template<typename T>
+constexpr bool SaturatingNumber<T>::operator!=(
+    const SaturatingNumber& rhs) const noexcept
+{
+    return this->raw != rhs.raw;
+}
+
+template<typename T>
+constexpr bool SaturatingNumber<T>::operator<=(
+    const SaturatingNumber& rhs) const noexcept
+{
+    return this->raw <= rhs.raw;
+}
+
+template<typename T>
+constexpr bool SaturatingNumber<T>::operator>(
+    const SaturatingNumber& rhs) const noexcept
+{
+    return this->raw > rhs.raw;
+}
+
+template<typename T>
+constexpr bool SaturatingNumber<T>::operator>=(
+    const SaturatingNumber& rhs) const noexcept
+{
+    return this->raw >= rhs.raw;
+}
+
+template<typename T>
+SaturatingNumber<T>& SaturatingNumber<T>::operator+=(
+    const SaturatingNumber& rhs) noexcept
+{
+    return *this = *this + rhs;
+}
+
+template<typename T>
+constexpr SaturatingNumber<T> SaturatingNumber<T>::operator+(
+    const SaturatingNumber& rhs) const noexcept
+{
+    // The wrapped sum is smaller than an operand if and only if it
+    // overflowed, which includes every sum with a non-zero infinity. The
+    // selection compiles to a conditional move or a blend, not a branch
+    return SaturatingNumber{static_cast<T>(
+        static_cast<T>(this->raw + rhs.raw) < this->raw
+            ? std::numeric_limits<T>::max()
+            : static_cast<T>(this->raw + rhs.raw))};
+}
+
+template<typename T, typename A>
+void add_each(
+    const SaturatingNumber<T>* values,
+    const A* addends,
+    std::size_t count,
+    SaturatingNumber<T>* result) noexcept
+{
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        result[i] = values[i] + SaturatingNumber<T>{
+            static_cast<T>(addends[i])};
+    }
+}
+
+template<typename T>
+std::size_t find_min(
+    const SaturatingNumber<T>* values,
+    std::size_t count) noexcept
+{
+    // Reduce to the smallest value first, which vectorizes, then find its
+    // first occurrence
+    auto smallest = values[0];
+
+    for (std::size_t i = 1; i < count; ++i)
+    {
+        smallest = values[i] < smallest ? values[i] : smallest;
+    }
+
+    std::size_t index = 0;
+
+    while (values[index] != smallest)
+    {
+        ++index;
+    }
+
+    return index;
+}
+
+template<typename T>
+std::ostream& operator<<(std::ostream& out, const SaturatingNumber<T>& number)
+{
+    if (number.isInfinity())
+    {
+        return out << "+∞";
+    }
+
+    return out << +number.value();
+}
@@ -0,0 +1,212 @@
+#ifndef UTIL_SMALL_VECTOR_HPP
+#define UTIL_SMALL_VECTOR_HPP
+
+#include <cstddef>
+#include <initializer_list>
+#include <iterator>
+#include <type_traits>
+
+/**
+ * Contiguous sequence container that stores up to `N` elements inline,
+ * without any heap allocation, and switches to a heap buffer for longer
+ * sequences. Elements must be trivially copyable, so that copying,
+ * inserting and erasing elements all reduce to moving blocks of memory.
+ *
+ * Its interface is a subset of the one of `std::vector`. Iterators are
+ * random-access and are invalidated by any operation that changes the
+ * size of the container.
+ */
+template<typename T, std::size_t N>
+class SmallVector
+{
+    static_assert(
+        std::is_trivially_copyable<T>::value,
+        "SmallVector elements must be trivially copyable");
+
+public:
+    using value_type = T;
+    using size_type = std::size_t;
+    using difference_type = std::ptrdiff_t;
+    using reference = T&;
+    using const_reference = const T&;
+    using pointer = T*;
+    using const_pointer = const T*;
+    using iterator = T*;
+    using const_iterator = const T*;
+    using reverse_iterator = std::reverse_iterator<iterator>;
+    using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+
+    /**
+     * Create an empty container.
+     */
+    SmallVector() noexcept;
+
+    /**
+     * Create a container holding `count` copies of a value.
+     *
+     * @param count Number of elements.
+     * @param value Value of each element.
+     */
+    explicit SmallVector(size_type, const T& = T());
+
+    /**
+     * Create a container holding a copy of a range of elements.
+     *
+     * @param first Iterator to the first element of the range.
+     * @param last Iterator past the last element of the range.
+     */
+    template<
+        typename InputIt,
+        typename = typename std::iterator_traits<InputIt>::iterator_category>
+    SmallVector(InputIt, InputIt);
+
+    /**
+     * Create a container holding a copy of a list of elements.
+     *
+     * @param init List of elements.
+     */
+    SmallVector(std::initializer_list<T>);
+
+    SmallVector(const SmallVector&);
+    SmallVector(SmallVector&&) noexcept;
+    SmallVector& operator=(const SmallVector&);
+    SmallVector& operator=(SmallVector&&) noexcept;
+    SmallVector& operator=(std::initializer_list<T>);
+    ~SmallVector();
+
+    // Element access
+    reference operator[](size_type) noexcept;
+    const_reference operator[](size_type) const noexcept;
+    reference front() noexcept;
+    const_reference front() const noexcept;
+    reference back() noexcept;
+    const_reference back() const noexcept;
+    T* data() noexcept;
+    const T* data() const noexcept;
+
+    // Iterators
+    iterator begin() noexcept;
+    const_iterator begin() const noexcept;
+    const_iterator cbegin() const noexcept;
+    iterator end() noexcept;
+    const_iterator end() const noexcept;
+    const_iterator cend() const noexcept;
+    reverse_iterator rbegin() noexcept;
+    const_reverse_iterator rbegin() const noexcept;
+    const_reverse_iterator crbegin() const noexcept;
+    reverse_iterator rend() noexcept;
+    const_reverse_iterator rend() const noexcept;
+    const_reverse_iterator crend() const noexcept;
+
+    // Capacity
+    bool empty() const noexcept;
+    size_type size() const noexcept;
+    size_type capacity() const noexcept;
+
+    /**
+     * Check whether the elements are currently stored inline.
+     */
+    bool isInline() const noexcept;
+
+    /**
+     * Make sure that the container can hold at least `capacity` elements
+     * without reallocating.
+     */
+    void reserve(size_type);
+
+    // Modifiers
+    void clear() noexcept;
+    void resize(size_type, const T& = T());
+    void push_back(const T&);
+
+    template<typename... Args>
+    reference emplace_back(Args&&...);
+
+    void pop_back() noexcept;
+
+    /**
+     * Insert an element before a position.
+     *
+     * @param pos Position before which to insert the element.
+     * @param value Value to insert.
+     * @return Iterator to the inserted element.
+     */
+    iterator insert(const_iterator, const T&);
+
+    /**
+     * Insert a range of elements before a position.
+     *
+     * @param pos Position before which to insert the elements.
+     * @param first Iterator to the first element to insert.
+     * @param last Iterator past the last element to insert.
+     * @return Iterator to the first inserted element.
+     */
+    template<
+        typename InputIt,
+        typename = typename std::iterator_traits<InputIt>::iterator_category>
+    iterator insert(const_iterator, InputIt, InputIt);
+
+    /**
+     * Remove the element at a position.
+     *
+     * @param pos Position of the element to remove.
+     * @return Iterator following the removed element.
+     */
+    iterator erase(const_iterator) noexcept;
+
+    /**
+     * Remove the elements of a range.
+     *
+     * @param first Iterator to the first element to remove.
+     * @param last Iterator past the last element to remove.
+     * @return Iterator following the removed elements.
+     */
+    iterator erase(const_iterator, const_iterator) noexcept;
+
+    void swap(SmallVector&) noexcept;
+
+private:
+    // Pointer to the first element, either in the inline buffer or on
+    // the heap
+    T* elements;
+
+    // Number of elements
+    size_type length;
+
+    // Number of elements that fit in the current buffer
+    size_type allocated;
+
+    // Inline buffer
+    typename std::aligned_storage<sizeof(T) * N, alignof(T)>::type buffer;
+
+    T* getInlineBuffer() noexcept;
+
+    // Make room for `count` elements at `index`, shifting the following
+    // elements, and return a pointer to the first of these elements
+    T* makeGap(size_type index, size_type count);
+};
+
+template<typename T, std::size_t N>
+bool operator==(const SmallVector<T, N>&, const SmallVector<T, N>&);
+
+template<typename T, std::size_t N>
+bool operator!=(const SmallVector<T, N>&, const SmallVector<T, N>&);
+
+template<typename T, std::size_t N>
+bool operator<(const SmallVector<T, N>&, const SmallVector<T, N>&);
+
+template<typename T, std::size_t N>
+bool operator<=(const SmallVector<T, N>&, const SmallVector<T, N>&);
+
+template<typename T, std::size_t N>
+bool operator>(const SmallVector<T, N>&, const SmallVector<T, N>&);
+
+template<typename T, std::size_t N>
+bool operator>=(const SmallVector<T, N>&, const SmallVector<T, N>&);
+
+template<typename T, std::size_t N>
+void swap(SmallVector<T, N>&, SmallVector<T, N>&) noexcept;
+
+#include "SmallVector.tpp"
+
+#endif // UTIL_SMALL_VECTOR_HPP
@@ -0,0 +1,131 @@
+#include "SmallVector.hpp"
+#include <catch.hpp>
+#include <list>
+#include <numeric>
+
+TEST_CASE("Inline and heap storage")
+{
+    SmallVector<int, 4> vec;
+    REQUIRE(vec.empty());
+    REQUIRE(vec.isInline());
+    REQUIRE(vec.capacity() == 4);
+
+    for (int i = 0; i < 4; ++i)
+    {
+        vec.push_back(i);
+    }
+
+    REQUIRE(vec.isInline());
+    REQUIRE(vec.size() == 4);
+
+    vec.push_back(4);
+    REQUIRE(!vec.isInline());
+    REQUIRE(vec.size() == 5);
+    REQUIRE(vec.capacity() >= 5);
+
+    for (int i = 0; i < 5; ++i)
+    {
+        REQUIRE(vec[i] == i);
+    }
+
+    REQUIRE(vec.front() == 0);
+    REQUIRE(vec.back() == 4);
+
+    vec.pop_back();
+    REQUIRE(vec == (SmallVector<int, 4>{0, 1, 2, 3}));
+}
+
+TEST_CASE("Construction, copy and move")
+{
+    SmallVector<int, 4> small{1, 2, 3};
+    SmallVector<int, 4> large{1, 2, 3, 4, 5, 6};
+
+    std::list<int> source{7, 8, 9};
+    SmallVector<int, 4> from_range(std::begin(source), std::end(source));
+    REQUIRE(from_range == (SmallVector<int, 4>{7, 8, 9}));
+
+    SmallVector<int, 4> filled(6, 42);
+    REQUIRE(filled.size() == 6);
+    REQUIRE(filled.back() == 42);
+
+    auto small_copy = small;
+    auto large_copy = large;
+    REQUIRE(small_copy == small);
+    REQUIRE(large_copy == large);
+
+    small_copy[0] = 10;
+    large_copy[0] = 10;
+    REQUIRE(small[0] == 1);
+    REQUIRE(large[0] == 1);
+
+    auto small_moved = std::move(small_copy);
+    auto large_moved = std::move(large_copy);
+    REQUIRE(small_moved == (SmallVector<int, 4>{10, 2, 3}));
+    REQUIRE(large_moved == (SmallVector<int, 4>{10, 2, 3, 4, 5, 6}));
+    REQUIRE(small_copy.empty());
+    REQUIRE(large_copy.empty());
+
+    small_moved = large;
+    REQUIRE(small_moved == large);
+    large_moved = small;
+    REQUIRE(large_moved == small);
+
+    swap(small_moved, large_moved);
+    REQUIRE(small_moved == small);
+    REQUIRE(large_moved == large);
+
+    // Both inline, with different lengths
+    SmallVector<int, 4> shorter{7};
+    SmallVector<int, 4> longer{8, 9, 10};
+    swap(shorter, longer);
+    REQUIRE(shorter == (SmallVector<int, 4>{8, 9, 10}));
+    REQUIRE(longer == (SmallVector<int, 4>{7}));
+    REQUIRE(shorter.isInline());
+    REQUIRE(longer.isInline());
+}
+
+TEST_CASE("Insertion and removal")
+{
+    SmallVector<int, 4> vec{1, 5};
+
+    vec.insert(std::begin(vec) + 1, 2);
+    REQUIRE(vec == (SmallVector<int, 4>{1, 2, 5}));
+
+    int values[] = {3, 4};
+    auto it = vec.insert(
+        std::begin(vec) + 2,
+        std::begin(values), std::end(values));
+    REQUIRE(*it == 3);
+    REQUIRE(vec == (SmallVector<int, 4>{1, 2, 3, 4, 5}));
+
+    // Insert a range of the container into itself while it grows
+    vec.insert(std::end(vec), std::begin(vec), std::end(vec));
+    REQUIRE(vec == (SmallVector<int, 4>{1, 2, 3, 4, 5, 1, 2, 3, 4, 5}));
+
+    it = vec.erase(std::begin(vec) + 2, std::begin(vec) + 7);
+    REQUIRE(*it == 3);
+    REQUIRE(vec == (SmallVector<int, 4>{1, 2, 3, 4, 5}));
+
+    vec.erase(std::begin(vec));
+    REQUIRE(vec == (SmallVector<int, 4>{2, 3, 4, 5}));
+
+    vec.resize(2);
+    REQUIRE(vec == (SmallVector<int, 4>{2, 3}));
+
+    vec.clear();
+    REQUIRE(vec.empty());
+}
+
+TEST_CASE("Comparison")
+{
+    using Vec = SmallVector<int, 2>;
+
+    REQUIRE(Vec{1, 2} == Vec{1, 2});
+    REQUIRE(Vec{1, 2} != Vec{1, 2, 3});
+    REQUIRE(Vec{1, 2} < Vec{1, 2, 3});
+    REQUIRE(Vec{1, 2, 3} < Vec{1, 3});
+    REQUIRE(Vec{} < Vec{0});
+    REQUIRE(Vec{1, 3} > Vec{1, 2, 3});
+    REQUIRE(Vec{1, 3} >= Vec{1, 3});
+    REQUIRE(Vec{1, 2} <= Vec{1, 3});
+}
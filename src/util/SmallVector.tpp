@@ -0,0 +1,521 @@
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <new>
+#include <utility>
+
+template<typename T, std::size_t N>
+SmallVector<T, N>::SmallVector() noexcept
+: elements(getInlineBuffer()), length(0), allocated(N)
+{}
+
+template<typename T, std::size_t N>
+SmallVector<T, N>::SmallVector(size_type count, const T& value)
+: SmallVector()
+{
+    this->resize(count, value);
+}
+
+template<typename T, std::size_t N>
+template<typename InputIt, typename>
+SmallVector<T, N>::SmallVector(InputIt first, InputIt last)
+: SmallVector()
+{
+    this->insert(this->cend(), first, last);
+}
+
+template<typename T, std::size_t N>
+SmallVector<T, N>::SmallVector(std::initializer_list<T> init)
+: SmallVector(std::begin(init), std::end(init))
+{}
+
+template<typename T, std::size_t N>
+SmallVector<T, N>::SmallVector(const SmallVector& other)
+: SmallVector()
+{
+    this->reserve(other.length);
+    std::memcpy(
+        static_cast<void*>(this->elements), other.elements,
+        other.length * sizeof(T));
+    this->length = other.length;
+}
+
+template<typename T, std::size_t N>
+SmallVector<T, N>::SmallVector(SmallVector&& other) noexcept
+: SmallVector()
+{
+    this->swap(other);
+}
+
+template<typename T, std::size_t N>
+SmallVector<T, N>& SmallVector<T, N>::operator=(const SmallVector& other)
+{
+    if (this != &other)
+    {
+        this->length = 0;
+        this->reserve(other.length);
+        std::memcpy(
+            static_cast<void*>(this->elements), other.elements,
+            other.length * sizeof(T));
+        this->length = other.length;
+    }
+
+    return *this;
+}
+
+template<typename T, std::size_t N>
+SmallVector<T, N>& SmallVector<T, N>::operator=(SmallVector&& other) noexcept
+{
+    if (this != &other)
+    {
+        this->clear();
+        this->swap(other);
+    }
+
+    return *this;
+}
+
+template<typename T, std::size_t N>
+SmallVector<T, N>& SmallVector<T, N>::operator=(std::initializer_list<T> init)
+{
+    this->clear();
+    this->insert(this->cend(), std::begin(init), std::end(init));
+    return *this;
+}
+
+template<typename T, std::size_t N>
+SmallVector<T, N>::~SmallVector()
+{
+    if (!this->isInline())
+    {
+        ::operator delete(this->elements);
+    }
+}
+
+template<typename T, std::size_t N>
+T& SmallVector<T, N>::operator[](size_type index) noexcept
+{
+    return this->elements[index];
+}
+
+template<typename T, std::size_t N>
+const T& SmallVector<T, N>::operator[](size_type index) const noexcept
+{
+    return this->elements[index];
+}
+
+template<typename T, std::size_t N>
+T& SmallVector<T, N>::front() noexcept
+{
+    return this->elements[0];
+}
+
+template<typename T, std::size_t N>
+const T& SmallVector<T, N>::front() const noexcept
+{
+    return this->elements[0];
+}
+
+template<typename T, std::size_t N>
+T& SmallVector<T, N>::back() noexcept
+{
+    return this->elements[this->length - 1];
+}
+
+template<typename T, std::size_t N>
+const T& SmallVector<T, N>::back() const noexcept
+{
+    return this->elements[this->length - 1];
+}
+
+template<typename T, std::size_t N>
+T* SmallVector<T, N>::data() noexcept
+{
+    return this->elements;
+}
+
+template<typename T, std::size_t N>
+const T* SmallVector<T, N>::data() const noexcept
+{
+    return this->elements;
+}
+
+template<typename T, std::size_t N>
+T* SmallVector<T, N>::begin() noexcept
+{
+    return this->elements;
+}
+
+template<typename T, std::size_t N>
+const T* SmallVector<T, N>::begin() const noexcept
+{
+    return this->elements;
+}
+
+template<typename T, std::size_t N>
+const T* SmallVector<T, N>::cbegin() const noexcept
+{
+    return this->elements;
+}
+
+template<typename T, std::size_t N>
+T* SmallVector<T, N>::end() noexcept
+{
+    return this->elements + this->length;
+}
+
+template<typename T, std::size_t N>
+const T* SmallVector<T, N>::end() const noexcept
+{
+    return this->elements + this->length;
+}
+
+template<typename T, std::size_t N>
+const T* SmallVector<T, N>::cend() const noexcept
+{
+    return this->elements + this->length;
+}
+
+template<typename T, std::size_t N>
+typename SmallVector<T, N>::reverse_iterator
+SmallVector<T, N>::rbegin() noexcept
+{
+    return reverse_iterator{this->end()};
+}
+
+template<typename T, std::size_t N>
+typename SmallVector<T, N>::const_reverse_iterator
+SmallVector<T, N>::rbegin() const noexcept
+{
+    return const_reverse_iterator{this->end()};
+}
+
+template<typename T, std::size_t N>
+typename SmallVector<T, N>::const_reverse_iterator
+SmallVector<T, N>::crbegin() const noexcept
+{
+    return const_reverse_iterator{this->end()};
+}
+
+template<typename T, std::size_t N>
+typename SmallVector<T, N>::reverse_iterator
+SmallVector<T, N>::rend() noexcept
+{
+    return reverse_iterator{this->begin()};
+}
+
+template<typename T, std::size_t N>
+typename SmallVector<T, N>::const_reverse_iterator
+SmallVector<T, N>::rend() const noexcept
+{
+    return const_reverse_iterator{this->begin()};
+}
+
+template<typename T, std::size_t N>
+typename SmallVector<T, N>::const_reverse_iterator
+SmallVector<T, N>::crend() const noexcept
+{
+    return const_reverse_iterator{this->begin()};
+}
+
+template<typename T, std::size_t N>
+bool SmallVector<T, N>::empty() const noexcept
+{
+    return this->length == 0;
+}
+
+template<typename T, std::size_t N>
+std::size_t SmallVector<T, N>::size() const noexcept
+{
+    return this->length;
+}
+
+template<typename T, std::size_t N>
+std::size_t SmallVector<T, N>::capacity() const noexcept
+{
+    return this->allocated;
+}
+
+template<typename T, std::size_t N>
+bool SmallVector<T, N>::isInline() const noexcept
+{
+    return this->elements == reinterpret_cast<const T*>(&this->buffer);
+}
+
+template<typename T, std::size_t N>
+void SmallVector<T, N>::reserve(size_type capacity)
+{
+    if (capacity <= this->allocated)
+    {
+        return;
+    }
+
+    auto new_allocated = std::max(capacity, 2 * this->allocated);
+    auto* new_elements = static_cast<T*>(
+        ::operator new(new_allocated * sizeof(T)));
+
+    std::memcpy(
+        static_cast<void*>(new_elements), this->elements,
+        this->length * sizeof(T));
+
+    if (!this->isInline())
+    {
+        ::operator delete(this->elements);
+    }
+
+    this->elements = new_elements;
+    this->allocated = new_allocated;
+}
+
+template<typename T, std::size_t N>
+void SmallVector<T, N>::clear() noexcept
+{
+    this->length = 0;
+}
+
+template<typename T, std::size_t N>
+void SmallVector<T, N>::resize(size_type count, const T& value)
+{
+    if (count > this->length)
+    {
+        T copy = value;
+        this->reserve(count);
+        std::uninitialized_fill(
+            this->elements + this->length,
+            this->elements + count,
+            copy);
+    }
+
+    this->length = count;
+}
+
+template<typename T, std::size_t N>
+void SmallVector<T, N>::push_back(const T& value)
+{
+    this->emplace_back(value);
+}
+
+template<typename T, std::size_t N>
+template<typename... Args>
+T& SmallVector<T, N>::emplace_back(Args&&... args)
+{
+    // Construct the element before growing, since the arguments may
+    // refer to current elements
+    T value(std::forward<Args>(args)...);
+    this->reserve(this->length + 1);
+    auto* result = new (this->elements + this->length) T(value);
+    ++this->length;
+    return *result;
+}
+
+template<typename T, std::size_t N>
+void SmallVector<T, N>::pop_back() noexcept
+{
+    --this->length;
+}
+
+template<typename T, std::size_t N>
+T* SmallVector<T, N>::insert(const_iterator pos, const T& value)
+{
+    T copy = value;
+    auto* gap = this->makeGap(pos - this->cbegin(), 1);
+    new (gap) T(copy);
+    return gap;
+}
+
+template<typename T, std::size_t N>
+template<typename InputIt, typename>
+T* SmallVector<T, N>::insert(const_iterator pos, InputIt first, InputIt last)
+{
+    auto index = static_cast<size_type>(pos - this->cbegin());
+
+    using Category = typename std::iterator_traits<InputIt>::iterator_category;
+
+    if (std::is_base_of<std::forward_iterator_tag, Category>::value)
+    {
+        // The range may belong to this container: copy it aside first
+        // if growing would invalidate it
+        SmallVector copy;
+        auto count = static_cast<size_type>(std::distance(first, last));
+        copy.reserve(count);
+
+        for (; first != last; ++first)
+        {
+            new (copy.elements + copy.length) T(*first);
+            ++copy.length;
+        }
+
+        auto* gap = this->makeGap(index, count);
+        std::memcpy(
+            static_cast<void*>(gap), copy.elements,
+            count * sizeof(T));
+        return gap;
+    }
+
+    auto current = index;
+
+    for (; first != last; ++first, ++current)
+    {
+        this->insert(this->cbegin() + current, *first);
+    }
+
+    return this->begin() + index;
+}
+
+template<typename T, std::size_t N>
+T* SmallVector<T, N>::erase(const_iterator pos) noexcept
+{
+    return this->erase(pos, pos + 1);
+}
+
+template<typename T, std::size_t N>
+T* SmallVector<T, N>::erase(const_iterator first, const_iterator last) noexcept
+{
+    auto index = static_cast<size_type>(first - this->cbegin());
+    auto count = static_cast<size_type>(last - first);
+
+    std::memmove(
+        static_cast<void*>(this->elements + index),
+        this->elements + index + count,
+        (this->length - index - count) * sizeof(T));
+
+    this->length -= count;
+    return this->elements + index;
+}
+
+template<typename T, std::size_t N>
+void SmallVector<T, N>::swap(SmallVector& other) noexcept
+{
+    if (this == &other)
+    {
+        return;
+    }
+
+    if (!this->isInline() && !other.isInline())
+    {
+        std::swap(this->elements, other.elements);
+        std::swap(this->length, other.length);
+        std::swap(this->allocated, other.allocated);
+        return;
+    }
+
+    if (this->isInline() && other.isInline())
+    {
+        // Only the elements in use are exchanged, since the rest of the
+        // inline buffers is uninitialized
+        auto common = std::min(this->length, other.length);
+
+        for (size_type i = 0; i < common; ++i)
+        {
+            typename std::aligned_storage<sizeof(T), alignof(T)>::type temp;
+            std::memcpy(&temp, this->elements + i, sizeof(T));
+            std::memcpy(
+                static_cast<void*>(this->elements + i),
+                other.elements + i, sizeof(T));
+            std::memcpy(
+                static_cast<void*>(other.elements + i),
+                &temp, sizeof(T));
+        }
+
+        if (this->length > common)
+        {
+            std::memcpy(
+                static_cast<void*>(other.elements + common),
+                this->elements + common,
+                (this->length - common) * sizeof(T));
+        }
+        else
+        {
+            std::memcpy(
+                static_cast<void*>(this->elements + common),
+                other.elements + common,
+                (other.length - common) * sizeof(T));
+        }
+
+        std::swap(this->length, other.length);
+        return;
+    }
+
+    // One of the containers is inline: move its elements to the inline
+    // buffer of the other one, which takes over its heap buffer
+    auto& inline_side = this->isInline() ? *this : other;
+    auto& heap_side = this->isInline() ? other : *this;
+    auto* heap_elements = heap_side.elements;
+    auto heap_allocated = heap_side.allocated;
+
+    heap_side.elements = heap_side.getInlineBuffer();
+    std::memcpy(
+        static_cast<void*>(heap_side.elements),
+        inline_side.elements,
+        inline_side.length * sizeof(T));
+    heap_side.allocated = N;
+
+    inline_side.elements = heap_elements;
+    inline_side.allocated = heap_allocated;
+    std::swap(this->length, other.length);
+}
+
+template<typename T, std::size_t N>
+T* SmallVector<T, N>::getInlineBuffer() noexcept
+{
+    return reinterpret_cast<T*>(&this->buffer);
+}
+
+template<typename T, std::size_t N>
+T* SmallVector<T, N>::makeGap(size_type index, size_type count)
+{
+    this->reserve(this->length + count);
+
+    std::memmove(
+        static_cast<void*>(this->elements + index + count),
+        this->elements + index,
+        (this->length - index) * sizeof(T));
+
+    this->length += count;
+    return this->elements + index;
+}
+
+template<typename T, std::size_t N>
+bool operator==(const SmallVector<T, N>& lhs, const SmallVector<T, N>& rhs)
+{
+    return lhs.size() == rhs.size()
+        && std::equal(std::begin(lhs), std::end(lhs), std::begin(rhs));
+}
+
+template<typename T, std::size_t N>
+bool operator!=(const SmallVector<T, N>& lhs, const SmallVector<T, N>& rhs)
+{
+    return !(lhs == rhs);
+}
+
+template<typename T, std::size_t N>
+bool operator<(const SmallVector<T, N>& lhs, const SmallVector<T, N>& rhs)
+{
+    return std::lexicographical_compare(
+        std::begin(lhs), std::end(lhs),
+        std::begin(rhs), std::end(rhs));
+}
+
+template<typename T, std::size_t N>
+bool operator<=(const SmallVector<T, N>& lhs, const SmallVector<T, N>& rhs)
+{
+    return !(rhs < lhs);
+}
+
+template<typename T, std::size_t N>
+bool operator>(const SmallVector<T, N>& lhs, const SmallVector<T, N>& rhs)
+{
+    return rhs < lhs;
+}
+
+template<typename T, std::size_t N>
+bool operator>=(const SmallVector<T, N>& lhs, const SmallVector<T, N>& rhs)
+{
+    return !(lhs < rhs);
+}
+
+template<typename T, std::size_t N>
+void swap(SmallVector<T, N>& lhs, SmallVector<T, N>& rhs) noexcept
+{
+    lhs.swap(rhs);
+}
@@ -0,0 +1,127 @@
+#include "SpillFile.hpp"
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#ifdef linux
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+SpillFile::SpillFile(const std::string& directory)
+{
+#ifdef linux
+    auto pattern = directory + "/spill-XXXXXX";
+    std::vector<char> path(pattern.begin(), pattern.end());
+    path.push_back('\0');
+    this->descriptor = mkstemp(path.data());
+
+    if (this->descriptor == -1)
+    {
+        throw std::runtime_error{"Cannot create a spill file in "
+            + directory + ": " + std::strerror(errno)};
+    }
+
+    unlink(path.data());
+#else
+    (void) directory;
+    throw std::runtime_error{"Spill files are only supported on Linux"};
+#endif
+}
+
+SpillFile::~SpillFile()
+{
+#ifdef linux
+    if (this->mapped != nullptr)
+    {
+        munmap(const_cast<char*>(this->mapped), this->mapped_size);
+    }
+
+    if (this->descriptor != -1)
+    {
+        close(this->descriptor);
+    }
+#endif
+}
+
+std::size_t SpillFile::append(const void* data, std::size_t size)
+{
+    // Reserve a range of the file, which no other thread writes to
+    auto offset = this->end.fetch_add(size);
+
+#ifdef linux
+    auto bytes = static_cast<const char*>(data);
+    std::size_t written = 0;
+
+    while (written < size)
+    {
+        auto result = pwrite(
+            this->descriptor,
+            bytes + written, size - written,
+            static_cast<off_t>(offset + written));
+
+        if (result == -1 && errno != EINTR)
+        {
+            throw std::runtime_error{"Cannot write to a spill file: "
+                + std::string{std::strerror(errno)}};
+        }
+
+        if (result > 0)
+        {
+            written += static_cast<std::size_t>(result);
+        }
+    }
+#else
+    (void) data;
+#endif
+
+    return offset;
+}
+
+const char* SpillFile::map()
+{
+#ifdef linux
+    auto size = this->size();
+
+    if (this->mapped != nullptr && this->mapped_size == size)
+    {
+        return this->mapped;
+    }
+
+    if (this->mapped != nullptr)
+    {
+        munmap(const_cast<char*>(this->mapped), this->mapped_size);
+        this->mapped = nullptr;
+        this->mapped_size = 0;
+    }
+
+    if (size == 0)
+    {
+        return nullptr;
+    }
+
+    void* address = mmap(
+        nullptr, size, PROT_READ, MAP_SHARED, this->descriptor, 0);
+
+    if (address == MAP_FAILED)
+    {
+        throw std::runtime_error{"Cannot map a spill file: "
+            + std::string{std::strerror(errno)}};
+    }
+
+    // Blocks are read in no particular order, each one only partially
+    madvise(address, size, MADV_RANDOM);
+    this->mapped = static_cast<const char*>(address);
+    this->mapped_size = size;
+#endif
+
+    return this->mapped;
+}
+
+std::size_t SpillFile::size() const
+{
+    return this->end;
+}
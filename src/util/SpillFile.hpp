@@ -0,0 +1,69 @@
+#ifndef UTIL_SPILL_FILE_HPP
+#define UTIL_SPILL_FILE_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <string>
+
+/**
+ * Anonymous temporary file to which blocks of data are moved out of memory
+ * while a computation runs, and from which they are read back by mapping
+ * the file in memory once it is complete. Only the pages that are read are
+ * loaded, and the kernel can drop them again whenever memory is needed.
+ * The file is removed from its directory as soon as it is created, so that
+ * its space is reclaimed when the instance is destroyed, even if the
+ * process crashes.
+ */
+class SpillFile
+{
+public:
+    /**
+     * Create an empty spill file.
+     *
+     * @param directory Directory in which to create the file.
+     * @throws std::runtime_error If the file cannot be created or if spill
+     * files are not supported on this platform (only Linux is).
+     */
+    explicit SpillFile(const std::string& directory);
+
+    SpillFile(const SpillFile&) = delete;
+    SpillFile& operator=(const SpillFile&) = delete;
+    ~SpillFile();
+
+    /**
+     * Write a block at the end of the file. Blocks can be appended by
+     * several threads concurrently, but not while the file is mapped.
+     *
+     * @param data Pointer to the first byte of the block.
+     * @param size Size of the block in bytes.
+     * @return Offset of the block in the file.
+     * @throws std::runtime_error If the block cannot be written.
+     */
+    std::size_t append(const void* data, std::size_t size);
+
+    /**
+     * Map the whole file in memory for reading, once all the blocks were
+     * appended.
+     *
+     * @return Pointer to the first byte of the file, at which blocks can be
+     * read from their offsets, or null if the file is empty. The pointer is
+     * aligned on a page boundary and remains valid until the instance is
+     * destroyed.
+     * @throws std::runtime_error If the file cannot be mapped.
+     */
+    const char* map();
+
+    /**
+     * Get the size of the file in bytes.
+     */
+    std::size_t size() const;
+
+private:
+    int descriptor = -1;
+    std::atomic<std::size_t> end{0};
+
+    const char* mapped = nullptr;
+    std::size_t mapped_size = 0;
+};
+
+#endif // UTIL_SPILL_FILE_HPP
@@ -0,0 +1,69 @@
+#include "SpillFile.hpp"
+#include <catch.hpp>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+
+TEST_CASE("Spill files")
+{
+    SECTION("Read back appended blocks")
+    {
+        SpillFile file{"/tmp"};
+        REQUIRE(file.size() == 0);
+        REQUIRE(file.map() == nullptr);
+
+        std::vector<std::uint32_t> first{1, 2, 3};
+        std::vector<std::uint32_t> second(5000, 42);
+        second.back() = 7;
+
+        auto first_offset = file.append(
+            first.data(), first.size() * sizeof(std::uint32_t));
+        auto second_offset = file.append(
+            second.data(), second.size() * sizeof(std::uint32_t));
+
+        REQUIRE(first_offset == 0);
+        REQUIRE(second_offset == 3 * sizeof(std::uint32_t));
+        REQUIRE(file.size() == 5003 * sizeof(std::uint32_t));
+
+        auto data = file.map();
+        REQUIRE(data != nullptr);
+        REQUIRE(std::memcmp(
+            data + first_offset, first.data(),
+            first.size() * sizeof(std::uint32_t)) == 0);
+        REQUIRE(std::memcmp(
+            data + second_offset, second.data(),
+            second.size() * sizeof(std::uint32_t)) == 0);
+    }
+
+    SECTION("Append blocks concurrently")
+    {
+        SpillFile file{"/tmp"};
+        std::vector<std::size_t> offsets(64);
+
+        #pragma omp parallel for num_threads(4)
+        for (int block = 0; block < 64; ++block)
+        {
+            std::vector<unsigned char> data(100, block);
+            offsets[block] = file.append(data.data(), data.size());
+        }
+
+        REQUIRE(file.size() == 6400);
+        auto data = file.map();
+
+        for (std::size_t block = 0; block < 64; ++block)
+        {
+            REQUIRE(offsets[block] % 100 == 0);
+            REQUIRE(static_cast<std::size_t>(data[offsets[block]]) == block);
+            REQUIRE(static_cast<std::size_t>(
+                data[offsets[block] + 99]) == block);
+        }
+    }
+
+    SECTION("Reject missing directories")
+    {
+        REQUIRE_THROWS_AS(
+            SpillFile{"/nonexistent/directory"},
+            std::runtime_error);
+    }
+}
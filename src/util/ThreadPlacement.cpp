@@ -0,0 +1,94 @@
+#include "ThreadPlacement.hpp"
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <unistd.h>
+#endif
+
+std::istream& operator>>(std::istream& in, ThreadPlacement& placement)
+{
+    std::string name;
+    in >> name;
+
+    if (name == "none")
+    {
+        placement = ThreadPlacement::None;
+    }
+    else if (name == "close")
+    {
+        placement = ThreadPlacement::Close;
+    }
+    else if (name == "spread")
+    {
+        placement = ThreadPlacement::Spread;
+    }
+    else
+    {
+        in.setstate(std::ios_base::failbit);
+    }
+
+    return in;
+}
+
+std::ostream& operator<<(std::ostream& out, const ThreadPlacement& placement)
+{
+    switch (placement)
+    {
+    case ThreadPlacement::None:
+        return out << "none";
+
+    case ThreadPlacement::Close:
+        return out << "close";
+
+    case ThreadPlacement::Spread:
+        return out << "spread";
+    }
+
+    return out;
+}
+
+void place_threads(ThreadPlacement placement, const char* const argv[])
+{
+    if (placement == ThreadPlacement::None)
+    {
+        return;
+    }
+
+#if defined(__unix__) || defined(__APPLE__)
+    std::ostringstream name;
+    name << placement;
+    const char* bind = std::getenv("OMP_PROC_BIND");
+
+    if (bind != nullptr && name.str() == bind
+            && std::getenv("OMP_PLACES") != nullptr)
+    {
+        return;
+    }
+
+    if (setenv("OMP_PROC_BIND", name.str().c_str(), 1) != 0
+            || setenv("OMP_PLACES", "cores", 0) != 0)
+    {
+        throw std::runtime_error{"Cannot set the thread placement: "
+            + std::string{std::strerror(errno)}};
+    }
+
+    // Only returns on failure. On Linux, the running executable is
+    // started again whatever the name it was given in `argv[0]`
+#ifdef linux
+    execv("/proc/self/exe", const_cast<char* const*>(argv));
+#else
+    execvp(argv[0], const_cast<char* const*>(argv));
+#endif
+    throw std::runtime_error{"Cannot restart with the thread placement: "
+        + std::string{std::strerror(errno)}};
+#else
+    (void) argv;
+    throw std::runtime_error{"Thread placement is only supported on "
+        "Unix-like systems"};
+#endif
+}
@@ -0,0 +1,69 @@
+#ifndef UTIL_THREAD_PLACEMENT_HPP
+#define UTIL_THREAD_PLACEMENT_HPP
+
+#include <istream>
+#include <ostream>
+
+/**
+ * Policies for binding worker threads to cores, which map to the
+ * `OMP_PROC_BIND` policies of the OpenMP runtime, over the cores of the
+ * machine as places (`OMP_PLACES=cores`).
+ *
+ * A bound thread never migrates to another core, so that the memory it
+ * touches first, which Linux allocates on the NUMA node of the touching
+ * CPU, stays local to it. Since each thread allocates from its own heap
+ * arena, the working set of the computations it runs stays on its node.
+ */
+enum class ThreadPlacement
+{
+    // Let the system move threads between CPUs
+    None,
+
+    // Put threads on consecutive cores, which fills each NUMA node before
+    // moving on to the next node
+    Close,
+
+    // Distribute threads evenly across all cores, and therefore across
+    // NUMA nodes
+    Spread,
+};
+
+/**
+ * Read a thread placement from its name ('none', 'close' or 'spread').
+ *
+ * @param in Input stream.
+ * @param [placement] Set to the read placement. If the name is unknown,
+ * the failbit of the stream is set.
+ * @return Input stream.
+ */
+std::istream& operator>>(std::istream&, ThreadPlacement&);
+
+/**
+ * Print the name of a thread placement.
+ *
+ * @param out Output stream.
+ * @param placement Placement to print.
+ * @return Output stream.
+ */
+std::ostream& operator<<(std::ostream&, const ThreadPlacement&);
+
+/**
+ * Bind the threads of the OpenMP runtime to cores.
+ *
+ * The runtime reads its binding policy from the environment when it
+ * starts, which can happen before the program does. If the environment
+ * does not request the placement yet, it is added (keeping the places of
+ * `OMP_PLACES` if it is already set) and the program is executed again
+ * with the same arguments, so that this function returns only when all
+ * parallel regions bind their threads. On Linux, the same executable is
+ * started through `/proc/self/exe`; elsewhere, it is looked up from
+ * `argv[0]`.
+ *
+ * @param placement Placement policy. Nothing is done for `None`.
+ * @param argv Arguments of the program, terminated by a null pointer.
+ * @throws std::runtime_error If the program cannot be executed again
+ * (only Unix-like systems are supported).
+ */
+void place_threads(ThreadPlacement, const char* const argv[]);
+
+#endif // UTIL_THREAD_PLACEMENT_HPP
@@ -0,0 +1,43 @@
+#include "ThreadPlacement.hpp"
+#include <catch.hpp>
+#include <cstdlib>
+#include <sstream>
+
+TEST_CASE("Thread placement names")
+{
+    ThreadPlacement placement = ThreadPlacement::None;
+    std::istringstream in{"spread close none other"};
+
+    REQUIRE(in >> placement);
+    REQUIRE(placement == ThreadPlacement::Spread);
+    REQUIRE(in >> placement);
+    REQUIRE(placement == ThreadPlacement::Close);
+    REQUIRE(in >> placement);
+    REQUIRE(placement == ThreadPlacement::None);
+    REQUIRE_FALSE(in >> placement);
+
+    std::ostringstream out;
+    out << ThreadPlacement::Spread << " " << ThreadPlacement::Close;
+    REQUIRE(out.str() == "spread close");
+}
+
+#if defined(__unix__) || defined(__APPLE__)
+TEST_CASE("Bind threads to cores")
+{
+    const char* const argv[] = {"tests", nullptr};
+
+    // Without placement, the environment is left untouched
+    unsetenv("OMP_PROC_BIND");
+    place_threads(ThreadPlacement::None, argv);
+    REQUIRE(std::getenv("OMP_PROC_BIND") == nullptr);
+
+    // When the environment already requests the placement, the program is
+    // not executed again
+    setenv("OMP_PROC_BIND", "spread", 1);
+    setenv("OMP_PLACES", "cores", 1);
+    place_threads(ThreadPlacement::Spread, argv);
+
+    unsetenv("OMP_PROC_BIND");
+    unsetenv("OMP_PLACES");
+}
+#endif
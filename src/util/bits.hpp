@@ -0,0 +1,63 @@
+#ifndef UTIL_BITS_HPP
+#define UTIL_BITS_HPP
+
+/**
+ * Count the number of set bits in an unsigned integer.
+ *
+ * @param value Input value.
+ * @return Number of bits set in `value`.
+ */
+template<typename T>
+constexpr int popcount(T value) noexcept;
+
+/**
+ * Isolate the lowest set bit of an unsigned integer.
+ *
+ * @param value Input value.
+ * @return Value in which only the lowest set bit of `value` is set, or
+ * zero if `value` is zero.
+ */
+template<typename T>
+constexpr T lowest_bit(T value) noexcept;
+
+/**
+ * Isolate the highest set bit of an unsigned integer.
+ *
+ * @param value Input value.
+ * @return Value in which only the highest set bit of `value` is set, or
+ * zero if `value` is zero.
+ */
+template<typename T>
+T highest_bit(T value) noexcept;
+
+/**
+ * Gather the bits of a value that are selected by a mask into the
+ * contiguous low-order bits of the result (equivalent to the
+ * PEXT instruction of the BMI2 instruction set).
+ *
+ * @example extract_bits(0b101100, 0b111010) == 0b1010
+ *
+ * @param value Value from which to extract bits.
+ * @param mask Positions of the bits to extract.
+ * @return Extracted bits.
+ */
+template<typename T>
+T extract_bits(T value, T mask) noexcept;
+
+/**
+ * Scatter the contiguous low-order bits of a value to the positions
+ * selected by a mask (equivalent to the PDEP instruction of the BMI2
+ * instruction set). This is the inverse of `extract_bits`.
+ *
+ * @example deposit_bits(0b1010, 0b111010) == 0b101000
+ *
+ * @param value Value whose low-order bits are deposited.
+ * @param mask Positions at which to deposit the bits.
+ * @return Deposited bits.
+ */
+template<typename T>
+T deposit_bits(T value, T mask) noexcept;
+
+#include "bits.tpp"
+
+#endif // UTIL_BITS_HPP
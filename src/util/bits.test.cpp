@@ -0,0 +1,39 @@
+#include "bits.hpp"
+#include <catch.hpp>
+#include <cstdint>
+
+TEST_CASE("Bit manipulation primitives")
+{
+    using Word = std::uint64_t;
+
+    SECTION("Population count")
+    {
+        REQUIRE(popcount(Word{0}) == 0);
+        REQUIRE(popcount(Word{0b101101}) == 4);
+        REQUIRE(popcount(~Word{0}) == 64);
+    }
+
+    SECTION("Lowest and highest bits")
+    {
+        REQUIRE(lowest_bit(Word{0}) == 0);
+        REQUIRE(lowest_bit(Word{0b101100}) == 0b100);
+        REQUIRE(highest_bit(Word{0}) == 0);
+        REQUIRE(highest_bit(Word{0b101100}) == 0b100000);
+        REQUIRE(highest_bit(~Word{0}) == Word{1} << 63);
+    }
+
+    SECTION("Bit extraction and deposit")
+    {
+        REQUIRE(extract_bits(Word{0b101100}, Word{0b111010}) == 0b1010);
+        REQUIRE(deposit_bits(Word{0b1010}, Word{0b111010}) == 0b101000);
+        REQUIRE(extract_bits(Word{0b1111}, Word{0}) == 0);
+        REQUIRE(deposit_bits(Word{0b1111}, Word{0}) == 0);
+
+        for (Word value = 0; value < 64; ++value)
+        {
+            REQUIRE(extract_bits(
+                deposit_bits(value, Word{0b110101011}),
+                Word{0b110101011}) == value);
+        }
+    }
+}
@@ -0,0 +1,73 @@
+#include <limits>
+#include <type_traits>
+
+#ifdef __BMI2__
+#include <immintrin.h>
+#endif
+
+template<typename T>
+constexpr int popcount(T value) noexcept
+{
+    static_assert(std::is_unsigned<T>::value, "Expected an unsigned type");
+    return __builtin_popcountll(static_cast<unsigned long long>(value));
+}
+
+template<typename T>
+constexpr T lowest_bit(T value) noexcept
+{
+    return value & (~value + 1);
+}
+
+template<typename T>
+T highest_bit(T value) noexcept
+{
+    if (value == 0)
+    {
+        return 0;
+    }
+
+    constexpr int width = std::numeric_limits<unsigned long long>::digits;
+    return static_cast<T>(1ull << (width - 1
+        - __builtin_clzll(static_cast<unsigned long long>(value))));
+}
+
+template<typename T>
+T extract_bits(T value, T mask) noexcept
+{
+#ifdef __BMI2__
+    return static_cast<T>(_pext_u64(value, mask));
+#else
+    T result = 0;
+    T bit = 1;
+
+    for (; mask != 0; mask &= mask - 1, bit <<= 1)
+    {
+        if (value & lowest_bit(mask))
+        {
+            result |= bit;
+        }
+    }
+
+    return result;
+#endif
+}
+
+template<typename T>
+T deposit_bits(T value, T mask) noexcept
+{
+#ifdef __BMI2__
+    return static_cast<T>(_pdep_u64(value, mask));
+#else
+    T result = 0;
+
+    for (; mask != 0 && value != 0; mask &= mask - 1, value >>= 1)
+    {
+        if (value & 1)
+        {
+            result |= lowest_bit(mask);
+        }
+    }
+
+    return result;
+#endif
+}
@@ -0,0 +1,35 @@
+#ifndef UTIL_RANDOM_HPP
+#define UTIL_RANDOM_HPP
+
+#include <cstdint>
+
+/**
+ * Derive a new seed from a seed and a value, so that a task identified by
+ * a list of values (its coordinates) can get its own seed by deriving a
+ * master seed with each of its values in turn. Seeds are mixed with the
+ * SplitMix64 finalizer, so that tasks with close coordinates get unrelated
+ * seeds, and derived seeds do not depend on the order in which tasks are
+ * run or on the thread that runs them.
+ *
+ * @param seed Seed to derive from.
+ * @param value Integral or floating-point value of at most 64 bits, whose
+ * binary representation is mixed into the seed.
+ * @return Derived seed.
+ */
+template<typename T>
+std::uint64_t derive_seed(std::uint64_t seed, T value) noexcept;
+
+/**
+ * Create a pseudo-random number generator from a 64-bit seed. The whole
+ * seed is used for initializing the state of the generator.
+ *
+ * @param seed Seed of the generator.
+ * @return Seeded generator, from C++’s <random> library generators
+ * (eg. std::mt19937).
+ */
+template<typename PRNG>
+PRNG make_prng(std::uint64_t seed);
+
+#include "random.tpp"
+
+#endif // UTIL_RANDOM_HPP
@@ -0,0 +1,52 @@
+#include "random.hpp"
+#include <catch.hpp>
+#include <cstdint>
+#include <random>
+#include <set>
+
+TEST_CASE("Seed derivation")
+{
+    SECTION("Derived seeds only depend on their inputs")
+    {
+        REQUIRE(derive_seed(42, 1u) == derive_seed(42, 1u));
+        REQUIRE(derive_seed(42, 0.5) == derive_seed(42, 0.5));
+
+        auto first = make_prng<std::mt19937>(derive_seed(7, 3u));
+        auto second = make_prng<std::mt19937>(derive_seed(7, 3u));
+
+        for (int i = 0; i < 100; ++i)
+        {
+            REQUIRE(first() == second());
+        }
+    }
+
+    SECTION("Close coordinates yield distinct seeds")
+    {
+        std::set<std::uint64_t> seeds;
+
+        for (std::uint64_t master = 0; master < 4; ++master)
+        {
+            for (unsigned sample = 0; sample < 64; ++sample)
+            {
+                for (double value : {0.1, 0.2, 0.3})
+                {
+                    seeds.insert(derive_seed(
+                        derive_seed(master, sample), value));
+                }
+            }
+        }
+
+        REQUIRE(seeds.size() == 4 * 64 * 3);
+
+        // The order of derivation matters
+        REQUIRE(derive_seed(derive_seed(0, 1u), 2u)
+            != derive_seed(derive_seed(0, 2u), 1u));
+    }
+
+    SECTION("The whole seed is used")
+    {
+        auto low = make_prng<std::mt19937>(1);
+        auto high = make_prng<std::mt19937>(std::uint64_t{1} << 32 | 1);
+        REQUIRE(low() != high());
+    }
+}
@@ -0,0 +1,34 @@
+#include <cstring>
+#include <random>
+#include <type_traits>
+
+template<typename T>
+std::uint64_t derive_seed(std::uint64_t seed, T value) noexcept
+{
+    static_assert(
+        std::is_arithmetic<T>::value && sizeof(T) <= sizeof(std::uint64_t),
+        "Only values of at most 64 bits can be mixed into a seed");
+
+    std::uint64_t bits = 0;
+    std::memcpy(&bits, &value, sizeof(T));
+
+    // Scramble the value with the SplitMix64 finalizer, then scramble its
+    // combination with the seed so that neither input can cancel the other
+    auto mix = [](std::uint64_t z)
+    {
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9u;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBu;
+        return z ^ (z >> 31);
+    };
+
+    return mix(seed ^ mix(bits + 0x9E3779B97F4A7C15u));
+}
+
+template<typename PRNG>
+PRNG make_prng(std::uint64_t seed)
+{
+    std::seed_seq sequence{
+        static_cast<std::uint32_t>(seed),
+        static_cast<std::uint32_t>(seed >> 32)};
+    return PRNG{sequence};
+}
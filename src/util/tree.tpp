@@ -1,28 +1,40 @@
 #include <tree.hh>
-#include <algorithm>
+#include <utility>
+#include <vector>
 
-namespace detail
+template<typename Source, typename Dest>
+::tree<Dest> tree_cast(const ::tree<Source>& src)
 {
-    template<typename Source, typename Dest>
-    ::tree<Dest> tree_cast_helper(
-        const ::tree<Source>& src,
-        typename ::tree<Source>::iterator_base root)
+    ::tree<Dest> result;
+
+    if (src.empty())
     {
-        ::tree<Dest> result{static_cast<Dest>(*root)};
+        return result;
+    }
+
+    // Nodes are visited iteratively, so that the call stack does not grow
+    // with the depth of the tree. Children are appended to their converted
+    // parent as soon as the parent is visited, which keeps their order
+    std::vector<std::pair<
+        typename ::tree<Source>::sibling_iterator,
+        typename ::tree<Dest>::iterator>> pending;
 
-        for (auto it = src.begin(root); it != src.end(root); ++it)
+    typename ::tree<Source>::sibling_iterator root = src.begin();
+    pending.emplace_back(root, result.set_head(static_cast<Dest>(*root)));
+
+    while (!pending.empty())
+    {
+        auto current = pending.back();
+        pending.pop_back();
+
+        for (auto child = src.begin(current.first);
+                child != src.end(current.first);
+                ++child)
         {
-            auto subtree = tree_cast_helper<Source, Dest>(src, it);
-            result.append_child(result.begin(), subtree.begin());
+            pending.emplace_back(child, result.append_child(
+                current.second, static_cast<Dest>(*child)));
         }
-
-        return result;
     }
-}
 
-template<typename Source, typename Dest>
-::tree<Dest> tree_cast(const ::tree<Source>& src)
-{
-    auto result = detail::tree_cast_helper<Source, Dest>(src, src.begin());
     return result;
 }
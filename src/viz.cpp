@@ -1,12 +1,14 @@
-#include "io/nhx.hpp"
+#include "io/format.hpp"
 #include "io/util.hpp"
-#include "util/tree.hpp"
 #include "model/Synteny.hpp"
 #include "model/Event.hpp"
+#include <algorithm>
 #include <boost/program_options.hpp>
 #include <cstdlib>
 #include <iostream>
+#include <ostream>
 #include <sstream>
+#include <unordered_map>
 
 namespace po = boost::program_options;
 
@@ -18,6 +20,9 @@ struct Arguments
 {
     std::string input_path;
     std::string output_path;
+    unsigned max_depth;
+    std::size_t min_size;
+    std::size_t max_genes;
 };
 
 /**
@@ -48,6 +53,25 @@ bool read_arguments(Arguments& result, int argc, const char* argv[])
             ->default_value("-"),
          "path of the file in which the output should be stored, or '-' "
             "to store it in standard output")
+        ("max-depth,d",
+         po::value(&result.max_depth)
+            ->value_name("DEPTH")
+            ->default_value(0),
+         "collapse the subtrees of the nodes at the given depth (the root "
+         "being at depth 0) into summary nodes that show their number of "
+         "leaves, duplications and losses. If 0, show all depths")
+        ("min-size,m",
+         po::value(&result.min_size)
+            ->value_name("SIZE")
+            ->default_value(0),
+         "collapse the subtrees of fewer than SIZE nodes into summary "
+         "nodes. If 0, show subtrees of all sizes")
+        ("max-genes,g",
+         po::value(&result.max_genes)
+            ->value_name("COUNT")
+            ->default_value(0),
+         "only show the first COUNT genes of each synteny, followed by the "
+         "number of hidden genes. If 0, show whole syntenies")
     ;
 
     po::variables_map values;
@@ -70,7 +94,14 @@ bool read_arguments(Arguments& result, int argc, const char* argv[])
     return true;
 }
 
-std::string event_to_graphviz(const Event& event)
+/**
+ * Create the Graphviz attributes of an event node.
+ *
+ * @param event Event to represent.
+ * @param max_genes Maximum number of genes to show, or 0 to show all genes.
+ * @return Attributes of the node.
+ */
+std::string event_to_graphviz(const Event& event, std::size_t max_genes)
 {
     std::string result;
 
@@ -97,9 +128,28 @@ std::string event_to_graphviz(const Event& event)
 
     std::size_t index = 0;
     auto it = std::begin(event.synteny);
+    auto shown = max_genes == 0
+        ? event.synteny.size()
+        : std::min(max_genes, event.synteny.size());
 
     while (true)
     {
+        // Close a segment that spans past the last shown gene
+        if (index == shown && index != event.synteny.size()
+                && event.segment.first < index
+                && event.segment.second > index)
+        {
+            result += event.type == Event::Type::Duplication ? "</u>"
+                : event.type == Event::Type::Loss ? "]" : "";
+        }
+
+        if (index == shown && index != event.synteny.size())
+        {
+            result += " … (+"
+                + std::to_string(event.synteny.size() - shown) + ")";
+            break;
+        }
+
         if (event.segment.first != event.segment.second)
         {
             if (index == event.segment.first)
@@ -152,7 +202,7 @@ std::string event_to_graphviz(const Event& event)
             result += " ";
         }
 
-        result += *it;
+        result += it->getName();
 
         ++it;
         ++index;
@@ -162,63 +212,127 @@ std::string event_to_graphviz(const Event& event)
     return result;
 }
 
-std::string event_subtree_to_graphviz(
-    const tree<Event>& tree,
-    typename ::tree<Event>::iterator root)
+/**
+ * Summary of the events of a subtree.
+ */
+struct SubtreeSummary
 {
-    std::string result;
+    std::size_t size = 0;
+    std::size_t leaves = 0;
+    std::size_t duplications = 0;
+    std::size_t losses = 0;
+};
+
+/**
+ * Summarize all the subtrees of a tree.
+ *
+ * @param tree Tree to summarize.
+ * @return Summary of the subtree rooted at each node, by node address.
+ */
+std::unordered_map<const void*, SubtreeSummary> summarize_subtrees(
+    const tree<Event>& tree)
+{
+    std::unordered_map<const void*, SubtreeSummary> result;
 
-    for (typename ::tree<Event>::sibling_iterator it = tree.begin(root);
-            it != tree.end(root); ++it)
+    for (auto it = tree.begin_post(); it != tree.end_post(); ++it)
     {
-        result += "    "
-            + std::to_string(reinterpret_cast<unsigned long long int>(&*root))
-            + " -- "
-            + std::to_string(reinterpret_cast<unsigned long long int>(&*it));
+        auto& summary = result[&*it];
+        summary.size += 1;
+        summary.duplications += it->type == Event::Type::Duplication;
+        summary.losses += it->type == Event::Type::Loss;
+        summary.leaves += it.number_of_children() == 0
+            && it->type != Event::Type::Loss;
+
+        auto parent = ::tree<Event>::parent(it);
 
-        if (it->type == Event::Type::Loss && it->synteny.empty())
+        if (tree.is_valid(parent))
         {
-            result += " [style=dashed]";
+            auto& parent_summary = result[&*parent];
+            parent_summary.size += summary.size;
+            parent_summary.leaves += summary.leaves;
+            parent_summary.duplications += summary.duplications;
+            parent_summary.losses += summary.losses;
         }
-
-        result += ";\n" + event_subtree_to_graphviz(tree, it);
     }
 
     return result;
 }
 
-std::string event_tree_to_graphviz(const tree<Event>& tree)
+/**
+ * Write a Graphviz representation of a tree. Nodes and edges are written
+ * in a single prefix traversal, as they are visited, so that the output is
+ * never built in memory.
+ *
+ * @param out Output stream.
+ * @param tree Tree to represent.
+ * @param args Arguments of the program, which control which subtrees are
+ * collapsed into summary nodes and how long syntenies are shown.
+ */
+void write_event_tree_graphviz(
+    std::ostream& out,
+    const tree<Event>& tree,
+    const Arguments& args)
 {
-    std::string result = "graph {\n";
+    bool is_collapsing = args.max_depth > 0 || args.min_size > 0;
+    std::unordered_map<const void*, SubtreeSummary> summaries;
+
+    if (is_collapsing)
+    {
+        summaries = summarize_subtrees(tree);
+    }
+
+    // Depth of each visited node whose children are shown
+    std::unordered_map<const void*, unsigned> depths;
+    out << "graph {\n";
 
-    for (
-        auto it = tree.begin();
-        it != tree.end();
-        ++it)
+    for (auto it = tree.begin(); it != tree.end(); ++it)
     {
-        auto parent_node = tree.parent(it);
-        Synteny parent_synteny = it->synteny;
+        auto parent = ::tree<Event>::parent(it);
+        unsigned depth = tree.is_valid(parent) ? depths[&*parent] + 1 : 0;
+
+        // We use a node’s address in memory as a unique identifier
+        auto id = reinterpret_cast<unsigned long long int>(&*it);
+        out << "    " << id << " [";
 
-        // If we are considering the root of the tree, it has no parent node
-        if (tree.is_valid(parent_node))
+        if (is_collapsing && it.number_of_children() != 0
+                && ((args.max_depth > 0 && depth >= args.max_depth)
+                    || summaries[&*it].size < args.min_size))
         {
-            parent_synteny = parent_node->synteny;
+            const auto& summary = summaries[&*it];
+            out << "shape=\"folder\", label=<"
+                << summary.size << " nodes<br/>"
+                << summary.leaves << " leaves, "
+                << summary.duplications << " dup., "
+                << summary.losses << " losses>";
+            it.skip_children();
         }
+        else
+        {
+            out << event_to_graphviz(*it, args.max_genes);
 
-        // We use a node’s address in memory as a unique identifier
-        result += "    "
-            + std::to_string(reinterpret_cast<unsigned long long int>(&*it))
-            + " [" + event_to_graphviz(*it) + "];\n";
-    }
+            if (it.number_of_children() != 0)
+            {
+                depths[&*it] = depth;
+            }
+        }
 
-    for (typename ::tree<Event>::sibling_iterator it = tree.begin();
-            it != tree.end(); ++it)
-    {
-        result += event_subtree_to_graphviz(tree, it);
+        out << "];\n";
+
+        if (tree.is_valid(parent))
+        {
+            out << "    " << reinterpret_cast<unsigned long long int>(&*parent)
+                << " -- " << id;
+
+            if (it->type == Event::Type::Loss && it->synteny.empty())
+            {
+                out << " [style=dashed]";
+            }
+
+            out << ";\n";
+        }
     }
 
-    result += "}\n";
-    return result;
+    out << "}\n";
 }
 
 int main(int argc, const char* argv[])
@@ -230,16 +344,17 @@ int main(int argc, const char* argv[])
         return EXIT_SUCCESS;
     }
 
-    auto input_tree = parse_nhx_tree(read_all_from(
+    auto event_tree = parse_event_tree(read_all_from(
         args.input_path,
         "Input the tree to be converted to a Graphviz representation, "
             "and finish with Ctrl-D:"));
 
-    auto event_tree = tree_cast<TaggedNode, Event>(input_tree);
-
     write_all_to(
         args.output_path,
-        event_tree_to_graphviz(event_tree),
+        [&](std::ostream& out)
+        {
+            write_event_tree_graphviz(out, event_tree, args);
+        },
         "Tree in Graphviz format (can be piped into `dot`):");
 
     return EXIT_SUCCESS;
@@ -10,7 +10,7 @@ parser = argparse.ArgumentParser(description='Plot the results from a '
     + 'sampled simulated evaluation of the algorithm.')
 
 parser.add_argument('input', action='store',
-    help='input JSON file from which to read data')
+    help='input JSON or JSON Lines file from which to read data')
 parser.add_argument('x', action='store',
     help='kind of data on the x-axis')
 parser.add_argument('y', action='store',
@@ -44,21 +44,57 @@ ylabels = {
     'dlscore': r'\emph{DL-score}',
     'duration': r'Time to compute (s)'}
 
+def read_json(in_file):
+    """Read the sets of parameters and their samples from a JSON array."""
+    for value in json.load(in_file):
+        yield value['params'], value[args.y]
+
+
+def read_json_lines(in_file):
+    """
+    Read the sets of parameters and their samples from a JSON Lines file,
+    one sample at a time, grouping the samples of each set of parameters.
+    Only the metric on the y-axis is kept, so that large files do not need
+    to fit in memory.
+    """
+    groups = {}
+
+    for line in in_file:
+        try:
+            record = json.loads(line)
+        except ValueError:
+            # Line that was being written when the evaluation was stopped
+            continue
+
+        if 'params' not in record or args.y not in record:
+            continue
+
+        key = json.dumps(record['params'], sort_keys=True)
+
+        if key not in groups:
+            groups[key] = (record['params'], [])
+
+        groups[key][1].append(record[args.y])
+
+    return groups.values()
+
+
 # Load data from file
 with open(args.input, 'r') as in_file:
-    data = json.load(in_file)
+    is_array = in_file.read(1) == '['
+    in_file.seek(0)
     positions = []
     values = []
 
-    for value in data:
-        positions.append(value['params'][args.x])
-        value_normalized = value[args.y]
+    for params, samples in (read_json(in_file) if is_array
+            else read_json_lines(in_file)):
+        positions.append(params[args.x])
 
         # Convert from μs to seconds
         if args.y == 'duration':
-            value_normalized = list(map(lambda x : x / 1e6, value_normalized))
+            samples = list(map(lambda x : x / 1e6, samples))
 
-        values.append(value_normalized)
+        values.append(samples)
 
 # Sort values on the x-axis
 positions, values = zip(*sorted(zip(positions, values)))
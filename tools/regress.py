@@ -0,0 +1,163 @@
+#!/usr/bin/env python3
+
+import argparse
+import json
+import os
+import platform
+import subprocess
+import sys
+
+root = os.path.dirname(os.path.abspath(__file__))
+
+parser = argparse.ArgumentParser(description='Reconcile each tree of the '
+    + 'performance corpus in each of its modes, and compare the timings with '
+    + 'a stored baseline.')
+
+parser.add_argument('--bin', '-b', action='store',
+    default=os.path.join(root, '..', 'build', 'Release'),
+    help='directory containing the built programs')
+parser.add_argument('--corpus', '-c', action='store',
+    default=os.path.join(root, 'corpus'),
+    help='directory containing the corpus manifest and trees')
+parser.add_argument('--baseline', action='store',
+    help='path of the baseline timings (default: baseline.json in the '
+    + 'corpus directory)')
+parser.add_argument('--repeat', '-r', action='store', type=int, default=5,
+    help='number of timed runs for each tree, of which the fastest is kept')
+parser.add_argument('--tolerance', '-t', action='store', type=float,
+    default=0.2,
+    help='relative slowdown above which a tree is reported as a regression')
+parser.add_argument('--min-delta', action='store', type=int, default=200,
+    help='absolute slowdown in microseconds below which a tree is never '
+    + 'reported, to ignore the noise of very fast runs')
+parser.add_argument('--filter', '-f', action='store', default='',
+    help='only run the trees whose name contains the given text')
+parser.add_argument('--update', '-u', action='store_true',
+    help='store the measured timings as the new baseline instead of '
+    + 'comparing them')
+parser.add_argument('--generate', action='store_true',
+    help='regenerate the simulated trees of the corpus from their seeds '
+    + 'instead of measuring anything')
+
+args = parser.parse_args()
+baseline_path = args.baseline or os.path.join(args.corpus, 'baseline.json')
+
+with open(os.path.join(args.corpus, 'manifest.json'), 'r') as manifest_file:
+    manifest = json.load(manifest_file)
+
+
+def program(name):
+    return os.path.join(args.bin, name)
+
+
+def generate(entry):
+    """Recreate a simulated tree of the corpus from its parameters."""
+    simulated = subprocess.run(
+        [program('simulate')] + entry['simulate'],
+        check=True, stdout=subprocess.PIPE).stdout
+    erased = subprocess.run(
+        [program('erase')],
+        check=True, input=simulated, stdout=subprocess.PIPE).stdout
+
+    with open(os.path.join(args.corpus, entry['file']), 'wb') as tree_file:
+        tree_file.write(erased.strip() + b'\n')
+
+
+def measure(tree, mode):
+    """
+    Measure the fastest reconciliation of a tree in microseconds, using
+    the server mode so that only the reconciliation is timed.
+    """
+    request = str(len(tree)).encode() + b'\n' + tree
+    command = [program('reconcile'), '--server', '--timing']
+
+    if mode == 'unordered':
+        command.append('--unordered')
+
+    # The first request warms the server up and is not counted
+    output = subprocess.run(
+        command, check=True,
+        input=request * (args.repeat + 1),
+        stdout=subprocess.PIPE).stdout
+
+    timings = []
+    position = 0
+
+    while position < len(output):
+        line_end = output.index(b'\n', position)
+        status, size, duration = output[position:line_end].split()
+
+        if status != b'ok':
+            message = output[line_end + 1:line_end + 1 + int(size)]
+            raise RuntimeError(message.decode())
+
+        timings.append(int(duration))
+        position = line_end + 1 + int(size) + 1
+
+    return min(timings[1:])
+
+
+if args.generate:
+    for entry in manifest['trees']:
+        if 'simulate' in entry and args.filter in entry['name']:
+            print('Generating', entry['file'])
+            generate(entry)
+
+    sys.exit(0)
+
+if os.path.exists(baseline_path):
+    with open(baseline_path, 'r') as baseline_file:
+        baseline = json.load(baseline_file)
+else:
+    baseline = {'timings': {}}
+
+timings = {}
+regressions = []
+
+print('{:<40} {:>12} {:>12} {:>8}'.format(
+    'tree', 'baseline', 'current', 'ratio'))
+
+for entry in manifest['trees']:
+    if args.filter not in entry['name']:
+        continue
+
+    with open(os.path.join(args.corpus, entry['file']), 'rb') as tree_file:
+        tree = tree_file.read().strip()
+
+    for mode in entry['modes']:
+        key = entry['name'] + '/' + mode
+        current = measure(tree, mode)
+        timings[key] = current
+        previous = baseline['timings'].get(key)
+
+        if previous is None:
+            print('{:<40} {:>12} {:>10}us {:>8}'.format(
+                key, '-', current, 'new'))
+            continue
+
+        ratio = current / max(previous, 1)
+        is_slower = (ratio > 1 + args.tolerance
+            and current - previous > args.min_delta)
+
+        print('{:<40} {:>10}us {:>10}us {:>7.2f}x{}'.format(
+            key, previous, current, ratio, ' SLOWER' if is_slower else ''))
+
+        if is_slower:
+            regressions.append(key)
+
+if args.update:
+    baseline['timings'].update(timings)
+    baseline['machine'] = {
+        'system': platform.system(),
+        'processor': platform.processor() or platform.machine(),
+        'cpus': os.cpu_count()}
+
+    with open(baseline_path, 'w') as baseline_file:
+        json.dump(baseline, baseline_file, indent=4, sort_keys=True)
+        baseline_file.write('\n')
+
+    print('Baseline updated in', baseline_path)
+elif regressions:
+    print('\n{} regression(s) above {:.0%}: {}'.format(
+        len(regressions), args.tolerance, ', '.join(regressions)))
+    sys.exit(1)